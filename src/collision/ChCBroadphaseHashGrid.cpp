@@ -0,0 +1,389 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+//////////////////////////////////////////////////
+//
+//   ChCBroadphaseHashGrid.cpp
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <math.h>
+#include <stdio.h>
+#include "collision/ChCBroadphaseHashGrid.h"
+
+
+namespace chrono
+{
+namespace collision
+{
+
+
+static inline bool AabbOverlap(const btBroadphaseProxy* a, const btBroadphaseProxy* b)
+{
+	return (a->m_aabbMin.getX() <= b->m_aabbMax.getX()) && (b->m_aabbMin.getX() <= a->m_aabbMax.getX()) &&
+		   (a->m_aabbMin.getY() <= b->m_aabbMax.getY()) && (b->m_aabbMin.getY() <= a->m_aabbMax.getY()) &&
+		   (a->m_aabbMin.getZ() <= b->m_aabbMax.getZ()) && (b->m_aabbMin.getZ() <= a->m_aabbMax.getZ());
+}
+
+// Cell index along one axis, clamped to avoid integer overflow far away from the origin
+static inline int CellCoord(double x, double inv_size)
+{
+	double c = floor(x * inv_size);
+	if (c < -1e9) return -1000000000;
+	if (c >  1e9) return  1000000000;
+	return (int)c;
+}
+
+static inline unsigned int CellHash(int level, int ix, int iy, int iz)
+{
+	return ((unsigned int)ix * 73856093u) ^ ((unsigned int)iy * 19349663u) ^ ((unsigned int)iz * 83492791u) ^ ((unsigned int)level * 2654435761u);
+}
+
+
+// Removes the pairs whose AABBs do not overlap anymore
+class ChHashGridRemovePairCallback : public btOverlapCallback
+{
+public:
+	virtual bool processOverlap(btBroadphasePair& pair)
+	{
+		return !AabbOverlap(pair.m_pProxy0, pair.m_pProxy1);
+	}
+};
+
+
+
+
+ChBroadphaseHashGrid::ChBroadphaseHashGrid(double mcell_size)
+{
+	pair_cache = new btHashedOverlappingPairCache();
+	next_unique_id = 0;
+	cell_size = mcell_size;
+	current_cell_size = mcell_size;
+}
+
+
+ChBroadphaseHashGrid::~ChBroadphaseHashGrid()
+{
+	for (size_t i = 0; i < proxies.size(); i++)
+		delete proxies[i];
+	delete pair_cache;
+}
+
+
+btBroadphaseProxy* ChBroadphaseHashGrid::createProxy(const btVector3& aabbMin, const btVector3& aabbMax, int shapeType, void* userPtr, short int collisionFilterGroup, short int collisionFilterMask, btDispatcher* dispatcher, void* multiSapProxy)
+{
+	ChGridProxy* mproxy = new ChGridProxy;
+	mproxy->m_aabbMin = aabbMin;
+	mproxy->m_aabbMax = aabbMax;
+	mproxy->m_clientObject = userPtr;
+	mproxy->m_collisionFilterGroup = collisionFilterGroup;
+	mproxy->m_collisionFilterMask = collisionFilterMask;
+	mproxy->m_multiSapParentProxy = multiSapProxy;
+	mproxy->m_uniqueId = ++next_unique_id;
+	mproxy->index = (int)proxies.size();
+	mproxy->level = 0;
+	proxies.push_back(mproxy);
+	return mproxy;
+}
+
+
+void ChBroadphaseHashGrid::destroyProxy(btBroadphaseProxy* proxy, btDispatcher* dispatcher)
+{
+	ChGridProxy* mproxy = (ChGridProxy*)proxy;
+	pair_cache->removeOverlappingPairsContainingProxy(mproxy, dispatcher);
+
+	proxies[mproxy->index] = proxies.back();
+	proxies[mproxy->index]->index = mproxy->index;
+	proxies.pop_back();
+
+	delete mproxy;
+}
+
+
+void ChBroadphaseHashGrid::setAabb(btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax, btDispatcher* dispatcher)
+{
+	// The grid is rebuilt from scratch in calculateOverlappingPairs()
+	proxy->m_aabbMin = aabbMin;
+	proxy->m_aabbMax = aabbMax;
+}
+
+
+void ChBroadphaseHashGrid::getAabb(btBroadphaseProxy* proxy, btVector3& aabbMin, btVector3& aabbMax) const
+{
+	aabbMin = proxy->m_aabbMin;
+	aabbMax = proxy->m_aabbMax;
+}
+
+
+void ChBroadphaseHashGrid::rayTest(const btVector3& rayFrom, const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin, const btVector3& aabbMax)
+{
+	// as btSimpleBroadphase: the callback performs the ray-AABB test
+	for (size_t i = 0; i < proxies.size(); i++)
+		rayCallback.process(proxies[i]);
+}
+
+
+void ChBroadphaseHashGrid::aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback)
+{
+	btBroadphaseProxy mbox;
+	mbox.m_aabbMin = aabbMin;
+	mbox.m_aabbMax = aabbMax;
+	for (size_t i = 0; i < proxies.size(); i++)
+	{
+		if (AabbOverlap(&mbox, proxies[i]))
+			callback.process(proxies[i]);
+	}
+}
+
+
+void ChBroadphaseHashGrid::getBroadphaseAabb(btVector3& aabbMin, btVector3& aabbMax) const
+{
+	if (proxies.empty())
+	{
+		aabbMin.setValue(0,0,0);
+		aabbMax.setValue(0,0,0);
+		return;
+	}
+	aabbMin = proxies[0]->m_aabbMin;
+	aabbMax = proxies[0]->m_aabbMax;
+	for (size_t i = 1; i < proxies.size(); i++)
+	{
+		aabbMin.setMin(proxies[i]->m_aabbMin);
+		aabbMax.setMax(proxies[i]->m_aabbMax);
+	}
+}
+
+
+void ChBroadphaseHashGrid::printStats()
+{
+	printf("ChBroadphaseHashGrid: %d proxies, %d too large for the grid, %d cells, cell size %g\n",
+		(int)proxies.size(), (int)large.size(), (int)table.size(), current_cell_size);
+}
+
+
+int ChBroadphaseHashGrid::FindCell(int level, int ix, int iy, int iz)
+{
+	unsigned int mask = (unsigned int)table.size() - 1;
+	unsigned int h = CellHash(level, ix, iy, iz) & mask;
+	while (table[h].level != -1)
+	{
+		const ChGridCell& c = table[h];
+		if ((c.ix == ix) && (c.iy == iy) && (c.iz == iz) && (c.level == level))
+			return (int)h;
+		h = (h + 1) & mask;
+	}
+	return -1;
+}
+
+
+int ChBroadphaseHashGrid::InsertCell(int level, int ix, int iy, int iz)
+{
+	unsigned int mask = (unsigned int)table.size() - 1;
+	unsigned int h = CellHash(level, ix, iy, iz) & mask;
+	while (table[h].level != -1)
+	{
+		const ChGridCell& c = table[h];
+		if ((c.ix == ix) && (c.iy == iy) && (c.iz == iz) && (c.level == level))
+			return (int)h;
+		h = (h + 1) & mask;
+	}
+	ChGridCell& c = table[h];
+	c.ix = ix; c.iy = iy; c.iz = iz;
+	c.level = level;
+	c.start = 0;
+	c.count = 0;
+	return (int)h;
+}
+
+
+void ChBroadphaseHashGrid::CellRange(const btVector3& aabbMin, const btVector3& aabbMax, double inv_size, int* imin, int* imax)
+{
+	imin[0] = CellCoord(aabbMin.getX(), inv_size);
+	imin[1] = CellCoord(aabbMin.getY(), inv_size);
+	imin[2] = CellCoord(aabbMin.getZ(), inv_size);
+	imax[0] = CellCoord(aabbMax.getX(), inv_size);
+	imax[1] = CellCoord(aabbMax.getY(), inv_size);
+	imax[2] = CellCoord(aabbMax.getZ(), inv_size);
+}
+
+
+void ChBroadphaseHashGrid::calculateOverlappingPairs(btDispatcher* dispatcher)
+{
+	int nproxies = (int)proxies.size();
+
+	// 1- Cell size of the first level, and level of each object
+
+	current_cell_size = cell_size;
+	if (current_cell_size <= 0)
+	{
+		double sum = 0;
+		for (int i = 0; i < nproxies; i++)
+		{
+			btVector3 ext = proxies[i]->m_aabbMax - proxies[i]->m_aabbMin;
+			sum += btMax(ext.getX(), btMax(ext.getY(), ext.getZ()));
+		}
+		current_cell_size = (nproxies && sum > 0) ? sum / nproxies : 1.0;
+	}
+
+	double level_size[MAX_LEVELS];
+	double level_inv[MAX_LEVELS];
+	level_size[0] = current_cell_size;
+	for (int l = 1; l < MAX_LEVELS; l++)
+		level_size[l] = level_size[l-1] * 2.0;
+	for (int l = 0; l < MAX_LEVELS; l++)
+		level_inv[l] = 1.0 / level_size[l];
+
+	large.clear();
+	int used_levels = 0;
+	int ninserts = 0;
+	int imin[3], imax[3];
+
+	for (int i = 0; i < nproxies; i++)
+	{
+		ChGridProxy* mproxy = proxies[i];
+		btVector3 ext = mproxy->m_aabbMax - mproxy->m_aabbMin;
+		double size = btMax(ext.getX(), btMax(ext.getY(), ext.getZ()));
+		int l = 0;
+		while ((l < MAX_LEVELS) && (level_size[l] < size))
+			l++;
+		if (l == MAX_LEVELS)
+		{
+			mproxy->level = -1;
+			large.push_back(i);
+			continue;
+		}
+		mproxy->level = l;
+		used_levels |= (1 << l);
+		CellRange(mproxy->m_aabbMin, mproxy->m_aabbMax, level_inv[l], imin, imax);
+		ninserts += (imax[0]-imin[0]+1) * (imax[1]-imin[1]+1) * (imax[2]-imin[2]+1);
+	}
+
+	// 2- Fill the hash table: count objects per cell, then store them
+
+	unsigned int tsize = 64;
+	while (tsize < 2 * (unsigned int)ninserts)
+		tsize *= 2;
+	ChGridCell empty_cell;
+	empty_cell.ix = empty_cell.iy = empty_cell.iz = 0;
+	empty_cell.level = -1;
+	empty_cell.start = empty_cell.count = 0;
+	table.assign(tsize, empty_cell);
+
+	for (int i = 0; i < nproxies; i++)
+	{
+		ChGridProxy* mproxy = proxies[i];
+		int l = mproxy->level;
+		if (l < 0)
+			continue;
+		CellRange(mproxy->m_aabbMin, mproxy->m_aabbMax, level_inv[l], imin, imax);
+		for (int ix = imin[0]; ix <= imax[0]; ix++)
+			for (int iy = imin[1]; iy <= imax[1]; iy++)
+				for (int iz = imin[2]; iz <= imax[2]; iz++)
+					table[InsertCell(l, ix, iy, iz)].count++;
+	}
+
+	int nitems = 0;
+	for (unsigned int h = 0; h < tsize; h++)
+	{
+		table[h].start = nitems;
+		nitems += table[h].count;
+		table[h].count = 0;
+	}
+	cell_items.resize(nitems);
+
+	for (int i = 0; i < nproxies; i++)
+	{
+		ChGridProxy* mproxy = proxies[i];
+		int l = mproxy->level;
+		if (l < 0)
+			continue;
+		CellRange(mproxy->m_aabbMin, mproxy->m_aabbMax, level_inv[l], imin, imax);
+		for (int ix = imin[0]; ix <= imax[0]; ix++)
+			for (int iy = imin[1]; iy <= imax[1]; iy++)
+				for (int iz = imin[2]; iz <= imax[2]; iz++)
+				{
+					ChGridCell& c = table[FindCell(l, ix, iy, iz)];
+					cell_items[c.start + c.count] = i;
+					c.count++;
+				}
+	}
+
+	// 3- Add new overlapping pairs. Each object looks for objects in the cells
+	// that it overlaps, at its own level and at coarser levels. A pair is found
+	// in all the cells shared by the two objects, so it is added only in the
+	// cell that contains the min corner of the intersection of the two AABBs.
+
+	for (int i = 0; i < nproxies; i++)
+	{
+		ChGridProxy* mproxy = proxies[i];
+		if (mproxy->level < 0)
+			continue;
+		for (int l = mproxy->level; l < MAX_LEVELS; l++)
+		{
+			if (!(used_levels & (1 << l)))
+				continue;
+			CellRange(mproxy->m_aabbMin, mproxy->m_aabbMax, level_inv[l], imin, imax);
+			for (int ix = imin[0]; ix <= imax[0]; ix++)
+				for (int iy = imin[1]; iy <= imax[1]; iy++)
+					for (int iz = imin[2]; iz <= imax[2]; iz++)
+					{
+						int h = FindCell(l, ix, iy, iz);
+						if (h < 0)
+							continue;
+						const ChGridCell& c = table[h];
+						for (int k = c.start; k < c.start + c.count; k++)
+						{
+							int j = cell_items[k];
+							// objects of the same level find each other: keep one
+							if ((l == mproxy->level) && (j <= i))
+								continue;
+							ChGridProxy* mother = proxies[j];
+							if (!AabbOverlap(mproxy, mother))
+								continue;
+							if ((CellCoord(btMax(mproxy->m_aabbMin.getX(), mother->m_aabbMin.getX()), level_inv[l]) != ix) ||
+								(CellCoord(btMax(mproxy->m_aabbMin.getY(), mother->m_aabbMin.getY()), level_inv[l]) != iy) ||
+								(CellCoord(btMax(mproxy->m_aabbMin.getZ(), mother->m_aabbMin.getZ()), level_inv[l]) != iz))
+								continue;
+							pair_cache->addOverlappingPair(mproxy, mother);
+						}
+					}
+		}
+	}
+
+	// Objects too large for the grid are tested against all the others
+
+	for (size_t k = 0; k < large.size(); k++)
+	{
+		int i = large[k];
+		for (int j = 0; j < nproxies; j++)
+		{
+			if ((j == i) || ((proxies[j]->level < 0) && (j < i)))
+				continue;
+			if (AabbOverlap(proxies[i], proxies[j]))
+				pair_cache->addOverlappingPair(proxies[i], proxies[j]);
+		}
+	}
+
+	// 4- Remove pairs that do not overlap anymore (this also deletes their algorithms)
+
+	ChHashGridRemovePairCallback mremove;
+	pair_cache->processAllOverlappingPairs(&mremove, dispatcher);
+}
+
+
+
+} // END_OF_NAMESPACE____
+} // END_OF_NAMESPACE____
+
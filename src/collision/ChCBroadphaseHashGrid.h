@@ -0,0 +1,128 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHC_BROADPHASEHASHGRID_H
+#define CHC_BROADPHASEHASHGRID_H
+
+//////////////////////////////////////////////////
+//
+//   ChCBroadphaseHashGrid.h
+//
+//   Bullet broadphase based on a multi-level
+//   uniform grid, stored in a hash table.
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <vector>
+#include "core/ChApiCE.h"
+#include "collision/bullet/btBulletCollisionCommon.h"
+
+
+namespace chrono
+{
+namespace collision
+{
+
+
+///
+/// Broadphase for the Bullet collision world, based on a hierarchy of
+/// uniform grids whose cells are stored in a hash table, so that the
+/// domain is unbounded and there is no limit on the number of objects.
+/// Cells of level L have size cell_size*2^L; each object is put in the
+/// finest level whose cells are not smaller than its AABB, hence it spans
+/// at most 2x2x2 cells. This is optimal for granular flows with objects of
+/// similar size, that all fall in the first level. Objects larger than
+/// the coarsest level (ex. the ground) are tested against all others.
+/// The grid is rebuilt at each calculateOverlappingPairs(), and the
+/// pair cache is updated incrementally, so that collision algorithms
+/// and contact manifolds persist as with other Bullet broadphases.
+///
+
+class ChApi ChBroadphaseHashGrid : public btBroadphaseInterface
+{
+public:
+					/// Create the broadphase. If cell_size is zero, the size of
+					/// the cells of the first level is set automatically at each
+					/// step, as the average size of the AABBs of the objects.
+	ChBroadphaseHashGrid(double mcell_size = 0);
+	virtual ~ChBroadphaseHashGrid();
+
+					/// Set the size of the cells of the first level (0 for automatic)
+	void   SetCellSize(double msize) {cell_size = msize;}
+	double GetCellSize() {return cell_size;}
+
+					/// Get the size of the cells of the first level used in the last update
+	double GetCurrentCellSize() {return current_cell_size;}
+
+					/// Number of levels of the grid. Objects that do not fit
+					/// the last level are tested against all the others.
+	static const int MAX_LEVELS = 16;
+
+					// Bullet interface
+	virtual btBroadphaseProxy* createProxy(const btVector3& aabbMin, const btVector3& aabbMax, int shapeType, void* userPtr, short int collisionFilterGroup, short int collisionFilterMask, btDispatcher* dispatcher, void* multiSapProxy);
+	virtual void destroyProxy(btBroadphaseProxy* proxy, btDispatcher* dispatcher);
+	virtual void setAabb(btBroadphaseProxy* proxy, const btVector3& aabbMin, const btVector3& aabbMax, btDispatcher* dispatcher);
+	virtual void getAabb(btBroadphaseProxy* proxy, btVector3& aabbMin, btVector3& aabbMax) const;
+	virtual void rayTest(const btVector3& rayFrom, const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin=btVector3(0,0,0), const btVector3& aabbMax=btVector3(0,0,0));
+	virtual void aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback);
+	virtual void calculateOverlappingPairs(btDispatcher* dispatcher);
+	virtual btOverlappingPairCache* getOverlappingPairCache() {return pair_cache;}
+	virtual const btOverlappingPairCache* getOverlappingPairCache() const {return pair_cache;}
+	virtual void getBroadphaseAabb(btVector3& aabbMin, btVector3& aabbMax) const;
+	virtual void printStats();
+
+private:
+	struct ChGridProxy : public btBroadphaseProxy
+	{
+		int index;	// position in 'proxies'
+		int level;	// level of the grid, or -1 if too large for the grid
+	};
+
+	struct ChGridCell
+	{
+		int ix, iy, iz;
+		int level;	// -1 for empty slots of the hash table
+		int start;
+		int count;
+	};
+
+	int  FindCell(int level, int ix, int iy, int iz);
+	int  InsertCell(int level, int ix, int iy, int iz);
+	void CellRange(const btVector3& aabbMin, const btVector3& aabbMax, double inv_size, int* imin, int* imax);
+
+	btOverlappingPairCache* pair_cache;
+	std::vector<ChGridProxy*> proxies;
+	int next_unique_id;
+
+	double cell_size;
+	double current_cell_size;
+
+					// grid data, kept to avoid reallocations
+	std::vector<ChGridCell> table;
+	std::vector<int> cell_items;
+	std::vector<int> large;
+};
+
+
+
+
+} // END_OF_NAMESPACE____
+} // END_OF_NAMESPACE____
+
+
+#endif
@@ -0,0 +1,409 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+//////////////////////////////////////////////////
+//
+//   ChCCollisionDispatcherParallel.cpp
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <algorithm>
+#include "collision/ChCCollisionDispatcherParallel.h"
+#include "BulletCollision/CollisionDispatch/btConvexConvexAlgorithm.h"
+
+
+namespace chrono
+{
+namespace collision
+{
+
+
+// Number of convex-convex pairs per task of the parallel phase
+static const int CH_NARROWPHASE_CHUNK = 64;
+
+// Number of manifolds in the pool of each thread
+static const int CH_THREAD_MANIFOLD_POOL_SIZE = 1024;
+
+
+
+// The default convex-convex algorithm of Bullet uses the simplex solver
+// shared by the collision configuration, that cannot be used by two
+// threads at the same time. This one owns its simplex solver.
+
+class ChConvexConvexAlgorithmOwnSimplex : public btConvexConvexAlgorithm
+{
+	btVoronoiSimplexSolver own_simplex;
+public:
+	ChConvexConvexAlgorithmOwnSimplex(btPersistentManifold* mf, const btCollisionAlgorithmConstructionInfo& ci,
+									  btCollisionObject* body0, btCollisionObject* body1,
+									  btConvexPenetrationDepthSolver* pdSolver, int numPerturbationIterations, int minimumPointsPerturbationThreshold)
+		// the base class only stores the pointer to the simplex solver
+		: btConvexConvexAlgorithm(mf, ci, body0, body1, &own_simplex, pdSolver, numPerturbationIterations, minimumPointsPerturbationThreshold)
+		{}
+};
+
+// Creates ChConvexConvexAlgorithmOwnSimplex algorithms, using the
+// settings of the convex-convex create function of the configuration.
+
+struct ChConvexConvexOwnSimplexCreateFunc : public btCollisionAlgorithmCreateFunc
+{
+	btConvexConvexAlgorithm::CreateFunc* defaults;
+
+	ChConvexConvexOwnSimplexCreateFunc(btConvexConvexAlgorithm::CreateFunc* mdefaults) : defaults(mdefaults) {}
+
+	virtual	btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci, btCollisionObject* body0, btCollisionObject* body1)
+	{
+		void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(ChConvexConvexAlgorithmOwnSimplex));
+		return new(mem) ChConvexConvexAlgorithmOwnSimplex(ci.m_manifold, ci, body0, body1,
+								defaults->m_pdSolver, defaults->m_numPerturbationIterations, defaults->m_minimumPointsPerturbationThreshold);
+	}
+};
+
+
+// Pairs where the algorithm does not modify any of the two objects
+// can be processed concurrently with other pairs of the same objects.
+static bool IsSharedSafe(int shapetype)
+{
+	return btBroadphaseProxy::isConvex(shapetype) || (shapetype == STATIC_PLANE_PROXYTYPE);
+}
+
+
+
+
+ChCollisionDispatcherParallel::ChCollisionDispatcherParallel(btCollisionConfiguration* collisionConfiguration, int nthreads)
+	: btCollisionDispatcher(collisionConfiguration)
+{
+	num_threads = 1;
+	in_parallel = false;
+	woken_objects = 0;
+
+	// Replace the convex-convex create function in all the entries of the double dispatch table
+	default_convex_func = collisionConfiguration->getCollisionAlgorithmCreateFunc(CONVEX_HULL_SHAPE_PROXYTYPE, CONVEX_HULL_SHAPE_PROXYTYPE);
+	convex_func = new ChConvexConvexOwnSimplexCreateFunc((btConvexConvexAlgorithm::CreateFunc*)default_convex_func);
+	for (int i = 0; i < MAX_BROADPHASE_COLLISION_TYPES; i++)
+		for (int j = 0; j < MAX_BROADPHASE_COLLISION_TYPES; j++)
+			if (m_doubleDispatch[i][j] == default_convex_func)
+				m_doubleDispatch[i][j] = convex_func;
+
+	SetNumThreads(nthreads);
+}
+
+
+ChCollisionDispatcherParallel::~ChCollisionDispatcherParallel()
+{
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].manifold_pool->~btPoolAllocator();
+		btAlignedFree(threads[i].manifold_pool);
+	}
+	delete convex_func;
+}
+
+
+void ChCollisionDispatcherParallel::SetNumThreads(int nthreads)
+{
+	if (nthreads < 1)
+		nthreads = 1;
+	num_threads = nthreads;
+
+	// Thread pools are never deleted before the destructor, because
+	// they may still contain manifolds.
+	while ((int)threads.size() < num_threads)
+	{
+		ChThreadData mdata;
+		void* mem = btAlignedAlloc(sizeof(btPoolAllocator), 16);
+		mdata.manifold_pool = new(mem) btPoolAllocator(sizeof(btPersistentManifold), CH_THREAD_MANIFOLD_POOL_SIZE);
+		mdata.task = 0;
+		threads.push_back(mdata);
+	}
+}
+
+
+int ChCollisionDispatcherParallel::GetAlgorithmMaxElementSize()
+{
+	return sizeof(ChConvexConvexAlgorithmOwnSimplex);
+}
+
+
+btPersistentManifold* ChCollisionDispatcherParallel::getNewManifold(void* b0, void* b1)
+{
+	if (!in_parallel)
+		return btCollisionDispatcher::getNewManifold(b0,b1);
+
+	ChThreadData& mthread = threads[CHOMPfunctions::GetThreadNum()];
+
+	btCollisionObject* body0 = (btCollisionObject*)b0;
+	btCollisionObject* body1 = (btCollisionObject*)b1;
+
+	btScalar contactBreakingThreshold = (m_dispatcherFlags & btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD) ?
+		btMin(body0->getCollisionShape()->getContactBreakingThreshold(gContactBreakingThreshold), body1->getCollisionShape()->getContactBreakingThreshold(gContactBreakingThreshold))
+		: gContactBreakingThreshold;
+	btScalar contactProcessingThreshold = btMin(body0->getContactProcessingThreshold(), body1->getContactProcessingThreshold());
+
+	void* mem = 0;
+	if (mthread.manifold_pool->getFreeCount())
+		mem = mthread.manifold_pool->allocate(sizeof(btPersistentManifold));
+	else
+		mem = btAlignedAlloc(sizeof(btPersistentManifold),16);
+
+	btPersistentManifold* manifold = new(mem) btPersistentManifold(body0,body1,0,contactBreakingThreshold,contactProcessingThreshold);
+
+	// New manifolds are kept in the list of the task, and moved in the
+	// manifold array by MergeParallelManifolds(). Negative index marks them.
+	std::vector<btPersistentManifold*>& mlist = task_manifolds[mthread.task];
+	manifold->m_index1a = -(int)mlist.size() - 1;
+	mlist.push_back(manifold);
+
+	return manifold;
+}
+
+
+void ChCollisionDispatcherParallel::releaseManifold(btPersistentManifold* manifold)
+{
+	clearManifold(manifold);
+
+	int findIndex = manifold->m_index1a;
+
+	if (in_parallel)
+	{
+		ChThreadData& mthread = threads[CHOMPfunctions::GetThreadNum()];
+		if (findIndex < 0)
+		{
+			// created by this same task
+			std::vector<btPersistentManifold*>& mlist = task_manifolds[mthread.task];
+			int k = -findIndex - 1;
+			mlist[k] = mlist.back();
+			mlist[k]->m_index1a = -k - 1;
+			mlist.pop_back();
+		}
+		else
+		{
+			// the array is compacted by MergeParallelManifolds()
+			m_manifoldsPtr[findIndex] = 0;
+		}
+		manifold->~btPersistentManifold();
+		mthread.released.push_back(manifold);
+		return;
+	}
+
+	btAssert(findIndex < m_manifoldsPtr.size());
+	m_manifoldsPtr.swap(findIndex,m_manifoldsPtr.size()-1);
+	m_manifoldsPtr[findIndex]->m_index1a = findIndex;
+	m_manifoldsPtr.pop_back();
+
+	manifold->~btPersistentManifold();
+	FreeManifoldMemory(manifold);
+}
+
+
+void ChCollisionDispatcherParallel::FreeManifoldMemory(btPersistentManifold* manifold)
+{
+	if (m_persistentManifoldPoolAllocator->validPtr(manifold))
+	{
+		m_persistentManifoldPoolAllocator->freeMemory(manifold);
+		return;
+	}
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		if (threads[i].manifold_pool->validPtr(manifold))
+		{
+			threads[i].manifold_pool->freeMemory(manifold);
+			return;
+		}
+	}
+	btAlignedFree(manifold);
+}
+
+
+void* ChCollisionDispatcherParallel::allocateCollisionAlgorithm(int size)
+{
+	// Compound and concave algorithms create sub-algorithms while processing
+	// collisions, so the shared pool must be locked in the parallel phase.
+	if (in_parallel)
+		algorithm_mutex.Lock();
+
+	void* mem;
+	if (m_collisionAlgorithmPoolAllocator->getFreeCount() && (size <= m_collisionAlgorithmPoolAllocator->getElementSize()))
+		mem = m_collisionAlgorithmPoolAllocator->allocate(size);
+	else
+		mem = btAlignedAlloc(static_cast<size_t>(size), 16);
+
+	if (in_parallel)
+		algorithm_mutex.Unlock();
+	return mem;
+}
+
+
+void ChCollisionDispatcherParallel::freeCollisionAlgorithm(void* ptr)
+{
+	if (in_parallel)
+		algorithm_mutex.Lock();
+
+	btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+
+	if (in_parallel)
+		algorithm_mutex.Unlock();
+}
+
+
+bool ChCollisionDispatcherParallel::needsCollision(btCollisionObject* body0, btCollisionObject* body1)
+{
+	if (!btCollisionDispatcher::needsCollision(body0, body1))
+		return false;
+	if (!woken_objects)
+		return true;
+
+	bool woken0 = std::binary_search(woken_objects->begin(), woken_objects->end(), body0);
+	bool woken1 = std::binary_search(woken_objects->begin(), woken_objects->end(), body1);
+	return (woken0 && (woken1 || !body1->isActive())) ||
+		   (woken1 && !body0->isActive());
+}
+
+
+void ChCollisionDispatcherParallel::dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo, btDispatcher* dispatcher)
+{
+	btBroadphasePairArray& pairs = pairCache->getOverlappingPairArray();
+	int npairs = pairs.size();
+
+	if ((num_threads < 2) ||
+		(npairs < CH_NARROWPHASE_CHUNK) ||
+		(dispatchInfo.m_dispatchFunc != btDispatcherInfo::DISPATCH_DISCRETE))
+	{
+		btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
+		return;
+	}
+
+	// 1- Serially create the missing algorithms, and sort pairs into tasks
+
+	task_start.clear();
+	task_pairs.clear();
+	keyed_pairs.clear();
+	serial_pairs.clear();
+
+	for (int ip = 0; ip < npairs; ip++)
+	{
+		btBroadphasePair& mpair = pairs[ip];
+		btCollisionObject* colObj0 = (btCollisionObject*)mpair.m_pProxy0->m_clientObject;
+		btCollisionObject* colObj1 = (btCollisionObject*)mpair.m_pProxy1->m_clientObject;
+
+		if (!needsCollision(colObj0,colObj1))
+			continue;
+		if (!mpair.m_algorithm)
+			mpair.m_algorithm = findAlgorithm(colObj0,colObj1);
+		if (!mpair.m_algorithm)
+			continue;
+
+		int type0 = colObj0->getCollisionShape()->getShapeType();
+		int type1 = colObj1->getCollisionShape()->getShapeType();
+		bool safe0 = IsSharedSafe(type0);
+		bool safe1 = IsSharedSafe(type1);
+
+		if (safe0 && safe1)
+		{
+			if (task_pairs.size() % CH_NARROWPHASE_CHUNK == 0)
+				task_start.push_back((int)task_pairs.size());
+			task_pairs.push_back(ip);
+		}
+		else if ((safe0 || safe1) && (type0 != GIMPACT_SHAPE_PROXYTYPE) && (type1 != GIMPACT_SHAPE_PROXYTYPE))
+		{
+			// group by the object that is modified by the algorithm (the unique id
+			// of its proxy is used, not the pointer, to have a reproducible order)
+			int mkey = safe0 ? mpair.m_pProxy1->m_uniqueId : mpair.m_pProxy0->m_uniqueId;
+			keyed_pairs.push_back(std::make_pair(mkey, ip));
+		}
+		else
+		{
+			serial_pairs.push_back(ip);
+		}
+	}
+
+	std::sort(keyed_pairs.begin(), keyed_pairs.end());
+	for (size_t i = 0; i < keyed_pairs.size(); i++)
+	{
+		if ((i == 0) || (keyed_pairs[i].first != keyed_pairs[i-1].first))
+			task_start.push_back((int)task_pairs.size());
+		task_pairs.push_back(keyed_pairs[i].second);
+	}
+
+	int ntasks = (int)task_start.size();
+	task_start.push_back((int)task_pairs.size());
+
+	if ((int)task_manifolds.size() < ntasks)
+		task_manifolds.resize(ntasks);
+
+	// 2- Process tasks in parallel
+
+	in_parallel = true;
+
+	#pragma omp parallel for schedule(dynamic) num_threads(this->num_threads)
+	for (int it = 0; it < ntasks; it++)
+	{
+		threads[CHOMPfunctions::GetThreadNum()].task = it;
+		for (int ip = task_start[it]; ip < task_start[it+1]; ip++)
+			(*getNearCallback())(pairs[task_pairs[ip]], *this, dispatchInfo);
+	}
+
+	in_parallel = false;
+
+	MergeParallelManifolds();
+
+	// 3- Process the pairs that must not run concurrently with others
+
+	for (size_t i = 0; i < serial_pairs.size(); i++)
+		(*getNearCallback())(pairs[serial_pairs[i]], *this, dispatchInfo);
+}
+
+
+void ChCollisionDispatcherParallel::MergeParallelManifolds()
+{
+	// Compact the array, keeping the order, where manifolds were released
+	int nkept = 0;
+	for (int i = 0; i < m_manifoldsPtr.size(); i++)
+	{
+		if (m_manifoldsPtr[i])
+		{
+			m_manifoldsPtr[nkept] = m_manifoldsPtr[i];
+			m_manifoldsPtr[nkept]->m_index1a = nkept;
+			nkept++;
+		}
+	}
+	m_manifoldsPtr.resize(nkept);
+
+	// Append new manifolds in task order
+	for (size_t it = 0; it < task_manifolds.size(); it++)
+	{
+		std::vector<btPersistentManifold*>& mlist = task_manifolds[it];
+		for (size_t k = 0; k < mlist.size(); k++)
+		{
+			mlist[k]->m_index1a = m_manifoldsPtr.size();
+			m_manifoldsPtr.push_back(mlist[k]);
+		}
+		mlist.clear();
+	}
+
+	// Free the memory of released manifolds
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		for (size_t k = 0; k < threads[i].released.size(); k++)
+			FreeManifoldMemory(threads[i].released[k]);
+		threads[i].released.clear();
+	}
+}
+
+
+
+} // END_OF_NAMESPACE____
+} // END_OF_NAMESPACE____
+
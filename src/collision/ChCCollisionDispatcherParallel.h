@@ -0,0 +1,132 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHC_COLLISIONDISPATCHERPARALLEL_H
+#define CHC_COLLISIONDISPATCHERPARALLEL_H
+
+//////////////////////////////////////////////////
+//
+//   ChCCollisionDispatcherParallel.h
+//
+//   Bullet collision dispatcher that runs the
+//   narrow phase on multiple threads.
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <vector>
+#include "core/ChApiCE.h"
+#include "parallel/ChOpenMP.h"
+#include "collision/bullet/btBulletCollisionCommon.h"
+#include "LinearMath/btPoolAllocator.h"
+
+
+namespace chrono
+{
+namespace collision
+{
+
+
+///
+/// Bullet collision dispatcher that processes the overlapping pairs
+/// of the broadphase in parallel, with OpenMP.
+/// Pairs between two convex shapes are split in fixed-size chunks;
+/// pairs where one object is compound or concave (whose algorithms
+/// temporarily change the shape of that object) are grouped per object,
+/// so that each object is touched by one thread only; the remaining
+/// pairs (GImpact meshes, or two non-convex objects) are processed
+/// serially at the end.
+/// Each thread allocates new persistent manifolds from its own pool;
+/// new manifolds are appended to the manifold array after the parallel
+/// phase, in pair order, so the result is deterministic and does not
+/// depend on the number of threads.
+/// Convex-convex algorithms are created with their own simplex solver
+/// instead of the one shared in the collision configuration, that must
+/// be a btDefaultCollisionConfiguration (or inherited): when creating
+/// the configuration, set m_customCollisionAlgorithmMaxElementSize to
+/// GetAlgorithmMaxElementSize() so that they fit the algorithm pool.
+///
+
+class ChApi ChCollisionDispatcherParallel : public btCollisionDispatcher
+{
+public:
+	ChCollisionDispatcherParallel(btCollisionConfiguration* collisionConfiguration, int nthreads = 1);
+	virtual ~ChCollisionDispatcherParallel();
+
+					/// Set the number of threads of the narrow phase. If 1, the
+					/// default serial Bullet dispatcher is used.
+	void SetNumThreads(int nthreads);
+	int  GetNumThreads() {return num_threads;}
+
+					/// Size in bytes of the largest algorithm created by this
+					/// dispatcher, to be used for the algorithm pool.
+	static int GetAlgorithmMaxElementSize();
+
+					/// Restrict the narrow phase to the pairs where an object is in
+					/// the given array, sorted by address, and the other is either in
+					/// the array or inactive (i.e. the pairs of objects just woken up, 
+					/// that were skipped when they were sleeping). Null to process all 
+					/// pairs as usual. The array is not copied.
+	void SetWokenObjects(std::vector<btCollisionObject*>* mwoken) {woken_objects = mwoken;}
+
+					// Bullet interface
+	virtual btPersistentManifold* getNewManifold(void* b0, void* b1);
+	virtual void releaseManifold(btPersistentManifold* manifold);
+	virtual void* allocateCollisionAlgorithm(int size);
+	virtual void freeCollisionAlgorithm(void* ptr);
+	virtual bool needsCollision(btCollisionObject* body0, btCollisionObject* body1);
+	virtual void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo, btDispatcher* dispatcher);
+
+private:
+	void FreeManifoldMemory(btPersistentManifold* manifold);
+	void MergeParallelManifolds();
+
+	struct ChThreadData
+	{
+		btPoolAllocator* manifold_pool;
+		int task;
+		std::vector<btPersistentManifold*> released;
+	};
+
+	int num_threads;
+	bool in_parallel;
+
+	std::vector<btCollisionObject*>* woken_objects;
+
+	std::vector<ChThreadData> threads;
+
+					// tasks of the parallel phase: ranges of pair indices
+	std::vector<int> task_start;
+	std::vector<int> task_pairs;
+	std::vector< std::vector<btPersistentManifold*> > task_manifolds;
+	std::vector< std::pair<int,int> > keyed_pairs;
+	std::vector<int> serial_pairs;
+
+	CHOMPmutex algorithm_mutex;
+
+	btCollisionAlgorithmCreateFunc* convex_func;
+	btCollisionAlgorithmCreateFunc* default_convex_func;
+};
+
+
+
+
+} // END_OF_NAMESPACE____
+} // END_OF_NAMESPACE____
+
+
+#endif
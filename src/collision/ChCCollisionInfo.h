@@ -49,6 +49,8 @@ public:
 	ChVector<> vN; 		      ///<  coll.normal, respect to A, in abs coords
 	double distance;		  ///<  distance (negative for penetration)
 	float* reaction_cache;	  ///<  pointer to some persistent user cache of reactions
+	int featureA;			  ///<  id of the feature of A in contact (ex. triangle of a mesh, child of a compound), or -1
+	int featureB;			  ///<  id of the feature of B in contact (ex. triangle of a mesh, child of a compound), or -1
 
 
 		/// Basic default constructor
@@ -59,6 +61,7 @@ public:
 			vN.Set(1,0,0);
 			distance = 0.;
 			reaction_cache=0;
+			featureA = featureB = -1;
 		}
 
 			/// Swap models, that is modelA becomes modelB and viceversa; 
@@ -74,6 +77,10 @@ public:
 			 vpA = vpB;
 			 vpB = vtemp;
 			vN = Vmul(vN, -1.0);
+			int ftemp;
+			 ftemp = featureA;
+			 featureA = featureB;
+			 featureB = ftemp;
 		}
 
 
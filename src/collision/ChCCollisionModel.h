@@ -185,6 +185,11 @@ public:
 		/// MUST be implemented by child classes!
   virtual void SyncPosition()=0;
 
+		/// Tell if the owner of this model is sleeping, i.e. it is not
+		/// moving: the contacts between two sleeping models are neither
+		/// computed again nor reported. By default it has no effect.
+  virtual void SetSleeping(bool msleeping) {};
+
 		/// By default, all collsion objects belong to family n.0, 
 		/// but you can set family in range 0..15. This is used when
 		/// the objects collided with another: the contact is created
@@ -28,15 +28,19 @@
 // ------------------------------------------------
 ///////////////////////////////////////////////////
 
+#include <vector>
+
 #include "collision/ChCCollisionInfo.h"
 #include "core/ChFrame.h"
 #include "core/ChApiCE.h"
+#include "core/ChProfiler.h"
 
 namespace chrono 
 {
 
 // forward references
 class ChBody; 
+class ChStateSnapshot;
 class ChLcpVariablesBody;
 class ChContactContainerBase;
 class ChProximityContainerBase;
@@ -112,6 +116,7 @@ class ChApi ChCollisionSystem
 				{
 					narrow_callback=0;
 					broad_callback=0;
+					profiler=0;
 				};
 
 	virtual ~ChCollisionSystem() {};
@@ -120,6 +125,16 @@ class ChApi ChCollisionSystem
 					/// if any (like persistent contact manifolds)
     virtual void Clear(void) = 0;
 
+					/// Save the data of the collision engine that persists between
+					/// steps, if any (like the multipliers cached in the persistent
+					/// contact points for warm starting) in a state snapshot.
+					/// Used by ChSystem::StateSave(). By default nothing is saved.
+	virtual void StateSave(ChStateSnapshot& msnapshot) {};
+
+					/// Restore the data saved by StateSave(). Used by
+					/// ChSystem::StateRestore(). By default, Clear() is called.
+	virtual void StateRestore(ChStateSnapshot& msnapshot) { Clear(); };
+
 					/// Adds a collision model to the collision
 					/// engine (custom data may be allocated).
     virtual void Add(ChCollisionModel* model) = 0;
@@ -138,6 +153,14 @@ class ChApi ChCollisionSystem
 					/// Children classes _must_ implement this.
 	virtual void Run() = 0;
 
+					/// After Run(), find again the contacts of the given models,
+					/// that were sleeping at Run() and were woken up since, with each
+					/// other and with the models that are still sleeping: the narrow 
+					/// phase skips the pairs of sleeping models. Used by ChSystem 
+					/// when it wakes up islands of bodies, before reporting the 
+					/// contacts again. By default, Run() is repeated.
+	virtual void RunWoken(std::vector<ChCollisionModel*>& mwoken) { Run(); }
+
 					/// After the Run() has completed, you can call this function to
 					/// fill a 'contact container', that is an object inherited from class 
 					/// ChContactContainerBase. For instance ChSystem, after each Run()
@@ -175,6 +198,12 @@ class ChApi ChCollisionSystem
 					/// to report the contacts found during the Run()
 					/// execution. It will be executed for each contact point.
 	void SetNarrowPhaseCallback(ChNarrowPhaseCallback* mcallback) {narrow_callback = mcallback;}
+
+					/// Sets the profiler where the phases of Run() are recorded 
+					/// as nested scopes, if the implementation supports it. Use 0 
+					/// for no profiling. Usually set by ChSystem::SetProfiler().
+	void SetProfiler(ChProfiler* mprofiler) {profiler = mprofiler;}
+	ChProfiler* GetProfiler() {return profiler;}
 					
 
 					/// This will be used to recover results from RayHit() raycasting
@@ -194,6 +223,7 @@ protected:
 
 	ChBroadPhaseCallback*  broad_callback;	// user callback for each near-enough pair of shapes 
 	ChNarrowPhaseCallback* narrow_callback;	// user callback for each contact	
+	ChProfiler* profiler;					// profiler of the phases, if any
 };
 
 
@@ -19,13 +19,19 @@
 ///////////////////////////////////////////////////
    
  
+#include <algorithm>
+#include <map>
+
 #include "collision/ChCCollisionSystemBullet.h"
 #include "collision/ChCModelBullet.h"
+#include "collision/ChCBroadphaseHashGrid.h"
 #include "collision/gimpact/GIMPACT/Bullet/btGImpactCollisionAlgorithm.h"
 #include "physics/ChBody.h"
 #include "physics/ChContactContainerBase.h"
 #include "physics/ChProximityContainerBase.h"
+#include "physics/ChStateSnapshot.h"
 #include "LinearMath/btPoolAllocator.h"
+#include "parallel/ChOpenMP.h"
 
 namespace chrono 
 {
@@ -42,23 +48,20 @@ void defaultChronoNearCallback(btBroadphasePair& collisionPair, btCollisionDispa
 }
 */
 
-ChCollisionSystemBullet::ChCollisionSystemBullet(unsigned int max_objects, double scene_size)
+ChCollisionSystemBullet::ChCollisionSystemBullet(unsigned int max_objects, double scene_size, eCh_broadphaseType mbroadphase)
 {
-	// btDefaultCollisionConstructionInfo conf_info(...); ***TODO***
-	bt_collision_configuration = new btDefaultCollisionConfiguration(); 
-	bt_dispatcher = new btCollisionDispatcher(bt_collision_configuration);  
-	
-	  //***OLD***
-	
-	btScalar sscene_size = (btScalar)scene_size;
-	 btVector3	worldAabbMin(-sscene_size,-sscene_size,-sscene_size);
-	 btVector3	worldAabbMax(sscene_size,sscene_size,sscene_size);
-	bt_broadphase = new bt32BitAxisSweep3(worldAabbMin,worldAabbMax, max_objects, 0, true); // true for disabling raycast accelerator
-	
-	  //***NEW***
-	//bt_broadphase = new btDbvtBroadphase();
-
+	num_threads = CHOMPfunctions::GetNumProcs(); // default n.threads as n.cores
 
+	// the algorithm pool must fit the convex-convex algorithms of the parallel dispatcher
+	btDefaultCollisionConstructionInfo conf_info;
+	conf_info.m_customCollisionAlgorithmMaxElementSize = ChCollisionDispatcherParallel::GetAlgorithmMaxElementSize();
+	bt_collision_configuration = new btDefaultCollisionConfiguration(conf_info); 
+	bt_dispatcher = new ChCollisionDispatcherParallel(bt_collision_configuration, num_threads);  
+	
+	sap_max_objects = max_objects;
+	sap_scene_size = scene_size;
+	broadphase_type = mbroadphase;
+	bt_broadphase = CreateBroadphase(mbroadphase);
 
 	bt_collision_world = new btCollisionWorld(bt_dispatcher, bt_broadphase, bt_collision_configuration);
 
@@ -78,6 +81,60 @@ ChCollisionSystemBullet::~ChCollisionSystemBullet()
 	if(bt_collision_configuration) delete bt_collision_configuration;
 }
 
+btBroadphaseInterface* ChCollisionSystemBullet::CreateBroadphase(eCh_broadphaseType mbroadphase)
+{
+	switch (mbroadphase)
+	{
+	case BROADPHASE_DBVT:
+		return new btDbvtBroadphase();
+	case BROADPHASE_HASHGRID:
+		return new ChBroadphaseHashGrid();
+	default:
+		{
+		btScalar sscene_size = (btScalar)sap_scene_size;
+		btVector3	worldAabbMin(-sscene_size,-sscene_size,-sscene_size);
+		btVector3	worldAabbMax(sscene_size,sscene_size,sscene_size);
+		return new bt32BitAxisSweep3(worldAabbMin,worldAabbMax, sap_max_objects, 0, true); // true for disabling raycast accelerator
+		}
+	}
+}
+
+void ChCollisionSystemBullet::SetBroadphase(eCh_broadphaseType mbroadphase)
+{
+	if (mbroadphase == broadphase_type)
+		return;
+
+	// Remove all objects from the old broadphase, remembering their collision filters
+	btCollisionObjectArray& mobjects = bt_collision_world->getCollisionObjectArray();
+	std::vector<btCollisionObject*> mlist;
+	std::vector<short int> mgroups;
+	std::vector<short int> mmasks;
+	for (int i = 0; i < mobjects.size(); i++)
+	{
+		mlist.push_back(mobjects[i]);
+		mgroups.push_back(mobjects[i]->getBroadphaseHandle()->m_collisionFilterGroup);
+		mmasks.push_back(mobjects[i]->getBroadphaseHandle()->m_collisionFilterMask);
+	}
+	for (size_t i = 0; i < mlist.size(); i++)
+		bt_collision_world->removeCollisionObject(mlist[i]);
+
+	delete bt_broadphase;
+	broadphase_type = mbroadphase;
+	bt_broadphase = CreateBroadphase(mbroadphase);
+	bt_collision_world->setBroadphase(bt_broadphase);
+
+	for (size_t i = 0; i < mlist.size(); i++)
+		bt_collision_world->addCollisionObject(mlist[i], mgroups[i], mmasks[i]);
+}
+
+void ChCollisionSystemBullet::SetNumThreads(int nthreads)
+{
+	if (nthreads < 1)
+		nthreads = 1;
+	num_threads = nthreads;
+	bt_dispatcher->SetNumThreads(nthreads);
+}
+
 void ChCollisionSystemBullet::Clear(void)
 {
 	int numManifolds = bt_collision_world->getDispatcher()->getNumManifolds();
@@ -86,7 +143,107 @@ void ChCollisionSystemBullet::Clear(void)
 		btPersistentManifold* contactManifold =  bt_collision_world->getDispatcher()->getManifoldByIndexInternal(i);
 		contactManifold->clearManifold();
 	}
+	saved_points.clear();
 }   
+
+void ChCollisionSystemBullet::StateSave(ChStateSnapshot& msnapshot)
+{
+	btCollisionObjectArray& mobjects = bt_collision_world->getCollisionObjectArray();
+	std::map<const btCollisionObject*, int> mindex;
+	for (int i = 0; i < mobjects.size(); i++)
+		mindex[mobjects[i]] = i;
+
+	int mcount = msnapshot.Reserve();
+	int nsaved = 0;
+
+	int numManifolds = bt_dispatcher->getNumManifolds();
+	for (int i = 0; i < numManifolds; i++)
+	{
+		btPersistentManifold* contactManifold = bt_dispatcher->getManifoldByIndexInternal(i);
+		std::map<const btCollisionObject*, int>::iterator iA = mindex.find((const btCollisionObject*)contactManifold->getBody0());
+		std::map<const btCollisionObject*, int>::iterator iB = mindex.find((const btCollisionObject*)contactManifold->getBody1());
+		if (iA == mindex.end() || iB == mindex.end())
+			continue;
+		for (int j = 0; j < contactManifold->getNumContacts(); j++)
+		{
+			btManifoldPoint& pt = contactManifold->getContactPoint(j);
+			msnapshot.Add(iA->second);
+			msnapshot.Add(iB->second);
+			msnapshot.Add(ChVector<>(pt.m_localPointA.x(), pt.m_localPointA.y(), pt.m_localPointA.z()));
+			msnapshot.Add(ChVector<>(pt.m_localPointB.x(), pt.m_localPointB.y(), pt.m_localPointB.z()));
+			for (int k = 0; k < 6; k++)
+				msnapshot.Add(pt.reactions_cache[k]);
+			nsaved++;
+		}
+	}
+
+	msnapshot.SetAt(mcount, nsaved);
+}
+
+void ChCollisionSystemBullet::StateRestore(ChStateSnapshot& msnapshot)
+{
+	Clear();
+
+	btCollisionObjectArray& mobjects = bt_collision_world->getCollisionObjectArray();
+	int nsaved = (int)msnapshot.Get();
+	saved_points.resize(nsaved);
+	ChVector<> mv;
+	for (int i = 0; i < nsaved; i++)
+	{
+		ChSavedPoint& msaved = saved_points[i];
+		int iA = (int)msnapshot.Get();
+		int iB = (int)msnapshot.Get();
+		if (iA < 0 || iB < 0 || iA >= mobjects.size() || iB >= mobjects.size())
+			throw ChException("The state snapshot does not match the system");
+		msaved.objA = mobjects[iA];
+		msaved.objB = mobjects[iB];
+		msnapshot.Get(mv);
+		msaved.pointA = btVector3((btScalar)mv.x, (btScalar)mv.y, (btScalar)mv.z);
+		msnapshot.Get(mv);
+		msaved.pointB = btVector3((btScalar)mv.x, (btScalar)mv.y, (btScalar)mv.z);
+		for (int k = 0; k < 6; k++)
+			msaved.reactions_cache[k] = (float)msnapshot.Get();
+	}
+	std::stable_sort(saved_points.begin(), saved_points.end());
+}
+
+void ChCollisionSystemBullet::MatchSavedPoints()
+{
+	int numManifolds = bt_dispatcher->getNumManifolds();
+	for (int i = 0; i < numManifolds; i++)
+	{
+		btPersistentManifold* contactManifold = bt_dispatcher->getManifoldByIndexInternal(i);
+		ChSavedPoint mkey;
+		mkey.objA = (btCollisionObject*)contactManifold->getBody0();
+		mkey.objB = (btCollisionObject*)contactManifold->getBody1();
+		std::pair<std::vector<ChSavedPoint>::iterator, std::vector<ChSavedPoint>::iterator> mrange =
+			std::equal_range(saved_points.begin(), saved_points.end(), mkey);
+		if (mrange.first == mrange.second)
+			continue;
+
+		btScalar mthreshold2 = contactManifold->getContactBreakingThreshold() * contactManifold->getContactBreakingThreshold();
+		for (int j = 0; j < contactManifold->getNumContacts(); j++)
+		{
+			btManifoldPoint& pt = contactManifold->getContactPoint(j);
+			std::vector<ChSavedPoint>::iterator mnearest = mrange.second;
+			btScalar mdist2 = mthreshold2;
+			for (std::vector<ChSavedPoint>::iterator it = mrange.first; it != mrange.second; ++it)
+			{
+				btScalar d2 = btMax((it->pointA - pt.m_localPointA).length2(),
+									(it->pointB - pt.m_localPointB).length2());
+				if (d2 < mdist2)
+				{
+					mdist2 = d2;
+					mnearest = it;
+				}
+			}
+			if (mnearest != mrange.second)
+				for (int k = 0; k < 6; k++)
+					pt.reactions_cache[k] = mnearest->reactions_cache[k];
+		}
+	}
+	saved_points.clear();
+}
 				
 
 
@@ -114,83 +271,206 @@ void ChCollisionSystemBullet::Run()
 {
 	if (bt_collision_world)
 	{
-		bt_collision_world->performDiscreteCollisionDetection(); 
+		// Same as bt_collision_world->performDiscreteCollisionDetection(), 
+		// but with the phases in separate scopes of the profiler, if any.
+		{
+			ChProfileScope mscope(profiler, "AABB update");
+			bt_collision_world->updateAabbs();
+		}
+		btBroadphaseInterface* mbroadphase = bt_collision_world->getBroadphase();
+		{
+			ChProfileScope mscope(profiler, "Broadphase");
+			mbroadphase->calculateOverlappingPairs(bt_dispatcher);
+			if (profiler)
+				profiler->SetCounter("pairs", mbroadphase->getOverlappingPairCache()->getNumOverlappingPairs());
+		}
+		{
+			ChProfileScope mscope(profiler, "Narrowphase");
+			bt_dispatcher->dispatchAllCollisionPairs(mbroadphase->getOverlappingPairCache(), bt_collision_world->getDispatchInfo(), bt_dispatcher);
+			if (profiler)
+				profiler->SetCounter("manifolds", bt_dispatcher->getNumManifolds());
+		}
+		if (!saved_points.empty())
+			MatchSavedPoints();
 	}
 }
 
 
+void ChCollisionSystemBullet::RunWoken(std::vector<ChCollisionModel*>& mwoken)
+{
+	if (!bt_collision_world)
+		return;
+
+	woken_objects.clear();
+	for (size_t i = 0; i < mwoken.size(); i++)
+		if (((ChModelBullet*)mwoken[i])->GetBulletModel()->getCollisionShape())
+			woken_objects.push_back(((ChModelBullet*)mwoken[i])->GetBulletModel());
+	std::sort(woken_objects.begin(), woken_objects.end());
+
+	// The woken objects did not move while sleeping, so the broadphase
+	// pairs are still valid: only the narrow phase of their pairs is done.
+	ChProfileScope mscope(profiler, "Narrowphase woken");
+	bt_dispatcher->SetWokenObjects(&woken_objects);
+	bt_dispatcher->dispatchAllCollisionPairs(bt_collision_world->getBroadphase()->getOverlappingPairCache(), bt_collision_world->getDispatchInfo(), bt_dispatcher);
+	bt_dispatcher->SetWokenObjects(0);
+}
+
+
+void ChCollisionSystemBullet::SortManifolds()
+{
+	btDispatcher* mdispatcher = bt_collision_world->getDispatcher();
+	int numManifolds = mdispatcher->getNumManifolds();
+
+	report_order.resize(numManifolds);
+
+	// refresh manifolds, count valid points and compute the keys, in parallel
+
+	#pragma omp parallel for num_threads(this->num_threads)
+	for (int i=0;i<numManifolds;i++)
+	{
+		btPersistentManifold* contactManifold =  mdispatcher->getManifoldByIndexInternal(i);
+		btCollisionObject* obA = static_cast<btCollisionObject*>(contactManifold->getBody0());
+		btCollisionObject* obB = static_cast<btCollisionObject*>(contactManifold->getBody1());
+		contactManifold->refreshContactPoints(obA->getWorldTransform(),obB->getWorldTransform());
+
+		double marginA = ((ChCollisionModel*)obA->getUserPointer())->GetSafeMargin();
+		double marginB = ((ChCollisionModel*)obB->getUserPointer())->GetSafeMargin();
+
+		// The narrow phase skips pairs of inactive (sleeping) objects,
+		// whose manifolds keep the old points: these are not reported.
+		int nvalid = 0;
+		int numContacts = contactManifold->getNumContacts();
+		if (!obA->isActive() && !obB->isActive())
+			numContacts = 0;
+		for (int j=0;j<numContacts;j++)
+		{
+			if (contactManifold->getContactPoint(j).getDistance() < marginA+marginB) // to discard "too far" constraints (the Bullet engine also has its threshold)
+				nvalid++;
+		}
+
+		ChManifoldKey& mkey = report_order[i];
+		mkey.idA = obA->getBroadphaseHandle()->m_uniqueId;
+		mkey.idB = obB->getBroadphaseHandle()->m_uniqueId;
+		mkey.featureA = numContacts ? contactManifold->getContactPoint(0).m_index0 : -1;
+		mkey.featureB = numContacts ? contactManifold->getContactPoint(0).m_index1 : -1;
+		mkey.manifold = i;
+		mkey.nvalid = nvalid;
+	}
+
+	std::sort(report_order.begin(), report_order.end());
+}
+
+
 void ChCollisionSystemBullet::ReportContacts(ChContactContainerBase* mcontactcontainer)
 {
 	// This should remove all old contacts (or at least rewind the index)
 	mcontactcontainer->BeginAddContact();
 
-	ChCollisionInfo icontact;
+	btDispatcher* mdispatcher = bt_collision_world->getDispatcher();
+	int numManifolds = mdispatcher->getNumManifolds();
 
-	int numManifolds = bt_collision_world->getDispatcher()->getNumManifolds();
-	for (int i=0;i<numManifolds;i++)
+	// The contact points are converted into ChCollisionInfo in parallel, 
+	// in a buffer where the points of the k-th manifold of report_order start 
+	// at report_offsets[k]. Then the callbacks and the contact container are 
+	// called serially, in that order, as these are not thread-safe.
+
+	// 1- refresh manifolds, count valid points, and sort manifolds
+
+	SortManifolds();
+
+	report_offsets.resize(numManifolds+1);
+	report_offsets[0] = 0;
+	for (int k=0;k<numManifolds;k++)
+		report_offsets[k+1] = report_offsets[k] + report_order[k].nvalid;
+
+	report_contacts.resize(report_offsets[numManifolds]);
+
+	// 2- fill the buffer
+
+	#pragma omp parallel for num_threads(this->num_threads)
+	for (int k=0;k<numManifolds;k++)
 	{
-		btPersistentManifold* contactManifold =  bt_collision_world->getDispatcher()->getManifoldByIndexInternal(i);
+		btPersistentManifold* contactManifold =  mdispatcher->getManifoldByIndexInternal(report_order[k].manifold);
 		btCollisionObject* obA = static_cast<btCollisionObject*>(contactManifold->getBody0());
 		btCollisionObject* obB = static_cast<btCollisionObject*>(contactManifold->getBody1());
-		contactManifold->refreshContactPoints(obA->getWorldTransform(),obB->getWorldTransform());
-	 
-		icontact.modelA = (ChCollisionModel*)obA->getUserPointer();
-		icontact.modelB = (ChCollisionModel*)obB->getUserPointer();
 
-		double envelopeA = icontact.modelA->GetEnvelope();
-		double envelopeB = icontact.modelB->GetEnvelope();
+		ChCollisionModel* modelA = (ChCollisionModel*)obA->getUserPointer();
+		ChCollisionModel* modelB = (ChCollisionModel*)obB->getUserPointer();
+
+		double envelopeA = modelA->GetEnvelope();
+		double envelopeB = modelB->GetEnvelope();
 		
-		double marginA = icontact.modelA->GetSafeMargin();
-		double marginB = icontact.modelB->GetSafeMargin();
+		double marginA = modelA->GetSafeMargin();
+		double marginB = modelB->GetSafeMargin();
+
+		int ic = report_offsets[k];
+		int numContacts = contactManifold->getNumContacts();
+
+		for (int j=0;j<numContacts;j++)
+		{
+			btManifoldPoint& pt = contactManifold->getContactPoint(j);
+
+			if (pt.getDistance() < marginA+marginB)
+			{
+				ChCollisionInfo& icontact = report_contacts[ic];
+				icontact.modelA = modelA;
+				icontact.modelB = modelB;
+
+				btVector3 ptA = pt.getPositionWorldOnA();
+				btVector3 ptB = pt.getPositionWorldOnB(); 
+				
+				icontact.vpA.Set(ptA.getX(), ptA.getY(), ptA.getZ());
+				icontact.vpB.Set(ptB.getX(), ptB.getY(), ptB.getZ());
+				
+				icontact.vN.Set( -pt.m_normalWorldOnB.getX(), 
+								 -pt.m_normalWorldOnB.getY(),
+								 -pt.m_normalWorldOnB.getZ());
+				icontact.vN.Normalize(); 
+
+				double ptdist = pt.getDistance();
+
+				icontact.vpA = icontact.vpA - icontact.vN*envelopeA;
+				icontact.vpB = icontact.vpB + icontact.vN*envelopeB;
+				icontact.distance = ptdist + envelopeA + envelopeB;	
+
+				icontact.reaction_cache = pt.reactions_cache;
+				icontact.featureA = pt.m_index0;
+				icontact.featureB = pt.m_index1;
+				ic++;
+			}
+		}
+	}
+
+	// 3- callbacks and contact container, serially
 
+	for (int k=0;k<numManifolds;k++)
+	{
 		// Execute custom broadphase callback, if any
 		bool do_narrow_contactgeneration = true;
 		if (this->broad_callback)
-			do_narrow_contactgeneration = this->broad_callback->BroadCallback(icontact.modelA, icontact.modelB);
+		{
+			btPersistentManifold* contactManifold =  mdispatcher->getManifoldByIndexInternal(report_order[k].manifold);
+			do_narrow_contactgeneration = this->broad_callback->BroadCallback(
+						(ChCollisionModel*)static_cast<btCollisionObject*>(contactManifold->getBody0())->getUserPointer(),
+						(ChCollisionModel*)static_cast<btCollisionObject*>(contactManifold->getBody1())->getUserPointer());
+		}
 
 		if (do_narrow_contactgeneration)
 		{
-			int numContacts = contactManifold->getNumContacts();
-
-			for (int j=0;j<numContacts;j++)
+			for (int ic = report_offsets[k]; ic < report_offsets[k+1]; ic++)
 			{
-				btManifoldPoint& pt = contactManifold->getContactPoint(j);
+				ChCollisionInfo& icontact = report_contacts[ic];
 
-				if (pt.getDistance() < marginA+marginB) // to discard "too far" constraints (the Bullet engine also has its threshold)
-				{
-					btVector3 ptA = pt.getPositionWorldOnA();
-					btVector3 ptB = pt.getPositionWorldOnB(); 
-					
-					icontact.vpA.Set(ptA.getX(), ptA.getY(), ptA.getZ());
-					icontact.vpB.Set(ptB.getX(), ptB.getY(), ptB.getZ());
-					
-					icontact.vN.Set( -pt.m_normalWorldOnB.getX(), 
-									 -pt.m_normalWorldOnB.getY(),
-									 -pt.m_normalWorldOnB.getZ());
-					icontact.vN.Normalize(); 
-
-					double ptdist = pt.getDistance();
-
-					icontact.vpA = icontact.vpA - icontact.vN*envelopeA;
-					icontact.vpB = icontact.vpB + icontact.vN*envelopeB;
-					icontact.distance = ptdist + envelopeA + envelopeB;	
-
-					icontact.reaction_cache = pt.reactions_cache;
-
-					// Execute some user custom callback, if any
-					if (this->narrow_callback)
-						this->narrow_callback->NarrowCallback(icontact);
-
-					// Add to contact container
-					mcontactcontainer->AddContact(icontact); 
-				}
+				// Execute some user custom callback, if any
+				if (this->narrow_callback)
+					this->narrow_callback->NarrowCallback(icontact);
 
+				// Add to contact container
+				mcontactcontainer->AddContact(icontact); 
 			}
 		}
-
-		//you can un-comment out this line, and then all points are removed
-		//contactManifold->clearManifold();	
 	}
+
 	mcontactcontainer->EndAddContact();
 }
 
@@ -199,17 +479,22 @@ void ChCollisionSystemBullet::ReportProximities(ChProximityContainerBase* mproxi
 {
 	mproximitycontainer->BeginAddProximities();
 
+	SortManifolds();
+
 	int numManifolds = bt_collision_world->getDispatcher()->getNumManifolds();
-	for (int i=0;i<numManifolds;i++)
+	for (int k=0;k<numManifolds;k++)
 	{
-		btPersistentManifold* contactManifold =  bt_collision_world->getDispatcher()->getManifoldByIndexInternal(i);
+		btPersistentManifold* contactManifold =  bt_collision_world->getDispatcher()->getManifoldByIndexInternal(report_order[k].manifold);
 		btCollisionObject* obA = static_cast<btCollisionObject*>(contactManifold->getBody0());
 		btCollisionObject* obB = static_cast<btCollisionObject*>(contactManifold->getBody1());
-		contactManifold->refreshContactPoints(obA->getWorldTransform(),obB->getWorldTransform());
 	 
 		ChCollisionModel* modelA = (ChCollisionModel*)obA->getUserPointer();
 		ChCollisionModel* modelB = (ChCollisionModel*)obB->getUserPointer();
 
+		// skip the old manifolds of inactive pairs, as in ReportContacts()
+		if (!obA->isActive() && !obB->isActive())
+			continue;
+
 		// Add to proximity container
 		mproximitycontainer->AddProximity(modelA, modelB);
 	}
@@ -30,7 +30,9 @@
 
 #include "core/ChApiCE.h"
 #include "collision/ChCCollisionSystem.h"
+#include "collision/ChCCollisionDispatcherParallel.h"
 #include "collision/bullet/btBulletCollisionCommon.h" 
+#include <vector>
 
 
 namespace chrono 
@@ -43,19 +45,45 @@ namespace collision
 /// Class for collision engine based on the 'Bullet' library.
 /// Contains either the broadphase and the narrow phase Bullet
 /// methods.
+/// The narrow phase and the conversion of Bullet contact points
+/// in ReportContacts() run on multiple threads, see SetNumThreads().
 /// 
 
 class ChApi ChCollisionSystemBullet : public ChCollisionSystem
 {
   public:
 
-	ChCollisionSystemBullet(unsigned int max_objects = 16000, double scene_size = 500);
+					/// Available broadphase algorithms
+	enum eCh_broadphaseType { 
+		BROADPHASE_SAP = 0,		///< sweep and prune (bt32BitAxisSweep3), limited to max_objects in a cube of half-size scene_size
+		BROADPHASE_DBVT,		///< dynamic AABB tree (btDbvtBroadphase), unbounded
+		BROADPHASE_HASHGRID		///< multi-level uniform hash grid (ChBroadphaseHashGrid), unbounded
+	};
+
+	ChCollisionSystemBullet(unsigned int max_objects = 16000, double scene_size = 500, eCh_broadphaseType mbroadphase = BROADPHASE_SAP);
 	virtual ~ChCollisionSystemBullet();
 
+					/// Change the broadphase algorithm. This can be done also when
+					/// collision models were already added: they are moved to the new
+					/// broadphase (persistent contact manifolds are lost, though).
+	void SetBroadphase(eCh_broadphaseType mbroadphase);
+	eCh_broadphaseType GetBroadphase() {return broadphase_type;}
+
 					/// Clears all data instanced by this algorithm
 					/// if any (like persistent contact manifolds)
     virtual void Clear(void);
 
+					/// Save the multipliers cached in the persistent contact points,
+					/// for warm starting, with the two objects of each point (as
+					/// indexes in the collision world) and its local positions.
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+
+					/// Clear the persistent contact points, and keep the multipliers
+					/// saved by StateSave(): at the next Run(), each new point takes the
+					/// multipliers of the nearest saved point of the same two objects,
+					/// if closer than the contact breaking threshold.
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 					/// Adds a collision model to the collision
 					/// engine (custom data may be allocated).
     virtual void Add(ChCollisionModel* model);
@@ -72,6 +100,11 @@ class ChApi ChCollisionSystemBullet : public ChCollisionSystem
 					/// (Contacts will be managed by the Bullet persistent contact cache).
 	virtual void Run();
 
+					/// Run the narrow phase again only for the pairs of the woken
+					/// models with each other and with the sleeping ones (the pairs
+					/// that Run() skipped), without updating the broadphase.
+	virtual void RunWoken(std::vector<ChCollisionModel*>& mwoken);
+
 					/// After the Run() has completed, you can call this function to
 					/// fill a 'contact container', that is an object inherited from class 
 					/// ChContactContainerBase. For instance ChSystem, after each Run()
@@ -91,6 +124,15 @@ class ChApi ChCollisionSystemBullet : public ChCollisionSystem
 	virtual void ReportProximities(ChProximityContainerBase* mproximitycontainer);
 
 
+					/// Set the number of threads used by the narrow phase and by
+					/// ReportContacts(). Results do not depend on the number of threads:
+					/// the dispatcher may create the manifolds in a different order, but
+					/// ReportContacts() and ReportProximities() sort them by the unique ids
+					/// of the two objects, so contacts are always reported in the same order.
+					/// ChSystem::SetParallelThreadNumber() also sets this.
+	void SetNumThreads(int nthreads);
+	int  GetNumThreads() {return num_threads;}
+
 					/// Perform a raycast (ray-hit test with the collision models).
 	virtual bool RayHit(const ChVector<>& from, const ChVector<>& to, ChRayhitResult& mresult);
 
@@ -99,10 +141,71 @@ class ChApi ChCollisionSystemBullet : public ChCollisionSystem
 
 private:
 	btCollisionConfiguration* bt_collision_configuration;
-	btCollisionDispatcher*  bt_dispatcher;
+	ChCollisionDispatcherParallel*  bt_dispatcher;
 	btBroadphaseInterface*	bt_broadphase;
 	btCollisionWorld*		bt_collision_world; 
 
+	int num_threads;
+
+	eCh_broadphaseType broadphase_type;
+	unsigned int sap_max_objects;
+	double sap_scene_size;
+
+	btBroadphaseInterface* CreateBroadphase(eCh_broadphaseType mbroadphase);
+
+					// A manifold, with the key that sorts the manifolds in an order that
+					// does not depend on the dispatcher: the unique ids of the broadphase 
+					// proxies of the two objects, then (for the many manifolds of a pair with 
+					// compound shapes) the features of the first point.
+	struct ChManifoldKey
+	{
+		int idA;
+		int idB;
+		int featureA;
+		int featureB;
+		int manifold;	// index in the dispatcher
+		int nvalid;		// number of points to report
+		bool operator<(const ChManifoldKey& other) const
+		{
+			if (idA != other.idA) return idA < other.idA;
+			if (idB != other.idB) return idB < other.idB;
+			if (featureA != other.featureA) return featureA < other.featureA;
+			if (featureB != other.featureB) return featureB < other.featureB;
+			return manifold < other.manifold;
+		}
+	};
+
+					// Refresh the points of the manifolds and sort them in report_order.
+	void SortManifolds();
+
+					// A contact point saved by StateSave(), waiting to be matched
+					// by the first Run() after StateRestore().
+	struct ChSavedPoint
+	{
+		btCollisionObject* objA;
+		btCollisionObject* objB;
+		btVector3 pointA;	// local, in objA
+		btVector3 pointB;	// local, in objB
+		float reactions_cache[6];
+		bool operator<(const ChSavedPoint& other) const
+		{
+			if (objA != other.objA) return objA < other.objA;
+			return objB < other.objB;
+		}
+	};
+
+					// Copy the multipliers of saved_points to the matching new
+					// points of the manifolds, then discard saved_points.
+	void MatchSavedPoints();
+
+	std::vector<ChSavedPoint> saved_points;	// sorted by pair of objects
+
+					// buffers of ReportContacts(), kept to avoid reallocations
+	std::vector<ChManifoldKey> report_order;
+	std::vector<btCollisionObject*> woken_objects;
+	std::vector<int> report_offsets;
+	std::vector<ChCollisionInfo> report_contacts;
+
 };
 
 
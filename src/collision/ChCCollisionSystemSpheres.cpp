@@ -19,17 +19,165 @@
 ///////////////////////////////////////////////////
    
  
+#include <math.h>
+#include <float.h>
+#include <string.h>
 #include "collision/ChCCollisionSystemSpheres.h"
 #include "collision/ChCModelSphereSet.h"
 #include "physics/ChBody.h"
 #include "physics/ChContactContainerBase.h"
 #include "physics/ChProximityContainerBase.h"
+#include "parallel/ChOpenMP.h"
 
 namespace chrono 
 {
 namespace collision 
 {
 
+
+// Max number of bins per axis, so that the index of a bin fits 30 bits
+static const int MAX_BINS_PER_AXIS = 1024;
+
+// Below this size, scans and sorts are done on a single thread
+static const int MIN_PARALLEL_SIZE = 4096;
+
+
+// Exclusive prefix sum of data[0..n), on 'nblocks' blocks processed
+// in parallel. Returns the total. 'sums' is a work buffer.
+
+static uint ParallelExclusiveScan(uint* data, int n, int nblocks, std::vector<uint>& sums)
+{
+	if (n < MIN_PARALLEL_SIZE)
+		nblocks = 1;
+	sums.resize(nblocks);
+
+	#pragma omp parallel for num_threads(nblocks)
+	for (int b = 0; b < nblocks; b++)
+	{
+		int start = (int)(((long long)n * b) / nblocks);
+		int end   = (int)(((long long)n * (b+1)) / nblocks);
+		uint sum = 0;
+		for (int i = start; i < end; i++)
+			sum += data[i];
+		sums[b] = sum;
+	}
+
+	uint total = 0;
+	for (int b = 0; b < nblocks; b++)
+	{
+		uint sum = sums[b];
+		sums[b] = total;
+		total += sum;
+	}
+
+	#pragma omp parallel for num_threads(nblocks)
+	for (int b = 0; b < nblocks; b++)
+	{
+		int start = (int)(((long long)n * b) / nblocks);
+		int end   = (int)(((long long)n * (b+1)) / nblocks);
+		uint sum = sums[b];
+		for (int i = start; i < end; i++)
+		{
+			uint val = data[i];
+			data[i] = sum;
+			sum += val;
+		}
+	}
+	return total;
+}
+
+
+// Stable LSD radix sort of keys[0..n), all not larger than max_key, 
+// with 8 bits per pass; values are moved along with their keys. Each of
+// the 'nblocks' blocks builds the histogram of its range and scatters it,
+// in parallel; offsets are assigned in block order, to keep stability.
+// The 'tmp' vectors, as large as the others, are used as double buffers.
+
+static void ParallelRadixSort(std::vector<uint>& keys, std::vector<uint>& values,
+							  std::vector<uint>& keys_tmp, std::vector<uint>& values_tmp,
+							  int n, uint max_key, int nblocks, std::vector<uint>& hist)
+{
+	if (n < 2)
+		return;
+	if (n < MIN_PARALLEL_SIZE)
+		nblocks = 1;
+	hist.resize(nblocks * 256);
+
+	for (int shift = 0; shift < 32 && (max_key >> shift) > 0; shift += 8)
+	{
+		const uint* src_keys = &keys[0];
+		const uint* src_values = &values[0];
+		uint* dst_keys = &keys_tmp[0];
+		uint* dst_values = &values_tmp[0];
+		uint* mhist = &hist[0];
+
+		#pragma omp parallel for num_threads(nblocks)
+		for (int b = 0; b < nblocks; b++)
+		{
+			int start = (int)(((long long)n * b) / nblocks);
+			int end   = (int)(((long long)n * (b+1)) / nblocks);
+			uint* bhist = mhist + b * 256;
+			memset(bhist, 0, 256 * sizeof(uint));
+			for (int i = start; i < end; i++)
+				bhist[(src_keys[i] >> shift) & 0xFF]++;
+		}
+
+		// skip the pass if all keys have the same digit
+		bool same_digit = false;
+		for (int d = 0; d < 256; d++)
+		{
+			uint count = 0;
+			for (int b = 0; b < nblocks; b++)
+				count += mhist[b * 256 + d];
+			if (count == (uint)n)
+				same_digit = true;
+			if (count)
+				break;
+		}
+		if (same_digit)
+			continue;
+
+		uint sum = 0;
+		for (int d = 0; d < 256; d++)
+			for (int b = 0; b < nblocks; b++)
+			{
+				uint count = mhist[b * 256 + d];
+				mhist[b * 256 + d] = sum;
+				sum += count;
+			}
+
+		#pragma omp parallel for num_threads(nblocks)
+		for (int b = 0; b < nblocks; b++)
+		{
+			int start = (int)(((long long)n * b) / nblocks);
+			int end   = (int)(((long long)n * (b+1)) / nblocks);
+			uint* bhist = mhist + b * 256;
+			for (int i = start; i < end; i++)
+			{
+				uint mpos = bhist[(src_keys[i] >> shift) & 0xFF]++;
+				dst_keys[mpos] = src_keys[i];
+				dst_values[mpos] = src_values[i];
+			}
+		}
+
+		keys.swap(keys_tmp);
+		values.swap(values_tmp);
+	}
+}
+
+
+// Index of the bin along one axis
+
+static inline int BinCoord(float x, float origin, float inv_size, int nbins)
+{
+	int i = (int)((x - origin) * inv_size);
+	if (i < 0) return 0;
+	if (i >= nbins) return nbins - 1;
+	return i;
+}
+
+
+
 ChCollisionSystemSpheres::ChCollisionSystemSpheres(unsigned int max_objects, double scene_size)
 {
 	number_of_particles=0;
@@ -37,11 +185,18 @@ ChCollisionSystemSpheres::ChCollisionSystemSpheres(unsigned int max_objects, dou
 	particle_list=new ChCollisionSpheres();
 	contact_list=new ChContacts();
 
-	bins_per_axis = realV(10, 10, 10); //100, 100, 100
+	num_threads = CHOMPfunctions::GetNumProcs(); // default n.threads as n.cores
+
+	bin_size = 0;	// automatic
+	current_bin_size = 0;
+	bins_per_axis[0] = bins_per_axis[1] = bins_per_axis[2] = 1;
+
+	last_active_bin = 0;
+	number_of_bin_intersections = 0;
+	number_of_contacts = 0;
 
 	min_bounding_point = realV(0.0,0.0,0.0);
 	max_bounding_point = realV(0.0,0.0,0.0);
-	global_origin = realV(0.0,0.0,0.0);
 }
 
 
@@ -53,15 +208,11 @@ ChCollisionSystemSpheres::~ChCollisionSystemSpheres()
 
 void ChCollisionSystemSpheres::Clear(void)
 {
-	potential_contacts.clear();
-	aabb_data.clear();
-	Bins_Intersected.clear();
-	bin_number.clear();
-	body_number.clear();
-	bin_start_index.clear();
-	Num_ContactD.clear();
-
+	// Buffers are not freed: they are reused at the next Run()
 	contact_list->clear();
+	last_active_bin = 0;
+	number_of_bin_intersections = 0;
+	number_of_contacts = 0;
 }   
 				
 
@@ -74,13 +225,9 @@ void ChCollisionSystemSpheres::Add(ChCollisionModel* model)
 		ChModelSphereSet *body = (ChModelSphereSet*) model;
 		body->SyncPosition();
 		collModels.push_back(body);
-		thrust::host_vector<ChVector<float> > gPosVec;
-		body->GetGlobalSpherePos(gPosVec);
-		thrust::host_vector<float> gRadVec;
-		body->GetSphereRad(gRadVec);
-		particle_list->add(bodID, gPosVec, gRadVec);
+		particle_list->add(bodID, body->GetGlobalSpherePosRef(), body->GetSphereRadRef());
 		number_of_bodies++;
-		number_of_particles+=gPosVec.size();
+		number_of_particles+=body->GetGlobalSpherePosRef().size();
 	}
 }
 		 		
@@ -112,382 +259,318 @@ void ChCollisionSystemSpheres::Remove(ChCollisionModel* model)
 
 void ChCollisionSystemSpheres::Run()
 {
-	double startTime = omp_get_wtime();
-
-	updateDataStructures(); //TOBY???
+	updateDataStructures();
 
 	number_of_particles = particle_list->num_particles;
-	aabb_data.resize(number_of_particles * 2);
-	potential_contacts.clear();
 	contact_list->clear();
+	last_active_bin = 0;
+	number_of_bin_intersections = 0;
+	number_of_contacts = 0;
 
+	if (number_of_particles == 0)
+		return;
 
-    host_Generate_AABB(particle_list->pos.data(), particle_list->radius.data(), aabb_data.data());
+	{
+		ChProfileScope mscope(profiler, "AABB update");
+		ComputeAABBs();
+	}
+	{
+		ChProfileScope mscope(profiler, "Broadphase");
+		BinSpheres();
+		if (profiler)
+			profiler->SetCounter("bin intersections", number_of_bin_intersections);
+	}
+	{
+		ChProfileScope mscope(profiler, "Narrowphase");
+		FindContacts();
+	}
+}
 
-	//##############################################################################################
-	bbox init = bbox(aabb_data[0], aabb_data[0]);
-	bbox_transformation unary_op;
-	bbox_reduction binary_op;
-	bbox result = thrust::transform_reduce(aabb_data.begin(), aabb_data.end(), unary_op, init, binary_op);
-	min_bounding_point = result.first;
-	max_bounding_point = result.second;
-	global_origin = realV(fabs(min_bounding_point.x), fabs(min_bounding_point.y), fabs(min_bounding_point.z));
-	bin_size_vec = realV(fabs((max_bounding_point + global_origin).x), fabs((max_bounding_point + global_origin).y), fabs((max_bounding_point + global_origin).z));
-	bin_size_vec = bins_per_axis / bin_size_vec;
-	thrust::transform(aabb_data.begin(), aabb_data.end(), thrust::constant_iterator<realV>(global_origin), aabb_data.begin(), thrust::plus<realV>());
-	//##############################################################################################
-	Bins_Intersected.resize(number_of_particles);
 
+void ChCollisionSystemSpheres::ComputeAABBs()
+{
+	// Bounding boxes and statistics of the radii are computed on a fixed
+	// number of blocks, so that results do not depend on the n. of threads
+	const int nblocks = 64;
+	realV block_min[nblocks];
+	realV block_max[nblocks];
+	double block_rsum[nblocks];
+	double block_rsum2[nblocks];
+
+	int n = number_of_particles;
+	aabb_data.resize(2 * n);
+
+	const realV* pos = &particle_list->pos[0];
+	const real* radius = &particle_list->radius[0];
+	realV* aabb = &aabb_data[0];
+
+	#pragma omp parallel for num_threads(this->num_threads) schedule(dynamic)
+	for (int b = 0; b < nblocks; b++)
+	{
+		int start = (int)(((long long)n * b) / nblocks);
+		int end   = (int)(((long long)n * (b+1)) / nblocks);
+		realV mmin(FLT_MAX, FLT_MAX, FLT_MAX);
+		realV mmax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		double rsum = 0;
+		double rsum2 = 0;
+		for (int i = start; i < end; i++)
+		{
+			realV mrad(radius[i], radius[i], radius[i]);
+			realV lo = pos[i] - mrad;
+			realV hi = pos[i] + mrad;
+			aabb[i] = lo;
+			aabb[i + n] = hi;
+			if (lo.x < mmin.x) mmin.x = lo.x;
+			if (lo.y < mmin.y) mmin.y = lo.y;
+			if (lo.z < mmin.z) mmin.z = lo.z;
+			if (hi.x > mmax.x) mmax.x = hi.x;
+			if (hi.y > mmax.y) mmax.y = hi.y;
+			if (hi.z > mmax.z) mmax.z = hi.z;
+			rsum  += radius[i];
+			rsum2 += radius[i] * radius[i];
+		}
+		block_min[b] = mmin;
+		block_max[b] = mmax;
+		block_rsum[b] = rsum;
+		block_rsum2[b] = rsum2;
+	}
 
-	host_Count_AABB_BIN_Intersection(aabb_data.data(), Bins_Intersected.data());
+	min_bounding_point = realV(FLT_MAX, FLT_MAX, FLT_MAX);
+	max_bounding_point = realV(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	double rsum = 0;
+	double rsum2 = 0;
+	for (int b = 0; b < nblocks; b++)
+	{
+		if (block_min[b].x < min_bounding_point.x) min_bounding_point.x = block_min[b].x;
+		if (block_min[b].y < min_bounding_point.y) min_bounding_point.y = block_min[b].y;
+		if (block_min[b].z < min_bounding_point.z) min_bounding_point.z = block_min[b].z;
+		if (block_max[b].x > max_bounding_point.x) max_bounding_point.x = block_max[b].x;
+		if (block_max[b].y > max_bounding_point.y) max_bounding_point.y = block_max[b].y;
+		if (block_max[b].z > max_bounding_point.z) max_bounding_point.z = block_max[b].z;
+		rsum  += block_rsum[b];
+		rsum2 += block_rsum2[b];
+	}
+
+	// Size of the bins: diameter of the spheres, as mean plus one
+	// standard deviation, unless set by the user
+	if (bin_size > 0)
+		current_bin_size = bin_size;
+	else
+	{
+		double rmean = rsum / n;
+		double rvar = rsum2 / n - rmean * rmean;
+		current_bin_size = 2.0 * (rmean + sqrt(rvar > 0 ? rvar : 0));
+	}
 
-	Thrust_Inclusive_Scan_Sum(Bins_Intersected, number_of_bin_intersections);
-	//std::cout << "NBI " << number_of_bin_intersections << ", ";
-	bin_number.resize(number_of_bin_intersections);
-	body_number.resize(number_of_bin_intersections);
-	bin_start_index.resize(number_of_bin_intersections);
+	realV extent = max_bounding_point - min_bounding_point;
+	double max_extent = ChMax(extent.x, ChMax(extent.y, extent.z));
+	if (current_bin_size < max_extent / (MAX_BINS_PER_AXIS - 1))
+		current_bin_size = max_extent / (MAX_BINS_PER_AXIS - 1);
+	if (current_bin_size <= 0)
+		current_bin_size = 1;
 
-	host_Store_AABB_BIN_Intersection(aabb_data.data(), Bins_Intersected.data(), bin_number.data(), body_number.data());
+	bins_per_axis[0] = ChMin(MAX_BINS_PER_AXIS, (int)(extent.x / current_bin_size) + 1);
+	bins_per_axis[1] = ChMin(MAX_BINS_PER_AXIS, (int)(extent.y / current_bin_size) + 1);
+	bins_per_axis[2] = ChMin(MAX_BINS_PER_AXIS, (int)(extent.z / current_bin_size) + 1);
+}
 
-	Thrust_Sort_By_Key(bin_number, body_number);
-	Thrust_Reduce_By_KeyA(last_active_bin, bin_number, bin_start_index);
 
-	val = bin_start_index[thrust::max_element(bin_start_index.begin(), bin_start_index.begin() + last_active_bin) - bin_start_index.begin()];
-	if (val > 50) {
-		bins_per_axis = bins_per_axis * 1.1;
-	} else if (val < 25 && val > 1) {
-		bins_per_axis = bins_per_axis * .9;
+void ChCollisionSystemSpheres::BinSpheres()
+{
+	int n = number_of_particles;
+	const realV* aabb = &aabb_data[0];
+	float inv_size = (float)(1.0 / current_bin_size);
+	realV origin = min_bounding_point;
+	int nx = bins_per_axis[0];
+	int ny = bins_per_axis[1];
+	int nz = bins_per_axis[2];
+
+	// Count the bins touched by each sphere, then get the offset 
+	// of each sphere in the list of (bin,sphere) pairs
+	Bins_Intersected.resize(n);
+	uint* offsets = &Bins_Intersected[0];
+
+	#pragma omp parallel for num_threads(this->num_threads)
+	for (int i = 0; i < n; i++)
+	{
+		int nbx = BinCoord(aabb[i+n].x, origin.x, inv_size, nx) - BinCoord(aabb[i].x, origin.x, inv_size, nx) + 1;
+		int nby = BinCoord(aabb[i+n].y, origin.y, inv_size, ny) - BinCoord(aabb[i].y, origin.y, inv_size, ny) + 1;
+		int nbz = BinCoord(aabb[i+n].z, origin.z, inv_size, nz) - BinCoord(aabb[i].z, origin.z, inv_size, nz) + 1;
+		offsets[i] = nbx * nby * nbz;
 	}
-	bin_start_index.resize(last_active_bin);
-	//std::cout << "LAB " << last_active_bin << ", ";
-	Thrust_Inclusive_Scan(bin_start_index);
-	Num_ContactD.resize(last_active_bin);
 
-	host_Count_AABB_AABB_Intersection(aabb_data.data(),
-	bin_number.data(), body_number.data(), particle_list->bodyIndex.data(), bin_start_index.data(), particle_list->active.data(), Num_ContactD.data());
+	number_of_bin_intersections = ParallelExclusiveScan(offsets, n, this->num_threads, scan_buffer);
 
-	Thrust_Inclusive_Scan_Sum(Num_ContactD, number_of_contacts_possible);
-	potential_contacts.resize(number_of_contacts_possible);
-	//std::cout << "NCP1 " << number_of_contacts_possible << ", ";
+	int npairs = number_of_bin_intersections;
+	bin_number.resize(npairs);
+	body_number.resize(npairs);
+	bin_number_tmp.resize(npairs);
+	body_number_tmp.resize(npairs);
 
-	host_Store_AABB_AABB_Intersection(aabb_data.data(),
-	bin_number.data(), body_number.data(), particle_list->bodyIndex.data(), bin_start_index.data(), Num_ContactD.data(), particle_list->active.data(), potential_contacts.data());
+	// Store the (bin,sphere) pairs
+	uint* mbins = &bin_number[0];
+	uint* mbodies = &body_number[0];
 
-	thrust::sort(potential_contacts.begin(), potential_contacts.end());
-	number_of_contacts_possible = thrust::unique(potential_contacts.begin(), potential_contacts.end()) - potential_contacts.begin();
-	//std::cout << "NCP2 " << number_of_contacts_possible << ", ";
-	//##############################################################################################
-	contact_list->resize(number_of_contacts_possible);
-	Num_ContactD.resize(number_of_contacts_possible);
+	#pragma omp parallel for num_threads(this->num_threads)
+	for (int i = 0; i < n; i++)
+	{
+		int ixmin = BinCoord(aabb[i].x, origin.x, inv_size, nx);
+		int iymin = BinCoord(aabb[i].y, origin.y, inv_size, ny);
+		int izmin = BinCoord(aabb[i].z, origin.z, inv_size, nz);
+		int ixmax = BinCoord(aabb[i+n].x, origin.x, inv_size, nx);
+		int iymax = BinCoord(aabb[i+n].y, origin.y, inv_size, ny);
+		int izmax = BinCoord(aabb[i+n].z, origin.z, inv_size, nz);
+		uint mpos = offsets[i];
+		for (int iz = izmin; iz <= izmax; iz++)
+			for (int iy = iymin; iy <= iymax; iy++)
+				for (int ix = ixmin; ix <= ixmax; ix++)
+				{
+					mbins[mpos] = (uint)(ix + nx * (iy + ny * iz));
+					mbodies[mpos] = i;
+					mpos++;
+				}
+	}
 
-	Thrust_Fill(Num_ContactD, 1);
+	// Sort the pairs by bin. The sort is stable, so the spheres
+	// of each bin stay sorted by index.
+	uint max_key = (uint)(nx * ny * nz - 1);
+	ParallelRadixSort(bin_number, body_number, bin_number_tmp, body_number_tmp, npairs, max_key, this->num_threads, scan_buffer);
 
-	host_Store_Contact(potential_contacts.data(), particle_list->pos.data(), particle_list->radius.data(), particle_list->bodyIndex.data(),
-	contact_list->ida.data(), contact_list->idb.data(), contact_list->pta.data(), contact_list->ptb.data(), contact_list->N.data(), contact_list->depth.data(), contact_list->rest_len.data(), Num_ContactD.data());
+	// Find the start of each non-empty bin: flag the first pair of
+	// each bin, then compact the flags with a scan
+	Num_ContactD.resize(npairs);
+	mbins = &bin_number[0];
+	uint* flags = &Num_ContactD[0];
 
-	thrust::sort_by_key(
-			Num_ContactD.begin(),
-			Num_ContactD.end(),
-			thrust::make_zip_iterator(thrust::make_tuple(contact_list->ida.begin(), contact_list->idb.begin(), contact_list->pta.begin(), contact_list->ptb.begin(), contact_list->N.begin(), contact_list->depth.begin(), contact_list->rest_len.begin())));
+	#pragma omp parallel for num_threads(this->num_threads)
+	for (int j = 0; j < npairs; j++)
+		flags[j] = (j == 0 || mbins[j] != mbins[j-1]) ? 1 : 0;
 
-	number_of_contacts = Thrust_Count(Num_ContactD,0);
-	//std::cout << "NC " << number_of_contacts << "\n";
-	contact_list->resize(number_of_contacts);
-	contact_list->num_contacts = number_of_contacts;
+	last_active_bin = ParallelExclusiveScan(flags, npairs, this->num_threads, scan_buffer);
 
-	//##############################################################################################
+	bin_start_index.resize(last_active_bin + 1);
+	uint* starts = &bin_start_index[0];
 
-	double endTime = omp_get_wtime();
-	//printf("CD %lf  ", (endTime - startTime)); //TOBY: Comment this out
-	//printf("BPA %f,%f,%f ",bins_per_axis.x, bins_per_axis.y, bins_per_axis.z); //TOBY: Comment this out
-	//printf("Spheres %i Contacts %i\n", number_of_particles,number_of_contacts); //TOBY: Comment this out
-}
+	#pragma omp parallel for num_threads(this->num_threads)
+	for (int j = 0; j < npairs; j++)
+		if (j == 0 || mbins[j] != mbins[j-1])
+			starts[flags[j]] = j;
 
-template<class T>
-inline int3 Hash(
-        const T &A,
-        const realV & bin_size_vec) {
-    int3 temp;
-    temp.x = A.x * bin_size_vec.x;
-    temp.y = A.y * bin_size_vec.y;
-    temp.z = A.z * bin_size_vec.z;
-    return temp;
+	starts[last_active_bin] = npairs;
 }
 
-template<class T>
-inline uint Hash_Index(
-        const T &A) {
-    return ((A.x * 73856093) ^ (A.y * 19349663) ^ (A.z * 83492791));
-}
 
-//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-//Function to Generate AABB
-
-inline void function_Generate_AABB(
-        const uint & index,
-        const realV* pos,
-        const real* radius,
-        const uint & number_of_particles,
-        realV* aabb_data) {
-    aabb_data[index] = pos[index] - realV(radius[index]);
-    aabb_data[index + number_of_particles] = pos[index] + realV(radius[index]);
+uint ChCollisionSystemSpheres::ProcessBin(uint mbin, const uint* offset)
+{
+	uint start = bin_start_index[mbin];
+	uint end = bin_start_index[mbin + 1];
+	if (end - start < 2)
+		return 0;
+
+	int n = number_of_particles;
+	const realV* aabb = &aabb_data[0];
+	const realV* pos = &particle_list->pos[0];
+	const real* radius = &particle_list->radius[0];
+	const char* active = &particle_list->active[0];
+	const uint* bodyIndex = &particle_list->bodyIndex[0];
+	float inv_size = (float)(1.0 / current_bin_size);
+	int nx = bins_per_axis[0];
+	int ny = bins_per_axis[1];
+	int nz = bins_per_axis[2];
+	uint key = bin_number[start];
+
+	uint count = 0;
+	for (uint i = start; i < end; i++)
+	{
+		uint a = body_number[i];
+		for (uint k = i + 1; k < end; k++)
+		{
+			uint b = body_number[k];
+
+			if (bodyIndex[a] == bodyIndex[b] || !(active[a] || active[b]))
+				continue;
+
+			if (aabb[a].x > aabb[b+n].x || aabb[b].x > aabb[a+n].x ||
+				aabb[a].y > aabb[b+n].y || aabb[b].y > aabb[a+n].y ||
+				aabb[a].z > aabb[b+n].z || aabb[b].z > aabb[a+n].z)
+				continue;
+
+			// Two spheres may share more bins: report the pair only in the bin 
+			// that contains the min corner of the intersection of their AABBs
+			int ix = BinCoord(ChMax(aabb[a].x, aabb[b].x), min_bounding_point.x, inv_size, nx);
+			int iy = BinCoord(ChMax(aabb[a].y, aabb[b].y), min_bounding_point.y, inv_size, ny);
+			int iz = BinCoord(ChMax(aabb[a].z, aabb[b].z), min_bounding_point.z, inv_size, nz);
+			if ((uint)(ix + nx * (iy + ny * iz)) != key)
+				continue;
+
+			realV relPos = pos[b] - pos[a];
+			real dist = relPos.Length();
+			real collideDist = radius[a] + radius[b];
+			if (dist >= collideDist)
+				continue;
+
+			if (offset)
+			{
+				uint index = *offset + count;
+				realV N = relPos.GetNormalized();
+				contact_list->ida[index] = bodyIndex[a];
+				contact_list->idb[index] = bodyIndex[b];
+				contact_list->pta[index] = pos[a] + N * radius[a];
+				contact_list->ptb[index] = pos[b] - N * radius[b];
+				contact_list->N[index] = N;
+				contact_list->depth[index] = collideDist - dist;
+				contact_list->rest_len[index] = dist;
+			}
+			count++;
+		}
+	}
+	return count;
 }
 
-void ChCollisionSystemSpheres::host_Generate_AABB(
-        const realV* pos,
-        const real* radius,
-        realV* aabb_data) {
 
-    for (uint i = 0; i < number_of_particles; i++) {
-        function_Generate_AABB(i, pos, radius, number_of_particles, aabb_data);
-    }
-}
-//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-//Function to Count AABB Bin intersections
-
-inline void function_Count_AABB_BIN_Intersection(
-        const uint & index,
-        const realV* aabb_data,
-        const realV & bin_size_vec,
-        const uint & number_of_particles,
-        uint* Bins_Intersected) {
-    int3 gmin = Hash(aabb_data[index], bin_size_vec);
-    int3 gmax = Hash(aabb_data[index + number_of_particles], bin_size_vec);
-    Bins_Intersected[index] = (gmax.x - gmin.x + 1) * (gmax.y - gmin.y + 1) * (gmax.z - gmin.z + 1);
-}
+void ChCollisionSystemSpheres::FindContacts()
+{
+	int nbins = last_active_bin;
+	Num_ContactD.resize(nbins);
+	uint* counts = &Num_ContactD[0];
 
-void ChCollisionSystemSpheres::host_Count_AABB_BIN_Intersection(
-        const realV* aabb_data,
-        uint* Bins_Intersected) {
-    for (uint i = 0; i < number_of_particles; i++) {
-        function_Count_AABB_BIN_Intersection(i, aabb_data, bin_size_vec, number_of_particles, Bins_Intersected);
-    }
-}
-//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-//Function to Store AABB Bin Intersections
-
-inline void function_Store_AABB_BIN_Intersection(
-        const uint & index,
-        const realV* aabb_data,
-        const uint* Bins_Intersected,
-        const realV & bin_size_vec,
-        const uint & number_of_particles,
-        uint * bin_number,
-        uint * body_number) {
-    uint count = 0, i, j, k;
-    int3 gmin = Hash(aabb_data[index], bin_size_vec);
-    int3 gmax = Hash(aabb_data[index + number_of_particles], bin_size_vec);
-    uint mInd = (index == 0) ? 0 : Bins_Intersected[index - 1];
-
-    for (i = gmin.x; i <= gmax.x; i++) {
-        for (j = gmin.y; j <= gmax.y; j++) {
-            for (k = gmin.z; k <= gmax.z; k++) {
-                bin_number[mInd + count] = Hash_Index(chrono::ChVector<uint>(i, j, k));
-                body_number[mInd + count] = index;
-                count++;
-            }
-        }
-    }
-}
+	// Count the contacts in each bin, get the offsets of the contacts
+	// of each bin, then store them: the order of the contacts does not
+	// depend on the number of threads.
+	#pragma omp parallel for num_threads(this->num_threads) schedule(dynamic, 256)
+	for (int b = 0; b < nbins; b++)
+		counts[b] = ProcessBin(b, 0);
 
-void ChCollisionSystemSpheres::host_Store_AABB_BIN_Intersection(
-        const realV* aabb_data,
-        const uint* Bins_Intersected,
-        uint * bin_number,
-        uint * body_number) {
-    for (uint i = 0; i < number_of_particles; i++) {
-        function_Store_AABB_BIN_Intersection(i, aabb_data, Bins_Intersected, bin_size_vec, number_of_particles, bin_number, body_number);
-    }
-}
-//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-//Function to count AABB AABB intersection
-
-inline void function_Count_AABB_AABB_Intersection(
-        const uint & index,
-        const realV* aabb_data,
-        const uint & number_of_particles,
-        const uint * bin_number,
-        const uint * body_number,
-        const uint * bodyIndex,
-        const uint * bin_start_index,
-        const bool* active,
-        uint* Num_ContactD) {
-    uint end = bin_start_index[index], count = 0, i = (!index) ? 0 : bin_start_index[index - 1];
-    uint tempa, tempb;
-    AABB A, B;
-    for (; i < end; i++) {
-        tempa = body_number[i];
-        A.min = aabb_data[tempa];
-        A.max = aabb_data[tempa + number_of_particles];
-        for (int k = i + 1; k < end; k++) {
-            tempb = body_number[k];
-            B.min = aabb_data[tempb];
-            B.max = aabb_data[tempb + number_of_particles];
-            bool inContact = (A.min.x <= B.max.x && B.min.x <= A.max.x) && (A.min.y <= B.max.y && B.min.y <= A.max.y) && (A.min.z <= B.max.z && B.min.z <= A.max.z);
-            if (inContact == true && tempa != tempb && bodyIndex[tempa] != bodyIndex[tempb] && (active[tempa] || active[tempb])) {
-                count++;
-            }
-        }
-    }
-    Num_ContactD[index] = count;
-}
+	number_of_contacts = ParallelExclusiveScan(counts, nbins, this->num_threads, scan_buffer);
 
-void ChCollisionSystemSpheres::host_Count_AABB_AABB_Intersection(
-        const realV* aabb_data,
-        const uint * bin_number,
-        const uint * body_number,
-        const uint * bodyIndex,
-        const uint * bin_start_index,
-        const bool* active,
-        uint* Num_ContactD) {
-    for (uint i = 0; i < last_active_bin; i++) {
-        function_Count_AABB_AABB_Intersection(i, aabb_data, number_of_particles, bin_number, body_number, bodyIndex, bin_start_index, active, Num_ContactD);
-    }
-}
-//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-//Function to process single contact
-inline void function_Store_AABB_AABB_Intersection(
-        const uint & index,
-        const realV* aabb_data,
-        const uint & number_of_particles,
-        const uint * bin_number,
-        const uint * body_number,
-        const uint * bodyIndex,
-        const uint * bin_start_index,
-        const uint* Num_ContactD,
-        const bool* active,
-        long long* potential_contacts) {
-    uint end = bin_start_index[index], count = 0, i = (!index) ? 0 : bin_start_index[index - 1], Bin = bin_number[index];
-    uint offset = (!index) ? 0 : Num_ContactD[index - 1];
-    if (end - i == 1) {
-        return;
-    }
-    uint tempa, tempb;
-    AABB A, B;
-    for (; i < end; i++) {
-        ;
-        tempa = body_number[i];
-        A.min = aabb_data[tempa];
-        A.max = aabb_data[tempa + number_of_particles];
-
-        for (int k = i + 1; k < end; k++) {
-            tempb = body_number[k];
-
-            B.min = aabb_data[tempb];
-            B.max = aabb_data[tempb + number_of_particles];
-
-            bool inContact = (A.min.x <= B.max.x && B.min.x <= A.max.x) && (A.min.y <= B.max.y && B.min.y <= A.max.y) && (A.min.z <= B.max.z && B.min.z <= A.max.z);
-            if (inContact == true && tempa != tempb && bodyIndex[tempa] != bodyIndex[tempb] && (active[tempa] || active[tempb])) {
-
-                int a = tempa;
-                int b = tempb;
-                if (b < a) {
-                    int t = a;
-                    a = b;
-                    b = t;
-                }
-                potential_contacts[offset + count] = ((long long) a << 32 | (long long) b); //the two indicies of the objects that make up the contact
-                count++;
-            }
-        }
-    }
-}
+	contact_list->resize(number_of_contacts);
 
-void ChCollisionSystemSpheres::host_Store_AABB_AABB_Intersection(
-        const realV* aabb_data,
-        const uint * bin_number,
-        const uint * body_number,
-        const uint * bodyIndex,
-        const uint * bin_start_index,
-        const uint* Num_ContactD,
-        const bool* active,
-        long long* potential_contacts) {
-    for (uint index = 0; index < last_active_bin; index++) {
-        function_Store_AABB_AABB_Intersection(index, aabb_data, number_of_particles, bin_number, body_number, bodyIndex, bin_start_index, Num_ContactD, active, potential_contacts);
-    }
-}
-//%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%
-
-inline void function_Store_Contact(
-        const uint & index,
-        const long long* potential_contacts,
-        const realV* pos,
-        const float* radius,
-        const uint * bodyIndex,
-        uint* id_a,
-        uint* id_b,
-        realV* cpt_a,
-        realV* cpt_b,
-        realV* Norm,
-        float * c_dist,
-        float* rest_len,
-        uint* counter) {
-    int ida = int(potential_contacts[index] >> 32);
-    int idb = int(potential_contacts[index] & 0xffffffff);
-
-    realV pa = pos[ida];
-    realV pb = pos[idb];
-    realV relPos = pb - pa;
-
-    real dist = relPos.Length();
-    realV N = relPos.GetNormalized();
-    real collideDist = radius[ida] + radius[idb];
-
-    if (dist < collideDist) {
-        id_a[index] = bodyIndex[ida];
-        id_b[index] = bodyIndex[idb];
-        cpt_a[index] = pa+N*radius[ida];
-        cpt_b[index] = pb-N*radius[idb];
-        Norm[index] = N;
-        c_dist[index] = collideDist - dist;
-        rest_len[index] = dist;
-        counter[index] = 0;
-    }
+	#pragma omp parallel for num_threads(this->num_threads) schedule(dynamic, 256)
+	for (int b = 0; b < nbins; b++)
+		ProcessBin(b, &counts[b]);
 }
 
-void ChCollisionSystemSpheres::host_Store_Contact(
-        const long long * potential_contacts,
-        const realV* pos,
-        const float* radius,
-        const uint * bodyIndex,
-        uint* id_a,
-        uint* id_b,
-        realV* cpt_a,
-        realV* cpt_b,
-        realV* Norm,
-        float * c_dist,
-        float* rest_len,
-        uint* counter) {
-    for (uint i = 0; i < number_of_contacts_possible; i++) {
-        function_Store_Contact(i, potential_contacts, pos, radius, bodyIndex, id_a, id_b, cpt_a, cpt_b, Norm, c_dist, rest_len, counter);
-    }
-}
 
 void ChCollisionSystemSpheres::updateDataStructures(){
-	int index = 0;
-	ChVector<> tMin, tMax;
-	float xm, xM, ym, yM, zm, zM;
-	ChVector<> globalPos;
-	float size;
-	ChModelSphereSet* body;
-	int spheresToAdd;
-	int fam;
-	int noC;
+	// offsets of the spheres of each model
+	body_offsets.resize(number_of_bodies + 1);
+	uint count = 0;
+	for( uint i=0; i<number_of_bodies; i++)
+	{
+		body_offsets[i] = count;
+		count += collModels[i]->GetGlobalSpherePosRef().size();
+	}
+	body_offsets[number_of_bodies] = count;
+	number_of_particles = count;
 
 	particle_list->reset(number_of_bodies, number_of_particles);
 
-	for( uint i=0; i<number_of_bodies; i++)
+	//update all spheres of all models
+	#pragma omp parallel for num_threads(this->num_threads)
+	for( int i=0; i<(int)number_of_bodies; i++)
 	{
-		body = collModels[i];
-		//update all spheres in this body
-		thrust::host_vector<ChVector<float> > gPosVec;
-		body->GetGlobalSpherePos(gPosVec);
-		thrust::host_vector<float> gRadVec;
-		body->GetSphereRad(gRadVec);
-		particle_list->set(i, body->GetPhysicsItem()->GetIdentifier(), gPosVec, gRadVec);
+		ChModelSphereSet* body = collModels[i];
+		particle_list->set(i, body->GetPhysicsItem()->GetIdentifier(), body_offsets[i], body->GetGlobalSpherePosRef(), body->GetSphereRadRef());
 	}
 }
 
@@ -580,7 +663,7 @@ ChCollisionSpheres::~ChCollisionSpheres()
 	bodyIndex.clear();
 	bID.clear();
 }
-void ChCollisionSpheres::add(int bID, const thrust::host_vector<realV>& sPos, const thrust::host_vector<real>& sRad)
+void ChCollisionSpheres::add(int bID, const std::vector<realV>& sPos, const std::vector<real>& sRad)
 {
 	this->bID.push_back(bID);
 
@@ -588,7 +671,7 @@ void ChCollisionSpheres::add(int bID, const thrust::host_vector<realV>& sPos, co
 	{
 		pos.push_back(sPos[i]);
 		radius.push_back(sRad[i]);
-		active.push_back(true);
+		active.push_back(1);
 		bodyIndex.push_back(num_bodies);
 		bodyID.push_back(bID);
 	}
@@ -596,26 +679,23 @@ void ChCollisionSpheres::add(int bID, const thrust::host_vector<realV>& sPos, co
 	num_bodies++;
 }
 
-void ChCollisionSpheres::set(int bInd, int bIDnum, const thrust::host_vector<realV>& sPos, const thrust::host_vector<real>& sRad)
+void ChCollisionSpheres::set(int bInd, int bIDnum, uint offset, const std::vector<realV>& sPos, const std::vector<real>& sRad)
 {
 	uint nSph=sPos.size();
 
 	bID[bInd]=bIDnum;
-	for(int i=0; i<nSph; i++)
+	for(uint i=0; i<nSph; i++)
 	{
-		pos[setPos+i]=sPos[i];
-		radius[setPos+i]=sRad[i];
-		active[setPos+i]=true;
-		bodyIndex[setPos+i]=bInd;
-		bodyID[setPos+i]=bIDnum;
+		pos[offset+i]=sPos[i];
+		radius[offset+i]=sRad[i];
+		active[offset+i]=1;
+		bodyIndex[offset+i]=bInd;
+		bodyID[offset+i]=bIDnum;
 	}
-
-	setPos+=nSph;
 }
 
 void ChCollisionSpheres::reset(int n_bodies, int n_particles)
 {
-	setPos=0;
 	num_particles=n_particles;
 	num_bodies=n_bodies;
 	pos.resize(n_particles);
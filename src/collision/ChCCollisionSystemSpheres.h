@@ -27,30 +27,14 @@
 // ------------------------------------------------
 ///////////////////////////////////////////////////
 
-#define THRUST_DEVICE_SYSTEM THRUST_DEVICE_SYSTEM_OMP
-
+#include <vector>
 #include "core/ChApiCE.h"
 #include "collision/ChCCollisionSystem.h"
 #include "collision/ChCModelSphereSet.h"
-#include <thrust/host_vector.h>
-#include <thrust/sort.h>
-#include <thrust/scan.h>
-#include <thrust/unique.h>
-#include <thrust/count.h>
-#include <thrust/iterator/constant_iterator.h>
-#include <thrust/iterator/counting_iterator.h>
 
 typedef chrono::ChVector<float> realV;
 typedef float real;
 
-#define Thrust_Inclusive_Scan_Sum(x,y)  thrust::inclusive_scan(x.begin(),x.end(), x.begin()); y=x.back();
-#define Thrust_Sort_By_Key(x,y)         thrust::sort_by_key(x.begin(),x.end(),y.begin())
-#define Thrust_Reduce_By_KeyA(x,y,z)x=  thrust::reduce_by_key(y.begin(),y.end(),thrust::constant_iterator<uint>(1),y.begin(),z.begin()).first-y.begin()
-#define Thrust_Inclusive_Scan(x)        thrust::inclusive_scan(x.begin(), x.end(), x.begin())
-#define Thrust_Fill(x,y)                thrust::fill(x.begin(),x.end(),y)
-#define Thrust_Count(x,y)               thrust::count(x.begin(),x.end(),y)
-
-using namespace thrust;
 
 namespace chrono 
 {
@@ -61,9 +45,15 @@ class ChCollisionSpheres;
 class ChContacts;
 
 ///
-/// Class for collision engine based on the 'Bullet' library.
-/// Contains either the broadphase and the narrow phase Bullet
-/// methods.
+/// Class for collision engine for models made of sets of spheres
+/// (ChModelSphereSet), as used in sphere-based DEM simulations.
+/// Spheres are binned in a uniform grid: the (sphere,bin) pairs are
+/// sorted by bin with a radix sort, then the spheres that share a bin
+/// are tested against each other. The bin size is set automatically
+/// from the distribution of the radii of the spheres.
+/// All phases run in parallel with OpenMP, and all buffers are kept
+/// from one step to the next, so there are no reallocations in the
+/// steady state. Results do not depend on the number of threads.
 /// 
 
 class ChApi ChCollisionSystemSpheres : public ChCollisionSystem
@@ -90,7 +80,6 @@ class ChApi ChCollisionSystemSpheres : public ChCollisionSystem
     //virtual void RemoveAll();
 
 					/// Run the algorithm and finds all the contacts.
-					/// (Contacts will be managed by the Bullet persistent contact cache).
 	virtual void Run();
 
 					// Update...
@@ -118,101 +107,58 @@ class ChApi ChCollisionSystemSpheres : public ChCollisionSystem
 					/// Perform a raycast (ray-hit test with the collision models).
 	virtual bool RayHit(const ChVector<>& from, const ChVector<>& to, ChRayhitResult& mresult);
 
+					/// Set the number of threads (default: number of cores)
+	void SetNumThreads(int nthreads) {num_threads = (nthreads < 1) ? 1 : nthreads;}
+	int  GetNumThreads() {return num_threads;}
 
-	// Some internally used functions
-	void host_Generate_AABB(
-			const realV* pos,
-			const real* radius,
-			realV* aabb_data);
-	void host_Count_AABB_BIN_Intersection(
-			const realV* aabb_data,
-			uint* Bins_Intersected);
-	void host_Store_AABB_BIN_Intersection(
-			const realV* aabb_data,
-			const uint* Bins_Intersected,
-			uint * bin_number,
-			uint * body_number);
-	void host_Count_AABB_AABB_Intersection(
-			const realV* aabb_data,
-			const uint * bin_number,
-			const uint * body_number,
-			const uint * bodyIndex,
-			const uint * bin_start_index,
-			const bool* active,
-			uint* Num_ContactD);
-	void host_Store_AABB_AABB_Intersection(
-			const realV* aabb_data,
-			const uint * bin_number,
-			const uint * body_number,
-			const uint * bodyIndex,
-			const uint * bin_start_index,
-			const uint* Num_ContactD,
-			const bool* active,
-			long long* potential_contacts);
-	void host_Store_Contact(
-			const long long * potential_contacts,
-			const realV* pos,
-			const float* radius,
-			const uint * bodyIndex,
-			uint* id_a,
-			uint* id_b,
-			realV* cpt_a,
-			realV* cpt_b,
-			realV* Norm,
-			float * c_dist,
-			float* rest_len,
-			uint* counter);
+					/// Set the size of the bins. If zero (default), the size is
+					/// set automatically at each Run(), as the diameter of the 
+					/// spheres (mean plus one standard deviation), so that most
+					/// spheres touch at most 2x2x2 bins.
+	void   SetBinSize(double msize) {bin_size = msize;}
+	double GetBinSize() {return bin_size;}
 
-public:
-	thrust::host_vector<long long> potential_contacts;
-	thrust::host_vector<realV> aabb_data;
-	thrust::host_vector<uint> Bins_Intersected;
-	thrust::host_vector<uint> bin_number;
-	thrust::host_vector<uint> body_number;
-	thrust::host_vector<uint> bin_start_index;
-	thrust::host_vector<uint> Num_ContactD;
+					/// Get the size of the bins used in the last Run()
+	double GetCurrentBinSize() {return current_bin_size;}
+
+					/// Get the number of non-empty bins in the last Run()
+	uint   GetNumActiveBins() {return last_active_bin;}
 
+public:
 	ChCollisionSpheres * particle_list;
 	ChContacts * contact_list;
 
 private:
+	void ComputeAABBs();
+	void BinSpheres();
+	void FindContacts();
+	uint ProcessBin(uint mbin, const uint* offset);
+
+	int num_threads;
+	double bin_size;
+	double current_bin_size;
+
 	realV min_bounding_point;
 	realV max_bounding_point;
-	realV global_origin;
-	realV bin_size_vec;
-	realV bins_per_axis;
+	int bins_per_axis[3];
 
 	uint number_of_particles, number_of_bodies;
-	uint last_active_bin, number_of_bin_intersections, number_of_contacts_possible,number_of_contacts;
-	uint val;
-
-	thrust::host_vector<ChModelSphereSet*> collModels;
-
-};
-
-struct AABB {
-    realV min, max;
-};
-
-typedef thrust::pair<realV, realV> bbox;
-
-// reduce a pair of bounding boxes (a,b) to a bounding box containing a and b
-struct bbox_reduction: public thrust::binary_function<bbox, bbox, bbox> {
-    bbox operator()(
-            bbox a,
-            bbox b) {
-        realV ll = realV(fmin(a.first.x, b.first.x), fmin(a.first.y, b.first.y), fmin(a.first.z, b.first.z)); // lower left corner
-        realV ur = realV(fmax(a.second.x, b.second.x), fmax(a.second.y, b.second.y), fmax(a.second.z, b.second.z)); // upper right corner
-        return bbox(ll, ur);
-    }
-};
+	uint last_active_bin, number_of_bin_intersections, number_of_contacts;
+
+					// buffers, kept to avoid reallocations
+	std::vector<realV> aabb_data;			// min corners, then max corners, of the spheres
+	std::vector<uint> Bins_Intersected;		// offset of each sphere in the (bin,sphere) pairs
+	std::vector<uint> bin_number;			// bin of each (bin,sphere) pair, sorted
+	std::vector<uint> body_number;			// sphere of each (bin,sphere) pair
+	std::vector<uint> bin_number_tmp;		// buffers of the radix sort
+	std::vector<uint> body_number_tmp;
+	std::vector<uint> bin_start_index;		// start of each non-empty bin in the pairs, plus end
+	std::vector<uint> Num_ContactD;			// offset of the contacts of each non-empty bin
+	std::vector<uint> body_offsets;			// offset of the spheres of each model
+	std::vector<uint> scan_buffer;			// per-thread data of scans and sorts
+
+	std::vector<ChModelSphereSet*> collModels;
 
-// convert a point to a bbox containing that point, (point) -> (point, point)
-struct bbox_transformation: public thrust::unary_function<realV, bbox> {
-    bbox operator()(
-            realV point) {
-        return bbox(point, point);
-    }
 };
 
 
@@ -221,22 +167,21 @@ class ChApi ChCollisionSpheres
 public:
 	ChCollisionSpheres();
 	virtual ~ChCollisionSpheres();
-	void add(int bID, const thrust::host_vector<realV>& sPos, const thrust::host_vector<real>& sRad);
-	void set(int bInd, int bIDnum, const thrust::host_vector<realV>& sPos, const thrust::host_vector<real>& sRad);
+	void add(int bID, const std::vector<realV>& sPos, const std::vector<real>& sRad);
+	void set(int bInd, int bIDnum, uint offset, const std::vector<realV>& sPos, const std::vector<real>& sRad);
 	void reset(int n_bodies, int n_particles);
 
 public:
 	uint num_particles;
 	uint num_bodies;
-	uint setPos;
 
-	thrust::host_vector<uint> bID; // this should have length equal to num_bodies
+	std::vector<uint> bID; // this should have length equal to num_bodies
 
-	thrust::host_vector<realV> pos; //this should have length equal to num particles
-	thrust::host_vector<real> radius; //this is mapped to pos, giving the radius for each particle
-	thrust::host_vector<bool> active; //this is mapped to pos,
-	thrust::host_vector<uint> bodyID; //this is mapped to pos, the ID number assigned when creating the body
-	thrust::host_vector<uint> bodyIndex; //this is mapped to pos, the index into the list of collModels that this sphere is a part of
+	std::vector<realV> pos; //this should have length equal to num particles
+	std::vector<real> radius; //this is mapped to pos, giving the radius for each particle
+	std::vector<char> active; //this is mapped to pos (not a vector<bool>, that cannot be written in parallel)
+	std::vector<uint> bodyID; //this is mapped to pos, the ID number assigned when creating the body
+	std::vector<uint> bodyIndex; //this is mapped to pos, the index into the list of collModels that this sphere is a part of
 };
 
 class ChApi ChContacts
@@ -248,13 +193,13 @@ public:
 	void resize(uint);
 
 public:
-	thrust::host_vector<uint> ida;
-	thrust::host_vector<uint> idb;
-	thrust::host_vector<realV> N;
-	thrust::host_vector<real> depth;
-	thrust::host_vector<real> rest_len;
-	thrust::host_vector<realV> pta;
-	thrust::host_vector<realV> ptb;
+	std::vector<uint> ida;
+	std::vector<uint> idb;
+	std::vector<realV> N;
+	std::vector<real> depth;
+	std::vector<real> rest_len;
+	std::vector<realV> pta;
+	std::vector<realV> ptb;
 	uint num_contacts;
 };
 
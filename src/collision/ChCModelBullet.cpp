@@ -669,6 +669,12 @@ void ChModelBullet::GetAABB(ChVector<>& bbmin, ChVector<>& bbmax) const
 }
 
 
+void ChModelBullet::SetSleeping(bool msleeping)
+{
+	bt_collision_object->forceActivationState(msleeping ? ISLAND_SLEEPING : ACTIVE_TAG);
+}
+
+
 void __recurse_add_newcollshapes(btCollisionShape* ashape, std::vector<smartptrshapes>& shapes)
 {
 	if (ashape)
@@ -169,6 +169,11 @@ public:
 		/// should be invoked before calling this.
   virtual void GetAABB(ChVector<>& bbmin, ChVector<>& bbmax) const;
 
+		/// Sleeping models are inactive Bullet objects, so the narrow
+		/// phase is skipped for pairs of sleeping models, and their
+		/// old manifolds are not reported.
+  virtual void SetSleeping(bool msleeping);
+
 	
 			//
 			// STREAMING
@@ -235,14 +235,14 @@ void ChModelSphereSet::GetAABB(ChVector<>& bbmin, ChVector<>& bbmax) const
 	bbmax.Set(myBBmaxGlobal.x,myBBmaxGlobal.y,myBBmaxGlobal.z);
 }
 
-void ChModelSphereSet::GetGlobalSpherePos(thrust::host_vector<ChVector<float> >& globalPos)
+void ChModelSphereSet::GetGlobalSpherePos(std::vector<ChVector<float> >& globalPos)
 {
 	globalPos=sphPosGlobal;
 }
 
-void ChModelSphereSet::GetSphereRad(thrust::host_vector<float>& rad)
+void ChModelSphereSet::GetSphereRad(std::vector<float>& rad)
 {
-	//thrust::host_vector<float> pRad=sphRad;
+	//std::vector<float> pRad=sphRad;
 	//rad.swap(pRad);
 	rad=sphRad;
 }
@@ -29,7 +29,6 @@
 
 #include <vector>
 #include "collision/ChCCollisionModel.h"
-#include <thrust/host_vector.h>
 
 namespace chrono 
 {
@@ -48,9 +47,9 @@ class ChApi ChModelSphereSet : public ChCollisionModel
 {
 protected:
 	uint nSpheres;
-	thrust::host_vector<ChVector<float> > sphPosLocal;
-	thrust::host_vector<ChVector<float> > sphPosGlobal;
-	thrust::host_vector<float> sphRad;
+	std::vector<ChVector<float> > sphPosLocal;
+	std::vector<ChVector<float> > sphPosGlobal;
+	std::vector<float> sphRad;
 	ChVector<float> myBBminLocal, myBBmaxLocal, myBBminGlobal, myBBmaxGlobal;
 
 	int colFam;
@@ -97,6 +96,9 @@ public:
   		/// Add a cylinder to this model (default axis on Y direction), for collision purposes
   virtual bool AddCylinder (double rx, double rz, double hy,  ChVector<>* pos=0, ChMatrix33<>* rot=0);
 
+  		/// Add a cone to this model (default axis on Y direction). Not supported.
+  virtual bool AddCone (double rx, double rz, double hy,  ChVector<>* pos=0, ChMatrix33<>* rot=0) {return false;}
+
   		/// Add a convex hull to this model. A convex hull is simply a point cloud that describe
 		/// a convex polytope. Connectivity between the vertexes, as faces/edges in triangle meshes is not necessary.
 		/// Points are passed as a list, that is instantly copied into the model.
@@ -181,10 +183,16 @@ public:
 	  //
 	  
 		/// Gets the global positions of the spheres
-  void GetGlobalSpherePos(thrust::host_vector<ChVector<float> >& globalPos);
+  void GetGlobalSpherePos(std::vector<ChVector<float> >& globalPos);
 
-		/// Gets the global positions of the spheres
-  void GetSphereRad(thrust::host_vector<float>& rad);
+		/// Gets the radii of the spheres
+  void GetSphereRad(std::vector<float>& rad);
+
+		/// Access the global positions of the spheres, without copying them
+  const std::vector<ChVector<float> >& GetGlobalSpherePosRef() const {return sphPosGlobal;}
+
+		/// Access the radii of the spheres, without copying them
+  const std::vector<float>& GetSphereRadRef() const {return sphRad;}
 
   uint getNSpheres(){return nSpheres;};
 
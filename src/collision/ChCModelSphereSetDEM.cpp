@@ -57,15 +57,12 @@ void ChModelSphereSetDEM::SyncPosition()
 	myBBminGlobal.Set(tmin.x,tmin.y,tmin.z);
 	myBBmaxGlobal.Set(tmax.x,tmax.y,tmax.z);
 
-	// Update the sphere positions in global frame
-	thrust::host_vector< ChVector<float> > gPos;
-	gPos.resize(nSpheres);
+	// Update the sphere positions in global frame (in place, to avoid reallocations)
+	sphPosGlobal.resize(nSpheres);
 	for(uint i=0; i<nSpheres; i++)
 	{
-		gPos[i]=bodyCoord.TrasformLocalToParent(sphPosLocal[i]);
+		sphPosGlobal[i]=bodyCoord.TrasformLocalToParent(sphPosLocal[i]);
 	}
-
-	sphPosGlobal.swap(gPos);
 }
 
 
@@ -0,0 +1,453 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChCSRMatrix.cpp
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <algorithm>
+#include "core/ChCSRMatrix.h"
+
+
+namespace chrono
+{
+
+
+ChCSRMatrix::ChCSRMatrix()
+{
+	rows = 0;
+	columns = 0;
+	Reset(0, 0);
+}
+
+ChCSRMatrix::ChCSRMatrix(int row, int col)
+{
+	rows = 0;
+	columns = 0;
+	Reset(row, col);
+}
+
+
+void ChCSRMatrix::Reset(int row, int col)
+{
+	assert (row >= 0 && col >= 0);
+	rows = row;
+	columns = col;
+	rowindex.assign(rows + 1, 0);
+	colindex.clear();
+	values.clear();
+	triplets.clear();
+}
+
+void ChCSRMatrix::ResetBlocks(int row, int col)
+{
+	if ((row == rows)&&(col == columns))	// size doesn't change
+	{
+		Compress();
+		std::fill(values.begin(), values.end(), 0.0);
+	}
+	else	// size changes
+	{
+		Reset(row, col);
+	}
+}
+
+
+int ChCSRMatrix::FindElement(int row, int col)
+{
+	const int* mbegin = colindex.empty() ? 0 : &colindex[0] + rowindex[row];
+	const int* mend   = colindex.empty() ? 0 : &colindex[0] + rowindex[row+1];
+	const int* mfound = std::lower_bound(mbegin, mend, col);
+	if (mfound != mend && *mfound == col)
+		return (int)(mfound - &colindex[0]);
+	return -1;
+}
+
+void ChCSRMatrix::Store(int row, int col, double val, bool add)
+{
+	assert (row >= 0 && col >= 0 && row < rows && col < columns);
+
+	// Elements already in the compressed arrays are modified in place:
+	// pending triplets are always about other elements, so the
+	// order of the operations is preserved.
+	int k = FindElement(row, col);
+	if (k >= 0)
+	{
+		if (add)
+			values[k] += val;
+		else
+			values[k] = val;
+		return;
+	}
+
+	Triplet mtriplet;
+	mtriplet.row = row;
+	mtriplet.col = col;
+	mtriplet.val = val;
+	mtriplet.add = add;
+	triplets.push_back(mtriplet);
+}
+
+
+void ChCSRMatrix::SetElement (int row, int col, double elem)
+{
+	Store(row, col, elem, false);
+}
+
+void ChCSRMatrix::AddElement (int row, int col, double elem)
+{
+	Store(row, col, elem, true);
+}
+
+double ChCSRMatrix::GetElement (int row, int col)
+{
+	assert (row >= 0 && col >= 0 && row < rows && col < columns);
+	Compress();
+	int k = FindElement(row, col);
+	if (k >= 0)
+		return values[k];
+	return 0;
+}
+
+
+void ChCSRMatrix::PasteMatrix (ChMatrix<>* matra, int insrow, int inscol)
+{
+	for (int i=0;i < matra->GetRows();i++)
+		for (int j=0;j < matra->GetColumns();j++)
+		{
+			double val = matra->GetElement(i,j);
+			if (val) Store(i+insrow, j+inscol, val, false);
+		}
+}
+
+void ChCSRMatrix::PasteTranspMatrix (ChMatrix<>* matra, int insrow, int inscol)
+{
+	for (int j=0;j < matra->GetColumns();j++)
+		for (int i=0;i < matra->GetRows();i++)
+		{
+			double val = matra->GetElement(i,j);
+			if (val) Store(j+insrow, i+inscol, val, false);
+		}
+}
+
+void ChCSRMatrix::PasteMatrixFloat (ChMatrix<float>* matra, int insrow, int inscol)
+{
+	for (int i=0;i < matra->GetRows();i++)
+		for (int j=0;j < matra->GetColumns();j++)
+		{
+			double val = matra->GetElement(i,j);
+			if (val) Store(i+insrow, j+inscol, val, false);
+		}
+}
+
+void ChCSRMatrix::PasteTranspMatrixFloat (ChMatrix<float>* matra, int insrow, int inscol)
+{
+	for (int j=0;j < matra->GetColumns();j++)
+		for (int i=0;i < matra->GetRows();i++)
+		{
+			double val = matra->GetElement(i,j);
+			if (val) Store(j+insrow, i+inscol, val, false);
+		}
+}
+
+void ChCSRMatrix::PasteClippedMatrix (ChMatrix<>* matra, int cliprow, int clipcol, int nrows, int ncolumns, int insrow, int inscol)
+{
+	for (int i=0;i < nrows;i++)
+		for (int j=0;j < ncolumns;j++)
+		{
+			double val = matra->GetElement(i+cliprow, j+clipcol);
+			if (val) Store(i+insrow, j+inscol, val, false);
+		}
+}
+
+void ChCSRMatrix::PasteSumClippedMatrix (ChMatrix<>* matra, int cliprow, int clipcol, int nrows, int ncolumns, int insrow, int inscol)
+{
+	for (int i=0;i < nrows;i++)
+		for (int j=0;j < ncolumns;j++)
+		{
+			double val = matra->GetElement(i+cliprow, j+clipcol);
+			if (val) Store(i+insrow, j+inscol, val, true);
+		}
+}
+
+void ChCSRMatrix::PasteSumMatrix (ChMatrix<>* matra, int insrow, int inscol)
+{
+	for (int i=0;i < matra->GetRows();i++)
+		for (int j=0;j < matra->GetColumns();j++)
+		{
+			double val = matra->GetElement(i,j);
+			if (val) Store(i+insrow, j+inscol, val, true);
+		}
+}
+
+void ChCSRMatrix::PasteSumTranspMatrix (ChMatrix<>* matra, int insrow, int inscol)
+{
+	for (int j=0;j < matra->GetColumns();j++)
+		for (int i=0;i < matra->GetRows();i++)
+		{
+			double val = matra->GetElement(i,j);
+			if (val) Store(j+insrow, i+inscol, val, true);
+		}
+}
+
+
+void ChCSRMatrix::Compress()
+{
+	if (triplets.empty())
+		return;
+
+	int ntriplets = (int)triplets.size();
+
+	// 1- sort the triplets by row and, in each row, by column, with two
+	//    stable counting sorts (radix sort): first by column, then by row.
+	//    Being stable, operations on the same element keep their order.
+	rowstart.assign(columns + 1, 0);		// column counts, here
+	for (int it = 0; it < ntriplets; it++)
+		rowstart[triplets[it].col + 1]++;
+	for (int j = 0; j < columns; j++)
+		rowstart[j+1] += rowstart[j];
+	sorted.resize(ntriplets);
+	for (int it = 0; it < ntriplets; it++)
+		sorted[rowstart[triplets[it].col]++] = triplets[it];
+
+	rowstart.assign(rows + 1, 0);
+	for (int it = 0; it < ntriplets; it++)
+		rowstart[sorted[it].row + 1]++;
+	for (int i = 0; i < rows; i++)
+		rowstart[i+1] += rowstart[i];
+	new_rowindex.assign(rowstart.begin(), rowstart.end() - 1);	// used as cursors here
+	for (int it = 0; it < ntriplets; it++)
+		triplets[new_rowindex[sorted[it].row]++] = sorted[it];
+	sorted.swap(triplets);
+
+	// 2- in each row, merge with the stored elements
+	new_rowindex.resize(rows + 1);
+	new_colindex.clear();
+	new_values.clear();
+	new_colindex.reserve(colindex.size() + ntriplets);
+	new_values.reserve(values.size() + ntriplets);
+
+	for (int i = 0; i < rows; i++)
+	{
+		new_rowindex[i] = (int)new_colindex.size();
+
+		int ib = rowstart[i];
+		int iend_b = rowstart[i+1];
+
+		int ia = rowindex[i];
+		int iend_a = rowindex[i+1];
+
+		while (ia < iend_a || ib < iend_b)
+		{
+			int mcol;
+			if (ib >= iend_b || (ia < iend_a && colindex[ia] <= sorted[ib].col))
+				mcol = colindex[ia];
+			else
+				mcol = sorted[ib].col;
+
+			double val = 0;
+			if (ia < iend_a && colindex[ia] == mcol)
+			{
+				val = values[ia];
+				ia++;
+			}
+			while (ib < iend_b && sorted[ib].col == mcol)
+			{
+				if (sorted[ib].add)
+					val += sorted[ib].val;
+				else
+					val = sorted[ib].val;
+				ib++;
+			}
+			new_colindex.push_back(mcol);
+			new_values.push_back(val);
+		}
+	}
+	new_rowindex[rows] = (int)new_colindex.size();
+
+	rowindex.swap(new_rowindex);
+	colindex.swap(new_colindex);
+	values.swap(new_values);
+
+	triplets.clear();
+}
+
+
+void ChCSRMatrix::MatrMultiply (const ChMatrix<>& x, ChMatrix<>& y)
+{
+	assert (x.GetRows() == columns && x.GetColumns() == 1);
+	Compress();
+	y.Reset(rows, 1);
+	MatrMultiplyInc(x, y, 1.0);
+}
+
+void ChCSRMatrix::MatrTMultiply (const ChMatrix<>& x, ChMatrix<>& y)
+{
+	assert (x.GetRows() == rows && x.GetColumns() == 1);
+	Compress();
+	y.Reset(columns, 1);
+	MatrTMultiplyInc(x, y, 1.0);
+}
+
+void ChCSRMatrix::MatrMultiplyInc (const ChMatrix<>& x, ChMatrix<>& y, double factor)
+{
+	assert (x.GetRows() == columns && y.GetRows() == rows);
+	Compress();
+	if (values.empty())
+		return;
+
+	const int* mrowindex = &rowindex[0];
+	const int* mcolindex = &colindex[0];
+	const double* mvalues = &values[0];
+	const double* mx = x.GetAddress();
+	double* my = y.GetAddress();
+
+	for (int i = 0; i < rows; i++)
+	{
+		double sum = 0;
+		for (int k = mrowindex[i]; k < mrowindex[i+1]; k++)
+			sum += mvalues[k] * mx[mcolindex[k]];
+		my[i] += factor * sum;
+	}
+}
+
+void ChCSRMatrix::MatrTMultiplyInc (const ChMatrix<>& x, ChMatrix<>& y, double factor)
+{
+	assert (x.GetRows() == rows && y.GetRows() == columns);
+	Compress();
+	if (values.empty())
+		return;
+
+	const int* mrowindex = &rowindex[0];
+	const int* mcolindex = &colindex[0];
+	const double* mvalues = &values[0];
+	const double* mx = x.GetAddress();
+	double* my = y.GetAddress();
+
+	for (int i = 0; i < rows; i++)
+	{
+		double xi = factor * mx[i];
+		if (xi == 0)
+			continue;
+		for (int k = mrowindex[i]; k < mrowindex[i+1]; k++)
+			my[mcolindex[k]] += mvalues[k] * xi;
+	}
+}
+
+
+void ChCSRMatrix::MatrTranspose (ChCSRMatrix& dest)
+{
+	assert (&dest != this);
+	Compress();
+
+	dest.Reset(columns, rows);
+	int nnz = (int)values.size();
+	dest.colindex.resize(nnz);
+	dest.values.resize(nnz);
+
+	// count elements per column
+	for (int k = 0; k < nnz; k++)
+		dest.rowindex[colindex[k] + 1]++;
+	for (int j = 0; j < columns; j++)
+		dest.rowindex[j+1] += dest.rowindex[j];
+
+	// scatter, row after row, so the columns of dest are sorted
+	dest.rowstart.assign(dest.rowindex.begin(), dest.rowindex.end() - 1);
+	for (int i = 0; i < rows; i++)
+	{
+		for (int k = rowindex[i]; k < rowindex[i+1]; k++)
+		{
+			int mpos = dest.rowstart[colindex[k]]++;
+			dest.colindex[mpos] = i;
+			dest.values[mpos] = values[k];
+		}
+	}
+}
+
+
+void ChCSRMatrix::MatrScale (double factor)
+{
+	Compress();
+	for (unsigned int k = 0; k < values.size(); k++)
+		values[k] *= factor;
+}
+
+
+void ChCSRMatrix::CopyFromMatrix (ChMatrix<>* matra)
+{
+	Reset(matra->GetRows(), matra->GetColumns());
+	for (int i = 0; i < rows; i++)
+	{
+		for (int j = 0; j < columns; j++)
+		{
+			double val = matra->GetElement(i,j);
+			if (val)
+			{
+				colindex.push_back(j);
+				values.push_back(val);
+			}
+		}
+		rowindex[i+1] = (int)colindex.size();
+	}
+}
+
+void ChCSRMatrix::CopyFromMatrix (ChSparseMatrix* matra)
+{
+	Reset(matra->GetRows(), matra->GetColumns());
+	for (int i = 0; i < rows; i++)
+	{
+		for (ChMelement* mel = matra->GetElarrayMel(i); mel != NULL; mel = mel->next)
+		{
+			if (mel->val)
+				Store(i, mel->col, mel->val, false);
+		}
+	}
+	Compress();
+}
+
+void ChCSRMatrix::CopyToMatrix (ChMatrix<>* matra)
+{
+	Compress();
+	matra->Reset(rows, columns);
+	for (int i = 0; i < rows; i++)
+		for (int k = rowindex[i]; k < rowindex[i+1]; k++)
+			matra->SetElement(i, colindex[k], values[k]);
+}
+
+
+void ChCSRMatrix::StreamOUTsparseMatlabFormat(ChStreamOutAscii& mstream)
+{
+	Compress();
+	bool mlast_written = false;
+	for (int i = 0; i < rows; i++)
+	{
+		for (int k = rowindex[i]; k < rowindex[i+1]; k++)
+		{
+			mstream << i+1 << " " << colindex[k]+1 << " " << values[k] << "\n";
+			mlast_written = (i+1 == rows && colindex[k]+1 == columns);
+		}
+	}
+	// as in ChSparseMatrix, the last element is always written, so Matlab gets the size
+	if (!mlast_written && rows && columns)
+		mstream << rows << " " << columns << " " << 0.0 << "\n";
+}
+
+
+
+} // END_OF_NAMESPACE____
+
+
@@ -0,0 +1,209 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHCSRMATRIX_H
+#define CHCSRMATRIX_H
+
+//////////////////////////////////////////////////
+//
+//   ChCSRMatrix.h
+//
+//   Math functions for :
+//      - SPARSE MATRICES IN COMPRESSED ROW STORAGE
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <vector>
+#include "core/ChSparseMatrixBase.h"
+#include "core/ChSpmatrix.h"
+#include "core/ChStream.h"
+#include "core/ChApiCE.h"
+
+
+namespace chrono
+{
+
+
+//////////////////////////////////////////////////
+// SPARSE MATRIX CLASS, COMPRESSED ROWS
+//
+/// This class defines a sparse matrix in compressed row storage
+/// (CSR): the column indexes and values of the non-zero elements
+/// are stored row after row in two contiguous arrays, and a third
+/// array tells where each row begins. Columns are sorted in each row.
+///
+/// The matrix is assembled quickly from a list of (row,col,value)
+/// triplets: SetElement(), AddElement() and the Paste...() functions
+/// just append triplets, that are sorted and merged in the compressed
+/// arrays only when the matrix is used (or when Compress() is called),
+/// with a radix sort whose cost is linear in the number of elements and
+/// of rows and columns, also for dense rows. Elements that
+/// are already stored are modified in place, so if the matrix is
+/// assembled again with the same pattern after ResetBlocks(),
+/// no triplets are generated at all.
+///
+/// The compressed rows of the transpose matrix are the compressed
+/// columns (CSC) of the matrix, see MatrTranspose().
+///
+/// Example, to get the jacobians of a system:
+///
+///   ChCSRMatrix mCq, mM;
+///   descriptor.ConvertToMatrixForm(&mCq, &mM, 0, 0, 0, 0);
+///   mCq.MatrMultiply(v, Cq_v);
+///
+
+class ChApi ChCSRMatrix : public ChSparseMatrixBase
+{
+public:
+		//
+		// CONSTRUCTORS
+		//
+
+					/// Creates an empty 0x0 matrix.
+	ChCSRMatrix ();
+					/// Creates a null sparse matrix with given size.
+	ChCSRMatrix (int row, int col);
+
+	virtual ~ChCSRMatrix () {};
+
+		//
+		// ASSEMBLY
+		//
+
+					/// Reset to null matrix and (if needed) changes the size.
+					/// The memory of the arrays is kept, to be reused.
+	virtual void Reset(int row, int col);
+	void Reset() {Reset(rows, columns);}
+
+					/// If size does not change, set to zero the stored elements
+					/// but keep the pattern, so that an assembly with the
+					/// same pattern is done in place. Otherwise as Reset().
+	void ResetBlocks(int row, int col);
+
+					/// Reserve memory for 'nelements' triplets, to avoid
+					/// reallocations when the number of elements is known.
+	void Reserve(int nelements) {triplets.reserve(nelements);}
+
+					/// Set the value of an element.
+	virtual void   SetElement (int row, int col, double elem);
+					/// Add a value to an element.
+	void		   AddElement (int row, int col, double elem);
+					/// Get the value of an element (zero if not stored).
+	virtual double GetElement (int row, int col);
+
+	virtual void PasteMatrix (ChMatrix<>* matra, int insrow, int inscol);
+	virtual void PasteTranspMatrix (ChMatrix<>* matra, int insrow, int inscol);
+	virtual void PasteMatrixFloat (ChMatrix<float>* matra, int insrow, int inscol);
+	virtual void PasteTranspMatrixFloat (ChMatrix<float>* matra, int insrow, int inscol);
+	virtual void PasteClippedMatrix (ChMatrix<>* matra, int cliprow, int clipcol, int nrows, int ncolumns, int insrow, int inscol);
+	virtual void PasteSumClippedMatrix (ChMatrix<>* matra, int cliprow, int clipcol, int nrows, int ncolumns, int insrow, int inscol);
+	virtual void PasteSumMatrix (ChMatrix<>* matra, int insrow, int inscol);
+	virtual void PasteSumTranspMatrix (ChMatrix<>* matra, int insrow, int inscol);
+
+					/// Sort and merge the pending triplets into the compressed
+					/// arrays. This is called automatically when needed.
+	void Compress();
+
+					/// Tell if there are no pending triplets.
+	bool IsCompressed() const {return triplets.empty();}
+
+		//
+		// ACCESS
+		//
+
+	int GetRows () const	{ return rows; }
+	int GetColumns () const	{ return columns; }
+
+					/// Number of stored elements.
+	int GetNNZ() {Compress(); return (int)values.size();}
+
+					/// Low level access to the compressed arrays: the elements
+					/// of row i are in GetColIndex()[k], GetValues()[k] for k from
+					/// GetRowIndex()[i] to GetRowIndex()[i+1] (excluded).
+	const int*    GetRowIndex() {Compress(); return &rowindex[0];}
+	const int*    GetColIndex() {Compress(); return colindex.empty() ? 0 : &colindex[0];}
+	double*       GetValues()   {Compress(); return values.empty() ? 0 : &values[0];}
+
+		//
+		// OPERATIONS
+		//
+
+					/// Product with a vector: y = A * x.
+					/// The y vector is resized if needed.
+	void MatrMultiply (const ChMatrix<>& x, ChMatrix<>& y);
+
+					/// Product of the transpose with a vector: y = A' * x.
+					/// The y vector is resized if needed.
+	void MatrTMultiply (const ChMatrix<>& x, ChMatrix<>& y);
+
+					/// Increment with the product with a vector: y += A * x * factor.
+	void MatrMultiplyInc (const ChMatrix<>& x, ChMatrix<>& y, double factor = 1.0);
+
+					/// Increment with the product of the transpose: y += A' * x * factor.
+	void MatrTMultiplyInc (const ChMatrix<>& x, ChMatrix<>& y, double factor = 1.0);
+
+					/// Store in 'dest' the transpose of this matrix (hence, in 'dest'
+					/// there are the compressed columns of this matrix).
+	void MatrTranspose (ChCSRMatrix& dest);
+
+	void MatrScale (double factor);
+
+	void CopyFromMatrix (ChMatrix<>* matra);
+	void CopyFromMatrix (ChSparseMatrix* matra);
+	void CopyToMatrix	(ChMatrix<>* matra);
+
+					/// Method to allow serializing transient data into in ascii stream (es a file)
+					/// as a Matlab sparse matrix format ( each row in file has three elements:
+					///     row,    column,    value
+					/// Note: the row and column indexes start from 1, not 0 as in C language.
+	void StreamOUTsparseMatlabFormat(ChStreamOutAscii& mstream);
+
+private:
+	struct Triplet
+	{
+		int row;
+		int col;
+		double val;
+		bool add;	// add to current value, or replace it
+	};
+
+	int  FindElement(int row, int col);	// index in colindex/values, or -1
+	void Store(int row, int col, double val, bool add);	// in place if stored, else as triplet
+
+	int rows;
+	int columns;
+
+	std::vector<int> rowindex;		// rows+1 offsets in colindex and values
+	std::vector<int> colindex;
+	std::vector<double> values;
+
+	std::vector<Triplet> triplets;	// pending elements, not yet compressed
+
+	std::vector<Triplet> sorted;	// workspace for Compress()
+	std::vector<int> rowstart;
+	std::vector<int> new_rowindex;
+	std::vector<int> new_colindex;
+	std::vector<double> new_values;
+};
+
+
+
+} // END_OF_NAMESPACE____
+
+
+#endif  // END of ChCSRMatrix.h
@@ -0,0 +1,158 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHCHUNKEDPOOL_H
+#define CHCHUNKEDPOOL_H
+
+//////////////////////////////////////////////////
+//
+//   ChChunkedPool.h
+//
+//   Pool of objects allocated in fixed-size chunks,
+//   with stable addresses and indexed access. Objects
+//   are recycled instead of being deleted.
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+#include <vector>
+#include <assert.h>
+
+
+namespace chrono
+{
+
+
+///
+/// Pool of objects of class T, allocated in chunks of CHUNK objects.
+/// Objects are default-constructed once, when their chunk is allocated,
+/// and never move in memory afterwards, so pointers to them (or
+/// pointers between their members) stay valid. The pool is meant to be
+/// rewound and refilled at each time step, as done by contact containers:
+/// Rewind() does not free anything, and Next() returns the objects of the
+/// previous fill for reuse (the caller must re-initialize them, for
+/// instance with a Reset() function), so that in steady state there is
+/// no heap allocation at all. Objects in the used range [0, Size())
+/// can be accessed by index, in chunk-contiguous order.
+///
+
+template <class T, int CHUNK = 128>
+class ChChunkedPool {
+
+	std::vector<T*> chunks;
+	int n_used;
+	int low_fills;		// consecutive fills that used less than half of the chunks, see EndFill()
+	int low_peak;		// max chunks used by those fills
+
+			// no copies: objects would not have stable addresses
+	ChChunkedPool(const ChChunkedPool&);
+	ChChunkedPool& operator=(const ChChunkedPool&);
+
+public:
+	ChChunkedPool() : n_used(0), low_fills(0), low_peak(0) {}
+
+	~ChChunkedPool() { Clear(); }
+
+			/// Number of objects in use, i.e. returned by Next() since last Rewind()
+	int Size() const { return n_used; }
+
+			/// Number of allocated objects, in use or not
+	int Capacity() const { return (int)chunks.size() * CHUNK; }
+
+			/// Access the i-th object in use
+	T& operator[](int i) { assert(i < n_used); return chunks[i / CHUNK][i % CHUNK]; }
+	const T& operator[](int i) const { assert(i < n_used); return chunks[i / CHUNK][i % CHUNK]; }
+
+			/// Get a pointer to the i-th object in use
+	T* Get(int i) { assert(i < n_used); return &chunks[i / CHUNK][i % CHUNK]; }
+
+			/// Return the next object, appending it to the used range.
+			/// The object is recycled from a previous fill if possible,
+			/// otherwise a new chunk is allocated.
+	T* Next()
+		{
+			if (n_used == Capacity())
+				chunks.push_back(new T[CHUNK]);
+			T* mobj = &chunks[n_used / CHUNK][n_used % CHUNK];
+			++n_used;
+			return mobj;
+		}
+
+			/// Empty the used range, but keep all objects for reuse.
+	void Rewind() { n_used = 0; }
+
+			/// Free the chunks beyond the used range, except for 'spare'
+			/// chunks that are kept to avoid reallocations when the number
+			/// of used objects fluctuates.
+	void Trim(int spare = 1)
+		{
+			int needed = (n_used + CHUNK - 1) / CHUNK + spare;
+			while ((int)chunks.size() > needed)
+			{
+				delete[] chunks.back();
+				chunks.pop_back();
+			}
+		}
+
+			/// To be called at the end of each fill (ex. at each time step).
+			/// The capacity is kept at its peak, so that no chunks are freed and
+			/// allocated again when the number of used objects fluctuates: only
+			/// after 'delay' fills in a row that used less than half of the chunks,
+			/// the chunks beyond the max used by those fills (plus a spare one)
+			/// are freed.
+	void EndFill(int delay = 200)
+		{
+			int used_chunks = (n_used + CHUNK - 1) / CHUNK;
+			if (2 * (used_chunks + 1) <= (int)chunks.size())
+			{
+				if (used_chunks > low_peak)
+					low_peak = used_chunks;
+				if (++low_fills >= delay)
+				{
+					while ((int)chunks.size() > low_peak + 1)
+					{
+						delete[] chunks.back();
+						chunks.pop_back();
+					}
+					low_fills = 0;
+					low_peak = 0;
+				}
+			}
+			else
+			{
+				low_fills = 0;
+				low_peak = 0;
+			}
+		}
+
+			/// Free all objects.
+	void Clear()
+		{
+			for (int i = 0; i < (int)chunks.size(); ++i)
+				delete[] chunks[i];
+			chunks.clear();
+			n_used = 0;
+			low_fills = 0;
+			low_peak = 0;
+		}
+};
+
+
+
+} // END_OF_NAMESPACE____
+
+
+#endif
@@ -0,0 +1,114 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChCpuFeatures.cpp
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "core/ChCpuFeatures.h"
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+ #include <intrin.h>
+ #define CH_CPUID_MSVC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+ #include <cpuid.h>
+ #define CH_CPUID_GCC
+#endif
+
+
+namespace chrono
+{
+
+
+#if defined(CH_CPUID_MSVC) || defined(CH_CPUID_GCC)
+
+	// Gets the ecx, edx registers of cpuid function 1
+static void ChCpuid1(unsigned int& mecx, unsigned int& medx)
+{
+#if defined(CH_CPUID_MSVC)
+	int regs[4];
+	__cpuid(regs, 1);
+	mecx = (unsigned int)regs[2];
+	medx = (unsigned int)regs[3];
+#else
+	unsigned int meax, mebx;
+	if (!__get_cpuid(1, &meax, &mebx, &mecx, &medx))
+	{
+		mecx = 0;
+		medx = 0;
+	}
+#endif
+}
+
+	// Gets the low 32 bits of the XCR0 register (only if OSXSAVE is set!)
+static unsigned int ChXgetbv0()
+{
+#if defined(CH_CPUID_MSVC) && (_MSC_FULL_VER >= 160040219)
+	return (unsigned int)_xgetbv(0);
+#elif defined(CH_CPUID_GCC)
+	unsigned int meax, medx;
+	__asm__ __volatile__ (".byte 0x0f, 0x01, 0xd0" : "=a"(meax), "=d"(medx) : "c"(0));
+	return meax;
+#else
+	return 0;
+#endif
+}
+
+static bool ChDetectSSE2()
+{
+	unsigned int mecx, medx;
+	ChCpuid1(mecx, medx);
+	return (medx & (1u << 26)) != 0;
+}
+
+static bool ChDetectAVX()
+{
+	unsigned int mecx, medx;
+	ChCpuid1(mecx, medx);
+	bool cpu_avx = (mecx & (1u << 28)) != 0;
+	bool os_xsave = (mecx & (1u << 27)) != 0;
+	if (!(cpu_avx && os_xsave))
+		return false;
+	// the OS must save both the XMM and YMM registers on context switch
+	return (ChXgetbv0() & 0x6) == 0x6;
+}
+
+#else
+
+static bool ChDetectSSE2() { return false; }
+static bool ChDetectAVX()  { return false; }
+
+#endif
+
+
+bool ChCpuFeatures::HasSSE2()
+{
+	static bool has_sse2 = ChDetectSSE2();
+	return has_sse2;
+}
+
+bool ChCpuFeatures::HasAVX()
+{
+	static bool has_avx = ChDetectAVX();
+	return has_avx;
+}
+
+
+
+} // END_OF_NAMESPACE____
+
+
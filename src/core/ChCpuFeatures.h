@@ -0,0 +1,60 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHCPUFEATURES_H
+#define CHCPUFEATURES_H
+
+//////////////////////////////////////////////////
+//
+//   ChCpuFeatures.h
+//
+//   Run-time detection of the SIMD instruction sets
+//   supported by the CPU, to choose between optimized
+//   code paths.
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "core/ChApiCE.h"
+
+
+namespace chrono
+{
+
+
+/// Class with static functions that tell which SIMD instruction
+/// sets can be used on the current CPU (and operating system).
+/// Detection is done once, at the first call. On non-x86
+/// platforms all functions return false.
+
+class ChApi ChCpuFeatures
+{
+public:
+			/// True if the CPU supports SSE2 instructions
+	static bool HasSSE2();
+
+			/// True if the CPU supports AVX instructions, and the
+			/// operating system saves the AVX registers.
+	static bool HasAVX();
+};
+
+
+
+} // END_OF_NAMESPACE____
+
+
+#endif  // END of ChCpuFeatures.h
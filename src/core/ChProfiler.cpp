@@ -0,0 +1,445 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChProfiler.cpp
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "core/ChProfiler.h"
+
+
+namespace chrono
+{
+
+
+	// Write a number with fixed format, since timestamps of
+	// long runs need more digits than the default of the streams.
+static void ChProfilerWriteNumber(ChStreamOutAscii& mstream, const char* format, double mval)
+{
+	char buffer[64];
+	sprintf(buffer, format, mval);
+	mstream << (const char*)buffer;
+}
+
+	// Write a string as a JSON string, with escapes.
+static void ChProfilerWriteString(ChStreamOutAscii& mstream, const std::string& mstring)
+{
+	std::string mout = "\"";
+	for (size_t i = 0; i < mstring.size(); i++)
+	{
+		char c = mstring[i];
+		if (c == '\"' || c == '\\')
+			mout += '\\';
+		if ((unsigned char)c < 0x20)
+			c = ' ';
+		mout += c;
+	}
+	mout += "\"";
+	mstream << mout;
+}
+
+
+
+double ChProfiler::Node::GetRollingMean() const
+{
+	if (window.empty())
+		return 0;
+	double msum = 0;
+	for (size_t i = 0; i < window.size(); i++)
+		msum += window[i];
+	return msum / window.size();
+}
+
+double ChProfiler::Node::GetRollingMax() const
+{
+	double mmax = 0;
+	for (size_t i = 0; i < window.size(); i++)
+		if (window[i] > mmax)
+			mmax = window[i];
+	return mmax;
+}
+
+
+
+ChProfiler::ChProfiler()
+{
+	record_trace = true;
+	max_trace_events = 1000000;
+	trace_dropped = 0;
+	window_size = 100;
+	clock.start();
+}
+
+
+double ChProfiler::Now()
+{
+	clock.stop();
+	return clock();
+}
+
+
+int ChProfiler::GetChild(int mparent, const char* name)
+{
+	std::vector<int>& mlist = (mparent < 0) ? roots : nodes[mparent].children;
+
+	for (size_t i = 0; i < mlist.size(); i++)
+		if (nodes[mlist[i]].name == name)
+			return mlist[i];
+
+	Node mnode;
+	mnode.name = name;
+	mnode.parent = mparent;
+	mnode.depth = (mparent < 0) ? 0 : nodes[mparent].depth + 1;
+	mnode.ncalls = 0;
+	mnode.total = 0;
+	mnode.last = 0;
+	mnode.min = 0;
+	mnode.max = 0;
+	mnode.window_pos = 0;
+
+	int mindex = (int)nodes.size();
+	nodes.push_back(mnode);
+	// note: 'mlist' may be invalid after push_back, if it was a children list
+	if (mparent < 0)
+		roots.push_back(mindex);
+	else
+		nodes[mparent].children.push_back(mindex);
+	return mindex;
+}
+
+
+int ChProfiler::GetArgName(const char* name)
+{
+	for (size_t i = 0; i < arg_names.size(); i++)
+		if (arg_names[i] == name)
+			return (int)i;
+	arg_names.push_back(name);
+	return (int)arg_names.size() - 1;
+}
+
+
+void ChProfiler::BeginScope(const char* name)
+{
+	int mparent = stack_nodes.empty() ? -1 : stack_nodes.back();
+	int mnode = GetChild(mparent, name);
+	double mstart = Now();
+
+	int mevent = -1;
+	if (record_trace)
+	{
+		if ((int)trace_events.size() < max_trace_events)
+		{
+			TraceEvent mev;
+			mev.node = mnode;
+			mev.start = mstart;
+			mev.duration = 0;
+			mev.first_arg = -1;
+			mev.last_arg = -1;
+			mevent = (int)trace_events.size();
+			trace_events.push_back(mev);
+		}
+		else
+			trace_dropped++;
+	}
+
+	stack_nodes.push_back(mnode);
+	stack_start.push_back(mstart);
+	stack_events.push_back(mevent);
+}
+
+
+void ChProfiler::EndScope()
+{
+	if (stack_nodes.empty())
+		return;
+
+	double mtime = Now() - stack_start.back();
+	Node& mnode = nodes[stack_nodes.back()];
+
+	if (mnode.ncalls == 0 || mtime < mnode.min)
+		mnode.min = mtime;
+	if (mnode.ncalls == 0 || mtime > mnode.max)
+		mnode.max = mtime;
+	mnode.ncalls++;
+	mnode.total += mtime;
+	mnode.last = mtime;
+
+	if ((int)mnode.window.size() < window_size)
+		mnode.window.push_back(mtime);
+	else
+	{
+		mnode.window[mnode.window_pos] = mtime;
+		mnode.window_pos = (mnode.window_pos + 1) % window_size;
+	}
+
+	if (stack_events.back() >= 0)
+		trace_events[stack_events.back()].duration = mtime;
+
+	stack_nodes.pop_back();
+	stack_start.pop_back();
+	stack_events.pop_back();
+}
+
+
+void ChProfiler::AddTraceArg(int mname, double mvalue, int mseries_begin, int mseries_end)
+{
+	if (stack_events.empty() || stack_events.back() < 0)
+		return;
+	TraceEvent& mev = trace_events[stack_events.back()];
+
+	TraceArg marg;
+	marg.name = mname;
+	marg.value = mvalue;
+	marg.series_begin = mseries_begin;
+	marg.series_end = mseries_end;
+	marg.next = -1;
+
+	int mindex = (int)trace_args.size();
+	trace_args.push_back(marg);
+	if (mev.last_arg >= 0)
+		trace_args[mev.last_arg].next = mindex;
+	else
+		mev.first_arg = mindex;
+	mev.last_arg = mindex;
+}
+
+
+void ChProfiler::SetCounter(const char* name, double value)
+{
+	if (stack_nodes.empty())
+		return;
+
+	Node& mnode = nodes[stack_nodes.back()];
+	size_t i = 0;
+	while (i < mnode.counters.size() && mnode.counters[i].name != name)
+		i++;
+	if (i == mnode.counters.size())
+	{
+		Counter mcounter;
+		mcounter.name = name;
+		mcounter.sum = 0;
+		mcounter.samples = 0;
+		mnode.counters.push_back(mcounter);
+	}
+	mnode.counters[i].last = value;
+	mnode.counters[i].sum += value;
+	mnode.counters[i].samples++;
+
+	AddTraceArg(GetArgName(name), value, -1, -1);
+}
+
+
+void ChProfiler::SetSeries(const char* name, const std::vector<double>& values)
+{
+	if (stack_events.empty() || stack_events.back() < 0)
+		return;
+
+	int mbegin = (int)trace_series.size();
+	trace_series.insert(trace_series.end(), values.begin(), values.end());
+
+	AddTraceArg(GetArgName(name), 0, mbegin, (int)trace_series.size());
+}
+
+
+int ChProfiler::FindNode(const char* path)
+{
+	std::string mpath(path);
+	int mnode = -1;
+	size_t mpos = 0;
+	while (mpos <= mpath.size())
+	{
+		size_t mend = mpath.find('/', mpos);
+		if (mend == std::string::npos)
+			mend = mpath.size();
+		std::string mname = mpath.substr(mpos, mend - mpos);
+
+		std::vector<int>& mlist = (mnode < 0) ? roots : nodes[mnode].children;
+		int mfound = -1;
+		for (size_t i = 0; i < mlist.size(); i++)
+			if (nodes[mlist[i]].name == mname)
+				mfound = mlist[i];
+		if (mfound < 0)
+			return -1;
+		mnode = mfound;
+		mpos = mend + 1;
+	}
+	return mnode;
+}
+
+
+void ChProfiler::Reset()
+{
+	nodes.clear();
+	roots.clear();
+	stack_nodes.clear();
+	stack_start.clear();
+	stack_events.clear();
+	arg_names.clear();
+	ClearTrace();
+	clock.start();
+}
+
+
+void ChProfiler::ClearTrace()
+{
+	trace_events.clear();
+	trace_args.clear();
+	trace_series.clear();
+	trace_dropped = 0;
+	// events of scopes still open are lost
+	for (size_t i = 0; i < stack_events.size(); i++)
+		stack_events[i] = -1;
+}
+
+
+void ChProfiler::WriteChromeTrace(ChStreamOutAscii& mstream)
+{
+	mstream << "{\"traceEvents\":[\n";
+	for (size_t i = 0; i < trace_events.size(); i++)
+	{
+		const TraceEvent& mev = trace_events[i];
+		mstream << "{\"name\":";
+		ChProfilerWriteString(mstream, nodes[mev.node].name);
+		mstream << ",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":";
+		ChProfilerWriteNumber(mstream, "%.3f", mev.start * 1e6);
+		mstream << ",\"dur\":";
+		ChProfilerWriteNumber(mstream, "%.3f", mev.duration * 1e6);
+		if (mev.first_arg >= 0)
+		{
+			mstream << ",\"args\":{";
+			for (int ia = mev.first_arg; ia >= 0; ia = trace_args[ia].next)
+			{
+				const TraceArg& marg = trace_args[ia];
+				if (ia != mev.first_arg)
+					mstream << ",";
+				ChProfilerWriteString(mstream, arg_names[marg.name]);
+				mstream << ":";
+				if (marg.series_begin >= 0)
+				{
+					mstream << "[";
+					for (int is = marg.series_begin; is < marg.series_end; is++)
+					{
+						if (is != marg.series_begin)
+							mstream << ",";
+						ChProfilerWriteNumber(mstream, "%.9g", trace_series[is]);
+					}
+					mstream << "]";
+				}
+				else
+					ChProfilerWriteNumber(mstream, "%.9g", marg.value);
+			}
+			mstream << "}";
+		}
+		mstream << "}";
+		if (i + 1 < trace_events.size())
+			mstream << ",";
+		mstream << "\n";
+	}
+	mstream << "],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+
+void ChProfiler::WriteNodeStatistics(ChStreamOutAscii& mstream, int mnode)
+{
+	const Node& mn = nodes[mnode];
+	mstream << "{\"name\":";
+	ChProfilerWriteString(mstream, mn.name);
+	mstream << ",\"calls\":" << mn.ncalls;
+	mstream << ",\"total\":";		ChProfilerWriteNumber(mstream, "%.9g", mn.total);
+	mstream << ",\"mean\":";		ChProfilerWriteNumber(mstream, "%.9g", mn.GetMean());
+	mstream << ",\"min\":";			ChProfilerWriteNumber(mstream, "%.9g", mn.min);
+	mstream << ",\"max\":";			ChProfilerWriteNumber(mstream, "%.9g", mn.max);
+	mstream << ",\"last\":";		ChProfilerWriteNumber(mstream, "%.9g", mn.last);
+	mstream << ",\"rolling_mean\":";ChProfilerWriteNumber(mstream, "%.9g", mn.GetRollingMean());
+	mstream << ",\"rolling_max\":";	ChProfilerWriteNumber(mstream, "%.9g", mn.GetRollingMax());
+	mstream << ",\"counters\":{";
+	for (size_t i = 0; i < mn.counters.size(); i++)
+	{
+		if (i)
+			mstream << ",";
+		ChProfilerWriteString(mstream, mn.counters[i].name);
+		mstream << ":{\"last\":";
+		ChProfilerWriteNumber(mstream, "%.9g", mn.counters[i].last);
+		mstream << ",\"mean\":";
+		ChProfilerWriteNumber(mstream, "%.9g", mn.counters[i].sum / mn.counters[i].samples);
+		mstream << "}";
+	}
+	mstream << "},\"children\":[";
+	for (size_t i = 0; i < mn.children.size(); i++)
+	{
+		if (i)
+			mstream << ",";
+		WriteNodeStatistics(mstream, mn.children[i]);
+	}
+	mstream << "]}";
+}
+
+
+void ChProfiler::WriteStatistics(ChStreamOutAscii& mstream)
+{
+	mstream << "{\"window\":" << window_size << ",\"scopes\":[";
+	for (size_t i = 0; i < roots.size(); i++)
+	{
+		if (i)
+			mstream << ",";
+		mstream << "\n";
+		WriteNodeStatistics(mstream, roots[i]);
+	}
+	mstream << "\n]}\n";
+}
+
+
+void ChProfiler::ReportNodeStatistics(ChStreamOutAscii& mstream, int mnode)
+{
+	const Node& mn = nodes[mnode];
+
+	char buffer[200];
+	std::string mname(2 * mn.depth, ' ');
+	mname += mn.name;
+	sprintf(buffer, "%-40s %9d %12.6f %12.6f %12.6f %12.6f",
+		mname.c_str(), mn.ncalls, mn.total, mn.GetMean(), mn.GetRollingMean(), mn.max);
+	mstream << (const char*)buffer;
+	for (size_t i = 0; i < mn.counters.size(); i++)
+	{
+		mstream << "  " << mn.counters[i].name.c_str() << "=";
+		ChProfilerWriteNumber(mstream, "%g", mn.counters[i].sum / mn.counters[i].samples);
+	}
+	mstream << "\n";
+
+	for (size_t i = 0; i < mn.children.size(); i++)
+		ReportNodeStatistics(mstream, mn.children[i]);
+}
+
+
+void ChProfiler::ReportStatistics(ChStreamOutAscii& mstream)
+{
+	char buffer[200];
+	sprintf(buffer, "%-40s %9s %12s %12s %12s %12s  %s\n",
+		"scope", "calls", "total[s]", "mean[s]", "rolling[s]", "max[s]", "mean counters");
+	mstream << (const char*)buffer;
+	for (size_t i = 0; i < roots.size(); i++)
+		ReportNodeStatistics(mstream, roots[i]);
+}
+
+
+
+} // END_OF_NAMESPACE____
+
+
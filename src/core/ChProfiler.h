@@ -0,0 +1,257 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHPROFILER_H
+#define CHPROFILER_H
+
+//////////////////////////////////////////////////
+//
+//   ChProfiler.h
+//
+//   Hierarchical profiler, with statistics of the
+//   time spent in nested scopes and trace output
+//   in Chrome trace (JSON) format.
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <string>
+#include <vector>
+#include "core/ChApiCE.h"
+#include "core/ChStream.h"
+#include "core/ChTimer.h"
+
+
+namespace chrono
+{
+
+
+/// Hierarchical profiler. Code is instrumented with pairs of
+/// BeginScope() / EndScope() calls (or with a ChProfileScope object),
+/// that can be nested: each distinct path of nested scope names
+/// becomes a node of a tree, that keeps statistics about the time
+/// spent in that scope (number of calls, total, min, max, and a
+/// rolling mean over the last calls). Counters, like the number of
+/// contacts or constraints, can be attached to the innermost open scope.
+///
+/// Optionally each scope is also recorded as an event of a trace,
+/// that can be saved in the Chrome trace JSON format and inspected
+/// with chrome://tracing or similar viewers.
+///
+/// The profiler is not thread-safe: scopes must be opened and closed
+/// by a single thread (ex. around OpenMP parallel loops, not inside).
+///
+/// How to use it:
+///
+///  ChProfiler profiler;
+///  my_system.SetProfiler(&profiler);
+///  ... do some steps...
+///  profiler.ReportStatistics(GetLog());
+///  ChStreamOutAsciiFile mfile("trace.json");
+///  profiler.WriteChromeTrace(mfile);
+///
+
+class ChApi ChProfiler
+{
+public:
+			/// Statistics of a value attached to a scope, see SetCounter()
+	struct Counter
+	{
+		std::string name;
+		double last;
+		double sum;
+		int samples;
+	};
+
+			/// A node of the tree of scopes, with its statistics
+	struct Node
+	{
+		std::string name;
+		int parent;					///< index of parent node, or -1 for root scopes
+		int depth;					///< nesting level, 0 for root scopes
+		std::vector<int> children;	///< indexes of children nodes
+		int ncalls;
+		double total;				///< total time [s]
+		double last;				///< time of last call [s]
+		double min;
+		double max;
+		std::vector<double> window;	///< times of last calls, circular buffer
+		int window_pos;
+		std::vector<Counter> counters;
+
+				/// Mean time of the last calls, up to the size of the window [s]
+		double GetRollingMean() const;
+				/// Max time of the last calls, up to the size of the window [s]
+		double GetRollingMax() const;
+				/// Mean time of all calls [s]
+		double GetMean() const {return ncalls ? total/ncalls : 0;}
+	};
+
+	ChProfiler();
+	virtual ~ChProfiler() {};
+
+			//
+			// INSTRUMENTATION
+			//
+
+			/// Open a scope, nested in the current one (if any).
+	void BeginScope(const char* name);
+
+			/// Close the innermost open scope, updating its statistics.
+	void EndScope();
+
+			/// Attach a value to the innermost open scope (ex. the number of
+			/// contacts). Its statistics are kept in the node, and the value
+			/// is saved among the arguments of the trace event.
+	void SetCounter(const char* name, double value);
+
+			/// Attach a sequence of values to the innermost open scope
+			/// (ex. the residual at each iteration of a solver). This is saved
+			/// only in the trace event, as an array argument.
+	void SetSeries(const char* name, const std::vector<double>& values);
+
+			//
+			// SETTINGS
+			//
+
+			/// Turn on/off the recording of the trace events (default: on).
+			/// Statistics are always computed.
+	void SetRecordTrace(bool mrec) {record_trace = mrec;}
+	bool GetRecordTrace() {return record_trace;}
+
+			/// Set the max number of trace events kept in memory (default
+			/// 1000000): when reached, further events are dropped, so for very
+			/// long runs one should save and clear the trace periodically.
+	void SetMaxTraceEvents(int mmax) {max_trace_events = mmax;}
+	int  GetMaxTraceEvents() {return max_trace_events;}
+
+			/// Set the number of last calls used for the rolling statistics
+			/// of the nodes (default 100). Call this before profiling.
+	void SetStatisticsWindow(int mwindow) {window_size = (mwindow > 0) ? mwindow : 1;}
+	int  GetStatisticsWindow() {return window_size;}
+
+			//
+			// RESULTS
+			//
+
+			/// Number of nodes in the tree of scopes.
+	int GetNnodes() {return (int)nodes.size();}
+
+			/// Access the i-th node of the tree of scopes.
+	const Node& GetNode(int i) {return nodes[i];}
+
+			/// Find the node with the given path of scope names, separated
+			/// by '/', ex. "Step/ComputeCollisions/Broadphase". Returns -1 if none.
+	int FindNode(const char* path);
+
+			/// Number of trace events in memory, and number of events dropped
+			/// because the max was reached.
+	int GetNtraceEvents() {return (int)trace_events.size();}
+	int GetNtraceEventsDropped() {return trace_dropped;}
+
+			/// Remove all statistics and trace events, and restart the clock.
+	void Reset();
+
+			/// Remove the trace events only (keep the statistics).
+	void ClearTrace();
+
+			/// Write the trace events in Chrome trace JSON format.
+	void WriteChromeTrace(ChStreamOutAscii& mstream);
+
+			/// Write the statistics of all nodes in JSON format.
+	void WriteStatistics(ChStreamOutAscii& mstream);
+
+			/// Write the statistics of all nodes as an indented, human-readable table.
+	void ReportStatistics(ChStreamOutAscii& mstream);
+
+private:
+	struct TraceEvent
+	{
+		int node;
+		double start;
+		double duration;
+		int first_arg;
+		int last_arg;
+	};
+	struct TraceArg
+	{
+		int name;					// index in arg_names
+		double value;
+		int series_begin;			// range in trace_series, or -1 if the arg is a scalar
+		int series_end;
+		int next;					// next arg of the same event, or -1
+	};
+
+	double Now();
+	int GetChild(int mparent, const char* name);
+	int GetArgName(const char* name);
+	void AddTraceArg(int mname, double mvalue, int mseries_begin, int mseries_end);
+	void WriteNodeStatistics(ChStreamOutAscii& mstream, int mnode);
+	void ReportNodeStatistics(ChStreamOutAscii& mstream, int mnode);
+
+	ChTimer<double> clock;
+
+	std::vector<Node> nodes;
+	std::vector<int> roots;
+
+	std::vector<int> stack_nodes;		// open scopes
+	std::vector<double> stack_start;
+	std::vector<int> stack_events;		// their trace event, or -1
+
+	bool record_trace;
+	int max_trace_events;
+	int trace_dropped;
+	int window_size;
+
+	std::vector<TraceEvent> trace_events;
+	std::vector<TraceArg> trace_args;
+	std::vector<double> trace_series;
+	std::vector<std::string> arg_names;
+};
+
+
+
+/// Helper to profile a scope: the constructor calls BeginScope() and
+/// the destructor calls EndScope(). If the profiler is null this
+/// does nothing, so instrumented code can run without profiling.
+///
+///  {
+///     ChProfileScope mscope(profiler, "Update");
+///     ...
+///  }
+
+class ChProfileScope
+{
+public:
+	ChProfileScope(ChProfiler* mprofiler, const char* name) : profiler(mprofiler)
+				{
+					if (profiler) profiler->BeginScope(name);
+				}
+	~ChProfileScope()
+				{
+					if (profiler) profiler->EndScope();
+				}
+private:
+	ChProfiler* profiler;
+};
+
+
+
+} // END_OF_NAMESPACE____
+
+
+#endif  // END of ChProfiler.h
@@ -0,0 +1,556 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChSparseLDL.cpp
+//
+//   The symbolic and numeric factorizations follow
+//   the up-looking LDL' algorithm of T.A.Davis,
+//   "Algorithm 849: A concise sparse Cholesky
+//   factorization package", ACM TOMS 31(4), 2005.
+//   The ordering is a minimum degree method on the
+//   quotient graph, with approximate degrees as in
+//   Amestoy, Davis, Duff, "An approximate minimum
+//   degree ordering algorithm", SIAM J. Matrix Anal.
+//   Appl. 17(4), 1996.
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <math.h>
+#include <string.h>
+#include "core/ChSparseLDL.h"
+
+
+namespace chrono
+{
+
+
+// Lists of nodes with the same degree, for the minimum degree ordering.
+
+class ChDegreeLists
+{
+public:
+	void Setup(int maxdegree, int nnodes)
+	{
+		head.assign(maxdegree + 1, -1);
+		next.assign(nnodes, -1);
+		prev.assign(nnodes, -1);
+		degree.assign(nnodes, -1);
+		mindegree = maxdegree + 1;
+	}
+
+	void Insert(int i, int d)
+	{
+		degree[i] = d;
+		prev[i] = -1;
+		next[i] = head[d];
+		if (head[d] >= 0)
+			prev[head[d]] = i;
+		head[d] = i;
+		if (d < mindegree)
+			mindegree = d;
+	}
+
+	void Remove(int i)
+	{
+		int d = degree[i];
+		if (d < 0)
+			return; // not in lists
+		if (prev[i] >= 0)
+			next[prev[i]] = next[i];
+		else
+			head[d] = next[i];
+		if (next[i] >= 0)
+			prev[next[i]] = prev[i];
+		degree[i] = -1;
+	}
+
+	int PopMin()
+	{
+		while (mindegree < (int)head.size() && head[mindegree] < 0)
+			mindegree++;
+		if (mindegree >= (int)head.size())
+			return -1;
+		int i = head[mindegree];
+		Remove(i);
+		return i;
+	}
+
+private:
+	std::vector<int> head;
+	std::vector<int> next;
+	std::vector<int> prev;
+	std::vector<int> degree;
+	int mindegree;
+};
+
+
+
+
+ChSparseLDL::ChSparseLDL()
+{
+	analyzed = false;
+	n = 0;
+	regularization = 1e-12;
+	nregularized = 0;
+	nwrongsign = 0;
+}
+
+
+void ChSparseLDL::ComputeOrdering(ChCSRMatrix& A, const std::vector<int>* blocks)
+{
+	// Groups of rows, ordered as single nodes
+
+	std::vector<int> bstart;
+	if (blocks && blocks->size() >= 2)
+	{
+		bstart = *blocks;
+		assert(bstart.front() == 0 && bstart.back() == n);
+	}
+	else
+	{
+		bstart.resize(n + 1);
+		for (int i = 0; i <= n; i++)
+			bstart[i] = i;
+	}
+	int nb = (int)bstart.size() - 1;
+
+	std::vector<int> blockof(n);
+	std::vector<int> w(nb);
+	std::vector<char> deferred(nb);
+	int wtot = 0;
+	for (int b = 0; b < nb; b++)
+	{
+		for (int i = bstart[b]; i < bstart[b+1]; i++)
+			blockof[i] = b;
+		w[b] = bstart[b+1] - bstart[b];
+		wtot += w[b];
+		deferred[b] = (w[b] > 0 && sign[bstart[b]] < 0);
+	}
+
+	// Graph of the blocks
+
+	const int* rowindex = A.GetRowIndex();
+	const int* colindex = A.GetColIndex();
+
+	std::vector< std::vector<int> > adj(nb);
+	std::vector<int> mark(nb, -1);
+	for (int b = 0; b < nb; b++)
+	{
+		mark[b] = b;
+		for (int i = bstart[b]; i < bstart[b+1]; i++)
+			for (int k = rowindex[i]; k < rowindex[i+1]; k++)
+			{
+				int c = blockof[colindex[k]];
+				if (mark[c] != b)
+				{
+					mark[c] = b;
+					adj[b].push_back(c);
+				}
+			}
+	}
+
+	// Minimum degree on the quotient graph: the eliminated nodes
+	// become 'elements', i.e. cliques of the nodes that were adjacent
+	// to them, so that the fill-in is never stored explicitly.
+
+	std::vector< std::vector<int> > Av(adj);	// adjacent variables
+	std::vector< std::vector<int> > Ev(nb);		// adjacent elements
+	std::vector< std::vector<int> > Le(nb);		// variables of elements
+	std::vector<int> Lw(nb, 0);					// weight of variables of elements
+	std::vector<char> status(nb, 0);			// 0 variable, 1 element, 2 absorbed element
+	std::vector<int> ndeferred(nb, 0);			// non-deferred neighbours still to eliminate
+	std::vector<int> wext(nb, 0);				// weight of variables of elements, outside current pivot
+	std::vector<int> wext_stamp(nb, -1);
+	std::vector<int> inpivot(nb, -1);
+
+	ChDegreeLists lists;
+	lists.Setup(wtot, nb);
+
+	for (int b = 0; b < nb; b++)
+	{
+		int d = 0;
+		for (unsigned int j = 0; j < adj[b].size(); j++)
+		{
+			int u = adj[b][j];
+			if (u == b)
+				continue;
+			d += w[u];
+			if (deferred[b] && !deferred[u])
+				ndeferred[b]++;
+		}
+		if (!deferred[b] || ndeferred[b] == 0)
+			lists.Insert(b, d);
+	}
+
+	std::vector<int> order;
+	order.reserve(nb);
+	int wleft = wtot;
+
+	while ((int)order.size() < nb)
+	{
+		int p = lists.PopMin();
+		if (p < 0)
+		{
+			// should not happen, but in case pick any remaining node
+			for (int b = 0; b < nb; b++)
+				if (status[b] == 0) {p = b; break;}
+		}
+
+		order.push_back(p);
+		status[p] = 1;
+		wleft -= w[p];
+
+		// the pivot becomes an element, with all the variables adjacent
+		// to it directly or through other elements, that are absorbed
+		std::vector<int>& Lpivot = Le[p];
+		Lpivot.clear();
+		inpivot[p] = p;
+		for (unsigned int j = 0; j < Av[p].size(); j++)
+		{
+			int u = Av[p][j];
+			if (status[u] == 0 && inpivot[u] != p)
+			{
+				inpivot[u] = p;
+				Lpivot.push_back(u);
+			}
+		}
+		for (unsigned int j = 0; j < Ev[p].size(); j++)
+		{
+			int e = Ev[p][j];
+			if (status[e] != 1)
+				continue;
+			for (unsigned int h = 0; h < Le[e].size(); h++)
+			{
+				int u = Le[e][h];
+				if (status[u] == 0 && inpivot[u] != p)
+				{
+					inpivot[u] = p;
+					Lpivot.push_back(u);
+				}
+			}
+			status[e] = 2;
+			std::vector<int>().swap(Le[e]);
+		}
+		std::vector<int>().swap(Av[p]);
+		std::vector<int>().swap(Ev[p]);
+
+		Lw[p] = 0;
+		for (unsigned int j = 0; j < Lpivot.size(); j++)
+			Lw[p] += w[Lpivot[j]];
+
+		if (!deferred[p])
+			for (unsigned int j = 0; j < adj[p].size(); j++)
+				if (deferred[adj[p][j]])
+					ndeferred[adj[p][j]]--;
+
+		// weight of the other elements, outside the pivot element
+		for (unsigned int j = 0; j < Lpivot.size(); j++)
+		{
+			int v = Lpivot[j];
+			lists.Remove(v);
+			for (unsigned int h = 0; h < Ev[v].size(); h++)
+			{
+				int e = Ev[v][h];
+				if (status[e] != 1)
+					continue;
+				if (wext_stamp[e] != p)
+				{
+					wext_stamp[e] = p;
+					wext[e] = Lw[e];
+				}
+				wext[e] -= w[v];
+			}
+		}
+
+		// update the adjacency and the approximate degree of the variables of the pivot
+		for (unsigned int j = 0; j < Lpivot.size(); j++)
+		{
+			int v = Lpivot[j];
+			int d = 0;
+
+			unsigned int ne = 0;
+			for (unsigned int h = 0; h < Ev[v].size(); h++)
+			{
+				int e = Ev[v][h];
+				if (status[e] != 1)
+					continue;
+				if (wext[e] <= 0)
+				{
+					// all variables of e are in the pivot element: absorb e
+					status[e] = 2;
+					std::vector<int>().swap(Le[e]);
+					continue;
+				}
+				Ev[v][ne++] = e;
+				d += wext[e];
+			}
+			Ev[v].resize(ne);
+			Ev[v].push_back(p);
+
+			unsigned int na = 0;
+			for (unsigned int h = 0; h < Av[v].size(); h++)
+			{
+				int u = Av[v][h];
+				if (status[u] != 0 || inpivot[u] == p || u == v)
+					continue;
+				Av[v][na++] = u;
+				d += w[u];
+			}
+			Av[v].resize(na);
+
+			d += Lw[p] - w[v];
+			if (d > wleft - w[v])
+				d = wleft - w[v];
+			if (d < 0)
+				d = 0;
+
+			if (!deferred[v] || ndeferred[v] == 0)
+				lists.Insert(v, d);
+		}
+	}
+
+	// Expand the order of the blocks into the permutation of the rows
+
+	P.resize(n);
+	Pinv.resize(n);
+	int k = 0;
+	for (int j = 0; j < nb; j++)
+	{
+		int b = order[j];
+		for (int i = bstart[b]; i < bstart[b+1]; i++)
+		{
+			P[k] = i;
+			Pinv[i] = k;
+			k++;
+		}
+	}
+}
+
+
+void ChSparseLDL::Analyze(ChCSRMatrix& A,
+						  const std::vector<int>* blocks,
+						  const std::vector<int>* signs)
+{
+	assert(A.GetRows() == A.GetColumns());
+
+	A.Compress();
+	n = A.GetRows();
+	analyzed = false;
+
+	if (signs)
+	{
+		assert((int)signs->size() == n);
+		sign = *signs;
+	}
+	else
+		sign.assign(n, 0);
+
+	ComputeOrdering(A, blocks);
+
+	// Keep the pattern, to check if it changes later
+
+	const int* rowindex = A.GetRowIndex();
+	const int* colindex = A.GetColIndex();
+	pattern_rowindex.assign(rowindex, rowindex + n + 1);
+	pattern_colindex.assign(colindex, colindex + rowindex[n]);
+
+	// Elimination tree and number of elements in each column of L
+
+	Parent.resize(n);
+	Lnz.resize(n);
+	Flag.resize(n);
+	Lp.resize(n + 1);
+
+	for (int k = 0; k < n; k++)
+	{
+		Parent[k] = -1;
+		Flag[k] = k;
+		Lnz[k] = 0;
+		int kk = P[k];
+		for (int p = rowindex[kk]; p < rowindex[kk+1]; p++)
+		{
+			int i = Pinv[colindex[p]];
+			if (i < k)
+			{
+				// follow the path from i to the root of the etree, stop at flagged node
+				for ( ; Flag[i] != k; i = Parent[i])
+				{
+					if (Parent[i] == -1)
+						Parent[i] = k;
+					Lnz[i]++;
+					Flag[i] = k;
+				}
+			}
+		}
+	}
+
+	Lp[0] = 0;
+	for (int k = 0; k < n; k++)
+		Lp[k+1] = Lp[k] + Lnz[k];
+
+	Li.resize(Lp[n]);
+	Lx.resize(Lp[n]);
+	D.resize(n);
+	Y.assign(n, 0.0);
+	Pattern.resize(n);
+
+	analyzed = true;
+}
+
+
+bool ChSparseLDL::HasSamePattern(ChCSRMatrix& A)
+{
+	if (!analyzed || A.GetRows() != n || A.GetColumns() != n)
+		return false;
+	if (A.GetNNZ() != (int)pattern_colindex.size())
+		return false;
+	const int* rowindex = A.GetRowIndex();
+	const int* colindex = A.GetColIndex();
+	if (memcmp(rowindex, &pattern_rowindex[0], (n+1)*sizeof(int)) != 0)
+		return false;
+	if (pattern_colindex.size() && memcmp(colindex, &pattern_colindex[0], pattern_colindex.size()*sizeof(int)) != 0)
+		return false;
+	return true;
+}
+
+
+bool ChSparseLDL::Factorize(ChCSRMatrix& A)
+{
+	assert(analyzed && HasSamePattern(A));
+
+	const int* rowindex = A.GetRowIndex();
+	const int* colindex = A.GetColIndex();
+	const double* values = A.GetValues();
+
+	// threshold for small pivots, relative to the largest diagonal element
+	double maxdiag = 0;
+	for (int i = 0; i < n; i++)
+		for (int p = rowindex[i]; p < rowindex[i+1]; p++)
+			if (colindex[p] == i && fabs(values[p]) > maxdiag)
+				maxdiag = fabs(values[p]);
+	double threshold = regularization * (maxdiag > 0 ? maxdiag : 1.0);
+
+	nregularized = 0;
+	nwrongsign = 0;
+
+	for (int k = 0; k < n; k++)
+	{
+		// compute the nonzero pattern of the k-th row of L, in topological order
+		Y[k] = 0.0;
+		int top = n;
+		Flag[k] = k;
+		Lnz[k] = 0;
+		int kk = P[k];
+		for (int p = rowindex[kk]; p < rowindex[kk+1]; p++)
+		{
+			int i = Pinv[colindex[p]];
+			if (i <= k)
+			{
+				Y[i] += values[p];	// scatter A(i,k) into Y
+				int len;
+				for (len = 0; Flag[i] != k; i = Parent[i])
+				{
+					Pattern[len++] = i;
+					Flag[i] = k;
+				}
+				while (len > 0)
+					Pattern[--top] = Pattern[--len];
+			}
+		}
+
+		// compute numerical values of the k-th row of L (a sparse triangular solve)
+		D[k] = Y[k];
+		Y[k] = 0.0;
+		for ( ; top < n; top++)
+		{
+			int i = Pattern[top];
+			double yi = Y[i];
+			Y[i] = 0.0;
+			int p;
+			int p2 = Lp[i] + Lnz[i];
+			for (p = Lp[i]; p < p2; p++)
+				Y[Li[p]] -= Lx[p] * yi;
+			double l_ki = yi / D[i];
+			D[k] -= l_ki * yi;
+			Li[p] = k;
+			Lx[p] = l_ki;
+			Lnz[i]++;
+		}
+
+		// regularize small pivots: these get the magnitude of the threshold,
+		// and the expected sign if known. Larger pivots with the wrong sign
+		// are kept (the factorization is still exact) but reported: the
+		// matrix is not the expected saddle point matrix.
+		int s = sign[kk];
+		if (fabs(D[k]) < threshold)
+		{
+			if (s == 0)
+				s = (D[k] >= 0) ? 1 : -1;
+			D[k] = s * threshold;
+			nregularized++;
+		}
+		else if (s * D[k] < 0)
+			nwrongsign++;
+	}
+
+	return (nwrongsign == 0);
+}
+
+
+void ChSparseLDL::Solve(const ChMatrix<>& b, ChMatrix<>& x)
+{
+	assert(analyzed);
+	assert(b.GetRows() == n);
+
+	// Y = P*b
+	for (int k = 0; k < n; k++)
+		Y[k] = b.ElementN(P[k]);
+
+	// solve L*y = Y
+	for (int j = 0; j < n; j++)
+	{
+		double yj = Y[j];
+		for (int p = Lp[j]; p < Lp[j+1]; p++)
+			Y[Li[p]] -= Lx[p] * yj;
+	}
+	// solve D*y = Y
+	for (int j = 0; j < n; j++)
+		Y[j] /= D[j];
+	// solve L'*y = Y
+	for (int j = n-1; j >= 0; j--)
+	{
+		double yj = Y[j];
+		for (int p = Lp[j]; p < Lp[j+1]; p++)
+			yj -= Lx[p] * Y[Li[p]];
+		Y[j] = yj;
+	}
+
+	// x = P'*Y
+	if (x.GetRows() != n || x.GetColumns() != 1)
+		x.Resize(n, 1);
+	for (int k = 0; k < n; k++)
+	{
+		x.ElementN(P[k]) = Y[k];
+		Y[k] = 0.0;
+	}
+}
+
+
+
+} // END_OF_NAMESPACE____
+
+
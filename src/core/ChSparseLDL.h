@@ -0,0 +1,154 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHSPARSELDL_H
+#define CHSPARSELDL_H
+
+//////////////////////////////////////////////////
+//
+//   ChSparseLDL.h
+//
+//   Sparse LDL' factorization of symmetric matrices
+//   in compressed row storage, with fill-reducing
+//   ordering.
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <vector>
+#include "core/ChCSRMatrix.h"
+#include "core/ChApiCE.h"
+
+
+namespace chrono
+{
+
+
+/// Sparse direct solver for symmetric (also indefinite) linear
+/// systems A*x=b, with A stored in a ChCSRMatrix (both the upper and
+/// the lower triangles must be stored), by the factorization
+/// P*A*P' = L*D*L' where L is unit lower triangular and D diagonal.
+///
+/// The work is split in two phases:
+/// - Analyze(): symbolic analysis, that depends only on the pattern of A:
+///   a fill-reducing permutation P computed with an approximate minimum
+///   degree method, the elimination tree and the pattern of L.
+/// - Factorize(): numeric factorization, that can be repeated for
+///   matrices with the same pattern (see HasSamePattern()) without
+///   repeating the analysis.
+///
+/// Rows can be grouped in blocks (ex. the 3 or 6 coordinates of nodes and
+/// bodies), that are ordered as single nodes: this makes the ordering
+/// faster and keeps the rows of each block contiguous.
+///
+/// For saddle point (KKT) matrices, as | H Cq'; Cq E | with H positive
+/// definite and E negative semidefinite, pass also the expected sign of
+/// each pivot (+1 for H rows, -1 for constraint rows): the rows of
+/// constraints are eliminated only after the rows they are coupled to,
+/// so that no pivoting is needed, and pivots that are too small (ex. for
+/// redundant constraints) are regularized with the expected sign. Larger
+/// pivots with the wrong sign make Factorize() fail (ex. if H is not
+/// positive definite).
+
+class ChApi ChSparseLDL
+{
+public:
+	ChSparseLDL();
+	virtual ~ChSparseLDL() {};
+
+				/// Symbolic analysis of the pattern of the square matrix A.
+				/// Optional 'blocks' are the indexes of the first rows of groups of
+				/// rows that are ordered together, plus the number of rows at the end.
+				/// Optional 'signs' are the expected signs of the pivots, one per row.
+	void Analyze(ChCSRMatrix& A,
+				 const std::vector<int>* blocks = 0,
+				 const std::vector<int>* signs = 0);
+
+				/// Tell if Analyze() has been done.
+	bool IsAnalyzed() {return analyzed;}
+
+				/// Tell if the pattern of A is the same of the last Analyze(),
+				/// so that Factorize() can be called without a new analysis.
+	bool HasSamePattern(ChCSRMatrix& A);
+
+				/// Numeric factorization of A, that must have the pattern
+				/// used in Analyze(). Returns false if some pivots larger than
+				/// the regularization threshold have a sign opposite to the
+				/// expected one (see GetNwrongSign()): the factorization is
+				/// still done, without pivoting, but it may be inaccurate.
+	bool Factorize(ChCSRMatrix& A);
+
+				/// Solve A*x=b using the factorization.
+				/// The x vector is resized if needed.
+	void Solve(const ChMatrix<>& b, ChMatrix<>& x);
+
+				/// Pivots whose magnitude is smaller than this value, relative to
+				/// the largest diagonal element, are regularized (default 1e-12):
+				/// they get this magnitude, with the expected sign if known.
+	void   SetRegularization(double mreg) {regularization = mreg;}
+	double GetRegularization() {return regularization;}
+
+				/// Number of rows.
+	int GetRows() {return n;}
+				/// Number of non-zero elements of L (excluding the unit diagonal).
+	int GetNNZfactor() {return analyzed ? Lp[n] : 0;}
+				/// Number of pivots regularized in last Factorize().
+	int GetNregularized() {return nregularized;}
+				/// Number of pivots, not regularized, with a sign opposite to the
+				/// expected one in last Factorize() (0 if it succeeded).
+	int GetNwrongSign() {return nwrongsign;}
+				/// Fill-reducing permutation: P[k] is the row of A that is the k-th pivot.
+	const std::vector<int>& GetPermutation() {return P;}
+
+private:
+	void ComputeOrdering(ChCSRMatrix& A, const std::vector<int>* blocks);
+
+	bool analyzed;
+	int n;
+	double regularization;
+	int nregularized;
+	int nwrongsign;
+
+		// pattern of the analyzed matrix
+	std::vector<int> pattern_rowindex;
+	std::vector<int> pattern_colindex;
+
+		// ordering
+	std::vector<int> P;
+	std::vector<int> Pinv;
+	std::vector<int> sign;	// expected sign of pivots, in original order (0 if unknown)
+
+		// factor
+	std::vector<int> Parent;	// elimination tree
+	std::vector<int> Lp;		// columns of L, compressed
+	std::vector<int> Li;
+	std::vector<double> Lx;
+	std::vector<double> D;
+
+		// workspace
+	std::vector<int> Lnz;
+	std::vector<int> Flag;
+	std::vector<int> Pattern;
+	std::vector<double> Y;
+};
+
+
+
+} // END_OF_NAMESPACE____
+
+
+#endif  // END of ChSparseLDL.h
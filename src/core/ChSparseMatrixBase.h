@@ -0,0 +1,86 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHSPARSEMATRIXBASE_H
+#define CHSPARSEMATRIXBASE_H
+
+//////////////////////////////////////////////////
+//
+//   ChSparseMatrixBase.h
+//
+//   Interface for filling sparse matrices, shared
+//   by the different storage formats.
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "core/ChMatrix.h"
+#include "core/ChApiCE.h"
+
+
+namespace chrono
+{
+
+
+/// Base interface for sparse matrices, with the functions that are
+/// used to assemble them block by block, for example by the Build_M(),
+/// Build_Cq() and Build_K() functions of the LCP variables, constraints
+/// and stiffness items. This lets the assembly code fill any storage
+/// format: the linked lists of ChSparseMatrix, or the compressed rows
+/// of ChCSRMatrix.
+///
+/// As in ChSparseMatrix, the Paste...() functions skip the zero
+/// elements of the pasted matrix.
+
+class ChApi ChSparseMatrixBase
+{
+public:
+	virtual ~ChSparseMatrixBase() {};
+
+				/// Reset to null matrix, and (if needed) change the size.
+	virtual void Reset(int row, int col) = 0;
+
+				/// Set the value of an element.
+	virtual void SetElement (int row, int col, double elem) = 0;
+				/// Get the value of an element (zero if not stored).
+	virtual double GetElement (int row, int col) = 0;
+
+				/// Copy the matrix 'matra' at the position insrow,inscol.
+	virtual void PasteMatrix (ChMatrix<>* matra, int insrow, int inscol) = 0;
+				/// Copy the transpose of the matrix 'matra' at the position insrow,inscol.
+	virtual void PasteTranspMatrix (ChMatrix<>* matra, int insrow, int inscol) = 0;
+				/// As PasteMatrix(), for a matrix of floats.
+	virtual void PasteMatrixFloat (ChMatrix<float>* matra, int insrow, int inscol) = 0;
+				/// As PasteTranspMatrix(), for a matrix of floats.
+	virtual void PasteTranspMatrixFloat (ChMatrix<float>* matra, int insrow, int inscol) = 0;
+				/// Copy the nrows x ncolumns block of 'matra' starting at cliprow,clipcol,
+				/// at the position insrow,inscol.
+	virtual void PasteClippedMatrix (ChMatrix<>* matra, int cliprow, int clipcol, int nrows, int ncolumns, int insrow, int inscol) = 0;
+				/// As PasteClippedMatrix(), but the block is added to the current values.
+	virtual void PasteSumClippedMatrix (ChMatrix<>* matra, int cliprow, int clipcol, int nrows, int ncolumns, int insrow, int inscol) = 0;
+				/// As PasteMatrix(), but 'matra' is added to the current values.
+	virtual void PasteSumMatrix (ChMatrix<>* matra, int insrow, int inscol) = 0;
+				/// As PasteTranspMatrix(), but the transpose of 'matra' is added to the current values.
+	virtual void PasteSumTranspMatrix (ChMatrix<>* matra, int insrow, int inscol) = 0;
+};
+
+
+
+} // END_OF_NAMESPACE____
+
+
+#endif  // END of ChSparseMatrixBase.h
@@ -31,6 +31,7 @@
 
 
 #include "core/ChMatrix.h"
+#include "core/ChSparseMatrixBase.h"
 #include "core/ChLists.h"
 #include "core/ChApiCE.h"
 
@@ -114,10 +115,12 @@ public:
 /// would stick with the implementation in the base class!
 /// (here, only few of them are reimplemented, more will
 /// come later in futire releases.).
+/// For large matrices that are assembled once and then used
+/// in products, see the compressed storage of ChCSRMatrix.
 /// 
 
 
-class ChApi ChSparseMatrix : public ChMatrix<double> {
+class ChApi ChSparseMatrix : public ChMatrix<double>, public ChSparseMatrixBase {
  private:
 	ChMelement** elarray;	// array of 1st column elements 
 
@@ -134,6 +137,8 @@ class ChApi ChSparseMatrix : public ChMatrix<double> {
 	ChMelement* GetElarrayMel(int num) {return (*(elarray+num));}
 	double GetElarrayN (int num) { return (*(elarray+num))->val; };
 	void SetElarrayN (double val, int num) { (*(elarray+num))->val = val;};
+
+	friend class ChCSRMatrix;
  public:
 
 		// 
@@ -178,11 +183,11 @@ class ChApi ChSparseMatrix : public ChMatrix<double> {
 	void Resize(int nrows, int ncols) {assert (false);}; // not implemented
 
 	void Reset();						// reset to null matrix 
-	void Reset(int row, int col);		// reset to null matrix and (if needed) changes the size.
+	virtual void Reset(int row, int col);		// reset to null matrix and (if needed) changes the size.
 	void ResetBlocks(int row, int col);	// if size changes, is like the above, otherwise just sets to zero the elements .
 	
-	void   SetElement ( int row, int col, double elem);
-	double GetElement ( int row, int col);
+	virtual void   SetElement ( int row, int col, double elem);
+	virtual double GetElement ( int row, int col);
 
 	void SwapColumns (int a, int b);
 	void SwapRows    (int a, int b);
@@ -190,16 +195,16 @@ class ChApi ChSparseMatrix : public ChMatrix<double> {
 
 		// Customized functions, speed-optimized for sparse matrices:
 
-	void PasteMatrix (ChMatrix<>* matra, int insrow, int inscol);
-	void PasteTranspMatrix (ChMatrix<>* matra, int insrow, int inscol);
-	void PasteMatrixFloat (ChMatrix<float>* matra, int insrow, int inscol);
-	void PasteTranspMatrixFloat (ChMatrix<float>* matra, int insrow, int inscol);
+	virtual void PasteMatrix (ChMatrix<>* matra, int insrow, int inscol);
+	virtual void PasteTranspMatrix (ChMatrix<>* matra, int insrow, int inscol);
+	virtual void PasteMatrixFloat (ChMatrix<float>* matra, int insrow, int inscol);
+	virtual void PasteTranspMatrixFloat (ChMatrix<float>* matra, int insrow, int inscol);
 	void PasteMatrix (ChSparseMatrix* matra, int insrow, int inscol);
 	void PasteTranspMatrix (ChSparseMatrix* matra, int insrow, int inscol);
-	void PasteClippedMatrix (ChMatrix<>* matra, int cliprow, int clipcol, int nrows, int ncolumns, int insrow, int inscol);
-	void PasteSumClippedMatrix (ChMatrix<>* matra, int cliprow, int clipcol, int nrows, int ncolumns, int insrow, int inscol);
-	void PasteSumMatrix (ChMatrix<>* matra, int insrow, int inscol);
-	void PasteSumTranspMatrix (ChMatrix<>* matra, int insrow, int inscol);
+	virtual void PasteClippedMatrix (ChMatrix<>* matra, int cliprow, int clipcol, int nrows, int ncolumns, int insrow, int inscol);
+	virtual void PasteSumClippedMatrix (ChMatrix<>* matra, int cliprow, int clipcol, int nrows, int ncolumns, int insrow, int inscol);
+	virtual void PasteSumMatrix (ChMatrix<>* matra, int insrow, int inscol);
+	virtual void PasteSumTranspMatrix (ChMatrix<>* matra, int insrow, int inscol);
 
 	void MatrMultiply ( ChSparseMatrix* matra, ChSparseMatrix* matrb);
 	void MatrMultiplyT ( ChSparseMatrix* matra, ChSparseMatrix* matrb);
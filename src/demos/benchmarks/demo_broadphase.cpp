@@ -0,0 +1,133 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   Benchmark about
+//
+//     - the broadphases of the Bullet collision
+//       system: sweep and prune, dynamic AABB tree,
+//       multi-level hash grid, comparing the time
+//       per step as the number of bodies grows.
+//
+//	 CHRONO
+//   ------
+//   Multibody dinamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+
+#include "physics/ChApidll.h"
+#include "physics/ChSystem.h"
+#include "physics/ChBody.h"
+#include "collision/ChCCollisionSystemBullet.h"
+#include <math.h>
+
+
+// Use the namespace of Chrono
+
+using namespace chrono;
+using namespace chrono::collision;
+
+
+
+// Create a container with a floor and 'nbodies' spheres
+// falling on it, randomly placed in a box.
+
+void create_scene(ChSystem& msystem, int nbodies)
+{
+	ChSharedBodyPtr floor(new ChBody);
+	floor->SetBodyFixed(true);
+	floor->GetCollisionModel()->ClearModel();
+	floor->GetCollisionModel()->AddBox(60, 1, 60, &ChVector<>(0,-1,0));
+	floor->GetCollisionModel()->BuildModel();
+	floor->SetCollide(true);
+	msystem.AddBody(floor);
+
+	double radius = 0.5;
+	double side = 2.0 * radius * pow((double)nbodies, 1.0/3.0) * 1.6;
+
+	ChSetRandomSeed(123);
+	for (int i = 0; i < nbodies; i++)
+	{
+		ChSharedBodyPtr sphere(new ChBody);
+		sphere->SetPos(ChVector<>( side * (ChRandom()-0.5),
+								   radius + side * ChRandom(),
+								   side * (ChRandom()-0.5) ));
+		sphere->SetMass(1.0);
+		sphere->SetInertiaXX(ChVector<>(0.4*radius*radius, 0.4*radius*radius, 0.4*radius*radius));
+		sphere->GetCollisionModel()->ClearModel();
+		sphere->GetCollisionModel()->AddSphere(radius);
+		sphere->GetCollisionModel()->BuildModel();
+		sphere->SetCollide(true);
+		msystem.AddBody(sphere);
+	}
+}
+
+
+
+int main(int argc, char* argv[])
+{
+	DLL_CreateGlobals();
+
+	const char* names[] = {"sweep and prune", "dynamic AABB tree", "hash grid"};
+	ChCollisionSystemBullet::eCh_broadphaseType types[] = {
+			ChCollisionSystemBullet::BROADPHASE_SAP,
+			ChCollisionSystemBullet::BROADPHASE_DBVT,
+			ChCollisionSystemBullet::BROADPHASE_HASHGRID };
+
+	int nsteps = 20;
+
+	GetLog() << "Average time per step [s] (collision detection time in brackets)\n\n";
+	GetLog() << "  bodies";
+	for (int ib = 0; ib < 3; ib++)
+		GetLog() << "   " << names[ib];
+	GetLog() << "\n";
+
+	for (int nbodies = 1000; nbodies <= 16000; nbodies *= 2)
+	{
+		GetLog() << "  " << nbodies;
+
+		for (int ib = 0; ib < 3; ib++)
+		{
+			// Size the sweep and prune for the number of bodies.
+			ChSystem msystem(nbodies + 100, 100);
+			msystem.SetIterLCPmaxItersSpeed(20);
+
+			ChCollisionSystemBullet* mcollsystem = dynamic_cast<ChCollisionSystemBullet*>(msystem.GetCollisionSystem());
+			mcollsystem->SetBroadphase(types[ib]);
+
+			create_scene(msystem, nbodies);
+
+			double time_step = 0;
+			double time_coll = 0;
+			for (int i = 0; i < nsteps; i++)
+			{
+				msystem.DoStepDynamics(0.005);
+				time_step += msystem.GetTimerStep();
+				time_coll += msystem.GetTimerCollisionBroad();
+			}
+
+			GetLog() << "   " << time_step / nsteps << " (" << time_coll / nsteps << ")";
+		}
+		GetLog() << "\n";
+	}
+
+	DLL_DeleteGlobals();
+
+	return 0;
+}
+
+
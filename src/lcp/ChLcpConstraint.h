@@ -357,11 +357,11 @@ public:
 				/// don't need to know jacobians explicitly)
 				/// *** This function MUST BE OVERRIDDEN by specialized
 				/// inherited classes!
-	virtual void Build_Cq(ChSparseMatrix& storage, int insrow) =0;
+	virtual void Build_Cq(ChSparseMatrixBase& storage, int insrow) =0;
 				/// Same as Build_Cq, but puts the _transposed_ jacobian row as a column.
 				/// *** This function MUST BE OVERRIDDEN by specialized
 				/// inherited classes!
-	virtual void Build_CqT(ChSparseMatrix& storage, int inscol) =0;
+	virtual void Build_CqT(ChSparseMatrixBase& storage, int inscol) =0;
 
 				/// Return true only if this constraint can be used by the special GPU 
 				/// solver (for example, constraint with two jacobians of 6 elements each). 
@@ -234,7 +234,7 @@ public:
 				/// offset of the corresponding ChLcpVariable.
 				/// This is used only by the ChLcpSimplex solver (iterative solvers 
 				/// don't need to know jacobians explicitly)
-	virtual void Build_Cq(ChSparseMatrix& storage, int insrow)
+	virtual void Build_Cq(ChSparseMatrixBase& storage, int insrow)
 					{
 						if (variables_a->IsActive())
 							storage.PasteMatrixFloat(&Cq_a, insrow, variables_a->GetOffset());
@@ -243,7 +243,7 @@ public:
 						if (variables_c->IsActive())
 							storage.PasteMatrixFloat(&Cq_c, insrow, variables_c->GetOffset());
 					}
-	virtual void Build_CqT(ChSparseMatrix& storage, int inscol)
+	virtual void Build_CqT(ChSparseMatrixBase& storage, int inscol)
 					{
 						if (variables_a->IsActive())
 							storage.PasteTranspMatrixFloat(&Cq_a, variables_a->GetOffset(), inscol);
@@ -228,14 +228,14 @@ public:
 				/// on the 'insrow' column, so that the sparse matrix is kept symmetric.
 				/// This is used only by the ChLcpSimplex solver (iterative solvers 
 				/// don't need to know jacobians explicitly)
-	virtual void Build_Cq(ChSparseMatrix& storage, int insrow)
+	virtual void Build_Cq(ChSparseMatrixBase& storage, int insrow)
 					{
 						if (variables_a->IsActive())
 							storage.PasteMatrixFloat(&Cq_a, insrow, variables_a->GetOffset());
 						if (variables_b->IsActive())
 							storage.PasteMatrixFloat(&Cq_b, insrow, variables_b->GetOffset());
 					}
-	virtual void Build_CqT(ChSparseMatrix& storage, int inscol)
+	virtual void Build_CqT(ChSparseMatrixBase& storage, int inscol)
 					{
 						if (variables_a->IsActive())
 							storage.PasteTranspMatrixFloat(&Cq_a, variables_a->GetOffset(), inscol);
@@ -0,0 +1,179 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChLcpConstraintTwoContactSoA.cpp
+//
+//
+//    file for CHRONO HYPEROCTANT LCP solver
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "ChLcpConstraintTwoContactSoA.h"
+#include "ChLcpContactsSoA.h"
+#include "core/ChSpmatrix.h"
+
+#include "core/ChMemory.h" // must be after system's include (memory leak debugger).
+
+
+namespace chrono
+{
+
+
+
+void ChLcpConstraintTwoContactSoA::SetVariables(ChLcpVariables* mvariables_a, ChLcpVariables* mvariables_b)
+{
+	assert(dynamic_cast<ChLcpVariablesBody*>(mvariables_a));
+	assert(dynamic_cast<ChLcpVariablesBody*>(mvariables_b));
+
+	if (!mvariables_a || !mvariables_b)
+	{
+		SetValid(false);
+		return ;
+	}
+
+	SetValid(true);
+	variables_a = mvariables_a;
+	variables_b = mvariables_b;
+}
+
+
+void ChLcpConstraintTwoContactSoA::Update_auxiliary()
+{
+	// The N component computes the data of the entire contact, and
+	// sets the g_i of U and V too (so that it is safe also when the
+	// constraints are updated in parallel, as in ChLcpIterativeSORcolored).
+	if (row % 3 != 0)
+		return;
+
+	block->Update_auxiliary(row/3);
+
+	this->Set_g_i(block->G_i(row));
+	block->GetConstraint(row+1).Set_g_i(block->G_i(row+1));
+	block->GetConstraint(row+2).Set_g_i(block->G_i(row+2));
+}
+
+
+double ChLcpConstraintTwoContactSoA::Compute_Cq_q()
+{
+	double ret = 0;
+
+	if (variables_a->IsActive())
+	 for (int i= 0; i < 6; i++)
+		ret += block->Cq_a_ij(row,i) * variables_a->Get_qb().ElementN(i);
+
+	if (variables_b->IsActive())
+	 for (int i= 0; i < 6; i++)
+		ret += block->Cq_b_ij(row,i) * variables_b->Get_qb().ElementN(i);
+
+	return ret;
+}
+
+
+void ChLcpConstraintTwoContactSoA::Increment_q(const double deltal)
+{
+
+	if (variables_a->IsActive())
+	 for (int i= 0; i < 6; i++)
+		variables_a->Get_qb()(i) += block->Eq_a_ij(row,i) * deltal;
+
+	if (variables_b->IsActive())
+	 for (int i= 0; i < 6; i++)
+		variables_b->Get_qb()(i) += block->Eq_b_ij(row,i) * deltal;
+}
+
+
+void ChLcpConstraintTwoContactSoA::MultiplyAndAdd(double& result, ChMatrix<double>& vect)
+{
+	int off_a = variables_a->GetOffset();
+	int off_b = variables_b->GetOffset();
+
+	if (variables_a->IsActive())
+	 for (int i= 0; i < 6; i++)
+		result += vect(off_a+i) * block->Cq_a_ij(row,i);
+
+	if (variables_b->IsActive())
+	 for (int i= 0; i < 6; i++)
+		result += vect(off_b+i) * block->Cq_b_ij(row,i);
+}
+
+
+void ChLcpConstraintTwoContactSoA::MultiplyTandAdd(ChMatrix<double>& result, double l)
+{
+	int off_a = variables_a->GetOffset();
+	int off_b = variables_b->GetOffset();
+
+	if (variables_a->IsActive())
+	 for (int i= 0; i < 6; i++)
+		result(off_a+i) += block->Cq_a_ij(row,i) * l;
+
+	if (variables_b->IsActive())
+	 for (int i= 0; i < 6; i++)
+		result(off_b+i) += block->Cq_b_ij(row,i) * l;
+}
+
+
+void ChLcpConstraintTwoContactSoA::Project()
+{
+	// U and V components are projected by the N component
+	if (row % 3 != 0)
+		return;
+
+	ChLcpConstraint& mU = block->GetConstraint(row+1);
+	ChLcpConstraint& mV = block->GetConstraint(row+2);
+
+	double ml[3];
+	ml[0] = this->l_i;
+	ml[1] = mU.Get_l_i();
+	ml[2] = mV.Get_l_i();
+
+	block->Project(row/3, ml);
+
+	this->Set_l_i(ml[0]);
+	mU.Set_l_i(ml[1]);
+	mV.Set_l_i(ml[2]);
+}
+
+
+void ChLcpConstraintTwoContactSoA::Build_Cq(ChSparseMatrixBase& storage, int insrow)
+{
+
+	if (variables_a->IsActive())
+	 for (int i= 0; i < 6; i++)
+		storage.SetElement(insrow, variables_a->GetOffset()+i, block->Cq_a_ij(row,i));
+	if (variables_b->IsActive())
+	 for (int i= 0; i < 6; i++)
+		storage.SetElement(insrow, variables_b->GetOffset()+i, block->Cq_b_ij(row,i));
+}
+
+
+void ChLcpConstraintTwoContactSoA::Build_CqT(ChSparseMatrixBase& storage, int inscol)
+{
+
+	if (variables_a->IsActive())
+	 for (int i= 0; i < 6; i++)
+		storage.SetElement(variables_a->GetOffset()+i, inscol, block->Cq_a_ij(row,i));
+	if (variables_b->IsActive())
+	 for (int i= 0; i < 6; i++)
+		storage.SetElement(variables_b->GetOffset()+i, inscol, block->Cq_b_ij(row,i));
+}
+
+
+
+
+} // END_OF_NAMESPACE____
+
+
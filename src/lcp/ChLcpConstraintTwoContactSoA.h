@@ -0,0 +1,172 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHLCPCONSTRAINTTWOCONTACTSOA_H
+#define CHLCPCONSTRAINTTWOCONTACTSOA_H
+
+//////////////////////////////////////////////////
+//
+//   ChLcpConstraintTwoContactSoA.h
+//
+//    A scalar contact constraint (N, U or V component)
+//   whose jacobians are stored in a ChLcpContactsSoA
+//   structure-of-arrays block, rather than in the object.
+//
+//   HEADER file for CHRONO HYPEROCTANT LCP solver
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+
+#include "ChLcpConstraintTwo.h"
+#include "ChLcpVariablesBody.h"
+
+#include "core/ChMemory.h" // must be after system's include (memory leak debugger).
+
+
+namespace chrono
+{
+
+class ChLcpContactsSoA;
+
+
+/// A lightweight constraint that represents one row (the normal
+/// N component, or the U or V tangential components) of a frictional
+/// contact whose data is stored in a ChLcpContactsSoA block.
+/// It does not own jacobians: Cq and Eq are read from the contiguous
+/// arrays of the block. These objects exist so that all the solvers
+/// and all the functions of ChLcpSystemDescriptor that work on the
+/// generic ChLcpConstraint interface can still see the contacts of a
+/// block, whereas the SoA-aware solvers can skip them and loop on the
+/// block arrays directly.
+/// Objects of this class are allocated and managed by ChLcpContactsSoA,
+/// do not create them by yourself.
+
+class ChApi ChLcpConstraintTwoContactSoA : public ChLcpConstraintTwo
+{
+	CH_RTTI(ChLcpConstraintTwoContactSoA, ChLcpConstraintTwo)
+
+			//
+			// DATA
+			//
+
+protected:
+				/// the block that stores the jacobians
+	ChLcpContactsSoA* block;
+				/// the row in the block (3*contact for N, +1 for U, +2 for V)
+	int row;
+
+public:
+
+			//
+			// CONSTRUCTORS
+			//
+						/// Default constructor
+	ChLcpConstraintTwoContactSoA()
+					{
+						mode = CONSTRAINT_FRIC;
+						block = 0;
+						row = 0;
+					};
+
+						/// Copy constructor
+	ChLcpConstraintTwoContactSoA(const ChLcpConstraintTwoContactSoA& other)
+			: ChLcpConstraintTwo(other)
+					{
+						block = other.block;
+						row = other.row;
+					}
+
+	virtual ~ChLcpConstraintTwoContactSoA()
+					{
+					};
+
+	virtual ChLcpConstraint* new_Duplicate () {return new ChLcpConstraintTwoContactSoA(*this);};
+
+					/// Assignment operator: copy from other object
+	ChLcpConstraintTwoContactSoA& operator=(const ChLcpConstraintTwoContactSoA& other)
+					{
+						if (&other == this)
+							return *this;
+						// copy parent class data
+						ChLcpConstraintTwo::operator=(other);
+
+						block = other.block;
+						row = other.row;
+						return *this;
+					}
+
+
+			//
+			// FUNCTIONS
+			//
+
+				/// Set the block that owns the data, and the row in the block
+	void SetBlockRow(ChLcpContactsSoA* mblock, int mrow) {block = mblock; row = mrow;}
+
+				/// Get the block that owns the data
+	ChLcpContactsSoA* GetBlock() {return block;}
+
+				/// Get the row in the block (3*contact for N, +1 for U, +2 for V)
+	int GetRow() {return row;}
+
+				/// Jacobians are not stored as ChMatrix objects, hence these
+				/// return null: use GetBlock()->Get_Cq_a(GetRow()) etc. instead.
+	virtual ChMatrix<float>* Get_Cq_a() {return 0;}
+	virtual ChMatrix<float>* Get_Cq_b() {return 0;}
+	virtual ChMatrix<float>* Get_Eq_a() {return 0;}
+	virtual ChMatrix<float>* Get_Eq_b() {return 0;}
+
+				/// Set references to the constrained objects,
+				/// both must be of ChLcpVariablesBody type.
+	virtual void SetVariables(ChLcpVariables* mvariables_a, ChLcpVariables* mvariables_b);
+
+				/// Computes [Eq]=[invM]*[Cq]' and g_i in the block, see
+				/// ChLcpContactsSoA::Update_auxiliary(int). Only the N component
+				/// does something: it updates the entire N,U,V triplet.
+	virtual void Update_auxiliary();
+
+				/// Computes the product [Cq_i]*q using the 'qb' of the two bodies
+	virtual double Compute_Cq_q();
+
+				/// Increments the 'qb' of the two bodies by [invM]*[Cq]'*deltal
+	virtual void Increment_q(const double deltal);
+
+	virtual void MultiplyAndAdd(double& result, ChMatrix<double>& vect);
+
+	virtual void MultiplyTandAdd(ChMatrix<double>& result, double l);
+
+				/// For iterative solvers: project the value of a possible
+				/// 'l_i' value of constraint reaction onto admissible set.
+				/// Only the N component does something: it projects the N,U,V
+				/// triplet onto the friction cone, as ChLcpConstraintTwoContactN.
+	virtual void Project();
+
+	virtual void Build_Cq(ChSparseMatrixBase& storage, int insrow);
+
+	virtual void Build_CqT(ChSparseMatrixBase& storage, int inscol);
+
+};
+
+
+
+
+} // END_OF_NAMESPACE____
+
+
+
+#include "core/ChMemorynomgr.h" // back to default new/delete/malloc/calloc etc. Avoid conflicts with system libs.
+
+
+#endif
@@ -0,0 +1,426 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChLcpContactsSoA.cpp
+//
+//
+//    file for CHRONO HYPEROCTANT LCP solver
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "ChLcpContactsSoA.h"
+#include "ChLcpContactsSoAkernels.h"
+#include "core/ChCpuFeatures.h"
+
+
+namespace chrono
+{
+
+
+// Choose the best instruction set supported by the CPU, at startup
+static ChLcpContactsSoA::eChSimdLevel ChLcpSoA_BestSimdLevel()
+{
+	if (ChLcpSoA_HasKernels_avx() && ChCpuFeatures::HasAVX())
+		return ChLcpContactsSoA::SIMD_AVX;
+	if (ChLcpSoA_HasKernels_sse2() && ChCpuFeatures::HasSSE2())
+		return ChLcpContactsSoA::SIMD_SSE2;
+	return ChLcpContactsSoA::SIMD_SCALAR;
+}
+
+ChLcpContactsSoA::eChSimdLevel ChLcpContactsSoA::simd_level = ChLcpSoA_BestSimdLevel();
+
+
+void ChLcpContactsSoA::SetSimdLevel(eChSimdLevel mlevel)
+{
+	eChSimdLevel best = ChLcpSoA_BestSimdLevel();
+	simd_level = (mlevel < best) ? mlevel : best;
+}
+
+
+
+ChLcpContactsSoA::ChLcpContactsSoA()
+{
+	n_contacts = 0;
+	n_packs = 0;
+	constraint_start = 0;
+	for (int i = 0; i < 6; i++)
+		q_null[i] = 0;
+}
+
+
+void ChLcpContactsSoA::Resize(int mcontacts)
+{
+	n_contacts = mcontacts;
+	n_packs = (mcontacts + LANES - 1) / LANES;
+	int n_padded = n_packs * LANES;
+
+	// std::vector::resize() does not release memory when shrinking,
+	// so in steady state there is no allocation here.
+	var_a.resize(n_padded);
+	var_b.resize(n_padded);
+	q_a.resize(n_padded);
+	q_b.resize(n_padded);
+	friction.resize(n_padded);
+	cohesion.resize(n_padded);
+	active.resize(n_padded);
+
+	Cq_a.resize(18*n_padded);
+	Cq_b.resize(18*n_padded);
+	Eq_a.resize(18*n_padded);
+	Eq_b.resize(18*n_padded);
+	g_i.resize(3*n_padded);
+	b_i.resize(3*n_padded);
+	cfm_i.resize(3*n_padded);
+	l_i.resize(3*n_padded);
+	row_buffer.resize(3*n_padded);
+
+	constraints.resize(3*mcontacts);
+	for (int row = 0; row < 3*mcontacts; row++)
+		constraints[row].SetBlockRow(this, row);
+
+	// Padding contacts of the last pack: no bodies, zero jacobians,
+	// never active, so batch functions can process full packs.
+	for (int k = mcontacts; k < n_padded; k++)
+	{
+		var_a[k] = 0;
+		var_b[k] = 0;
+		q_a[k] = q_null;
+		q_b[k] = q_null;
+		friction[k] = 0;
+		cohesion[k] = 0;
+		active[k] = 0;
+		for (int row = 3*k; row < 3*k+3; row++)
+		{
+			for (int j = 0; j < 6; j++)
+			{
+				Cq_a_ij(row,j) = 0;
+				Cq_b_ij(row,j) = 0;
+				Eq_a_ij(row,j) = 0;
+				Eq_b_ij(row,j) = 0;
+			}
+			G_i(row) = 1;
+			B_i(row) = 0;
+			Cfm_i(row) = 0;
+			L_i(row) = 0;
+		}
+	}
+}
+
+
+void ChLcpContactsSoA::SetContact(int k, ChLcpVariablesBody* mvar_a, ChLcpVariablesBody* mvar_b, float mfriction, float mcohesion)
+{
+	var_a[k] = mvar_a;
+	var_b[k] = mvar_b;
+	q_a[k] = q_null;
+	q_b[k] = q_null;
+	friction[k] = mfriction;
+	cohesion[k] = mcohesion;
+	active[k] = 0;
+	for (int i = 0; i < 3; i++)
+		constraints[3*k+i].SetVariables(mvar_a, mvar_b);
+}
+
+
+void ChLcpContactsSoA::Update_auxiliary(int k)
+{
+	active[k] = constraints[3*k].IsActive() ? 1.0f : 0.0f;
+
+	// Body A: [Eq_a]=[invM_a]*[Cq_a]', with invM_a = diag(1/m, 1/m, 1/m, invI)
+	// (this is the same of ChLcpVariablesBody::Compute_invMb_v, without the
+	// virtual call per row)
+	if (var_a[k]->IsActive())
+	{
+		q_a[k] = var_a[k]->Get_qb().GetAddress();
+		double inv_mass = 1.0 / var_a[k]->GetBodyMass();
+		ChMatrix33<>& invI = var_a[k]->GetBodyInvInertia();
+		for (int row = 3*k; row < 3*k+3; row++)
+		{
+			float mCq[6];
+			for (int j = 0; j < 6; j++)
+				mCq[j] = Cq_a_ij(row,j);
+			Eq_a_ij(row,0) = (float)(inv_mass * mCq[0]);
+			Eq_a_ij(row,1) = (float)(inv_mass * mCq[1]);
+			Eq_a_ij(row,2) = (float)(inv_mass * mCq[2]);
+			Eq_a_ij(row,3) = (float)(invI(0,0)*mCq[3] + invI(0,1)*mCq[4] + invI(0,2)*mCq[5]);
+			Eq_a_ij(row,4) = (float)(invI(1,0)*mCq[3] + invI(1,1)*mCq[4] + invI(1,2)*mCq[5]);
+			Eq_a_ij(row,5) = (float)(invI(2,0)*mCq[3] + invI(2,1)*mCq[4] + invI(2,2)*mCq[5]);
+		}
+	}
+	else
+	{
+		q_a[k] = q_null;
+		for (int row = 3*k; row < 3*k+3; row++)
+			for (int j = 0; j < 6; j++)
+				Eq_a_ij(row,j) = 0;
+	}
+
+	// Body B: [Eq_b]=[invM_b]*[Cq_b]'
+	if (var_b[k]->IsActive())
+	{
+		q_b[k] = var_b[k]->Get_qb().GetAddress();
+		double inv_mass = 1.0 / var_b[k]->GetBodyMass();
+		ChMatrix33<>& invI = var_b[k]->GetBodyInvInertia();
+		for (int row = 3*k; row < 3*k+3; row++)
+		{
+			float mCq[6];
+			for (int j = 0; j < 6; j++)
+				mCq[j] = Cq_b_ij(row,j);
+			Eq_b_ij(row,0) = (float)(inv_mass * mCq[0]);
+			Eq_b_ij(row,1) = (float)(inv_mass * mCq[1]);
+			Eq_b_ij(row,2) = (float)(inv_mass * mCq[2]);
+			Eq_b_ij(row,3) = (float)(invI(0,0)*mCq[3] + invI(0,1)*mCq[4] + invI(0,2)*mCq[5]);
+			Eq_b_ij(row,4) = (float)(invI(1,0)*mCq[3] + invI(1,1)*mCq[4] + invI(1,2)*mCq[5]);
+			Eq_b_ij(row,5) = (float)(invI(2,0)*mCq[3] + invI(2,1)*mCq[4] + invI(2,2)*mCq[5]);
+		}
+	}
+	else
+	{
+		q_b[k] = q_null;
+		for (int row = 3*k; row < 3*k+3; row++)
+			for (int j = 0; j < 6; j++)
+				Eq_b_ij(row,j) = 0;
+	}
+
+	// g_i = [Cq_i]*[invM_i]*[Cq_i]' + cfm_i
+	// (inactive bodies have Eq=0, hence they do not contribute)
+	for (int row = 3*k; row < 3*k+3; row++)
+	{
+		float mg = 0;
+		for (int j = 0; j < 6; j++)
+			mg += Cq_a_ij(row,j)*Eq_a_ij(row,j) + Cq_b_ij(row,j)*Eq_b_ij(row,j);
+		G_i(row) = mg + constraints[row].Get_cfm_i();
+	}
+}
+
+
+void ChLcpContactsSoA::Update_auxiliary()
+{
+	for (int k = 0; k < n_contacts; k++)
+		Update_auxiliary(k);
+}
+
+
+void ChLcpContactsSoA::Average_g_i()
+{
+	for (int row = 0; row < 3*n_contacts; row += 3)
+	{
+		double average_g_i = (G_i(row)+G_i(row+1)+G_i(row+2))/3.0;
+		G_i(row)   = average_g_i;
+		G_i(row+1) = average_g_i;
+		G_i(row+2) = average_g_i;
+	}
+}
+
+
+void ChLcpContactsSoA::GatherFromConstraints()
+{
+	for (int row = 0; row < 3*n_contacts; row++)
+	{
+		B_i(row)   = constraints[row].Get_b_i();
+		Cfm_i(row) = constraints[row].Get_cfm_i();
+		L_i(row)   = constraints[row].Get_l_i();
+	}
+}
+
+
+void ChLcpContactsSoA::ScatterToConstraints()
+{
+	for (int row = 0; row < 3*n_contacts; row++)
+		constraints[row].Set_l_i(L_i(row));
+}
+
+
+
+////////// BATCH FUNCTIONS, DISPATCH ////
+
+
+static void ChLcpSoA_FillData(ChLcpContactsSoAdata& d,
+							  int n_contacts, int n_packs,
+							  std::vector<float>& Cq_a, std::vector<float>& Cq_b,
+							  std::vector<double*>& q_a, std::vector<double*>& q_b,
+							  std::vector<double>& g_i, std::vector<double>& b_i,
+							  std::vector<double>& cfm_i, std::vector<double>& l_i,
+							  std::vector<float>& friction, std::vector<float>& cohesion,
+							  std::vector<float>& active)
+{
+	d.n_contacts = n_contacts;
+	d.n_packs = n_packs;
+	d.Cq_a = &Cq_a[0];
+	d.Cq_b = &Cq_b[0];
+	d.q_a = &q_a[0];
+	d.q_b = &q_b[0];
+	d.g_i = &g_i[0];
+	d.b_i = &b_i[0];
+	d.cfm_i = &cfm_i[0];
+	d.l_i = &l_i[0];
+	d.friction = &friction[0];
+	d.cohesion = &cohesion[0];
+	d.active = &active[0];
+}
+
+
+void ChLcpContactsSoA::JacobiStep(double omega, double shlambda, double* delta, double& maxviolation, double& maxdeltalambda)
+{
+	if (!n_contacts)
+		return;
+	ChLcpContactsSoAdata d;
+	ChLcpSoA_FillData(d, n_contacts, n_packs, Cq_a, Cq_b, q_a, q_b, g_i, b_i, cfm_i, l_i, friction, cohesion, active);
+
+	switch (simd_level)
+	{
+	case SIMD_AVX:
+		ChLcpSoA_JacobiStep_avx(d, omega, shlambda, delta, maxviolation, maxdeltalambda);
+		break;
+	case SIMD_SSE2:
+		ChLcpSoA_JacobiStep_sse2(d, omega, shlambda, delta, maxviolation, maxdeltalambda);
+		break;
+	default:
+		ChLcpSoA_JacobiStep_scalar(d, omega, shlambda, delta, maxviolation, maxdeltalambda);
+	}
+}
+
+
+void ChLcpContactsSoA::Compute_Cq_q_all(double* result)
+{
+	if (!n_contacts)
+		return;
+	ChLcpContactsSoAdata d;
+	ChLcpSoA_FillData(d, n_contacts, n_packs, Cq_a, Cq_b, q_a, q_b, g_i, b_i, cfm_i, l_i, friction, cohesion, active);
+
+	switch (simd_level)
+	{
+	case SIMD_AVX:
+		ChLcpSoA_Compute_Cq_q_avx(d, result);
+		break;
+	case SIMD_SSE2:
+		ChLcpSoA_Compute_Cq_q_sse2(d, result);
+		break;
+	default:
+		ChLcpSoA_Compute_Cq_q_scalar(d, result);
+	}
+}
+
+
+void ChLcpContactsSoA::Project_all(double* ml)
+{
+	if (!n_contacts)
+		return;
+	ChLcpContactsSoAdata d;
+	ChLcpSoA_FillData(d, n_contacts, n_packs, Cq_a, Cq_b, q_a, q_b, g_i, b_i, cfm_i, l_i, friction, cohesion, active);
+
+	switch (simd_level)
+	{
+	case SIMD_AVX:
+		ChLcpSoA_Project_avx(d, ml);
+		break;
+	case SIMD_SSE2:
+		ChLcpSoA_Project_sse2(d, ml);
+		break;
+	default:
+		ChLcpSoA_Project_scalar(d, ml);
+	}
+}
+
+
+
+////////// SCALAR KERNELS ////
+
+
+void ChLcpSoA_JacobiStep_scalar(const ChLcpContactsSoAdata& d, double omega, double shlambda, double* delta, double& maxviolation, double& maxdeltalambda)
+{
+	const int W = ChLcpContactsSoA::LANES;
+	double mresidual[3];
+	double old_lambda[3];
+	double new_lambda[3];
+
+	for (int k = 0; k < d.n_contacts; k++)
+	{
+		if (!d.active[k])
+			continue;
+
+		int pack = k / W;
+		int lane = k % W;
+		const double* mqa = d.q_a[k];
+		const double* mqb = d.q_b[k];
+
+		// compute residuals  c_i = [Cq_i]*q + b_i + cfm_i*l_i  for N,U,V
+		// and update:   lambda += delta_lambda;
+		for (int i = 0; i < 3; i++)
+		{
+			int is = (pack*3 + i)*W + lane;
+			int ib = (pack*3 + i)*6*W + lane;
+			double mCq_q = 0;
+			for (int j = 0; j < 6; j++)
+				mCq_q += d.Cq_a[ib + j*W]*mqa[j] + d.Cq_b[ib + j*W]*mqb[j];
+			old_lambda[i] = d.l_i[is];
+			mresidual[i] = mCq_q + d.b_i[is] + d.cfm_i[is] * old_lambda[i];
+			new_lambda[i] = old_lambda[i] - ( omega / d.g_i[is] ) * mresidual[i];
+		}
+
+		// project N,U,V onto the friction cone
+		ChLcpContactsSoA::Project(d.friction[k], d.cohesion[k], new_lambda);
+
+		for (int i = 0; i < 3; i++)
+		{
+			// Apply the smoothing: lambda= sharpness*lambda_new_projected + (1-sharpness)*lambda_old
+			if (shlambda!=1.0)
+				new_lambda[i] = shlambda*new_lambda[i] + (1.0-shlambda)*old_lambda[i];
+			d.l_i[(pack*3 + i)*W + lane] = new_lambda[i];
+
+			delta[3*k+i] = new_lambda[i] - old_lambda[i];
+			maxdeltalambda = ChMax(maxdeltalambda, fabs(delta[3*k+i]));
+		}
+
+		maxviolation = ChMax(maxviolation, fabs(ChMin(0.0,mresidual[0])));
+	}
+}
+
+
+void ChLcpSoA_Compute_Cq_q_scalar(const ChLcpContactsSoAdata& d, double* result)
+{
+	const int W = ChLcpContactsSoA::LANES;
+
+	for (int k = 0; k < d.n_contacts; k++)
+	{
+		int pack = k / W;
+		int lane = k % W;
+		const double* mqa = d.q_a[k];
+		const double* mqb = d.q_b[k];
+		for (int i = 0; i < 3; i++)
+		{
+			int ib = (pack*3 + i)*6*W + lane;
+			double mCq_q = 0;
+			for (int j = 0; j < 6; j++)
+				mCq_q += d.Cq_a[ib + j*W]*mqa[j] + d.Cq_b[ib + j*W]*mqb[j];
+			result[3*k+i] = mCq_q;
+		}
+	}
+}
+
+
+void ChLcpSoA_Project_scalar(const ChLcpContactsSoAdata& d, double* ml)
+{
+	for (int k = 0; k < d.n_contacts; k++)
+		if (d.active[k])
+			ChLcpContactsSoA::Project(d.friction[k], d.cohesion[k], &ml[3*k]);
+}
+
+
+
+} // END_OF_NAMESPACE____
+
+
@@ -0,0 +1,326 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHLCPCONTACTSSOA_H
+#define CHLCPCONTACTSSOA_H
+
+//////////////////////////////////////////////////
+//
+//   ChLcpContactsSoA.h
+//
+//    A block of frictional contacts between 6DOF bodies,
+//   stored as a structure of arrays, for fast loops
+//   in the inner iterations of LCP solvers.
+//
+//   HEADER file for CHRONO HYPEROCTANT LCP solver
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+
+#include "ChLcpConstraintTwoContactSoA.h"
+#include <vector>
+#include <math.h>
+
+
+namespace chrono
+{
+
+
+/// A block of frictional contacts between ChLcpVariablesBody objects,
+/// where the jacobians, the [invM]*[Cq]' terms, the g_i, b_i, cfm_i
+/// and l_i of the N,U,V rows of all contacts are stored in contiguous
+/// arrays rather than in many ChLcpConstraintTwoContactN,
+/// ChLcpConstraintTwoFrictionT objects.
+/// Contacts are grouped in packs of LANES contacts, and inside a pack
+/// the data of the same row type (N,U or V) and of the same jacobian
+/// component is contiguous over the contacts ('array of structures of
+/// arrays' layout), so that the batch functions (JacobiStep(),
+/// Compute_Cq_q_all(), Project_all()) can process LANES contacts at
+/// once with SSE2 or AVX instructions. The SIMD instruction set is
+/// chosen at run time, with a fallback to scalar code, see SetSimdLevel().
+/// Row 'row' of the block is the N (row%3==0), U or V component of the
+/// contact row/3, as in the sequence of proxies in the descriptor.
+/// The block is inserted in the ChLcpSystemDescriptor with
+/// ChLcpSystemDescriptor::InsertContactBlock(), that also inserts
+/// 3 ChLcpConstraintTwoContactSoA proxies per contact in the list
+/// of constraints. Hence:
+///  - solvers that are not aware of blocks see the usual N,U,V
+///    friction triplets through the ChLcpConstraint interface;
+///  - SoA-aware solvers (SOR, Jacobi, and the ShurComplementProduct()
+///    of the descriptor) skip the proxies and use the inline,
+///    non-virtual functions of this class over the arrays instead.
+/// The scalars b_i, cfm_i and l_i of the proxies are the reference
+/// values: SoA-aware solvers must call GatherFromConstraints() before
+/// iterating and ScatterToConstraints() at the end.
+
+class ChApi ChLcpContactsSoA
+{
+public:
+				/// Number of contacts in a pack (a SIMD lane group)
+	static const int LANES = 4;
+
+				/// Instruction sets for the batch functions
+	enum eChSimdLevel
+	{
+		SIMD_SCALAR = 0,
+		SIMD_SSE2,
+		SIMD_AVX
+	};
+
+protected:
+			//
+			// DATA
+			//
+	int n_contacts;
+	int n_packs;
+
+			// per-contact data (including the padding of the last pack)
+	std::vector<ChLcpVariablesBody*> var_a;
+	std::vector<ChLcpVariablesBody*> var_b;
+	std::vector<double*> q_a;		///< 'qb' of body A, or a zero vector if body not active
+	std::vector<double*> q_b;		///< 'qb' of body B, or a zero vector if body not active
+	std::vector<float> friction;
+	std::vector<float> cohesion;
+	std::vector<float> active;		///< 1 if contact is active, 0 if not (or if padding)
+
+			// per-row data, 'array of structures of arrays' layout
+	std::vector<float> Cq_a;
+	std::vector<float> Cq_b;
+	std::vector<float> Eq_a;
+	std::vector<float> Eq_b;
+	std::vector<double> g_i;
+	std::vector<double> b_i;
+	std::vector<double> cfm_i;
+	std::vector<double> l_i;
+
+			// proxies for the generic ChLcpConstraint interface
+	std::vector<ChLcpConstraintTwoContactSoA> constraints;
+
+	int constraint_start;			///< index of first proxy in the descriptor list
+
+	double q_null[6];				///< read-only zero vector for inactive bodies
+
+	std::vector<double> row_buffer;	///< scratch vector, one value per row
+
+	static eChSimdLevel simd_level;
+
+public:
+
+			//
+			// CONSTRUCTORS
+			//
+
+	ChLcpContactsSoA();
+
+	virtual ~ChLcpContactsSoA() {};
+
+
+			//
+			// FUNCTIONS
+			//
+
+				/// Set the number of contacts in the block. Memory is reallocated
+				/// only if the number grows beyond the previous capacity.
+				/// Note: this invalidates the pointers to the proxy constraints.
+	void Resize(int mcontacts);
+
+				/// Get the number of contacts
+	int GetNcontacts() const {return n_contacts;}
+
+				/// Get the number of scalar constraints (rows), i.e. 3 per contact
+	int GetNconstraints() const {return 3*n_contacts;}
+
+				/// Set the two bodies, the friction and the cohesion of the k-th contact
+	void SetContact(int k, ChLcpVariablesBody* mvar_a, ChLcpVariablesBody* mvar_b, float mfriction, float mcohesion);
+
+				/// Position of the scalar data of a row in the g_i, b_i, cfm_i, l_i arrays
+	static int RowIndex(int row)		{int k = row/3; return ((k/LANES)*3 + row%3)*LANES + k%LANES;}
+
+				/// Position of the j-th jacobian component of a row in the Cq, Eq arrays
+	static int JacIndex(int row, int j)	{int k = row/3; return (((k/LANES)*3 + row%3)*6 + j)*LANES + k%LANES;}
+
+				/// Access the j-th jacobian component of a row, for body A and body B
+	float& Cq_a_ij(int row, int j) {return Cq_a[JacIndex(row,j)];}
+	float& Cq_b_ij(int row, int j) {return Cq_b[JacIndex(row,j)];}
+	float& Eq_a_ij(int row, int j) {return Eq_a[JacIndex(row,j)];}
+	float& Eq_b_ij(int row, int j) {return Eq_b[JacIndex(row,j)];}
+
+	ChLcpVariablesBody* GetVariables_a(int k) {return var_a[k];}
+	ChLcpVariablesBody* GetVariables_b(int k) {return var_b[k];}
+	float GetFriction(int k) const {return friction[k];}
+	float GetCohesion(int k) const {return cohesion[k];}
+
+				/// Access the scalar data of a row, as used by SoA-aware solvers
+	double& G_i(int row)   {return g_i[RowIndex(row)];}
+	double& B_i(int row)   {return b_i[RowIndex(row)];}
+	double& Cfm_i(int row) {return cfm_i[RowIndex(row)];}
+	double& L_i(int row)   {return l_i[RowIndex(row)];}
+
+				/// Access a scratch vector with one value per row, that
+				/// solvers can use with the batch functions.
+	double* GetRowBuffer() {return &row_buffer[0];}
+
+				/// Access the proxy constraint of a row
+	ChLcpConstraintTwoContactSoA& GetConstraint(int row) {return constraints[row];}
+
+				/// Index of the first proxy in the list of constraints of the
+				/// descriptor (set by ChLcpSystemDescriptor::InsertContactBlock)
+	int  GetConstraintStart() const {return constraint_start;}
+	void SetConstraintStart(int mstart) {constraint_start = mstart;}
+
+				/// Computes [Eq]=[invM]*[Cq]' and g_i=[Cq]*[invM]*[Cq]'+cfm_i for
+				/// the three rows of the k-th contact, and caches the pointers to
+				/// the 'qb' vectors of the two bodies and the active flag. Note: g_i
+				/// is not averaged, and cfm_i is taken from the proxy constraints.
+	void Update_auxiliary(int k);
+
+				/// As Update_auxiliary(int), for all contacts
+	void Update_auxiliary();
+
+				/// Sets the g_i of the N,U,V rows of each contact to their average,
+				/// as done by SOR-like solvers.
+	void Average_g_i();
+
+				/// Copies b_i, cfm_i, l_i from the proxy constraints into the arrays
+	void GatherFromConstraints();
+
+				/// Copies l_i from the arrays into the proxy constraints
+	void ScatterToConstraints();
+
+
+			//
+			// INNER LOOP KERNELS (not virtual)
+			//
+
+				/// Computes [Cq_i]*q for a row, using the current 'qb' of the bodies
+	double Compute_Cq_q(int row) const
+				{
+					int k = row/3;
+					int ib = JacIndex(row,0);
+					const double* mqa = q_a[k];
+					const double* mqb = q_b[k];
+					double ret = 0;
+					for (int j = 0; j < 6; j++, ib += LANES)
+						ret += Cq_a[ib]*mqa[j] + Cq_b[ib]*mqb[j];
+					return ret;
+				}
+
+				/// Performs 'qb' += [invM]*[Cq_i]'*deltal on both bodies (inactive
+				/// bodies point to the shared zero vector, that is never written)
+	void Increment_q(int row, double deltal)
+				{
+					int k = row/3;
+					int ib = JacIndex(row,0);
+					double* mqa = q_a[k];
+					double* mqb = q_b[k];
+					if (mqa != q_null)
+						for (int j = 0; j < 6; j++)
+							mqa[j] += Eq_a[ib + j*LANES] * deltal;
+					if (mqb != q_null)
+						for (int j = 0; j < 6; j++)
+							mqb[j] += Eq_b[ib + j*LANES] * deltal;
+				}
+
+				/// Projects the N,U,V multipliers of the k-th contact, stored
+				/// in 'ml' at ml[0],ml[1],ml[2], onto the friction cone, with
+				/// the same method of ChLcpConstraintTwoContactN::Project()
+	static void Project(double mfriction, double mcohesion, double* ml)
+				{
+					double f_n = ml[0] + mcohesion;
+					double f_u = ml[1];
+					double f_v = ml[2];
+					double f_tang = sqrt (f_v*f_v + f_u*f_u );
+
+					if (!mfriction)
+					{
+						ml[1] = 0;
+						ml[2] = 0;
+						if (f_n < 0)
+							ml[0] = 0;
+						return;
+					}
+						// inside upper cone? keep untouched!
+					if (f_tang < mfriction * f_n)
+						return;
+						// inside lower cone? reset  normal,u,v to zero!
+					if ((f_tang < -(1.0/mfriction) * f_n)||(fabs(f_n)<10e-15))
+					{
+						ml[0] = 0;
+						ml[1] = 0;
+						ml[2] = 0;
+						return;
+					}
+						// remaining case: project orthogonally to generator segment of upper cone
+					double f_n_proj =  ( f_tang * mfriction + f_n ) / (mfriction*mfriction + 1) ;
+					double f_tang_proj = f_n_proj * mfriction;
+					double tproj_div_t = f_tang_proj / f_tang;
+					ml[0] = f_n_proj - mcohesion;
+					ml[1] = tproj_div_t * f_u;
+					ml[2] = tproj_div_t * f_v;
+				}
+
+				/// Projects the N,U,V multipliers 'ml' of the k-th contact onto the friction cone
+	void Project(int k, double* ml) const {Project(friction[k], cohesion[k], ml);}
+
+				/// Projects the N,U,V multipliers of the k-th contact as stored in the block
+	void Project(int k)
+				{
+					double ml[3];
+					for (int i = 0; i < 3; i++)
+						ml[i] = L_i(3*k+i);
+					Project(k, ml);
+					for (int i = 0; i < 3; i++)
+						L_i(3*k+i) = ml[i];
+				}
+
+
+			//
+			// BATCH FUNCTIONS (SIMD, see SetSimdLevel() )
+			//
+
+				/// Performs a projected Jacobi step on all active contacts of the
+				/// block: for each row computes the residual c_i=[Cq_i]*q+b_i+cfm_i*l_i,
+				/// updates l_i -= (omega/g_i)*c_i, projects N,U,V onto the friction cone,
+				/// applies the 'sharpness' smoothing, and stores the increments of l_i
+				/// in 'delta' (indexed by row). The 'qb' of the bodies are not changed.
+				/// Also updates maxviolation (normal components) and maxdeltalambda.
+	void JacobiStep(double omega, double shlambda, double* delta, double& maxviolation, double& maxdeltalambda);
+
+				/// Computes [Cq_i]*q for all rows, storing them in 'result' (indexed by row).
+	void Compute_Cq_q_all(double* result);
+
+				/// Projects the multipliers 'ml' (indexed by row) of all the active contacts 
+				/// onto their friction cones; the others are left untouched.
+	void Project_all(double* ml);
+
+				/// Set the instruction set used by the batch functions for all blocks.
+				/// By default, the best one supported by the CPU is used. Levels that
+				/// are not supported by the CPU (or by the build) fall back to lower ones.
+	static void SetSimdLevel(eChSimdLevel mlevel);
+
+				/// Get the instruction set used by the batch functions
+	static eChSimdLevel GetSimdLevel() {return simd_level;}
+
+};
+
+
+
+
+} // END_OF_NAMESPACE____
+
+
+
+
+#endif
@@ -0,0 +1,84 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHLCPCONTACTSSOAKERNELS_H
+#define CHLCPCONTACTSSOAKERNELS_H
+
+//////////////////////////////////////////////////
+//
+//   ChLcpContactsSoAkernels.h
+//
+//    Batch kernels (scalar, SSE2, AVX) used by
+//   ChLcpContactsSoA. Not to be used directly.
+//
+//   HEADER file for CHRONO HYPEROCTANT LCP solver
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+
+namespace chrono
+{
+
+
+/// Raw pointers to the arrays of a ChLcpContactsSoA block, as
+/// passed to the batch kernels. See ChLcpContactsSoA for the layout:
+/// packs of 4 contacts, inside a pack N,U,V rows, inside a row
+/// the 6 jacobian components, each as 4 contiguous lanes.
+
+struct ChLcpContactsSoAdata
+{
+	int n_contacts;
+	int n_packs;
+	const float* Cq_a;
+	const float* Cq_b;
+	double* const* q_a;
+	double* const* q_b;
+	const double* g_i;
+	const double* b_i;
+	const double* cfm_i;
+	double* l_i;
+	const float* friction;
+	const float* cohesion;
+	const float* active;
+};
+
+
+// Scalar kernels, always available (ChLcpContactsSoA.cpp)
+
+void ChLcpSoA_JacobiStep_scalar(const ChLcpContactsSoAdata& d, double omega, double shlambda, double* delta, double& maxviolation, double& maxdeltalambda);
+void ChLcpSoA_Compute_Cq_q_scalar(const ChLcpContactsSoAdata& d, double* result);
+void ChLcpSoA_Project_scalar(const ChLcpContactsSoAdata& d, double* ml);
+
+// SSE2 kernels (ChLcpContactsSoAkernelsSSE2.cpp), return false if not compiled in
+
+bool ChLcpSoA_HasKernels_sse2();
+void ChLcpSoA_JacobiStep_sse2(const ChLcpContactsSoAdata& d, double omega, double shlambda, double* delta, double& maxviolation, double& maxdeltalambda);
+void ChLcpSoA_Compute_Cq_q_sse2(const ChLcpContactsSoAdata& d, double* result);
+void ChLcpSoA_Project_sse2(const ChLcpContactsSoAdata& d, double* ml);
+
+// AVX kernels (ChLcpContactsSoAkernelsAVX.cpp), return false if not compiled in
+
+bool ChLcpSoA_HasKernels_avx();
+void ChLcpSoA_JacobiStep_avx(const ChLcpContactsSoAdata& d, double omega, double shlambda, double* delta, double& maxviolation, double& maxdeltalambda);
+void ChLcpSoA_Compute_Cq_q_avx(const ChLcpContactsSoAdata& d, double* result);
+void ChLcpSoA_Project_avx(const ChLcpContactsSoAdata& d, double* ml);
+
+
+
+} // END_OF_NAMESPACE____
+
+
+
+#endif
@@ -0,0 +1,284 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChLcpContactsSoAkernelsAVX.cpp
+//
+//    AVX batch kernels for ChLcpContactsSoA, processing
+//   the 4 contacts of a pack in one register (4 doubles).
+//   This file must be compiled with AVX enabled (ex. -mavx);
+//   if not, the kernels are not compiled in and the scalar
+//   ones are used. Note: do not include other Chrono headers
+//   here, otherwise their inline functions could be compiled
+//   with AVX instructions and then used also on other CPUs.
+//
+//    file for CHRONO HYPEROCTANT LCP solver
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "ChLcpContactsSoAkernels.h"
+
+#if defined(__AVX__)
+ #include <immintrin.h>
+ #define CH_LCPSOA_AVX
+#endif
+
+
+namespace chrono
+{
+
+
+#ifdef CH_LCPSOA_AVX
+
+
+static inline double ChAvxMax(double a, double b) { return (a > b) ? a : b; }
+static inline int    ChAvxMin(int a, int b) { return (a < b) ? a : b; }
+
+static inline __m256d ChAvxAbs(__m256d a)
+{
+	return _mm256_max_pd(a, _mm256_sub_pd(_mm256_setzero_pd(), a));
+}
+
+static inline double ChAvxHorizontalMax(__m256d a)
+{
+	double m[4];
+	_mm256_storeu_pd(m, a);
+	return ChAvxMax(ChAvxMax(m[0],m[1]), ChAvxMax(m[2],m[3]));
+}
+
+	// Loads the 'qb' of the bodies of the 4 contacts of a pack,
+	// transposed so that qa[4*j+lane] is the j-th component of lane.
+static inline void ChAvxGatherQ(const ChLcpContactsSoAdata& d, int pack, double* qa, double* qb)
+{
+	for (int lane = 0; lane < 4; lane++)
+	{
+		const double* pa = d.q_a[pack*4 + lane];
+		const double* pb = d.q_b[pack*4 + lane];
+		for (int j = 0; j < 6; j++)
+		{
+			qa[4*j + lane] = pa[j];
+			qb[4*j + lane] = pb[j];
+		}
+	}
+}
+
+	// [Cq_i]*q for the row type i (N,U,V) of the 4 contacts of a pack
+static inline __m256d ChAvxCq_q(const ChLcpContactsSoAdata& d, int pack, int i, const double* qa, const double* qb)
+{
+	const float* mCqa = d.Cq_a + (pack*3 + i)*24;
+	const float* mCqb = d.Cq_b + (pack*3 + i)*24;
+	__m256d acc = _mm256_setzero_pd();
+	for (int j = 0; j < 6; j++)
+	{
+		__m256d ca = _mm256_cvtps_pd(_mm_loadu_ps(mCqa + 4*j));
+		__m256d cb = _mm256_cvtps_pd(_mm_loadu_ps(mCqb + 4*j));
+		acc = _mm256_add_pd(acc, _mm256_mul_pd(ca, _mm256_loadu_pd(qa + 4*j)));
+		acc = _mm256_add_pd(acc, _mm256_mul_pd(cb, _mm256_loadu_pd(qb + 4*j)));
+	}
+	return acc;
+}
+
+	// Friction cone projection of 4 N,U,V triplets,
+	// same as ChLcpContactsSoA::Project(), branch-free
+static inline void ChAvxProject(const ChLcpContactsSoAdata& d, int pack, __m256d* ml)
+{
+	__m256d vzero = _mm256_setzero_pd();
+	__m256d f = _mm256_cvtps_pd(_mm_loadu_ps(d.friction + pack*4));
+	__m256d c = _mm256_cvtps_pd(_mm_loadu_ps(d.cohesion + pack*4));
+
+	__m256d f_n = _mm256_add_pd(ml[0], c);
+	__m256d f_u = ml[1];
+	__m256d f_v = ml[2];
+	__m256d f_tang = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(f_u,f_u), _mm256_mul_pd(f_v,f_v)));
+
+		// project orthogonally to generator segment of upper cone
+		// (lanes with f_tang=0 are always in the upper or lower cone, so their
+		// result is discarded: divide them by 1, not to raise FP exceptions)
+	__m256d f_tang_safe = _mm256_blendv_pd(f_tang, _mm256_set1_pd(1.0), _mm256_cmp_pd(f_tang, vzero, _CMP_EQ_OQ));
+	__m256d f_n_proj = _mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(f_tang, f), f_n),
+									 _mm256_add_pd(_mm256_mul_pd(f, f), _mm256_set1_pd(1.0)));
+	__m256d tproj_div_t = _mm256_div_pd(_mm256_mul_pd(f_n_proj, f), f_tang_safe);
+	__m256d r0 = _mm256_sub_pd(f_n_proj, c);
+	__m256d r1 = _mm256_mul_pd(tproj_div_t, f_u);
+	__m256d r2 = _mm256_mul_pd(tproj_div_t, f_v);
+
+		// inside lower cone? reset normal,u,v to zero!  (f_tang < -(1/f)*f_n, with f>0)
+	__m256d lower = _mm256_or_pd(_mm256_cmp_pd(_mm256_mul_pd(f, f_tang), _mm256_sub_pd(vzero, f_n), _CMP_LT_OQ),
+								 _mm256_cmp_pd(ChAvxAbs(f_n), _mm256_set1_pd(10e-15), _CMP_LT_OQ));
+	r0 = _mm256_blendv_pd(r0, vzero, lower);
+	r1 = _mm256_blendv_pd(r1, vzero, lower);
+	r2 = _mm256_blendv_pd(r2, vzero, lower);
+
+		// inside upper cone? keep untouched!
+	__m256d upper = _mm256_cmp_pd(f_tang, _mm256_mul_pd(f, f_n), _CMP_LT_OQ);
+	r0 = _mm256_blendv_pd(r0, ml[0], upper);
+	r1 = _mm256_blendv_pd(r1, ml[1], upper);
+	r2 = _mm256_blendv_pd(r2, ml[2], upper);
+
+		// no friction: only clamp the normal component
+	__m256d nofric = _mm256_cmp_pd(f, vzero, _CMP_EQ_OQ);
+	__m256d n_clamped = _mm256_blendv_pd(ml[0], vzero, _mm256_cmp_pd(f_n, vzero, _CMP_LT_OQ));
+	ml[0] = _mm256_blendv_pd(r0, n_clamped, nofric);
+	ml[1] = _mm256_blendv_pd(r1, vzero, nofric);
+	ml[2] = _mm256_blendv_pd(r2, vzero, nofric);
+}
+
+
+bool ChLcpSoA_HasKernels_avx()
+{
+	return true;
+}
+
+
+void ChLcpSoA_JacobiStep_avx(const ChLcpContactsSoAdata& d, double omega, double shlambda, double* delta, double& maxviolation, double& maxdeltalambda)
+{
+	__m256d vzero  = _mm256_setzero_pd();
+	__m256d vomega = _mm256_set1_pd(omega);
+	__m256d vsh    = _mm256_set1_pd(shlambda);
+	__m256d v1msh  = _mm256_set1_pd(1.0-shlambda);
+	__m256d vmaxviolation = vzero;
+	__m256d vmaxdelta = vzero;
+
+	double qa[24], qb[24], mdelta[4];
+	__m256d mresidual[3], old_lambda[3], new_lambda[3];
+
+	for (int pack = 0; pack < d.n_packs; pack++)
+	{
+		ChAvxGatherQ(d, pack, qa, qb);
+
+		// compute residuals  c_i = [Cq_i]*q + b_i + cfm_i*l_i  for N,U,V
+		// and update:   lambda += -(omega/g_i)*c_i
+		for (int i = 0; i < 3; i++)
+		{
+			int is = (pack*3 + i)*4;
+			old_lambda[i] = _mm256_loadu_pd(d.l_i + is);
+			mresidual[i] = _mm256_add_pd(ChAvxCq_q(d, pack, i, qa, qb),
+						   _mm256_add_pd(_mm256_loadu_pd(d.b_i + is),
+										 _mm256_mul_pd(_mm256_loadu_pd(d.cfm_i + is), old_lambda[i])));
+			new_lambda[i] = _mm256_sub_pd(old_lambda[i],
+						   _mm256_mul_pd(_mm256_div_pd(vomega, _mm256_loadu_pd(d.g_i + is)), mresidual[i]));
+		}
+
+		// project N,U,V onto the friction cone
+		ChAvxProject(d, pack, new_lambda);
+
+		__m256d vactive = _mm256_cmp_pd(_mm256_cvtps_pd(_mm_loadu_ps(d.active + pack*4)), vzero, _CMP_GT_OQ);
+		int nlanes = ChAvxMin(4, d.n_contacts - pack*4);
+
+		for (int i = 0; i < 3; i++)
+		{
+			// Apply the smoothing: lambda= sharpness*lambda_new_projected + (1-sharpness)*lambda_old
+			if (shlambda!=1.0)
+				new_lambda[i] = _mm256_add_pd(_mm256_mul_pd(vsh, new_lambda[i]), _mm256_mul_pd(v1msh, old_lambda[i]));
+			// inactive contacts are left untouched
+			new_lambda[i] = _mm256_blendv_pd(old_lambda[i], new_lambda[i], vactive);
+			_mm256_storeu_pd(d.l_i + (pack*3 + i)*4, new_lambda[i]);
+
+			__m256d vdelta = _mm256_sub_pd(new_lambda[i], old_lambda[i]);
+			vmaxdelta = _mm256_max_pd(vmaxdelta, ChAvxAbs(vdelta));
+			_mm256_storeu_pd(mdelta, vdelta);
+			for (int lane = 0; lane < nlanes; lane++)
+				if (d.active[pack*4 + lane])
+					delta[3*(pack*4 + lane) + i] = mdelta[lane];
+		}
+
+		__m256d viol = _mm256_and_pd(vactive, ChAvxAbs(_mm256_min_pd(vzero, mresidual[0])));
+		vmaxviolation = _mm256_max_pd(vmaxviolation, viol);
+	}
+
+	maxviolation   = ChAvxMax(maxviolation,   ChAvxHorizontalMax(vmaxviolation));
+	maxdeltalambda = ChAvxMax(maxdeltalambda, ChAvxHorizontalMax(vmaxdelta));
+}
+
+
+void ChLcpSoA_Compute_Cq_q_avx(const ChLcpContactsSoAdata& d, double* result)
+{
+	double qa[24], qb[24], mres[4];
+
+	for (int pack = 0; pack < d.n_packs; pack++)
+	{
+		ChAvxGatherQ(d, pack, qa, qb);
+		int nlanes = ChAvxMin(4, d.n_contacts - pack*4);
+		for (int i = 0; i < 3; i++)
+		{
+			_mm256_storeu_pd(mres, ChAvxCq_q(d, pack, i, qa, qb));
+			for (int lane = 0; lane < nlanes; lane++)
+				result[3*(pack*4 + lane) + i] = mres[lane];
+		}
+	}
+}
+
+
+void ChLcpSoA_Project_avx(const ChLcpContactsSoAdata& d, double* ml)
+{
+	double mbuf[3][4];
+	__m256d vml[3];
+
+	for (int pack = 0; pack < d.n_packs; pack++)
+	{
+		int nlanes = ChAvxMin(4, d.n_contacts - pack*4);
+		for (int i = 0; i < 3; i++)
+			for (int lane = 0; lane < 4; lane++)
+				mbuf[i][lane] = (lane < nlanes) ? ml[3*(pack*4 + lane) + i] : 0.;
+		__m256d old_ml[3];
+		for (int i = 0; i < 3; i++)
+			vml[i] = old_ml[i] = _mm256_loadu_pd(mbuf[i]);
+
+		ChAvxProject(d, pack, vml);
+
+		// inactive contacts are left untouched
+		__m256d vactive = _mm256_cmp_pd(_mm256_cvtps_pd(_mm_loadu_ps(d.active + pack*4)), _mm256_setzero_pd(), _CMP_GT_OQ);
+		for (int i = 0; i < 3; i++)
+		{
+			_mm256_storeu_pd(mbuf[i], _mm256_blendv_pd(old_ml[i], vml[i], vactive));
+			for (int lane = 0; lane < nlanes; lane++)
+				ml[3*(pack*4 + lane) + i] = mbuf[i][lane];
+		}
+	}
+}
+
+
+#else // no AVX in this build: never selected, see ChLcpContactsSoA::SetSimdLevel()
+
+
+bool ChLcpSoA_HasKernels_avx()
+{
+	return false;
+}
+
+void ChLcpSoA_JacobiStep_avx(const ChLcpContactsSoAdata& d, double omega, double shlambda, double* delta, double& maxviolation, double& maxdeltalambda)
+{
+	ChLcpSoA_JacobiStep_scalar(d, omega, shlambda, delta, maxviolation, maxdeltalambda);
+}
+
+void ChLcpSoA_Compute_Cq_q_avx(const ChLcpContactsSoAdata& d, double* result)
+{
+	ChLcpSoA_Compute_Cq_q_scalar(d, result);
+}
+
+void ChLcpSoA_Project_avx(const ChLcpContactsSoAdata& d, double* ml)
+{
+	ChLcpSoA_Project_scalar(d, ml);
+}
+
+
+#endif
+
+
+
+} // END_OF_NAMESPACE____
+
+
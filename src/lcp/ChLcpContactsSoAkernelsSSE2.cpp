@@ -0,0 +1,299 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChLcpContactsSoAkernelsSSE2.cpp
+//
+//    SSE2 batch kernels for ChLcpContactsSoA, processing
+//   the 4 contacts of a pack as two registers of 2 doubles.
+//   This file must be compiled with SSE2 enabled (default
+//   on x64 platforms); if not, the kernels are not compiled
+//   in and the scalar ones are used. Note: do not include
+//   other Chrono headers here (see ChLcpContactsSoAkernelsAVX.cpp).
+//
+//    file for CHRONO HYPEROCTANT LCP solver
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "ChLcpContactsSoAkernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+ #include <emmintrin.h>
+ #define CH_LCPSOA_SSE2
+#endif
+
+
+namespace chrono
+{
+
+
+#ifdef CH_LCPSOA_SSE2
+
+
+static inline double ChSse2Max(double a, double b) { return (a > b) ? a : b; }
+static inline int    ChSse2Min(int a, int b) { return (a < b) ? a : b; }
+
+static inline __m128d ChSse2Abs(__m128d a)
+{
+	return _mm_max_pd(a, _mm_sub_pd(_mm_setzero_pd(), a));
+}
+
+	// SSE2 has no blendv: select b where mask is set, a elsewhere
+static inline __m128d ChSse2Blend(__m128d a, __m128d b, __m128d mask)
+{
+	return _mm_or_pd(_mm_andnot_pd(mask, a), _mm_and_pd(mask, b));
+}
+
+	// Loads two floats and converts them to doubles
+static inline __m128d ChSse2Load2f(const float* p)
+{
+	return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*)p)));
+}
+
+static inline double ChSse2HorizontalMax(__m128d a)
+{
+	double m[2];
+	_mm_storeu_pd(m, a);
+	return ChSse2Max(m[0],m[1]);
+}
+
+	// Loads the 'qb' of the bodies of the 4 contacts of a pack,
+	// transposed so that qa[4*j+lane] is the j-th component of lane.
+static inline void ChSse2GatherQ(const ChLcpContactsSoAdata& d, int pack, double* qa, double* qb)
+{
+	for (int lane = 0; lane < 4; lane++)
+	{
+		const double* pa = d.q_a[pack*4 + lane];
+		const double* pb = d.q_b[pack*4 + lane];
+		for (int j = 0; j < 6; j++)
+		{
+			qa[4*j + lane] = pa[j];
+			qb[4*j + lane] = pb[j];
+		}
+	}
+}
+
+	// [Cq_i]*q for the row type i (N,U,V) of the two contacts of half 'h' of a pack
+static inline __m128d ChSse2Cq_q(const ChLcpContactsSoAdata& d, int pack, int h, int i, const double* qa, const double* qb)
+{
+	const float* mCqa = d.Cq_a + (pack*3 + i)*24 + 2*h;
+	const float* mCqb = d.Cq_b + (pack*3 + i)*24 + 2*h;
+	__m128d acc = _mm_setzero_pd();
+	for (int j = 0; j < 6; j++)
+	{
+		acc = _mm_add_pd(acc, _mm_mul_pd(ChSse2Load2f(mCqa + 4*j), _mm_loadu_pd(qa + 4*j + 2*h)));
+		acc = _mm_add_pd(acc, _mm_mul_pd(ChSse2Load2f(mCqb + 4*j), _mm_loadu_pd(qb + 4*j + 2*h)));
+	}
+	return acc;
+}
+
+	// Friction cone projection of 2 N,U,V triplets (half 'h' of a pack),
+	// same as ChLcpContactsSoA::Project(), branch-free
+static inline void ChSse2Project(const ChLcpContactsSoAdata& d, int pack, int h, __m128d* ml)
+{
+	__m128d vzero = _mm_setzero_pd();
+	__m128d f = ChSse2Load2f(d.friction + pack*4 + 2*h);
+	__m128d c = ChSse2Load2f(d.cohesion + pack*4 + 2*h);
+
+	__m128d f_n = _mm_add_pd(ml[0], c);
+	__m128d f_u = ml[1];
+	__m128d f_v = ml[2];
+	__m128d f_tang = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(f_u,f_u), _mm_mul_pd(f_v,f_v)));
+
+		// project orthogonally to generator segment of upper cone
+		// (lanes with f_tang=0 are always in the upper or lower cone, so their
+		// result is discarded: divide them by 1, not to raise FP exceptions)
+	__m128d f_tang_safe = ChSse2Blend(f_tang, _mm_set1_pd(1.0), _mm_cmpeq_pd(f_tang, vzero));
+	__m128d f_n_proj = _mm_div_pd(_mm_add_pd(_mm_mul_pd(f_tang, f), f_n),
+								  _mm_add_pd(_mm_mul_pd(f, f), _mm_set1_pd(1.0)));
+	__m128d tproj_div_t = _mm_div_pd(_mm_mul_pd(f_n_proj, f), f_tang_safe);
+	__m128d r0 = _mm_sub_pd(f_n_proj, c);
+	__m128d r1 = _mm_mul_pd(tproj_div_t, f_u);
+	__m128d r2 = _mm_mul_pd(tproj_div_t, f_v);
+
+		// inside lower cone? reset normal,u,v to zero!  (f_tang < -(1/f)*f_n, with f>0)
+	__m128d lower = _mm_or_pd(_mm_cmplt_pd(_mm_mul_pd(f, f_tang), _mm_sub_pd(vzero, f_n)),
+							  _mm_cmplt_pd(ChSse2Abs(f_n), _mm_set1_pd(10e-15)));
+	r0 = _mm_andnot_pd(lower, r0);
+	r1 = _mm_andnot_pd(lower, r1);
+	r2 = _mm_andnot_pd(lower, r2);
+
+		// inside upper cone? keep untouched!
+	__m128d upper = _mm_cmplt_pd(f_tang, _mm_mul_pd(f, f_n));
+	r0 = ChSse2Blend(r0, ml[0], upper);
+	r1 = ChSse2Blend(r1, ml[1], upper);
+	r2 = ChSse2Blend(r2, ml[2], upper);
+
+		// no friction: only clamp the normal component
+	__m128d nofric = _mm_cmpeq_pd(f, vzero);
+	__m128d n_clamped = _mm_andnot_pd(_mm_cmplt_pd(f_n, vzero), ml[0]);
+	ml[0] = ChSse2Blend(r0, n_clamped, nofric);
+	ml[1] = _mm_andnot_pd(nofric, r1);
+	ml[2] = _mm_andnot_pd(nofric, r2);
+}
+
+
+bool ChLcpSoA_HasKernels_sse2()
+{
+	return true;
+}
+
+
+void ChLcpSoA_JacobiStep_sse2(const ChLcpContactsSoAdata& d, double omega, double shlambda, double* delta, double& maxviolation, double& maxdeltalambda)
+{
+	__m128d vzero  = _mm_setzero_pd();
+	__m128d vomega = _mm_set1_pd(omega);
+	__m128d vsh    = _mm_set1_pd(shlambda);
+	__m128d v1msh  = _mm_set1_pd(1.0-shlambda);
+	__m128d vmaxviolation = vzero;
+	__m128d vmaxdelta = vzero;
+
+	double qa[24], qb[24], mdelta[2];
+	__m128d mresidual[3], old_lambda[3], new_lambda[3];
+
+	for (int pack = 0; pack < d.n_packs; pack++)
+	{
+		ChSse2GatherQ(d, pack, qa, qb);
+		int nlanes = ChSse2Min(4, d.n_contacts - pack*4);
+
+		for (int h = 0; h < 2; h++)
+		{
+			// compute residuals  c_i = [Cq_i]*q + b_i + cfm_i*l_i  for N,U,V
+			// and update:   lambda += -(omega/g_i)*c_i
+			for (int i = 0; i < 3; i++)
+			{
+				int is = (pack*3 + i)*4 + 2*h;
+				old_lambda[i] = _mm_loadu_pd(d.l_i + is);
+				mresidual[i] = _mm_add_pd(ChSse2Cq_q(d, pack, h, i, qa, qb),
+							   _mm_add_pd(_mm_loadu_pd(d.b_i + is),
+										  _mm_mul_pd(_mm_loadu_pd(d.cfm_i + is), old_lambda[i])));
+				new_lambda[i] = _mm_sub_pd(old_lambda[i],
+							   _mm_mul_pd(_mm_div_pd(vomega, _mm_loadu_pd(d.g_i + is)), mresidual[i]));
+			}
+
+			// project N,U,V onto the friction cone
+			ChSse2Project(d, pack, h, new_lambda);
+
+			__m128d vactive = _mm_cmpgt_pd(ChSse2Load2f(d.active + pack*4 + 2*h), vzero);
+
+			for (int i = 0; i < 3; i++)
+			{
+				// Apply the smoothing: lambda= sharpness*lambda_new_projected + (1-sharpness)*lambda_old
+				if (shlambda!=1.0)
+					new_lambda[i] = _mm_add_pd(_mm_mul_pd(vsh, new_lambda[i]), _mm_mul_pd(v1msh, old_lambda[i]));
+				// inactive contacts are left untouched
+				new_lambda[i] = ChSse2Blend(old_lambda[i], new_lambda[i], vactive);
+				_mm_storeu_pd(d.l_i + (pack*3 + i)*4 + 2*h, new_lambda[i]);
+
+				__m128d vdelta = _mm_sub_pd(new_lambda[i], old_lambda[i]);
+				vmaxdelta = _mm_max_pd(vmaxdelta, ChSse2Abs(vdelta));
+				_mm_storeu_pd(mdelta, vdelta);
+				for (int lane = 2*h; lane < ChSse2Min(2*h+2, nlanes); lane++)
+					if (d.active[pack*4 + lane])
+						delta[3*(pack*4 + lane) + i] = mdelta[lane - 2*h];
+			}
+
+			__m128d viol = _mm_and_pd(vactive, ChSse2Abs(_mm_min_pd(vzero, mresidual[0])));
+			vmaxviolation = _mm_max_pd(vmaxviolation, viol);
+		}
+	}
+
+	maxviolation   = ChSse2Max(maxviolation,   ChSse2HorizontalMax(vmaxviolation));
+	maxdeltalambda = ChSse2Max(maxdeltalambda, ChSse2HorizontalMax(vmaxdelta));
+}
+
+
+void ChLcpSoA_Compute_Cq_q_sse2(const ChLcpContactsSoAdata& d, double* result)
+{
+	double qa[24], qb[24], mres[2];
+
+	for (int pack = 0; pack < d.n_packs; pack++)
+	{
+		ChSse2GatherQ(d, pack, qa, qb);
+		int nlanes = ChSse2Min(4, d.n_contacts - pack*4);
+		for (int h = 0; h < 2; h++)
+			for (int i = 0; i < 3; i++)
+			{
+				_mm_storeu_pd(mres, ChSse2Cq_q(d, pack, h, i, qa, qb));
+				for (int lane = 2*h; lane < ChSse2Min(2*h+2, nlanes); lane++)
+					result[3*(pack*4 + lane) + i] = mres[lane - 2*h];
+			}
+	}
+}
+
+
+void ChLcpSoA_Project_sse2(const ChLcpContactsSoAdata& d, double* ml)
+{
+	double mbuf[3][4];
+	__m128d vml[3];
+
+	for (int pack = 0; pack < d.n_packs; pack++)
+	{
+		int nlanes = ChSse2Min(4, d.n_contacts - pack*4);
+		for (int i = 0; i < 3; i++)
+			for (int lane = 0; lane < 4; lane++)
+				mbuf[i][lane] = (lane < nlanes) ? ml[3*(pack*4 + lane) + i] : 0.;
+
+		for (int h = 0; h < 2; h++)
+		{
+			__m128d old_ml[3];
+			for (int i = 0; i < 3; i++)
+				vml[i] = old_ml[i] = _mm_loadu_pd(&mbuf[i][2*h]);
+			ChSse2Project(d, pack, h, vml);
+			// inactive contacts are left untouched
+			__m128d vactive = _mm_cmpgt_pd(ChSse2Load2f(d.active + pack*4 + 2*h), _mm_setzero_pd());
+			for (int i = 0; i < 3; i++)
+				_mm_storeu_pd(&mbuf[i][2*h], ChSse2Blend(old_ml[i], vml[i], vactive));
+		}
+
+		for (int i = 0; i < 3; i++)
+			for (int lane = 0; lane < nlanes; lane++)
+				ml[3*(pack*4 + lane) + i] = mbuf[i][lane];
+	}
+}
+
+
+#else // no SSE2 in this build: never selected, see ChLcpContactsSoA::SetSimdLevel()
+
+
+bool ChLcpSoA_HasKernels_sse2()
+{
+	return false;
+}
+
+void ChLcpSoA_JacobiStep_sse2(const ChLcpContactsSoAdata& d, double omega, double shlambda, double* delta, double& maxviolation, double& maxdeltalambda)
+{
+	ChLcpSoA_JacobiStep_scalar(d, omega, shlambda, delta, maxviolation, maxdeltalambda);
+}
+
+void ChLcpSoA_Compute_Cq_q_sse2(const ChLcpContactsSoAdata& d, double* result)
+{
+	ChLcpSoA_Compute_Cq_q_scalar(d, result);
+}
+
+void ChLcpSoA_Project_sse2(const ChLcpContactsSoAdata& d, double* ml)
+{
+	ChLcpSoA_Project_scalar(d, ml);
+}
+
+
+#endif
+
+
+
+} // END_OF_NAMESPACE____
+
+
@@ -116,6 +116,17 @@ public:
 				/// of magnitude.
 	void SetDiagonalPreconditioning(bool mp) {this->diag_preconditioning = mp;}
 	bool GetDiagonalPreconditioning() {return this->diag_preconditioning;}
+
+	virtual void CopySettings(ChLcpIterativeSolver* source)
+			{
+				ChLcpIterativeSolver::CopySettings(source);
+				if (ChLcpIterativeBB* msource = dynamic_cast<ChLcpIterativeBB*>(source))
+				{
+					n_armijo = msource->n_armijo;
+					max_armijo_backtrace = msource->max_armijo_backtrace;
+					diag_preconditioning = msource->diag_preconditioning;
+				}
+			}
 };
 
 
@@ -34,6 +34,9 @@ double ChLcpIterativeJacobi::Solve(
 {
 	std::vector<ChLcpConstraint*>& mconstraints = sysd.GetConstraintsList();
 	std::vector<ChLcpVariables*>&  mvariables	= sysd.GetVariablesList();
+	std::vector<ChLcpContactsSoA*>& mblocks		= sysd.GetContactBlocksList();
+	int nblocks = (int)mblocks.size();
+	int ib;
 
 	tot_iterations = 0;
 	double maxviolation = 0.;
@@ -43,15 +46,35 @@ double ChLcpIterativeJacobi::Solve(
 
 	// 1)  Update auxiliary data in all constraints before starting,
 	//     that is: g_i=[Cq_i]*[invM_i]*[Cq_i]' and  [Eq_i]=[invM_i]*[Cq_i]'
+	//     (contacts in SoA blocks are updated and averaged by the block itself)
+	ib = 0;
 	for (unsigned int ic = 0; ic< mconstraints.size(); ic++)
+	{
+		if (ib < nblocks && (int)ic == mblocks[ib]->GetConstraintStart())
+		{
+			mblocks[ib]->GatherFromConstraints();
+			mblocks[ib]->Update_auxiliary();
+			mblocks[ib]->Average_g_i();
+			ic += mblocks[ib]->GetNconstraints() - 1;
+			ib++;
+			continue;
+		}
 		mconstraints[ic]->Update_auxiliary();
+	}
 
 	// Average all g_i for the triplet of contact constraints n,u,v.
 	//
 	int j_friction_comp = 0;
 	double gi_values[3];
+	ib = 0;
 	for (unsigned int ic = 0; ic< mconstraints.size(); ic++)
 	{
+		if (ib < nblocks && (int)ic == mblocks[ib]->GetConstraintStart())
+		{
+			ic += mblocks[ib]->GetNconstraints() - 1;
+			ib++;
+			continue;
+		}
 		if (mconstraints[ic]->GetMode() == CONSTRAINT_FRIC) 
 		{
 			gi_values[j_friction_comp] = mconstraints[ic]->Get_g_i();
@@ -85,6 +108,9 @@ double ChLcpIterativeJacobi::Solve(
 	{
 		for (unsigned int ic = 0; ic< mconstraints.size(); ic++)
 			mconstraints[ic]->Set_l_i(0.);
+		for (ib = 0; ib < nblocks; ib++)
+			for (int row = 0; row < mblocks[ib]->GetNconstraints(); row++)
+				mblocks[ib]->L_i(row) = 0.;
 	}
 
 	// 4)  Perform the iteration loops
@@ -100,9 +126,23 @@ double ChLcpIterativeJacobi::Solve(
 
 		maxviolation = 0;
 		maxdeltalambda =0;
+		ib = 0;
 
 		for (unsigned int ic = 0; ic < mconstraints.size(); ic++)
 		{
+			// contacts in SoA blocks: use the non-virtual kernels of the block
+			if (ib < nblocks && (int)ic == mblocks[ib]->GetConstraintStart())
+			{
+				// (batch function, processing several contacts at once with SIMD)
+				double maxdelta_block = 0;
+				mblocks[ib]->JacobiStep(omega, shlambda, &delta_gammas[ic], maxviolation, maxdelta_block);
+				if (this->record_violation_history)
+					maxdeltalambda = ChMax(maxdeltalambda, maxdelta_block);
+				ic += mblocks[ib]->GetNconstraints() - 1;
+				ib++;
+				continue;
+			}
+
 			// skip computations if constraint not active.
 			if (mconstraints[ic]->IsActive())
 			{
@@ -192,8 +232,18 @@ double ChLcpIterativeJacobi::Solve(
 		}
 
 		// Now, after all deltas are updated, sweep through all constraints and increment  q += [invM][Cq]'* delta_l 
+		ib = 0;
 		for (unsigned int ic = 0; ic < mconstraints.size(); ic++)
 		{	
+			if (ib < nblocks && (int)ic == mblocks[ib]->GetConstraintStart())
+			{
+				for (int row = 0; row < mblocks[ib]->GetNconstraints(); row++)
+					if (mblocks[ib]->GetConstraint(row).IsActive())
+						mblocks[ib]->Increment_q(row, delta_gammas[ic+row]);
+				ic += mblocks[ib]->GetNconstraints() - 1;
+				ib++;
+				continue;
+			}
 			if (mconstraints[ic]->IsActive())
 				mconstraints[ic]->Increment_q(delta_gammas[ic]);
 		}
@@ -210,6 +260,10 @@ double ChLcpIterativeJacobi::Solve(
 
 	}
 
+	// Store the multipliers of SoA blocks back into their constraints
+	for (ib = 0; ib < nblocks; ib++)
+		mblocks[ib]->ScatterToConstraints();
+
 
 	return maxviolation;
 
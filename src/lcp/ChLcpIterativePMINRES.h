@@ -120,6 +120,17 @@ public:
 	void SetDiagonalPreconditioning(bool mp) {this->diag_preconditioning = mp;}
 	bool GetDiagonalPreconditioning() {return this->diag_preconditioning;}
 
+	virtual void CopySettings(ChLcpIterativeSolver* source)
+			{
+				ChLcpIterativeSolver::CopySettings(source);
+				if (ChLcpIterativePMINRES* msource = dynamic_cast<ChLcpIterativePMINRES*>(source))
+				{
+					grad_diffstep = msource->grad_diffstep;
+					rel_tolerance = msource->rel_tolerance;
+					diag_preconditioning = msource->diag_preconditioning;
+				}
+			}
+
 };
 
 
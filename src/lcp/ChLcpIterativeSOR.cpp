@@ -34,6 +34,9 @@ double ChLcpIterativeSOR::Solve(
 {
 	std::vector<ChLcpConstraint*>& mconstraints = sysd.GetConstraintsList();
 	std::vector<ChLcpVariables*>&  mvariables	= sysd.GetVariablesList();
+	std::vector<ChLcpContactsSoA*>& mblocks		= sysd.GetContactBlocksList();
+	int nblocks = (int)mblocks.size();
+	int ib;
 
 	tot_iterations = 0;
 	double maxviolation = 0.;
@@ -44,15 +47,35 @@ double ChLcpIterativeSOR::Solve(
 
 	// 1)  Update auxiliary data in all constraints before starting,
 	//     that is: g_i=[Cq_i]*[invM_i]*[Cq_i]' and  [Eq_i]=[invM_i]*[Cq_i]'
+	//     (contacts in SoA blocks are updated and averaged by the block itself)
+	ib = 0;
 	for (unsigned int ic = 0; ic< mconstraints.size(); ic++)
+	{
+		if (ib < nblocks && (int)ic == mblocks[ib]->GetConstraintStart())
+		{
+			mblocks[ib]->GatherFromConstraints();
+			mblocks[ib]->Update_auxiliary();
+			mblocks[ib]->Average_g_i();
+			ic += mblocks[ib]->GetNconstraints() - 1;
+			ib++;
+			continue;
+		}
 		mconstraints[ic]->Update_auxiliary();
+	}
 
 	// Average all g_i for the triplet of contact constraints n,u,v.
 	//
 	int j_friction_comp = 0;
 	double gi_values[3];
+	ib = 0;
 	for (unsigned int ic = 0; ic< mconstraints.size(); ic++)
 	{
+		if (ib < nblocks && (int)ic == mblocks[ib]->GetConstraintStart())
+		{
+			ic += mblocks[ib]->GetNconstraints() - 1;
+			ib++;
+			continue;
+		}
 		if (mconstraints[ic]->GetMode() == CONSTRAINT_FRIC) 
 		{
 			gi_values[j_friction_comp] = mconstraints[ic]->Get_g_i();
@@ -82,14 +105,29 @@ double ChLcpIterativeSOR::Solve(
 	//     Otherwise, if no warm start, simply resets initial lagrangians to zero.
 	if (warm_start)
 	{
+		ib = 0;
 		for (unsigned int ic = 0; ic< mconstraints.size(); ic++)
+		{
+			if (ib < nblocks && (int)ic == mblocks[ib]->GetConstraintStart())
+			{
+				for (int row = 0; row < mblocks[ib]->GetNconstraints(); row++)
+					if (mblocks[ib]->GetConstraint(row).IsActive())
+						mblocks[ib]->Increment_q(row, mblocks[ib]->L_i(row));
+				ic += mblocks[ib]->GetNconstraints() - 1;
+				ib++;
+				continue;
+			}
 			if (mconstraints[ic]->IsActive())
 				mconstraints[ic]->Increment_q(mconstraints[ic]->Get_l_i());
+		}
 	}
 	else
 	{
 		for (unsigned int ic = 0; ic< mconstraints.size(); ic++)
 			mconstraints[ic]->Set_l_i(0.);
+		for (ib = 0; ib < nblocks; ib++)
+			for (int row = 0; row < mblocks[ib]->GetNconstraints(); row++)
+				mblocks[ib]->L_i(row) = 0.;
 	}
 
 	// 4)  Perform the iteration loops
@@ -104,9 +142,19 @@ double ChLcpIterativeSOR::Solve(
 		maxviolation = 0;
 		maxdeltalambda = 0;
 		i_friction_comp = 0;
+		ib = 0;
 
 		for (unsigned int ic = 0; ic < mconstraints.size(); ic++)
 		{
+			// contacts in SoA blocks: use the non-virtual kernels of the block
+			if (ib < nblocks && (int)ic == mblocks[ib]->GetConstraintStart())
+			{
+				SolveContactBlock(*mblocks[ib], maxviolation, maxdeltalambda);
+				ic += mblocks[ib]->GetNconstraints() - 1;
+				ib++;
+				continue;
+			}
+
 			// skip computations if constraint not active.
 			if (mconstraints[ic]->IsActive())
 			{
@@ -212,12 +260,65 @@ double ChLcpIterativeSOR::Solve(
 
 	} // end iteration loop
 
+	// Store the multipliers of SoA blocks back into their constraints
+	for (ib = 0; ib < nblocks; ib++)
+		mblocks[ib]->ScatterToConstraints();
+
 
 	return maxviolation;
 
 }
 
 
+void ChLcpIterativeSOR::SolveContactBlock(
+				ChLcpContactsSoA& mblock,
+				double& maxviolation,
+				double& maxdeltalambda
+				)
+{
+	double mresidual[3];
+	double old_lambda[3];
+	double new_lambda[3];
+
+	for (int k = 0; k < mblock.GetNcontacts(); k++)
+	{
+		int row = 3*k;
+
+		// skip computations if contact not active.
+		if (!mblock.GetConstraint(row).IsActive())
+			continue;
+
+		// compute residuals  c_i = [Cq_i]*q + b_i + cfm_i*l_i  for N,U,V
+		// and update:   lambda += delta_lambda;
+		for (int i = 0; i < 3; i++)
+		{
+			old_lambda[i] = mblock.L_i(row+i);
+			mresidual[i] = mblock.Compute_Cq_q(row+i) + mblock.B_i(row+i) + mblock.Cfm_i(row+i) * old_lambda[i];
+			new_lambda[i] = old_lambda[i] - ( omega / mblock.G_i(row+i) ) * mresidual[i];
+		}
+
+		// project N,U,V onto the friction cone
+		mblock.Project(k, new_lambda);
+
+		for (int i = 0; i < 3; i++)
+		{
+			// Apply the smoothing: lambda= sharpness*lambda_new_projected + (1-sharpness)*lambda_old
+			if (this->shlambda!=1.0)
+				new_lambda[i] = shlambda*new_lambda[i] + (1.0-shlambda)*old_lambda[i];
+			mblock.L_i(row+i) = new_lambda[i];
+
+			double true_delta = new_lambda[i] - old_lambda[i];
+			mblock.Increment_q(row+i, true_delta);
+
+			if (this->record_violation_history)
+				maxdeltalambda = ChMax(maxdeltalambda, fabs(true_delta));
+		}
+
+		maxviolation = ChMax(maxviolation, fabs(ChMin(0.0,mresidual[0])));
+	}
+}
+
+
 
 
 
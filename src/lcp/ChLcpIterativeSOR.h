@@ -86,7 +86,14 @@ public:
 				ChLcpSystemDescriptor& sysd		///< system description with constraints and variables	
 				);
 
-
+protected:
+				/// Performs one SOR sweep on the contacts of a SoA block,
+				/// using its non-virtual kernels on the contiguous arrays.
+	void SolveContactBlock(
+				ChLcpContactsSoA& mblock,
+				double& maxviolation,
+				double& maxdeltalambda
+				);
 
 };
 
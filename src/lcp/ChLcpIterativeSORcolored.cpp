@@ -0,0 +1,255 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be 
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChLcpIterativeSORcolored.cpp
+//
+//
+//    file for CHRONO HYPEROCTANT LCP solver
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+  
+   
+#include "ChLcpIterativeSORcolored.h"
+#include "parallel/ChOpenMP.h"
+
+
+namespace chrono
+{
+
+
+void ChLcpIterativeSORcolored::SolveItem(
+					std::vector<ChLcpConstraint*>& mconstraints, 
+					int ic, 
+					double& maxviolation, 
+					double& maxdeltalambda)
+{
+	if (mconstraints[ic]->GetMode() == CONSTRAINT_FRIC)
+	{
+		// The N,U,V triplet: all residuals are computed with the same q,
+		// as in the serial ChLcpIterativeSOR.
+		double old_lambda_friction[3];
+		for (int k = 0; k < 3; k++)
+		{
+			double mresidual = mconstraints[ic+k]->Compute_Cq_q() + mconstraints[ic+k]->Get_b_i()
+							 + mconstraints[ic+k]->Get_cfm_i() * mconstraints[ic+k]->Get_l_i();
+			double deltal = ( omega / mconstraints[ic+k]->Get_g_i() ) * ( -mresidual );
+
+			if (k==0)
+				maxviolation = ChMax(maxviolation, fabs(ChMin(0.0,mresidual)));
+
+			old_lambda_friction[k] = mconstraints[ic+k]->Get_l_i();
+			mconstraints[ic+k]->Set_l_i( old_lambda_friction[k] + deltal);
+		}
+
+		mconstraints[ic]->Project(); // the N normal component will take care of N,U,V
+
+		for (int k = 0; k < 3; k++)
+		{
+			double new_lambda = mconstraints[ic+k]->Get_l_i();
+			// Apply the smoothing: lambda= sharpness*lambda_new_projected + (1-sharpness)*lambda_old
+			if (this->shlambda!=1.0)
+			{
+				new_lambda = shlambda*new_lambda + (1.0-shlambda)*old_lambda_friction[k];
+				mconstraints[ic+k]->Set_l_i(new_lambda);
+			}
+			double true_delta = new_lambda - old_lambda_friction[k];
+			mconstraints[ic+k]->Increment_q(true_delta);
+
+			if (this->record_violation_history)
+				maxdeltalambda = ChMax(maxdeltalambda, fabs(true_delta));
+		}
+	}
+	else
+	{
+		// compute residual  c_i = [Cq_i]*q + b_i + cfm_i*l_i
+		double mresidual = mconstraints[ic]->Compute_Cq_q() + mconstraints[ic]->Get_b_i()
+						 + mconstraints[ic]->Get_cfm_i() * mconstraints[ic]->Get_l_i();
+
+		// true constraint violation may be different from 'mresidual' (ex:clamped if unilateral)
+		double candidate_violation = fabs(mconstraints[ic]->Violation(mresidual));
+
+		// compute:  delta_lambda = -(omega/g_i) * ([Cq_i]*q + b_i + cfm_i*l_i )
+		double deltal = ( omega / mconstraints[ic]->Get_g_i() ) * ( -mresidual );
+
+		// update:   lambda += delta_lambda;
+		double old_lambda = mconstraints[ic]->Get_l_i();
+		mconstraints[ic]->Set_l_i( old_lambda + deltal);
+
+		// If new lagrangian multiplier does not satisfy inequalities, project
+		// it into an admissible orthant (or, in general, onto an admissible set)
+		mconstraints[ic]->Project();
+
+		// After projection, the lambda may have changed a bit..
+		double new_lambda = mconstraints[ic]->Get_l_i() ;
+
+		// Apply the smoothing: lambda= sharpness*lambda_new_projected + (1-sharpness)*lambda_old
+		if (this->shlambda!=1.0)
+		{
+			new_lambda = shlambda*new_lambda + (1.0-shlambda)*old_lambda;
+			mconstraints[ic]->Set_l_i(new_lambda);
+		}
+
+		double true_delta = new_lambda - old_lambda;
+
+		// For all items with variables, add the effect of incremented
+		// (and projected) lagrangian reactions:
+		mconstraints[ic]->Increment_q(true_delta);
+
+		if (this->record_violation_history)
+			maxdeltalambda = ChMax(maxdeltalambda, fabs(true_delta)); 
+
+		maxviolation = ChMax(maxviolation, candidate_violation);
+	}
+}
+
+
+double ChLcpIterativeSORcolored::Solve(
+					ChLcpSystemDescriptor& sysd		///< system description with constraints and variables	
+					)
+{
+	std::vector<ChLcpConstraint*>& mconstraints = sysd.GetConstraintsList();
+	std::vector<ChLcpVariables*>&  mvariables	= sysd.GetVariablesList();
+	int nthreads = sysd.GetNumThreads();
+
+	tot_iterations = 0;
+	double maxviolation = 0.;
+	double maxdeltalambda = 0.;
+
+	// 0)  Color the constraint graph (done only once per step, even if
+	//     the descriptor is used also for the stabilization problem)
+	sysd.UpdateConstraintColoring();
+	std::vector< std::vector<int> >& mcolors = sysd.GetConstraintColors();
+
+
+	// 1)  Update auxiliary data in all constraints before starting,
+	//     that is: g_i=[Cq_i]*[invM_i]*[Cq_i]' and  [Eq_i]=[invM_i]*[Cq_i]'
+	#pragma omp parallel for num_threads(nthreads)
+	for (int ic = 0; ic< (int)mconstraints.size(); ic++)
+		mconstraints[ic]->Update_auxiliary();
+
+	// Average all g_i for the triplet of contact constraints n,u,v.
+	//
+	int j_friction_comp = 0;
+	double gi_values[3];
+	for (unsigned int ic = 0; ic< mconstraints.size(); ic++)
+	{
+		if (mconstraints[ic]->GetMode() == CONSTRAINT_FRIC) 
+		{
+			gi_values[j_friction_comp] = mconstraints[ic]->Get_g_i();
+			j_friction_comp++;
+			if (j_friction_comp==3)
+			{
+				double average_g_i = (gi_values[0]+gi_values[1]+gi_values[2])/3.0;
+				mconstraints[ic-2]->Set_g_i(average_g_i);
+				mconstraints[ic-1]->Set_g_i(average_g_i);
+				mconstraints[ic-0]->Set_g_i(average_g_i);
+				j_friction_comp=0;
+			}
+		}	
+	}
+
+
+	// 2)  Compute, for all items with variables, the initial guess for
+	//     still unconstrained system:
+	#pragma omp parallel for num_threads(nthreads)
+	for (int iv = 0; iv< (int)mvariables.size(); iv++)
+		if (mvariables[iv]->IsActive())
+			mvariables[iv]->Compute_invMb_v(mvariables[iv]->Get_qb(), mvariables[iv]->Get_fb()); // q = [M]'*fb 
+
+
+	// 3)  For all items with variables, add the effect of initial (guessed)
+	//     lagrangian reactions of contraints, if a warm start is desired.
+	//     Otherwise, if no warm start, simply resets initial lagrangians to zero.
+	//     (Increment_q writes into variables, so it must go color by color)
+	if (warm_start)
+	{
+		#pragma omp parallel num_threads(nthreads)
+		for (int icol = 0; icol < (int)mcolors.size(); icol++)
+		{
+			std::vector<int>& mitems = mcolors[icol];
+			// (the implicit barrier at the end of 'omp for' separates the colors)
+			#pragma omp for
+			for (int iu = 0; iu < (int)mitems.size(); iu++)
+			{
+				int ic = mitems[iu];
+				int ncomp = (mconstraints[ic]->GetMode() == CONSTRAINT_FRIC) ? 3 : 1;
+				for (int k = 0; k < ncomp; k++)
+					mconstraints[ic+k]->Increment_q(mconstraints[ic+k]->Get_l_i());
+			}
+		}
+	}
+	else
+	{
+		#pragma omp parallel for num_threads(nthreads)
+		for (int ic = 0; ic< (int)mconstraints.size(); ic++)
+			mconstraints[ic]->Set_l_i(0.);
+	}
+
+	// 4)  Perform the iteration loops
+	//
+
+	for (int iter = 0; iter < max_iterations; iter++)
+	{
+		maxviolation = 0;
+		maxdeltalambda = 0;
+
+		// The iteration on all colors, one after the other, and on
+		// all constraints of each color, in parallel. A single parallel
+		// region is used for all colors: the implicit barrier at the end
+		// of 'omp for' separates the colors.
+		#pragma omp parallel num_threads(nthreads)
+		{
+			double t_maxviolation = 0;
+			double t_maxdeltalambda = 0;
+
+			for (int icol = 0; icol < (int)mcolors.size(); icol++)
+			{
+				std::vector<int>& mitems = mcolors[icol];
+
+				#pragma omp for
+				for (int iu = 0; iu < (int)mitems.size(); iu++)
+					SolveItem(mconstraints, mitems[iu], t_maxviolation, t_maxdeltalambda);
+			}
+
+			#pragma omp critical
+			{
+				maxviolation   = ChMax(maxviolation,   t_maxviolation);
+				maxdeltalambda = ChMax(maxdeltalambda, t_maxdeltalambda);
+			}
+		}
+ 
+		// For recording into violaiton history, if debugging
+		if (this->record_violation_history)
+			AtIterationEnd(maxviolation, maxdeltalambda, iter);
+
+		tot_iterations++;
+		// Terminate the loop if violation in constraints has been succesfully limited.
+		if (maxviolation < tolerance)
+			break;
+
+	} // end iteration loop
+
+
+	return maxviolation;
+
+}
+
+
+
+
+} // END_OF_NAMESPACE____
+
+
@@ -0,0 +1,119 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be 
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHLCPITERATIVESORCOLORED_H
+#define CHLCPITERATIVESORCOLORED_H
+
+//////////////////////////////////////////////////
+//
+//   ChLcpIterativeSORcolored.h
+//
+//  An iterative VI solver based on projective
+//  fixed point method, with overrelaxation
+//  and immediate variable update as in SOR methods,
+//  where constraints are processed in parallel
+//  color by color (graph-colored Gauss-Seidel).
+//
+//   HEADER file for CHRONO HYPEROCTANT LCP solver
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+
+#include "ChLcpIterativeSolver.h"
+
+
+namespace chrono
+{
+
+
+/// An iterative LCP solver based on projective
+/// fixed point method, with overrelaxation
+/// and immediate variable update as in SOR methods,
+/// that runs in parallel on multicore processors.
+/// The constraint graph (two constraints are adjacent if
+/// they share an active ChLcpVariables) is colored by the
+/// ChLcpSystemDescriptor, then all the constraints of one 
+/// color are processed concurrently with OpenMP, one color
+/// after the other. Since constraints of the same color never
+/// touch the same variables, there are no race conditions, and 
+/// the method is equivalent to a serial SOR with a different 
+/// ordering of constraints, so it has the same convergence properties.
+/// N,U,V friction triplets are kept together, as in ChLcpIterativeSOR.
+/// The number of threads is the one of the ChLcpSystemDescriptor.
+/// The problem is described by a variational inequality VI(Z*x-d,K):
+///
+///  | M -Cq'|*|q|- | f|= |0| , l \in Y, C \in Ny, normal cone to Y  
+///  | Cq -E | |l|  |-b|  |c|    
+///
+/// Also Z symmetric by flipping sign of l_i: |M  Cq'|*| q|-| f|=|0|  
+///                                           |Cq  E | |-l| |-b| |c|
+/// * case linear problem:  all Y_i = R, Ny=0, ex. all bilaterals
+/// * case LCP: all Y_i = R+:  c>=0, l>=0, l*c=0
+/// * case CCP: Y_i are friction cones
+
+class ChApi ChLcpIterativeSORcolored : public ChLcpIterativeSolver
+{
+protected:
+			//
+			// DATA
+			//
+
+
+public:
+			//
+			// CONSTRUCTORS
+			//
+
+	ChLcpIterativeSORcolored(
+				int mmax_iters=50,      ///< max.number of iterations
+				bool mwarm_start=false,	///< uses warm start?
+				double mtolerance=0.0,  ///< tolerance for termination criterion
+				double momega=1.0       ///< overrelaxation criterion
+				)  
+			: ChLcpIterativeSolver(mmax_iters,mwarm_start, mtolerance,momega)
+			{};
+				
+	virtual ~ChLcpIterativeSORcolored() {};
+
+			//
+			// FUNCTIONS
+			//
+
+				/// Performs the solution of the LCP.
+				/// \return  the maximum constraint violation after termination.
+
+	virtual double Solve(
+				ChLcpSystemDescriptor& sysd		///< system description with constraints and variables	
+				);
+
+protected:
+				/// Performs the SOR update of a single constraint (or of a N,U,V
+				/// friction triplet if ic is the normal component), updating the
+				/// max violation and max delta lambda found so far.
+	void SolveItem(std::vector<ChLcpConstraint*>& mconstraints, 
+				   int ic, 
+				   double& maxviolation, 
+				   double& maxdeltalambda);
+
+};
+
+
+
+} // END_OF_NAMESPACE____
+
+
+
+
+#endif  // END of ChLcpIterativeSORcolored.h
@@ -156,6 +156,20 @@ public:
 				/// Note that you must set SetRecordViolation(true) to use it.
 	std::vector<double>& GetDeltalambdaHistory() {return dlambda_history;};
 
+				/// Copy the settings (not the results) of another solver, ex. to
+				/// solve the islands of a system with the settings of its solver.
+				/// Children classes copy also their own settings, if the source
+				/// has their type.
+	virtual void CopySettings(ChLcpIterativeSolver* source)
+			{
+				max_iterations = source->max_iterations;
+				warm_start = source->warm_start;
+				tolerance = source->tolerance;
+				omega = source->omega;
+				shlambda = source->shlambda;
+				record_violation_history = source->record_violation_history;
+			}
+
 
 protected:
 				// This method MUST be called by all iterative
@@ -90,6 +90,7 @@ double ChLcpIterativeSymmSOR::Solve(
 
 	// 4)  Perform the iteration loops
 	//
+	tot_iterations = 0;
 	for (int iter = 0; iter < max_iterations; )
 	{
 		//
@@ -208,6 +209,7 @@ double ChLcpIterativeSymmSOR::Solve(
 		// Increment iter count (each sweep, either forward or backward, is considered
 		// as a complete iteration, to be fair when comparing to the non-symmetric SOR :)
 		iter++;
+		tot_iterations++;
 
 
 		//
@@ -316,6 +318,8 @@ double ChLcpIterativeSymmSOR::Solve(
 		if (this->record_violation_history)
 			AtIterationEnd(maxviolation, maxdeltalambda, iter);
 
+		tot_iterations++;
+
 		// Terminate the loop if violation in constraints has been succesfully limited.
 		if (maxviolation < tolerance)
 			break;	
@@ -134,7 +134,7 @@ void ChLcpKstiffnessGeneric::DiagonalAdd(ChMatrix<double>& result)
 }
 
 
-void ChLcpKstiffnessGeneric::Build_K(ChSparseMatrix& storage, bool add)
+void ChLcpKstiffnessGeneric::Build_K(ChSparseMatrixBase& storage, bool add)
 {
 	if (!K) 
 		return;
@@ -61,6 +61,11 @@ class ChUnilateralData;
 ///
 ///   as arising in the solution of QP with
 ///   inequalities or in multibody problems.
+///    The matrix is a ChSparseMatrix, not a ChCSRMatrix:
+///   the pivoting swaps and updates rows and columns in
+///   place, that compressed rows do not support. For large
+///   problems with bilateral constraints only, use
+///   ChLcpSparseDirectSolver.
 
 
 class ChApi ChLcpSimplexSolver : public ChLcpDirectSolver
@@ -23,6 +23,7 @@
   
    
 #include "ChLcpSolverDEM.h"
+#include "parallel/ChOpenMP.h"
 
 
 namespace chrono
@@ -35,18 +36,22 @@ double ChLcpSolverDEM::Solve(
 	std::vector<ChLcpConstraint*>& mconstraints = sysd.GetConstraintsList();
 	std::vector<ChLcpVariables*>&  mvariables	= sysd.GetVariablesList();
 
+	int nthreads = sysd.GetNumThreads();
+
 	double maxviolation = 0.;
 	double maxdeltalambda = 0.;
 
 	// 1)  Update auxiliary data in all constraints before starting,
 	//     that is: g_i=[Cq_i]*[invM_i]*[Cq_i]' and  [Eq_i]=[invM_i]*[Cq_i]'
-	for (unsigned int ic = 0; ic< mconstraints.size(); ic++)
+	#pragma omp parallel for num_threads(nthreads)
+	for (int ic = 0; ic< (int)mconstraints.size(); ic++)
 		mconstraints[ic]->Update_auxiliary();
 
 	// 2)  Compute, for all items with variables, the initial guess for
-	//     still unconstrained system:
-
-	for (unsigned int iv = 0; iv< mvariables.size(); iv++)
+	//     still unconstrained system (in DEM this is the explicit update of the
+	//     speeds of the bodies, from the contact forces: each variable is independent)
+	#pragma omp parallel for num_threads(nthreads)
+	for (int iv = 0; iv< (int)mvariables.size(); iv++)
 	{
 		if (mvariables[iv]->IsActive())
 		{
@@ -0,0 +1,155 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be 
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChLcpSparseDirectSolver.cpp
+//
+//    file for CHRONO HYPEROCTANT LCP solver
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "ChLcpSparseDirectSolver.h"
+#include "core/ChLog.h"
+ 
+ 
+namespace chrono 
+{
+
+ChLcpSparseDirectSolver::ChLcpSparseDirectSolver()
+{
+	max_refinement_steps = 2;
+	n_analyze = 0;
+	n_factorize = 0;
+	n_failed = 0;
+}
+ 
+
+double ChLcpSparseDirectSolver::Solve(
+					ChLcpSystemDescriptor& sysd		///< system description with constraints and variables	
+					)
+{
+	std::vector<ChLcpConstraint*>& mconstraints = sysd.GetConstraintsList();
+	std::vector<ChLcpVariables*>&  mvariables	= sysd.GetVariablesList();
+	std::vector<ChLcpKstiffness*>& mstiffness	= sysd.GetKstiffnessList();
+
+	// --
+	// Count active variables and constraints, and set offsets
+
+	int n_q = sysd.CountActiveVariables();
+	int n_c = sysd.CountActiveConstraints();
+	int n = n_q + n_c;
+
+	if (n_q==0) return 0;
+
+	// --
+	// Fill the Z matrix (if the size is the same, the old pattern is
+	// kept and most elements are just overwritten in place):
+	//  | M+K  Cq'|
+	//  | Cq    E |
+
+	Z.ResetBlocks(n,n);
+
+	blocks.clear();
+	signs.resize(n);
+
+	for (unsigned int iv = 0; iv< mvariables.size(); iv++)
+	{
+		if (mvariables[iv]->IsActive())
+		{
+			int off = mvariables[iv]->GetOffset();
+			mvariables[iv]->Build_M(Z, off, off);
+			blocks.push_back(off);
+			for (int i = 0; i < mvariables[iv]->Get_ndof(); i++)
+				signs[off+i] = 1;
+		}
+	}
+
+	for (unsigned int ik = 0; ik< mstiffness.size(); ik++)
+	{
+		mstiffness[ik]->Build_K(Z, true);
+	}
+
+	for (unsigned int ic = 0; ic< mconstraints.size(); ic++)
+	{
+		if (mconstraints[ic]->IsActive())
+		{
+			int row = n_q + mconstraints[ic]->GetOffset();
+			mconstraints[ic]->Build_Cq (Z, row);
+			mconstraints[ic]->Build_CqT(Z, row);
+			Z.SetElement(row, row, - mconstraints[ic]->Get_cfm_i()); // always stored, also if zero, for a stable pattern
+			blocks.push_back(row);
+			signs[row] = -1;
+		}
+	}
+	blocks.push_back(n);
+
+	Z.Compress();
+
+	// --
+	// Factorize: the symbolic analysis only if the pattern changed
+
+	if (!LDL.HasSamePattern(Z))
+	{
+		LDL.Analyze(Z, &blocks, &signs);
+		n_analyze++;
+	}
+
+	n_factorize++;
+	bool factorized = LDL.Factorize(Z);
+	if (!factorized)
+	{
+		// some large pivots have the wrong sign (ex. the stiffness matrix is
+		// not positive definite): without pivoting, the factorization may be
+		// inaccurate, so always refine
+		n_failed++;
+		if (verbose)
+			GetLog() << "ChLcpSparseDirectSolver: " << LDL.GetNwrongSign() << " pivots with the wrong sign, the matrix is not a saddle point matrix\n";
+	}
+
+	// --
+	// Solve, and refine if needed (regularized pivots can give a
+	// less accurate solution)
+
+	sysd.BuildDiVector(d);
+
+	LDL.Solve(d, x);
+
+	double dnorm = d.NormInf();
+	double maxres = 0;
+	for (int iter = 0; ; iter++)
+	{
+		Z.MatrMultiply(x, res);
+		res.MatrSub(d, res);	// res = d - Z*x
+		maxres = res.NormInf();
+		int max_steps = factorized ? max_refinement_steps : ChMax(max_refinement_steps, 10);
+		if (iter >= max_steps || maxres <= 1e-12 * dnorm)
+			break;
+		LDL.Solve(res, dx);
+		x.MatrInc(dx);
+	}
+
+	// --
+	// Update results into variables and constraints 
+	// (the sign of multipliers is flipped back)
+
+	sysd.FromVectorToUnknowns(x);
+
+	return maxres;
+}
+
+
+
+} // END_OF_NAMESPACE____
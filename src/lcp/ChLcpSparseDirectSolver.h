@@ -0,0 +1,133 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be 
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHLCPSPARSEDIRECTSOLVER_H
+#define CHLCPSPARSEDIRECTSOLVER_H
+
+//////////////////////////////////////////////////
+//
+//   ChLcpSparseDirectSolver.h
+//
+//    A direct solver for the linear problems
+//   with bilateral constraints and stiffness
+//   matrices, based on a sparse LDL' factorization.
+//
+//   HEADER file for CHRONO HYPEROCTANT LCP solver
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "ChLcpDirectSolver.h"
+#include "core/ChCSRMatrix.h"
+#include "core/ChSparseLDL.h"
+
+
+namespace chrono
+{
+
+///    A direct solver for the linear systems that arise
+///   when all constraints are bilateral, also with
+///   ChLcpKstiffness blocks (ex. FEM problems), where
+///   iterative solvers converge slowly because of the
+///   bad conditioning of the stiffness matrices.
+///    The symmetric saddle point matrix
+///
+///    | M+K  Cq'|*| q|- | f|= |0|
+///    | Cq    E | |-l|  |-b|  |0|
+///
+///   is assembled in compressed row storage and
+///   factorized with ChSparseLDL, with a minimum degree
+///   ordering where each block of variables is a node.
+///   The symbolic analysis is repeated only when the
+///   pattern of the matrix changes (ex. constraints added
+///   or removed), otherwise only the numeric factorization
+///   is done at each solve.
+///    Redundant constraints are handled by regularizing
+///   their pivots (see GetNfailed() for matrices that are
+///   not saddle point ones). Unilateral constraints and friction
+///   are NOT handled: they are treated as bilateral.
+
+class ChApi ChLcpSparseDirectSolver : public ChLcpDirectSolver
+{
+protected:
+			//
+			// DATA
+			//
+
+	ChCSRMatrix Z;		// the system matrix, with stable pattern
+	ChSparseLDL LDL;	// the factorization of Z
+	ChMatrixDynamic<> d;		// the known vector
+	ChMatrixDynamic<> x;		// the unknowns
+	ChMatrixDynamic<> res;	// residual, for iterative refinement
+	ChMatrixDynamic<> dx;
+	std::vector<int> blocks;
+	std::vector<int> signs;
+
+	int max_refinement_steps;
+	int n_analyze;
+	int n_factorize;
+	int n_failed;
+
+public:
+			//
+			// CONSTRUCTORS
+			//
+
+	ChLcpSparseDirectSolver();
+				
+	virtual ~ChLcpSparseDirectSolver() {};
+
+
+			//
+			// FUNCTIONS
+			//
+
+				/// Performs the solution of the problem, by factorization
+				/// of the system matrix.
+				/// \return  the max residual of the linear system after solution.
+
+	virtual double Solve(
+				ChLcpSystemDescriptor& sysd		///< system description with constraints and variables	
+				);
+
+				/// Set the max number of steps of iterative refinement of the
+				/// solution, that are done only if the residual is not small
+				/// (ex. because of regularized pivots). Default 2.
+	void SetMaxRefinementSteps(int mst) {max_refinement_steps = mst;}
+	int  GetMaxRefinementSteps() {return max_refinement_steps;}
+
+				/// Number of symbolic analyses done so far (a new one is
+				/// needed only when the pattern of the system matrix changes).
+	int GetNanalyze() {return n_analyze;}
+				/// Number of numeric factorizations done so far.
+	int GetNfactorize() {return n_factorize;}
+				/// Number of factorizations that failed so far, because the
+				/// matrix had large pivots with the wrong sign (ex. M+K not
+				/// positive definite). The solution is still computed, with
+				/// at least 10 steps of iterative refinement: check the residual
+				/// returned by Solve(). With SetVerbose(true), a warning is logged.
+	int GetNfailed() {return n_failed;}
+
+				/// Access the factorization, for statistics.
+	ChSparseLDL& GetFactorization() {return LDL;}
+};
+
+
+
+} // END_OF_NAMESPACE____
+
+
+
+
+#endif  // END of ChLcpSparseDirectSolver.h
@@ -27,6 +27,8 @@
 #include "ChLcpConstraintTwoFrictionT.h"
 #include "ChLcpConstraintTwoRollingN.h"
 #include "ChLcpConstraintTwoRollingT.h"
+#include "ChLcpConstraintThree.h"
+#include <typeinfo>
 
  
 namespace chrono 
@@ -43,6 +45,15 @@ ChLcpSystemDescriptor::ChLcpSystemDescriptor()
 	n_q=0;
 	n_c=0;
 	freeze_count = false;
+	coloring_valid = false;
+
+	static_valid = false;
+	static_nvariables = 0;
+	static_nconstraints = 0;
+	static_nstiffness = 0;
+	static_ncontactblocks = 0;
+
+	n_islands = 0;
 
 	this->num_threads = CHOMPfunctions::GetNumProcs();
 
@@ -55,6 +66,11 @@ ChLcpSystemDescriptor::~ChLcpSystemDescriptor()
 	vconstraints.clear();
 	vvariables.clear();
 	vstiffness.clear();
+	constraint_colors.clear();
+
+	for (unsigned int i = 0; i < islands.size(); i++)
+		delete islands[i];
+	islands.clear();
 
 	if (spinlocktable)
 		delete[] spinlocktable;
@@ -135,20 +151,296 @@ int ChLcpSystemDescriptor::CountActiveConstraints()
 }
 
 
+void ChLcpSystemDescriptor::SetStaticMark()
+{
+	static_nvariables = (int)vvariables.size();
+	static_nconstraints = (int)vconstraints.size();
+	static_nstiffness = (int)vstiffness.size();
+	static_ncontactblocks = (int)vcontactblocks.size();
+	static_valid = true;
+}
+
+
+bool ChLcpSystemDescriptor::BeginIncrementalInsertion()
+{
+	if (!static_valid)
+	{
+		BeginInsertion();
+		return false;
+	}
+
+	// remove only the items after the mark (this never reallocates)
+	vvariables.resize(static_nvariables);
+	vconstraints.resize(static_nconstraints);
+	vstiffness.resize(static_nstiffness);
+	vcontactblocks.resize(static_ncontactblocks);
+	coloring_valid = false;
+	return true;
+}
+
+
 void ChLcpSystemDescriptor::UpdateCountsAndOffsets()
 {
 	freeze_count = false;
 	CountActiveVariables();
 	CountActiveConstraints();
 	freeze_count = true;
+	coloring_valid = false;
+}
+
+
+// Cache of the kind of the last constraint type seen by ChLcpGetConstraintVariables().
+struct ChLcpConstraintKindCache
+{
+	ChLcpConstraintKindCache() : type(0), n_vars(-1) {}
+	const std::type_info* type;
+	int n_vars;
+};
+
+// Get the variables of a constraint inherited from ChLcpConstraintTwo or
+// ChLcpConstraintThree, and return their number, or -1 for other constraints.
+// The dynamic_cast is done only when the type changes from the previous
+// call, since constraints of the same type are usually contiguous (ex. contacts).
+static int ChLcpGetConstraintVariables(ChLcpConstraint* mconstr, ChLcpVariables** mvars, ChLcpConstraintKindCache& mcache)
+{
+	const std::type_info& mtype = typeid(*mconstr);
+	if (!mcache.type || *mcache.type != mtype)
+	{
+		mcache.type = &mtype;
+		if (dynamic_cast<ChLcpConstraintTwo*>(mconstr))
+			mcache.n_vars = 2;
+		else if (dynamic_cast<ChLcpConstraintThree*>(mconstr))
+			mcache.n_vars = 3;
+		else
+			mcache.n_vars = -1;
+	}
+	if (mcache.n_vars == 2)
+	{
+		ChLcpConstraintTwo* mtwo = static_cast<ChLcpConstraintTwo*>(mconstr);
+		mvars[0] = mtwo->GetVariables_a();
+		mvars[1] = mtwo->GetVariables_b();
+	}
+	else if (mcache.n_vars == 3)
+	{
+		ChLcpConstraintThree* mthree = static_cast<ChLcpConstraintThree*>(mconstr);
+		mvars[0] = mthree->GetVariables_a();
+		mvars[1] = mthree->GetVariables_b();
+		mvars[2] = mthree->GetVariables_c();
+	}
+	return mcache.n_vars;
+}
+
+
+void ChLcpSystemDescriptor::ComputeConstraintColoring()
+{
+	constraint_colors.clear();
+
+	// Map the offsets of active variables into a compact index, 
+	// to be used as node id in the constraint graph.
+	n_q = CountActiveVariables();
+	std::vector<int> var_slot(n_q, -1);
+	int n_slots = 0;
+	for (unsigned int iv = 0; iv< vvariables.size(); iv++)
+	{
+		if (vvariables[iv]->IsActive())
+		{
+			var_slot[vvariables[iv]->GetOffset()] = n_slots;
+			n_slots++;
+		}
+	}
+
+	std::vector< std::vector<int> > var_colors(n_slots); // colors already used around each variable
+	std::vector<int> color_stamp;	// color_stamp[c]==n_item means that color c is forbidden for item n_item
+	std::vector<int> uncolored;		// items with unknown variables
+	int n_item = 0;
+	int i_friction_comp = 0;
+	ChLcpConstraintKindCache kind_cache;
+
+	for (unsigned int ic = 0; ic< vconstraints.size(); ic++)
+	{
+		if (!vconstraints[ic]->IsActive())
+			continue;
+
+		// N,U,V friction triplets are colored as a whole, when the last component is reached
+		int item_start = ic;
+		if (vconstraints[ic]->GetMode() == CONSTRAINT_FRIC)
+		{
+			i_friction_comp++;
+			if (i_friction_comp < 3)
+				continue;
+			i_friction_comp = 0;
+			item_start = ic-2;
+		}
+
+		ChLcpVariables* mvars[3];
+		int n_vars = ChLcpGetConstraintVariables(vconstraints[ic], mvars, kind_cache);
+		if (n_vars < 0)
+		{
+			uncolored.push_back(item_start);
+			continue;
+		}
+
+		// Only active variables are written by Increment_q(), so only those make edges
+		int slots[3];
+		int n_used = 0;
+		for (int iv = 0; iv < n_vars; iv++)
+			if (mvars[iv] && mvars[iv]->IsActive())
+				slots[n_used++] = var_slot[mvars[iv]->GetOffset()];
+
+		// Greedy first-fit: pick the lowest color not used by the neighbours
+		for (int is = 0; is < n_used; is++)
+			for (unsigned int k = 0; k < var_colors[slots[is]].size(); k++)
+				color_stamp[var_colors[slots[is]][k]] = n_item;
+
+		unsigned int mcolor = 0;
+		while ((mcolor < color_stamp.size()) && (color_stamp[mcolor] == n_item))
+			mcolor++;
+
+		if (mcolor == constraint_colors.size())
+		{
+			constraint_colors.push_back(std::vector<int>());
+			color_stamp.push_back(-1);
+		}
+
+		constraint_colors[mcolor].push_back(item_start);
+		for (int is = 0; is < n_used; is++)
+			var_colors[slots[is]].push_back(mcolor);
+
+		n_item++;
+	}
+
+	for (unsigned int iu = 0; iu < uncolored.size(); iu++)
+	{
+		constraint_colors.push_back(std::vector<int>());
+		constraint_colors.back().push_back(uncolored[iu]);
+	}
+
+	coloring_valid = true;
+}
+
+
+static int ChLcpIslandFind(std::vector<int>& parent, int i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];	// path halving
+		i = parent[i];
+	}
+	return i;
+}
+
+
+int ChLcpSystemDescriptor::SplitIntoIslands()
+{
+	n_islands = 0;
+
+	if (!vstiffness.empty() || !vcontactblocks.empty())
+		return 0;
+
+	// Map the offsets of active variables into a compact index,
+	// as in ComputeConstraintColoring().
+	UpdateCountsAndOffsets();
+	std::vector<int> var_slot(n_q, -1);
+	int n_slots = 0;
+	for (unsigned int iv = 0; iv< vvariables.size(); iv++)
+	{
+		if (vvariables[iv]->IsActive())
+		{
+			var_slot[vvariables[iv]->GetOffset()] = n_slots;
+			n_slots++;
+		}
+	}
+
+	// Union-find of the variables coupled by active constraints. The
+	// first active variable of each constraint is stored, for the
+	// assignment of the constraint to its island later.
+	std::vector<int> parent(n_slots);
+	for (int is = 0; is < n_slots; is++)
+		parent[is] = is;
+	std::vector<int> constr_slot(vconstraints.size(), -1);
+	ChLcpConstraintKindCache kind_cache;
+
+	for (unsigned int ic = 0; ic< vconstraints.size(); ic++)
+	{
+		ChLcpVariables* mvars[3];
+		int n_vars = ChLcpGetConstraintVariables(vconstraints[ic], mvars, kind_cache);
+		if (n_vars < 0)
+			return 0;
+
+		int root = -1;
+		for (int iv = 0; iv < n_vars; iv++)
+		{
+			if (!(mvars[iv] && mvars[iv]->IsActive()))
+				continue;
+			int mslot = var_slot[mvars[iv]->GetOffset()];
+			if (root == -1)
+			{
+				constr_slot[ic] = mslot;
+				root = ChLcpIslandFind(parent, mslot);
+			}
+			else if (vconstraints[ic]->IsActive())
+			{
+				int mroot = ChLcpIslandFind(parent, mslot);
+				if (mroot != root)
+				{
+					// the smaller index becomes the root
+					if (mroot < root) 
+						{int tmp = root; root = mroot; mroot = tmp;}
+					parent[mroot] = root;
+				}
+			}
+		}
+	}
+
+	// Number the islands in the order of their first variable
+
+	std::vector<int> slot_island(n_slots, -1);
+	for (int is = 0; is < n_slots; is++)
+	{
+		int root = ChLcpIslandFind(parent, is);
+		if (root == is)
+			slot_island[is] = n_islands++;
+		else
+			slot_island[is] = slot_island[root];	// root < is, already numbered
+	}
+	if (n_islands == 0)
+		n_islands = 1;
+
+	while ((int)islands.size() < n_islands)
+	{
+		islands.push_back(new ChLcpSystemDescriptor);
+		islands.back()->SetNumThreads(1);
+	}
+	for (int i = 0; i < n_islands; i++)
+		islands[i]->BeginInsertion();
+
+	int n_slot = 0;
+	for (unsigned int iv = 0; iv< vvariables.size(); iv++)
+	{
+		if (vvariables[iv]->IsActive())
+		{
+			islands[slot_island[n_slot]]->InsertVariables(vvariables[iv]);
+			n_slot++;
+		}
+	}
+	for (unsigned int ic = 0; ic< vconstraints.size(); ic++)
+	{
+		int mslot = constr_slot[ic];
+		islands[(mslot == -1) ? 0 : slot_island[mslot]]->InsertConstraint(vconstraints[ic]);
+	}
+
+	for (int i = 0; i < n_islands; i++)
+		islands[i]->EndInsertion();
+
+	return n_islands;
 }
 
 
 
 void ChLcpSystemDescriptor::ConvertToMatrixForm (
-								  ChSparseMatrix* Cq, 
-								  ChSparseMatrix* M, 
-								  ChSparseMatrix* E,  
+								  ChSparseMatrixBase* Cq, 
+								  ChSparseMatrixBase* M, 
+								  ChSparseMatrixBase* E,  
 								  ChMatrix<>* Fvector,
 								  ChMatrix<>* Bvector,
 								  ChMatrix<>* Frict,  
@@ -244,8 +536,8 @@ void ChLcpSystemDescriptor::ConvertToMatrixForm (
 
 }
 
-void  ChLcpSystemDescriptor::BuildMatrices (ChSparseMatrix* Cq,
-								ChSparseMatrix* M,	
+void  ChLcpSystemDescriptor::BuildMatrices (ChSparseMatrixBase* Cq,
+								ChSparseMatrixBase* M,	
 								bool only_bilaterals, 
 								bool skip_contacts_uv)
 {
@@ -596,10 +888,40 @@ void ChLcpSystemDescriptor::ShurComplementProduct(
 	//     iterating over all constraints (when implemented in parallel this
 	//     could be non-trivial because race conditions might occur -> reduction buffer etc.)
 	//     Also, begin to add the cfm term ( -[E]*l ) to the result.
+	//     Contacts stored in SoA blocks are processed with the non-virtual
+	//     kernels of the block, all other constraints via virtual calls.
+
+	int nblocks = (int)vcontactblocks.size();
+	int ib = 0;
 
 	//#pragma omp parallel for num_threads(this->num_threads)  ***NOT POSSIBLE!!! concurrent write to same q may happen
 	for (int ic = 0; ic < (int)vconstraints.size(); ic++)
 	{	
+		if (ib < nblocks && ic == vcontactblocks[ib]->GetConstraintStart())
+		{
+			ChLcpContactsSoA* mblock = vcontactblocks[ib];
+			for (int row = 0; row < mblock->GetNconstraints(); row++)
+			{
+				ChLcpConstraintTwoContactSoA& mc = mblock->GetConstraint(row);
+				if (!mc.IsActive())
+					continue;
+				int s_c = mc.GetOffset();
+				if (enabled)
+					if ((*enabled)[s_c]==false)
+						continue;
+				double li;
+				if (lvector)
+					li = (*lvector)(s_c,0);
+				else
+					li = mc.Get_l_i();
+				mblock->Increment_q(row, li);
+				result(s_c,0) = mc.Get_cfm_i() * li;
+			}
+			ic += mblock->GetNconstraints() - 1;
+			ib++;
+			continue;
+		}
+
 		if (vconstraints[ic]->IsActive())
 		{
 			int s_c = vconstraints[ic]->GetOffset();
@@ -623,29 +945,60 @@ void ChLcpSystemDescriptor::ShurComplementProduct(
 
 				// Add constraint force mixing term  result = cfm * l_i = -[E]*l_i
 				result(s_c,0) =  vconstraints[ic]->Get_cfm_i() * li;
-
 			}
 
 		}
 	}
 
 	// 3 - performs    result=[Cq']*qb    by
-	//     iterating over all constraints 
+	//     iterating over all constraints, range by range: generic constraints
+	//     between SoA blocks, then the rows of the following block.
 
-	#pragma omp parallel for num_threads(this->num_threads)
-	for (int ic = 0; ic < (int)vconstraints.size(); ic++)
-	{	
-		if (vconstraints[ic]->IsActive())
+	int ic_start = 0;
+	for (ib = 0; ib <= nblocks; ib++)
+	{
+		int ic_end = (ib < nblocks) ? vcontactblocks[ib]->GetConstraintStart() : (int)vconstraints.size();
+
+		#pragma omp parallel for num_threads(this->num_threads)
+		for (int ic = ic_start; ic < ic_end; ic++)
+		{	
+			if (vconstraints[ic]->IsActive())
+			{
+				bool process=true;
+				if (enabled)
+					if ((*enabled)[vconstraints[ic]->GetOffset()]==false)
+						process = false;
+				
+				if (process) 
+					result(vconstraints[ic]->GetOffset(),0)+= vconstraints[ic]->Compute_Cq_q();	// <----!!!  fpu intensive
+				else
+					result(vconstraints[ic]->GetOffset(),0)= 0; // not enabled constraints, just set to 0 result 
+			}
+		}
+
+		if (ib < nblocks)
 		{
-			bool process=true;
-			if (enabled)
-				if ((*enabled)[vconstraints[ic]->GetOffset()]==false)
-					process = false;
-			
-			if (process) 
-				result(vconstraints[ic]->GetOffset(),0)+= vconstraints[ic]->Compute_Cq_q();	// <----!!!  fpu intensive
-			else
-				result(vconstraints[ic]->GetOffset(),0)= 0; // not enabled constraints, just set to 0 result 
+			// (batch function, processing several contacts at once with SIMD)
+			ChLcpContactsSoA* mblock = vcontactblocks[ib];
+			double* mCq_q = mblock->GetRowBuffer();
+			mblock->Compute_Cq_q_all(mCq_q);
+			for (int row = 0; row < mblock->GetNconstraints(); row++)
+			{
+				ChLcpConstraintTwoContactSoA& mc = mblock->GetConstraint(row);
+				if (mc.IsActive())
+				{
+					int s_c = mc.GetOffset();
+					bool process=true;
+					if (enabled)
+						if ((*enabled)[s_c]==false)
+							process = false;
+					if (process) 
+						result(s_c,0)+= mCq_q[row];
+					else
+						result(s_c,0)= 0;
+				}
+			}
+			ic_start = ic_end + mblock->GetNconstraints();
 		}
 	}
 
@@ -738,11 +1091,34 @@ void ChLcpSystemDescriptor::ConstraintsProject(
 {
 	this->FromVectorToConstraints(multipliers);	
 
-	#pragma omp parallel for num_threads(this->num_threads)
-	for (int ic = 0; ic < (int)vconstraints.size(); ic++)
+	// Generic constraints, range by range between SoA blocks
+	int nblocks = (int)vcontactblocks.size();
+	int ic_start = 0;
+	for (int ib = 0; ib <= nblocks; ib++)
 	{
-		if (vconstraints[ic]->IsActive())
-				vconstraints[ic]->Project();
+		int ic_end = (ib < nblocks) ? vcontactblocks[ib]->GetConstraintStart() : (int)vconstraints.size();
+
+		#pragma omp parallel for num_threads(this->num_threads)
+		for (int ic = ic_start; ic < ic_end; ic++)
+		{
+			if (vconstraints[ic]->IsActive())
+					vconstraints[ic]->Project();
+		}
+
+		if (ib < nblocks)
+			ic_start = ic_end + vcontactblocks[ib]->GetNconstraints();
+	}
+
+	// Contacts in SoA blocks: batch projection (several contacts at once with SIMD)
+	for (int ib = 0; ib < nblocks; ib++)
+	{
+		ChLcpContactsSoA* mblock = vcontactblocks[ib];
+		double* ml = mblock->GetRowBuffer();
+		for (int row = 0; row < mblock->GetNconstraints(); row++)
+			ml[row] = mblock->GetConstraint(row).Get_l_i();
+		mblock->Project_all(ml);
+		for (int row = 0; row < mblock->GetNconstraints(); row++)
+			mblock->GetConstraint(row).Set_l_i(ml[row]);
 	}
 
 	this->FromConstraintsToVector(multipliers,false);		
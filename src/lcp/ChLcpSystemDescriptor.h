@@ -32,6 +32,8 @@
 #include "lcp/ChLcpVariables.h"
 #include "lcp/ChLcpConstraint.h"
 #include "lcp/ChLcpKstiffness.h"
+#include "lcp/ChLcpContactsSoA.h"
+#include "core/ChCSRMatrix.h"
 #include <vector>
 #include "parallel/ChOpenMP.h"
 #include "parallel/ChThreadsSync.h"
@@ -77,16 +79,30 @@ protected:
 		std::vector<ChLcpConstraint*> vconstraints;
 		std::vector<ChLcpVariables*>  vvariables;
 		std::vector<ChLcpKstiffness*>  vstiffness;
+		std::vector<ChLcpContactsSoA*> vcontactblocks;
 		
 		int num_threads;
 
 		ChSpinlock* spinlocktable;
 
+		std::vector< std::vector<int> > constraint_colors;
+		bool coloring_valid;
+
+		std::vector<ChLcpSystemDescriptor*> islands; // pool of sub-descriptors, see SplitIntoIslands()
+		int n_islands;
+
 private:
 		int n_q; // n.active variables
 		int n_c; // n.active constraints
 		bool freeze_count; // for optimizartions
 
+				// static part of the lists, see SetStaticMark()
+		bool static_valid;
+		int static_nvariables;
+		int static_nconstraints;
+		int static_nstiffness;
+		int static_ncontactblocks;
+
 public:
 
 			//
@@ -111,6 +127,12 @@ public:
 		/// Access the vector of stiffness matrix blocks
 	std::vector<ChLcpKstiffness*>& GetKstiffnessList() {return vstiffness;};
 
+		/// Access the vector of SoA contact blocks. Their proxy constraints
+		/// are also in the list of constraints, in a contiguous range
+		/// starting at ChLcpContactsSoA::GetConstraintStart(); blocks are
+		/// sorted by increasing start index.
+	std::vector<ChLcpContactsSoA*>& GetContactBlocksList() {return vcontactblocks;};
+
 
 		/// Begin insertion of items
 	virtual void BeginInsertion()
@@ -118,8 +140,32 @@ public:
 						vconstraints.clear();
 						vvariables.clear();
 						vstiffness.clear();
+						vcontactblocks.clear();
+						coloring_valid = false;
+						static_valid = false;
 					}
 
+		/// Mark all the items inserted so far (since BeginInsertion()) as the
+		/// 'static' part of the system, that will be kept by the next calls to 
+		/// BeginIncrementalInsertion().
+	virtual void SetStaticMark();
+
+		/// Begin insertion of items, removing only the items inserted after the
+		/// static mark (see SetStaticMark()), so that only those must be inserted 
+		/// again. Counts and offsets are updated for all items at EndInsertion(), 
+		/// since the active state of the kept items might have changed.
+		/// If there is no valid mark, this is the same as BeginInsertion() and
+		/// returns false: in that case all items must be inserted again.
+	virtual bool BeginIncrementalInsertion();
+
+		/// Discard the static mark, for instance because the items of the static 
+		/// part, or their active state, changed. The next BeginIncrementalInsertion()
+		/// will fall back to a full insertion.
+	virtual void InvalidateStaticMark() {static_valid = false;}
+
+		/// Tell if there is a valid static mark.
+	bool HasStaticMark() {return static_valid;}
+
 		/// Insert reference to a ChLcpConstraint object
 	virtual void InsertConstraint(ChLcpConstraint* mc) { vconstraints.push_back(mc); }
 
@@ -129,6 +175,17 @@ public:
 		/// Insert reference to a ChLcpKstiffness object (a piece of K matrix)
 	virtual void InsertKstiffness(ChLcpKstiffness* mk) { vstiffness.push_back(mk); }
 
+		/// Insert reference to a block of contacts stored as structure of arrays.
+		/// This also inserts all its proxy constraints in the list of constraints,
+		/// so the block must be already resized and filled.
+	virtual void InsertContactBlock(ChLcpContactsSoA* mb)
+					{
+						mb->SetConstraintStart((int)vconstraints.size());
+						for (int row = 0; row < mb->GetNconstraints(); row++)
+							vconstraints.push_back(&mb->GetConstraint(row));
+						vcontactblocks.push_back(mb);
+					}
+
 
 		/// End insertion of items
 	virtual void EndInsertion()
@@ -156,6 +213,56 @@ public:
 	virtual void UpdateCountsAndOffsets();
 
 
+				/// Partitions the active constraints into 'colors', i.e. groups of 
+				/// constraints that do not share any active ChLcpVariables, so that all 
+				/// the constraints with the same color can be processed in parallel
+				/// by Gauss-Seidel solvers without concurrent writes to the 'q' vectors.
+				/// Friction constraints (CONSTRAINT_FRIC) are never split: each N,U,V triplet
+				/// is colored as a single item and it is referenced by the index of its 
+				/// first constraint. Constraints whose variables cannot be inferred (not 
+				/// inherited from ChLcpConstraintTwo or ChLcpConstraintThree) get a color each.
+				/// Note: a greedy first-fit strategy is used, so the number of colors 
+				/// is at least the max number of constraints acting on one active variable.
+	virtual void ComputeConstraintColoring();
+
+				/// Calls ComputeConstraintColoring() only if the constraints have been 
+				/// re-inserted (or counts updated) since the last coloring, so that the
+				/// coloring is computed at most once per time step.
+	virtual void UpdateConstraintColoring() 
+					{
+						if (!coloring_valid) 
+							ComputeConstraintColoring();
+					}
+
+				/// Access the groups computed by ComputeConstraintColoring(): for each
+				/// color, the indexes (in GetConstraintsList()) of the single constraints
+				/// or of the first constraint of N,U,V friction triplets.
+	std::vector< std::vector<int> >& GetConstraintColors() {return constraint_colors;}
+
+
+				/// Partitions the system into 'islands', i.e. the connected components
+				/// of the graph whose nodes are the active variables and whose edges are 
+				/// the active constraints, and fills a sub-descriptor for each island, so
+				/// that the islands can be solved independently (also in parallel, since
+				/// they do not share variables). Inactive variables are not inserted; the
+				/// constraints keep their order, and constraints without active variables
+				/// go in the first island. Each sub-descriptor has its own counts and offsets,
+				/// so after the split the offsets of variables and constraints refer to their
+				/// island: call UpdateCountsAndOffsets() on this descriptor to restore them.
+				/// Returns the number of islands, or 0 if the system cannot be split because
+				/// there are ChLcpKstiffness or SoA contact blocks, or constraints whose 
+				/// variables cannot be inferred (not inherited from ChLcpConstraintTwo or 
+				/// ChLcpConstraintThree): in that case the system must be solved as a whole.
+	virtual int SplitIntoIslands();
+
+				/// Number of islands found by the last SplitIntoIslands().
+	int GetNislands() {return n_islands;}
+
+				/// Access the sub-descriptor of the i-th island found by the last 
+				/// SplitIntoIslands(). Islands are numbered by their first variable.
+	ChLcpSystemDescriptor* GetIsland(int i) {return islands[i];}
+
+
 			//
 			// DATA <-> MATH.VECTORS FUNCTIONS
 			//
@@ -370,10 +477,12 @@ public:
 				/// using these matrices, for performance), for example you will load these matrices in Matlab.
 				/// Optionally, tangential (u,v) contact jacobians may be skipped, or only bilaterals can be considered
 				/// The matrices and vectors are automatically resized if needed.
+				/// The matrices can be ChSparseMatrix objects or, for large systems, ChCSRMatrix
+				/// objects, that are assembled faster and are better suited for products with vectors.
 	virtual void ConvertToMatrixForm 
-								 (ChSparseMatrix* Cq, ///< fill this system jacobian matrix, if not null
-								  ChSparseMatrix* M,  ///< fill this system mass matrix, if not null
-								  ChSparseMatrix* E,  ///< fill this system 'compliance' matrix , if not null
+								 (ChSparseMatrixBase* Cq, ///< fill this system jacobian matrix, if not null
+								  ChSparseMatrixBase* M,  ///< fill this system mass matrix, if not null
+								  ChSparseMatrixBase* E,  ///< fill this system 'compliance' matrix , if not null
 								  ChMatrix<>* Fvector,///< fill this vector as the known term 'f', if not null
 								  ChMatrix<>* Bvector,///< fill this vector as the known term 'b', if not null
 								  ChMatrix<>* Frict,  ///< fill as a vector with friction coefficients (=-1 for tangent comp.; =-2 for bilaterals), if not null
@@ -383,8 +492,8 @@ public:
 
 
 				/// OBSOLETE. Kept only for backward compability. Use rather: ConvertToMatrixForm
-	virtual void BuildMatrices (ChSparseMatrix* Cq,
-								ChSparseMatrix* M,
+	virtual void BuildMatrices (ChSparseMatrixBase* Cq,
+								ChSparseMatrixBase* M,
 								bool only_bilaterals = false, 
 								bool skip_contacts_uv = false);
 				/// OBSOLETE. Kept only for backward compability. Use rather: ConvertToMatrixForm, or BuildFbVector or BuildBiVector
@@ -282,7 +282,7 @@ public:
 				/// it in 'storage' sparse matrix, at given column/row offset.
 				/// Note, most iterative solvers don't need to know mass matrix explicitly.
 				/// Optimised: doesn't fill unneeded elements except mass and 3x3 inertia.
-	virtual void Build_M(ChSparseMatrix& storage, int insrow, int inscol)
+	virtual void Build_M(ChSparseMatrixBase& storage, int insrow, int inscol)
 					{
 						storage.SetElement(insrow+0, inscol+0, sharedmass->mass);
 						storage.SetElement(insrow+1, inscol+1, sharedmass->mass);
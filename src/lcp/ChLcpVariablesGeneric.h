@@ -192,7 +192,7 @@ public:
 				/// Build the mass matrix (for these variables) storing
 				/// it in 'storage' sparse matrix, at given column/row offset.
 				/// Note, most iterative solvers don't need to know mass matrix explicitly.
-	virtual void Build_M(ChSparseMatrix& storage, int insrow, int inscol)
+	virtual void Build_M(ChSparseMatrixBase& storage, int insrow, int inscol)
 					{
 						storage.PasteMatrix(Mmass, insrow, inscol);
 					};
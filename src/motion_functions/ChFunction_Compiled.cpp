@@ -0,0 +1,573 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChFunction_Compiled.cpp
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "ChFunction_Compiled.h"
+#include "ChFunction_Ramp.h"
+#include "ChFunction_Sine.h"
+#include "ChFunction_Poly.h"
+#include "ChFunction_Operation.h"
+#include "ChFunction_Mirror.h"
+#include "ChFunction_Repeat.h"
+#include "ChFunction_Sequence.h"
+
+
+namespace chrono
+{
+
+
+// Register into the object factory, to enable run-time
+// dynamic creation and persistence
+ChClassRegister<ChFunction_Compiled> a_registration_compiled;
+
+
+// Instructions of the program. Leaves (CONST..LEAF) push their value at the
+// current argument; operators pop their operands and push the result;
+// FUNCT, MIRROR, REPEAT and SEQUENCE execute the following block of
+// instructions with a new argument.
+
+enum {
+	ChFC_CONST = 0,
+	ChFC_RAMP,
+	ChFC_SINE,
+	ChFC_POLY,
+	ChFC_LEAF,
+	ChFC_ADD,
+	ChFC_SUB,
+	ChFC_MUL,
+	ChFC_DIV,
+	ChFC_POW,
+	ChFC_MAX,
+	ChFC_MIN,
+	ChFC_MODULO,
+	ChFC_FABS,
+	ChFC_FUNCT,
+	ChFC_MIRROR,
+	ChFC_REPEAT,
+	ChFC_SEQUENCE
+};
+
+
+void ChFunction_Compiled::Copy (ChFunction_Compiled* source)
+{
+	if (fa) delete fa;
+	fa = source->fa->new_Duplicate();
+	Compile();
+}
+
+ChFunction* ChFunction_Compiled::new_Duplicate ()
+{
+	ChFunction_Compiled* m_func;
+	m_func = new ChFunction_Compiled;
+	m_func->Copy(this);
+	return (m_func);
+}
+
+
+void ChFunction_Compiled::Compile()
+{
+	program.clear();
+	constants.clear();
+	segments.clear();
+	nleaves = 0;
+
+	if (fa)
+		Emit(fa);
+
+	// each instruction is executed at most once per evaluation
+	stack.resize(program.size() + 1);
+}
+
+
+void ChFunction_Compiled::Emit(ChFunction* mfx)
+{
+	int pc = (int)program.size();
+
+	Instruction instr;
+	instr.op = ChFC_LEAF;
+	instr.next = 0;			// set after the block, for FUNCT, MIRROR, REPEAT, SEQUENCE
+	instr.index = (int)constants.size();
+	instr.count = 0;
+	instr.fx = 0;
+
+	// Only the exact classes are inlined, since inherited
+	// classes might override Get_y() etc.
+
+	if (ChIsExactlyClass(ChFunction_Const, mfx))
+	{
+		instr.op = ChFC_CONST;
+		constants.push_back(((ChFunction_Const*)mfx)->Get_yconst());
+		program.push_back(instr);
+	}
+	else if (ChIsExactlyClass(ChFunction_Ramp, mfx))
+	{
+		instr.op = ChFC_RAMP;
+		constants.push_back(((ChFunction_Ramp*)mfx)->Get_y0());
+		constants.push_back(((ChFunction_Ramp*)mfx)->Get_ang());
+		program.push_back(instr);
+	}
+	else if (ChIsExactlyClass(ChFunction_Sine, mfx))
+	{
+		instr.op = ChFC_SINE;
+		constants.push_back(((ChFunction_Sine*)mfx)->Get_amp());
+		constants.push_back(((ChFunction_Sine*)mfx)->Get_phase());
+		constants.push_back(((ChFunction_Sine*)mfx)->Get_w());
+		program.push_back(instr);
+	}
+	else if (ChIsExactlyClass(ChFunction_Poly, mfx))
+	{
+		ChFunction_Poly* mpoly = (ChFunction_Poly*)mfx;
+		instr.op = ChFC_POLY;
+		instr.count = mpoly->Get_order() + 1;
+		for (int i = 0; i < instr.count; i++)
+			constants.push_back(mpoly->Get_coeff(i));
+		program.push_back(instr);
+	}
+	else if (ChIsExactlyClass(ChFunction_Operation, mfx))
+	{
+		ChFunction_Operation* mop = (ChFunction_Operation*)mfx;
+		switch (mop->Get_optype())
+		{
+		case ChOP_ADD:		instr.op = ChFC_ADD;	break;
+		case ChOP_SUB:		instr.op = ChFC_SUB;	break;
+		case ChOP_MUL:		instr.op = ChFC_MUL;	break;
+		case ChOP_DIV:		instr.op = ChFC_DIV;	break;
+		case ChOP_POW:		instr.op = ChFC_POW;	break;
+		case ChOP_MAX:		instr.op = ChFC_MAX;	break;
+		case ChOP_MIN:		instr.op = ChFC_MIN;	break;
+		case ChOP_MODULO:	instr.op = ChFC_MODULO;	break;
+		case ChOP_FABS:		instr.op = ChFC_FABS;	break;
+		case ChOP_FUNCT:	instr.op = ChFC_FUNCT;	break;
+		default:			instr.op = ChFC_CONST;	break;
+		}
+		if (instr.op == ChFC_CONST)
+		{
+			constants.push_back(0);
+			program.push_back(instr);
+		}
+		else if (instr.op == ChFC_FABS)
+		{
+			Emit(mop->Get_fa());
+			program.push_back(instr);
+		}
+		else if (instr.op == ChFC_FUNCT)
+		{
+			// fa(fb(x)): the block of fa is executed with the value of fb as argument
+			Emit(mop->Get_fb());
+			pc = (int)program.size();
+			program.push_back(instr);
+			Emit(mop->Get_fa());
+			program[pc].next = (int)program.size();
+		}
+		else
+		{
+			Emit(mop->Get_fa());
+			Emit(mop->Get_fb());
+			program.push_back(instr);
+		}
+	}
+	else if (ChIsExactlyClass(ChFunction_Mirror, mfx))
+	{
+		instr.op = ChFC_MIRROR;
+		constants.push_back(((ChFunction_Mirror*)mfx)->Get_mirror_axis());
+		program.push_back(instr);
+		Emit(((ChFunction_Mirror*)mfx)->Get_fa());
+		program[pc].next = (int)program.size();
+	}
+	else if (ChIsExactlyClass(ChFunction_Repeat, mfx))
+	{
+		instr.op = ChFC_REPEAT;
+		constants.push_back(((ChFunction_Repeat*)mfx)->Get_window_start());
+		constants.push_back(((ChFunction_Repeat*)mfx)->Get_window_length());
+		program.push_back(instr);
+		Emit(((ChFunction_Repeat*)mfx)->Get_fa());
+		program[pc].next = (int)program.size();
+	}
+	else if (ChIsExactlyClass(ChFunction_Sequence, mfx))
+	{
+		// The blocks of the sub-functions follow the instruction; nested
+		// sequences add their segments after the ones of this sequence.
+		ChList<ChFseqNode>* mlist = ((ChFunction_Sequence*)mfx)->Get_list();
+		ChNode<ChFseqNode>* mnode;
+		instr.op = ChFC_SEQUENCE;
+		instr.index = (int)segments.size();
+		for (mnode = mlist->GetHead(); mnode != NULL; mnode= mnode->next)
+			if (mnode->data->t_end > mnode->data->t_start)
+				instr.count++;
+		segments.resize(instr.index + instr.count);
+		program.push_back(instr);
+
+		int iseg = instr.index;
+		for (mnode = mlist->GetHead(); mnode != NULL; mnode= mnode->next)
+		{
+			if (!(mnode->data->t_end > mnode->data->t_start))
+				continue;	// never active
+			Segment mseg;
+			mseg.t_start = mnode->data->t_start;
+			mseg.t_end	 = mnode->data->t_end;
+			mseg.Iy		 = mnode->data->Iy;
+			mseg.Iydt	 = mnode->data->Iydt;
+			mseg.Iydtdt	 = mnode->data->Iydtdt;
+			mseg.begin	 = (int)program.size();
+			Emit(mnode->data->fx);
+			mseg.end	 = (int)program.size();
+			segments[iseg++] = mseg;
+		}
+		program[pc].next = (int)program.size();
+	}
+	else if (ChIsExactlyClass(ChFunction_Compiled, mfx))
+	{
+		Emit(((ChFunction_Compiled*)mfx)->Get_fa());
+	}
+	else
+	{
+		instr.op = ChFC_LEAF;
+		instr.fx = mfx;
+		program.push_back(instr);
+		nleaves++;
+	}
+}
+
+
+// Value and derivatives of f(u(x)), given f,f',f'' at u and the derivatives of u
+
+void ChFunction_Compiled::Chain(double f, double f_dx, double f_dxdx, const Jet& u, Jet& res)
+{
+	res.y	   = f;
+	res.y_dx   = f_dx * u.y_dx;
+	res.y_dxdx = f_dxdx * u.y_dx * u.y_dx + f_dx * u.y_dxdx;
+}
+
+
+void ChFunction_Compiled::Execute(int begin, int end, const Jet& arg, Jet*& top, int order)
+{
+	int pc = begin;
+	while (pc < end)
+	{
+		const Instruction& instr = program[pc];
+		const double* c = constants.empty() ? 0 : &constants[0] + instr.index;
+
+		switch (instr.op)
+		{
+		case ChFC_CONST:
+			top->y = c[0];
+			top->y_dx = top->y_dxdx = 0;
+			top++;
+			break;
+		case ChFC_RAMP:
+			Chain(c[0] + c[1]*arg.y, c[1], 0, arg, *top++);
+			break;
+		case ChFC_SINE:
+			{
+				double s = sin(c[1] + c[2]*arg.y);
+				double co = (order > 0) ? cos(c[1] + c[2]*arg.y) : 0;
+				Chain(c[0]*s, c[0]*c[2]*co, -c[0]*c[2]*c[2]*s, arg, *top++);
+			}
+			break;
+		case ChFC_POLY:
+			{
+				// Horner scheme, also for the derivatives
+				double p = 0, p_dx = 0, p_dxdx = 0;
+				for (int i = instr.count-1; i >= 0; i--)
+				{
+					p_dxdx = p_dxdx*arg.y + 2*p_dx;
+					p_dx   = p_dx*arg.y + p;
+					p	   = p*arg.y + c[i];
+				}
+				Chain(p, p_dx, p_dxdx, arg, *top++);
+			}
+			break;
+		case ChFC_LEAF:
+			Chain(instr.fx->Get_y(arg.y),
+				  (order > 0) ? instr.fx->Get_y_dx(arg.y) : 0,
+				  (order > 1) ? instr.fx->Get_y_dxdx(arg.y) : 0,
+				  arg, *top++);
+			break;
+		case ChFC_ADD:
+			top--;
+			top[-1].y		+= top->y;
+			top[-1].y_dx	+= top->y_dx;
+			top[-1].y_dxdx	+= top->y_dxdx;
+			break;
+		case ChFC_SUB:
+			top--;
+			top[-1].y		-= top->y;
+			top[-1].y_dx	-= top->y_dx;
+			top[-1].y_dxdx	-= top->y_dxdx;
+			break;
+		case ChFC_MUL:
+			{
+				top--;
+				Jet a = top[-1];
+				Jet& b = *top;
+				top[-1].y	   = a.y * b.y;
+				top[-1].y_dx   = a.y_dx * b.y + a.y * b.y_dx;
+				top[-1].y_dxdx = a.y_dxdx * b.y + 2 * a.y_dx * b.y_dx + a.y * b.y_dxdx;
+			}
+			break;
+		case ChFC_DIV:
+			{
+				top--;
+				Jet a = top[-1];
+				Jet& b = *top;
+				double q	  = a.y / b.y;
+				double q_dx	  = (a.y_dx - q * b.y_dx) / b.y;
+				top[-1].y	   = q;
+				top[-1].y_dx   = q_dx;
+				top[-1].y_dxdx = (a.y_dxdx - 2 * q_dx * b.y_dx - q * b.y_dxdx) / b.y;
+			}
+			break;
+		case ChFC_POW:
+			{
+				top--;
+				Jet a = top[-1];
+				Jet& b = *top;
+				double y = pow(a.y, b.y);
+				top[-1].y = y;
+				top[-1].y_dx = top[-1].y_dxdx = 0;
+				if (order == 0)
+					break;
+				if (b.y_dx == 0 && b.y_dxdx == 0)
+				{
+					// constant exponent: also for a<=0
+					double e = b.y;
+					if (a.y_dx != 0)
+					{
+						top[-1].y_dx   = e * pow(a.y, e-1) * a.y_dx;
+						top[-1].y_dxdx = e * (e-1) * pow(a.y, e-2) * a.y_dx * a.y_dx;
+					}
+					if (a.y_dxdx != 0)
+						top[-1].y_dxdx += e * pow(a.y, e-1) * a.y_dxdx;
+				}
+				else
+				{
+					// a^b = exp(b*log(a))
+					double L	  = log(a.y);
+					double L_dx	  = a.y_dx / a.y;
+					double L_dxdx = (a.y_dxdx * a.y - a.y_dx * a.y_dx) / (a.y * a.y);
+					double g_dx	  = b.y_dx * L + b.y * L_dx;
+					double g_dxdx = b.y_dxdx * L + 2 * b.y_dx * L_dx + b.y * L_dxdx;
+					top[-1].y_dx   = y * g_dx;
+					top[-1].y_dxdx = y * (g_dxdx + g_dx * g_dx);
+				}
+			}
+			break;
+		case ChFC_MAX:
+			top--;
+			if (!(top[-1].y > top->y))
+				top[-1] = *top;
+			break;
+		case ChFC_MIN:
+			top--;
+			if (!(top[-1].y < top->y))
+				top[-1] = *top;
+			break;
+		case ChFC_MODULO:
+			{
+				top--;
+				Jet a = top[-1];
+				Jet& b = *top;
+				double r = fmod(a.y, b.y);
+				double n = (a.y - r) / b.y;		// integer quotient, locally constant
+				top[-1].y	   = r;
+				top[-1].y_dx   = a.y_dx - n * b.y_dx;
+				top[-1].y_dxdx = a.y_dxdx - n * b.y_dxdx;
+			}
+			break;
+		case ChFC_FABS:
+			if (top[-1].y < 0)
+			{
+				top[-1].y	   = -top[-1].y;
+				top[-1].y_dx   = -top[-1].y_dx;
+				top[-1].y_dxdx = -top[-1].y_dxdx;
+			}
+			break;
+		case ChFC_FUNCT:
+			{
+				Jet u = *--top;
+				Execute(pc+1, instr.next, u, top, order);
+			}
+			break;
+		case ChFC_MIRROR:
+			{
+				Jet u = arg;
+				if (arg.y > c[0])
+				{
+					u.y		 = 2*c[0] - arg.y;
+					u.y_dx	 = -arg.y_dx;
+					u.y_dxdx = -arg.y_dxdx;
+				}
+				Execute(pc+1, instr.next, u, top, order);
+			}
+			break;
+		case ChFC_REPEAT:
+			{
+				Jet u = arg;
+				u.y = c[0] + fmod(arg.y, c[1]);
+				Execute(pc+1, instr.next, u, top, order);
+			}
+			break;
+		case ChFC_SEQUENCE:
+			{
+				// as in ChFunction_Sequence, the last segment containing x is used
+				int iseg = instr.index + instr.count - 1;
+				while (iseg >= instr.index &&
+					   !(arg.y >= segments[iseg].t_start && arg.y < segments[iseg].t_end))
+					iseg--;
+				if (iseg < instr.index)
+				{
+					top->y = top->y_dx = top->y_dxdx = 0;
+					top++;
+					break;
+				}
+				const Segment& mseg = segments[iseg];
+				Jet u = arg;
+				u.y -= mseg.t_start;
+				Execute(mseg.begin, mseg.end, u, top, order);
+
+				// continuity offsets, with the derivatives of ChFunction_Sequence
+				Jet off;
+				Chain(mseg.Iy + mseg.Iydt * u.y + 0.5 * mseg.Iydtdt * u.y * u.y,
+					  mseg.Iydt + mseg.Iydtdt * u.y,
+					  mseg.Iydtdt, u, off);
+				top[-1].y	   += off.y;
+				top[-1].y_dx   += off.y_dx;
+				top[-1].y_dxdx += off.y_dxdx;
+			}
+			break;
+		}
+
+		pc = (instr.op >= ChFC_FUNCT) ? instr.next : pc + 1;
+	}
+}
+
+
+void ChFunction_Compiled::Evaluate(double x, int order, Jet& result)
+{
+	Jet arg;
+	arg.y	   = x;
+	arg.y_dx   = 1;
+	arg.y_dxdx = 0;
+	Jet* top = &stack[0];
+	Execute(0, (int)program.size(), arg, top, order);
+	result = stack[0];
+}
+
+double ChFunction_Compiled::Get_y      (double x)
+{
+	Jet res;
+	Evaluate(x, 0, res);
+	return res.y;
+}
+
+double ChFunction_Compiled::Get_y_dx   (double x)
+{
+	Jet res;
+	Evaluate(x, 1, res);
+	return res.y_dx;
+}
+
+double ChFunction_Compiled::Get_y_dxdx (double x)
+{
+	Jet res;
+	Evaluate(x, 2, res);
+	return res.y_dxdx;
+}
+
+void ChFunction_Compiled::Get_y_batch (int n, const double* x, double* y, double* y_dx, double* y_dxdx)
+{
+	int order = y_dxdx ? 2 : (y_dx ? 1 : 0);
+	Jet res;
+	for (int i = 0; i < n; i++)
+	{
+		Evaluate(x[i], order, res);
+		y[i] = res.y;
+		if (y_dx)
+			y_dx[i] = res.y_dx;
+		if (y_dxdx)
+			y_dxdx[i] = res.y_dxdx;
+	}
+}
+
+
+void ChFunction_Compiled::Extimate_x_range (double& xmin, double& xmax)
+{
+	fa->Extimate_x_range(xmin,xmax);
+}
+
+int ChFunction_Compiled::MakeOptVariableTree(ChList<chjs_propdata>* mtree)
+{
+	int i=0;
+
+	// inherit parent behaviour
+	ChFunction::MakeOptVariableTree(mtree);
+
+	// expand tree for children..
+
+	chjs_propdata* mdataA = new chjs_propdata;
+	strcpy(mdataA->propname, "fa");
+	strcpy(mdataA->label,    mdataA->propname);
+	mdataA->haschildren = TRUE;
+	mtree->AddTail(mdataA);
+
+	i += this->fa->MakeOptVariableTree(&mdataA->children);
+
+	return i;
+}
+
+void ChFunction_Compiled::StreamOUT(ChStreamOutBinary& mstream)
+{
+		// class version number
+	mstream.VersionWrite(1);
+		// serialize parent class too
+	ChFunction::StreamOUT(mstream);
+
+		// stream out all member data
+	mstream.AbstractWrite(fa);
+}
+
+void ChFunction_Compiled::StreamIN(ChStreamInBinary& mstream)
+{
+		// class version number
+	int version = mstream.VersionRead();
+		// deserialize parent class too
+	ChFunction::StreamIN(mstream);
+
+		// stream in all member data
+	if (fa) delete fa; fa=NULL;
+	mstream.AbstractReadCreate(&fa);
+	Compile();
+}
+
+void ChFunction_Compiled::StreamOUT(ChStreamOutAscii& mstream)
+{
+	mstream << "FUNCT_COMPILED  \n";
+
+	//***TO DO***
+}
+
+
+
+
+
+} // END_OF_NAMESPACE____
+
+
+// eof
@@ -0,0 +1,150 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHFUNCT_COMPILED_H
+#define CHFUNCT_COMPILED_H
+
+//////////////////////////////////////////////////
+//
+//   ChFunction_Compiled.h
+//
+//   Function objects,
+//   as scalar functions of scalar variable y=f(t)
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <vector>
+#include "ChFunction_Base.h"
+#include "ChFunction_Const.h"
+
+
+namespace chrono
+{
+
+#define FUNCT_COMPILED	21
+
+
+/// COMPILED FUNCTION:
+/// y = fa(x), evaluated by a flat program
+///
+/// Wraps a tree of functions (ex. ChFunction_Operation, ChFunction_Mirror,
+/// ChFunction_Repeat, ChFunction_Sequence with their children) and
+/// flattens it into a compact stack program, that is evaluated
+/// without the nested virtual calls of the tree.
+/// The program computes y together with dy/dx and ddy/dxdx by the
+/// chain and product rules, so derivatives are analytical also for
+/// operations and compositions, instead of the numerical differentiation
+/// of the tree. Const, Ramp, Sine and Poly functions are inlined;
+/// other functions (ex. Sigma, Recorder, or custom classes) are called
+/// as leaves, using their own Get_y(), Get_y_dx() and Get_y_dxdx().
+///
+/// Parameters of the functions are copied into the program: if the
+/// tree is modified after the creation, call Compile() again.
+/// Note: the evaluation uses an internal stack, so the same object
+/// must not be evaluated concurrently by multiple threads.
+
+class ChApi ChFunction_Compiled : public ChFunction
+{
+	CH_RTTI(ChFunction_Compiled, ChFunction);
+private:
+	ChFunction* fa;
+
+	struct Jet
+	{
+		double y, y_dx, y_dxdx;
+	};
+
+	struct Instruction
+	{
+		int op;
+		int next;				// end of the block of nested instructions, if any
+		int index;				// in constants or segments
+		int count;
+		ChFunction* fx;			// function evaluated as a leaf
+	};
+
+	struct Segment				// a sub-function of a ChFunction_Sequence
+	{
+		double t_start, t_end;
+		double Iy, Iydt, Iydtdt;
+		int begin, end;			// block of instructions
+	};
+
+	std::vector<Instruction> program;
+	std::vector<double> constants;
+	std::vector<Segment> segments;
+	std::vector<Jet> stack;
+	int nleaves;
+
+	static void Chain(double f, double f_dx, double f_dxdx, const Jet& u, Jet& res);
+	void Emit(ChFunction* mfx);
+	void Execute(int begin, int end, const Jet& arg, Jet*& top, int order);
+	void Evaluate(double x, int order, Jet& result);
+
+public:
+	ChFunction_Compiled() {fa = new ChFunction_Const; Compile();}
+	ChFunction_Compiled(ChFunction* m_fa) {fa = m_fa; Compile();}
+	~ChFunction_Compiled () {if (fa) delete fa;};
+	void Copy (ChFunction_Compiled* source);
+	ChFunction* new_Duplicate ();
+
+				/// Set the function to be compiled (it will be deleted
+				/// automatically with this object), and compile it.
+	void Set_fa  (ChFunction* m_fa)  {fa = m_fa; Compile();}
+	ChFunction* Get_fa () {return fa;}
+
+				/// Flatten the tree of fa into the program. Must be called
+				/// again if the functions in the tree have been changed.
+	void Compile();
+
+				/// Number of instructions of the program.
+	int GetProgramLength() {return (int)program.size();}
+
+				/// Number of functions of the tree that are not inlined, but
+				/// called as leaves with their Get_y(), Get_y_dx() etc.
+	int GetNleaves() {return nleaves;}
+
+	double Get_y      (double x) ;
+	double Get_y_dx   (double x) ;
+	double Get_y_dxdx (double x) ;
+
+				/// Evaluate the function for 'n' values x[i], storing the results
+				/// in y[i]. If y_dx or y_dxdx arrays are given, also the derivatives
+				/// are computed, in the same pass.
+	void Get_y_batch (int n, const double* x, double* y, double* y_dx = 0, double* y_dxdx = 0);
+
+	double Get_weight (double x) {return fa->Get_weight(x);}
+
+	void Extimate_x_range (double& xmin, double& xmax);
+	int Get_Type () {return (FUNCT_COMPILED);}
+
+	int MakeOptVariableTree(ChList<chjs_propdata>* mtree);
+
+	void StreamOUT(ChStreamOutAscii& mstream);
+	void StreamIN(ChStreamInBinary& mstream);
+	void StreamOUT(ChStreamOutBinary& mstream);
+
+};
+
+
+
+
+} // END_OF_NAMESPACE____
+
+
+#endif
@@ -19,7 +19,11 @@
 ///////////////////////////////////////////////////
 
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
 #include "ChFunction_Recorder.h"
+#include "core/ChException.h"
 
 
 namespace chrono
@@ -31,19 +35,24 @@ namespace chrono
 ChClassRegister<ChFunction_Recorder> a_registration_recorder;
 
 
+static bool ChRecPointLess (const ChRecPoint& a, const ChRecPoint& b)
+{
+	return a.x < b.x;
+}
+
+static bool ChRecPointAbove (double x, const ChRecPoint& p)
+{
+	return x < p.x;
+}
+
+
 void ChFunction_Recorder::Copy (ChFunction_Recorder* source)
 {
-	points.KillAll();
-	lastnode = NULL;
-	ChRecPoint* mpt;
-	for (ChNode<ChRecPoint>* mnode = source->points.GetHead(); mnode != NULL; mnode= mnode->next)
-	{
-		mpt = new ChRecPoint;
-		mpt->x = mnode->data->x;
-		mpt->y = mnode->data->y;
-		mpt->w = mnode->data->w;
-		points.AddTail(mpt);
-	}
+	points = source->points;
+	lastindex = 0;
+	cubic = source->cubic;
+	coeffs = source->coeffs;
+	coeffs_valid = source->coeffs_valid;
 }
 
 ChFunction* ChFunction_Recorder::new_Duplicate ()
@@ -56,248 +65,263 @@ ChFunction* ChFunction_Recorder::new_Duplicate ()
 
 void ChFunction_Recorder::Extimate_x_range (double& xmin, double& xmax)
 {
-	if (!points.GetTail())
+	if (points.empty())
 	{
 		xmin = 0.0; xmax = 1.2;
 		return;
 	}
-	xmin = points.GetHead()->data->x;
-	xmax = points.GetTail()->data->x;
+	xmin = points.front().x;
+	xmax = points.back().x;
 	if (xmin == xmax) xmax = xmin+ 0.5;
 }
 
 
-int ChFunction_Recorder::AddPoint (double mx, double my, double mw)
+int ChFunction_Recorder::InsertPoint (const ChRecPoint& mpt)
 {
-	ChRecPoint* mpt = new ChRecPoint;
-	mpt->x = mx;  	mpt->y = my;  	mpt->w = mw;
-	double dist;
+	coeffs_valid = false;
 
-	if (!points.GetTail())
+	// fast path: appended after the last point
+	if (points.empty() || mpt.x - points.back().x >= CH_RECORDER_EPSILON)
 	{
-		points.AddTail(mpt);
-		return TRUE;
+		points.push_back(mpt);
+		return (int)points.size() - 1;
 	}
 
-	for (ChNode<ChRecPoint>* mnode = points.GetTail(); mnode != NULL; mnode= mnode->prev)
+	std::vector<ChRecPoint>::iterator iter = std::upper_bound(points.begin(), points.end(), mpt.x, ChRecPointAbove);
+	if (iter != points.end() && iter->x - mpt.x < CH_RECORDER_EPSILON)
 	{
-		dist = mx - mnode->data->x;
-		if (fabs(dist) < CH_RECORDER_EPSILON)
-		{
-			mnode->data = mpt;	// copy to preexisting node
-			return TRUE;
-		}
-		if (dist > 0.0)
-		{
-			points.InsertAfter(mnode, mpt);  // insert
-			return TRUE;
-		}
+		*iter = mpt;	// copy to preexisting point
+		return (int)(iter - points.begin());
 	}
+	if (iter != points.begin() && mpt.x - (iter-1)->x < CH_RECORDER_EPSILON)
+	{
+		*(iter-1) = mpt;
+		return (int)(iter - points.begin()) - 1;
+	}
+	iter = points.insert(iter, mpt);
+	return (int)(iter - points.begin());
+}
 
-
-	points.AddHead(mpt); // was 1st in list
+int ChFunction_Recorder::AddPoint (double mx, double my, double mw)
+{
+	ChRecPoint mpt;
+	mpt.x = mx;  	mpt.y = my;  	mpt.w = mw;
+	InsertPoint(mpt);
 	return TRUE;
 }
 
 int ChFunction_Recorder::AddPointClean (double mx, double my, double dx_clean)
 {
-	ChRecPoint* mpt = new ChRecPoint;
-	mpt->x = mx;  	mpt->y = my;  	mpt->w = 0;
-	double dist;
-	ChNode<ChRecPoint>* msetnode = NULL;
+	ChRecPoint mpt;
+	mpt.x = mx;  	mpt.y = my;  	mpt.w = 0;
+	int iset = InsertPoint(mpt);
 
-	if (!points.GetHead())
+	// clean on dx
+	if (dx_clean >0)
 	{
-		points.AddHead(mpt);
-		lastnode = msetnode = points.GetHead();
-		return TRUE;
+		int iend = iset + 1;
+		while (iend < (int)points.size() && (points[iend].x - mx) < dx_clean)
+			iend++;
+		points.erase(points.begin() + iset + 1, points.begin() + iend);
 	}
 
-	if (!lastnode)
-		lastnode = points.GetHead();
+	return TRUE;
+}
+
 
-	if (lastnode->data->x < mx) // 1 forward search
+void ChFunction_Recorder::LoadPoints (std::vector<ChRecPoint>& mpoints)
+{
+	// stable sort, so that the last of the points with the same x is the last given
+	for (size_t i = 1; i < mpoints.size(); i++)
 	{
-		for (ChNode<ChRecPoint>* mnode = lastnode; mnode != NULL; mnode= mnode->next)
+		if (mpoints[i].x < mpoints[i-1].x)
 		{
-			if (mnode->data->x >= mx)
-			{
-				lastnode = mnode;
-				dist = - mx + mnode->data->x;
-				if (fabs(dist) < CH_RECORDER_EPSILON) {
-					mnode->data = mpt;
-					msetnode = mnode;}	// copy to preexisting node
-				else {
-					points.InsertBefore(mnode, mpt);
-					msetnode = mnode->prev;} // insert
-				break;
-
-			}
-		}
-		if (!msetnode)
-		{			// ..oh, it should be tail..
-			points.AddTail(mpt);
-			msetnode = points.GetTail();
+			std::stable_sort(mpoints.begin(), mpoints.end(), ChRecPointLess);
+			break;
 		}
 	}
-	else						// 2 backward search
+
+	points.clear();
+	points.reserve(mpoints.size());
+	for (size_t i = 0; i < mpoints.size(); i++)
 	{
-		for (ChNode<ChRecPoint>* mnode = lastnode; mnode != NULL; mnode= mnode->prev)
-		{
-			if (mnode->data->x <= mx)
-			{
-				lastnode = mnode;
-				dist =  mx - mnode->data->x;
-				if (fabs(dist) < CH_RECORDER_EPSILON) {
-					mnode->data = mpt;	// copy to preexisting node
-					msetnode = mnode;}
-				else {
-					points.InsertAfter(mnode, mpt);  // insert
-					msetnode = mnode->next; }
-				break;
-			}
-		}
-		if (!msetnode)
-		{			// ..oh, it should be head
-			points.AddHead(mpt);
-			msetnode = points.GetHead();
-		}
+		if (!points.empty() && mpoints[i].x - points.back().x < CH_RECORDER_EPSILON)
+			points.back() = mpoints[i];
+		else
+			points.push_back(mpoints[i]);
 	}
 
-	lastnode = msetnode;
+	lastindex = 0;
+	coeffs_valid = false;
+	if (cubic)
+		UpdateCoefficients();
+}
 
-	// clean on dx
-	if (dx_clean >0)
+void ChFunction_Recorder::SetPoints (int n, const double* x, const double* y)
+{
+	std::vector<ChRecPoint> mpoints(n);
+	for (int i = 0; i < n; i++)
 	{
-		ChNode<ChRecPoint>* mnode = msetnode->next;
-		ChNode<ChRecPoint>* mnextnode = NULL;
-		while (mnode != NULL)
-		{
-			mnextnode = mnode->next;
-			if ((mnode->data->x - mx) < dx_clean)
-			{
-				points.Kill(mnode);
-			}
-			mnode = mnextnode;
-		}
+		mpoints[i].x = x[i];
+		mpoints[i].y = y[i];
+		mpoints[i].w = 1.0;
 	}
-
-	return TRUE;
+	LoadPoints(mpoints);
 }
 
-double ChFunction_Recorder::Get_y      (double x)
+int ChFunction_Recorder::LoadAscii (const char* filename)
 {
-	double y = 0;
-
-	ChRecPoint p1;
-	p1.w = 1;
-	p1.x = 0;
-	p1.y = 0;
-	ChRecPoint p2;
-	p2 = p1;
-	p2.x = p1.x + 1.0;
-
-	if (points.GetHead() == NULL) return 0.0;
-
-	if (x < points.GetHead()->data->x) return 0.0;
-	if (x > points.GetTail()->data->x) return 0.0;
+	FILE* mfile = fopen(filename, "r");
+	if (!mfile)
+		throw ChException("Cannot open file for ChFunction_Recorder");
+
+	std::vector<ChRecPoint> mpoints;
+	ChRecPoint mpt;
+	mpt.w = 1.0;
+	char line[1024];
+	while (fgets(line, sizeof(line), mfile))
+	{
+		char* begin = line;
+		char* end;
+		mpt.x = strtod(begin, &end);
+		if (end == begin)
+			continue;
+		begin = end;
+		while (*begin == ',' || *begin == ';')
+			begin++;
+		mpt.y = strtod(begin, &end);
+		if (end == begin)
+			continue;
+		mpoints.push_back(mpt);
+	}
+	fclose(mfile);
 
-	if (!lastnode) lastnode = points.GetHead();
+	LoadPoints(mpoints);
+	return (int)points.size();
+}
 
-	if (lastnode->data->x < x) // forward search
+int ChFunction_Recorder::LoadBinary (const char* filename)
+{
+	FILE* mfile = fopen(filename, "rb");
+	if (!mfile)
+		throw ChException("Cannot open file for ChFunction_Recorder");
+
+	std::vector<ChRecPoint> mpoints;
+	ChRecPoint mpt;
+	mpt.w = 1.0;
+	double buffer[1024];
+	size_t nread;
+	while ((nread = fread(buffer, sizeof(double), 1024, mfile)) > 0)
 	{
-		for (ChNode<ChRecPoint>* mnode = lastnode; mnode != NULL; mnode= mnode->next)
+		for (size_t i = 0; i + 1 < nread; i += 2)
 		{
-			if (mnode->data->x >= x)
-			{
-				p2 = *mnode->data; lastnode = mnode;
-				if (mnode->prev)	{ p1 = *mnode->prev->data; }
-				break;
-			}
+			mpt.x = buffer[i];
+			mpt.y = buffer[i+1];
+			mpoints.push_back(mpt);
 		}
 	}
-	else	// backward search
+	fclose(mfile);
+
+	LoadPoints(mpoints);
+	return (int)points.size();
+}
+
+
+int ChFunction_Recorder::FindInterval (double x)
+{
+	// The interval i, between points i and i+1, that contains x.
+	// There must be two points at least, and x must be in their range.
+	int nint = (int)points.size() - 1;
+
+	if (lastindex >= nint)
+		lastindex = nint - 1;
+	if (points[lastindex].x <= x)
 	{
-		for (ChNode<ChRecPoint>* mnode = lastnode; mnode != NULL; mnode= mnode->prev)
-		{
-			if (mnode->data->x <= x)
-			{
-				p1 = *mnode->data;	lastnode = mnode;
-				if (mnode->next)	{ p2 = *mnode->next->data; }
-				break;
-			}
-		}
+		if (x <= points[lastindex+1].x)
+			return lastindex;
+		if (lastindex + 1 < nint && x <= points[lastindex+2].x)
+			return ++lastindex;
 	}
 
+	std::vector<ChRecPoint>::iterator iter = std::upper_bound(points.begin(), points.end(), x, ChRecPointAbove);
+	lastindex = ChMin((int)(iter - points.begin()) - 1, nint - 1);
+	return lastindex;
+}
 
-	y = ((x - p1.x)*p2.y + (p2.x -x)*p1.y)/(p2.x - p1.x);
+void ChFunction_Recorder::UpdateCoefficients ()
+{
+	int nint = (int)points.size() - 1;
+	coeffs.resize(4 * ChMax(nint, 0));
 
-	return y;
+	double s_prev = 0;
+	for (int i = 0; i < nint; i++)
+	{
+		double h   = points[i+1].x - points[i].x;
+		double s   = (points[i+1].y - points[i].y) / h;
+		double s_next = (i + 1 < nint) ? (points[i+2].y - points[i+1].y) / (points[i+2].x - points[i+1].x) : s;
+		double m1 = (i > 0) ? 0.5 * (s_prev + s) : s;	// slopes at the ends of the interval
+		double m2 = 0.5 * (s + s_next);
+		coeffs[4*i]   = points[i].y;
+		coeffs[4*i+1] = m1;
+		coeffs[4*i+2] = (3.0 * s - 2.0 * m1 - m2) / h;
+		coeffs[4*i+3] = (m1 + m2 - 2.0 * s) / (h * h);
+		s_prev = s;
+	}
+	coeffs_valid = true;
 }
 
-double ChFunction_Recorder::Get_y_dx   (double x)
-{
-	double dy = 0;
 
-	ChRecPoint p1;					//    p0...p1..x...p2.....p3
-	p1.x = x;	p1.y = 0;	p1.w = 1;
-	ChRecPoint p2;
-	p2 = p1;	p2.x += 100.0;
-	ChRecPoint p0;
-	p0 = p1;	p0.x -= 100.0;
-	ChRecPoint p3;
-	p3 = p1;	p3.x += 200.0;
+double ChFunction_Recorder::Get_y      (double x)
+{
+	if (points.empty()) return 0.0;
 
-	if (points.GetHead() == NULL) return 0.0;
+	if (x < points.front().x) return 0.0;
+	if (x > points.back().x) return 0.0;
 
-	if (x < points.GetHead()->data->x) return 0.0;
-	if (x > points.GetTail()->data->x) return 0.0;
+	if (points.size() == 1) return points[0].y;
 
-	if (!lastnode) lastnode = points.GetHead();
+	int i = FindInterval(x);
 
-	if (lastnode->data->x < x) // forward search
+	if (cubic)
 	{
-		for (ChNode<ChRecPoint>* mnode = lastnode; mnode != NULL; mnode= mnode->next)
-		{
-			if (mnode->data->x >= x)
-			{
-				p2 = *mnode->data; lastnode = mnode;
-				if (mnode->prev) {
-					p1 = *mnode->prev->data;
-					if (mnode->prev->prev) {
-						p0 = *mnode->prev->prev->data;
-						if (mnode->next) {
-							p3 = *mnode->next->data;
-						}else { p3 = p2; p3.x += 1.0;}
-					}else { p0 = p1; p0.x -= 1.0;}
-				}else { p1 = p2; p1.x -= 1.0;}
-
-				break;
-			}
-		}
+		if (!coeffs_valid) UpdateCoefficients();
+		const double* c = &coeffs[4*i];
+		double t = x - points[i].x;
+		return c[0] + t * (c[1] + t * (c[2] + t * c[3]));
 	}
-	else	// backward search
+
+	const ChRecPoint& p1 = points[i];
+	const ChRecPoint& p2 = points[i+1];
+
+	return ((x - p1.x)*p2.y + (p2.x -x)*p1.y)/(p2.x - p1.x);
+}
+
+double ChFunction_Recorder::Get_y_dx   (double x)
+{
+	if (points.size() < 2) return 0.0;
+
+	if (x < points.front().x) return 0.0;
+	if (x > points.back().x) return 0.0;
+
+	int i = FindInterval(x);
+
+	if (cubic)
 	{
-		for (ChNode<ChRecPoint>* mnode = lastnode; mnode != NULL; mnode= mnode->prev)
-		{
-			if (mnode->data->x <= x)
-			{
-				p1 = *mnode->data;	lastnode = mnode;
-				if (mnode->next)  {
-					p2 = *mnode->next->data;
-					if (mnode->prev)  {
-						p0 = *mnode->prev->data;
-						if (mnode->next->next)  {
-							p3 = *mnode->next->next->data;
-						}else { p3 = p2; p3.x += 1.0;}
-					}else { p0 = p1; p0.x -= 1.0;}
-				}else { p2 = p1; p2.x += 1.0;}
-
-				break;
-			}
-		}
+		if (!coeffs_valid) UpdateCoefficients();
+		const double* c = &coeffs[4*i];
+		double t = x - points[i].x;
+		return c[1] + t * (2.0 * c[2] + 3.0 * t * c[3]);
 	}
 
+	ChRecPoint p1 = points[i];		//    p0...p1..x...p2.....p3
+	ChRecPoint p2 = points[i+1];
+	ChRecPoint p0;
+	if (i > 0) { p0 = points[i-1]; }
+	else { p0 = p1; p0.x -= 1.0;}
+	ChRecPoint p3;
+	if (i + 2 < (int)points.size()) { p3 = points[i+2]; }
+	else { p3 = p2; p3.x += 1.0;}
+
 	double vA = (p1.y -p0.y)/(p1.x -p0.x);
 	double vB = (p2.y -p1.y)/(p2.x -p1.x);
 	double vC = (p3.y -p2.y)/(p3.x -p2.x);
@@ -305,74 +329,35 @@ double ChFunction_Recorder::Get_y_dx   (double x)
 	double v1 = 0.5* (vA + vB);
 	double v2 = 0.5* (vB + vC);
 
-	dy = ((x - p1.x)* v2 + (p2.x -x)* v1)  /  (p2.x - p1.x);
-
-	return dy;
+	return ((x - p1.x)* v2 + (p2.x -x)* v1)  /  (p2.x - p1.x);
 }
 
 double ChFunction_Recorder::Get_y_dxdx (double x)
 {
-	double ddy = 0;
-
-	ChRecPoint p1;					//    p0...p1..x...p2.....p3
-	p1.x = x;	p1.y = 0;	p1.w = 1;
-	ChRecPoint p2;
-	p2 = p1;	p2.x = p1.x + 100.0;
-	ChRecPoint p0;
-	p0 = p1;	p0.x = p1.x - 100.0;
-	ChRecPoint p3;
-	p3 = p1;	p3.x = p1.x + 200.0;
+	if (points.size() < 2) return 0.0;
 
-	if (points.GetHead() == NULL) return 0.0;
+	if (x < points.front().x) return 0.0;
+	if (x > points.back().x) return 0.0;
 
-	if (x < points.GetHead()->data->x) return 0.0;
-	if (x > points.GetTail()->data->x) return 0.0;
+	int i = FindInterval(x);
 
-	if (!lastnode) lastnode = points.GetHead();
-
-	if (lastnode->data->x < x) // forward search
-	{
-		for (ChNode<ChRecPoint>* mnode = lastnode; mnode != NULL; mnode= mnode->next)
-		{
-			if (mnode->data->x >= x)
-			{
-				p2 = *mnode->data; lastnode = mnode;
-				if (mnode->prev) {
-					p1 = *mnode->prev->data;
-					if (mnode->prev->prev) {
-						p0 = *mnode->prev->prev->data;
-						if (mnode->next) {
-							p3 = *mnode->next->data;
-						}else { p3 = p2; p3.x += 1.0;}
-					}else { p0 = p1; p0.x -= 1.0;}
-				}else { p1 = p2; p1.x -= 1.0;}
-
-				break;
-			}
-		}
-	}
-	else	// backward search
+	if (cubic)
 	{
-		for (ChNode<ChRecPoint>* mnode = lastnode; mnode != NULL; mnode= mnode->prev)
-		{
-			if (mnode->data->x <= x)
-			{
-				p1 = *mnode->data;	lastnode = mnode;
-				if (mnode->next)  {
-					p2 = *mnode->next->data;
-					if (mnode->prev)  {
-						p0 = *mnode->prev->data;
-						if (mnode->next->next)  {
-							p3 = *mnode->next->next->data;
-						}else { p3 = p2; p3.x += 1.0;}
-					}else { p0 = p1; p0.x -= 1.0;}
-				}else { p2 = p1; p2.x += 1.0;}
-
-				break;
-			}
-		}
+		if (!coeffs_valid) UpdateCoefficients();
+		const double* c = &coeffs[4*i];
+		double t = x - points[i].x;
+		return 2.0 * c[2] + 6.0 * t * c[3];
 	}
 
+	ChRecPoint p1 = points[i];		//    p0...p1..x...p2.....p3
+	ChRecPoint p2 = points[i+1];
+	ChRecPoint p0;
+	if (i > 0) { p0 = points[i-1]; }
+	else { p0 = p1; p0.x -= 1.0;}
+	ChRecPoint p3;
+	if (i + 2 < (int)points.size()) { p3 = points[i+2]; }
+	else { p3 = p2; p3.x += 1.0;}
+
 	double vA = (p1.y -p0.y)/(p1.x -p0.x);
 	double vB = (p2.y -p1.y)/(p2.x -p1.x);
 	double vC = (p3.y -p2.y)/(p3.x -p2.x);
@@ -380,28 +365,28 @@ double ChFunction_Recorder::Get_y_dxdx (double x)
 	double a1 = 2.0 * (vB - vA)/(p2.x - p0.x);
 	double a2 = 2.0 * (vC - vB)/(p3.x - p1.x);
 
-	ddy = ((x - p1.x)* a2 + (p2.x -x)* a1)  /  (p2.x - p1.x);
-
-	return ddy;
+	return ((x - p1.x)* a2 + (p2.x -x)* a1)  /  (p2.x - p1.x);
 }
 
 
 void ChFunction_Recorder::StreamOUT(ChStreamOutBinary& mstream)
 {
 		// class version number
-	mstream.VersionWrite(1);
+	mstream.VersionWrite(2);
 		// serialize parent class too
 	ChFunction::StreamOUT(mstream);
 
 		// stream out all member data
-	mstream << (int)(points.Count());
+	mstream << (int)(points.size());
 
-	for (ChNode<ChRecPoint>* mnode = points.GetTail(); mnode != NULL; mnode= mnode->prev)
+	for (int i = (int)points.size() - 1; i >= 0; i--)
 	{
-		mstream << mnode->data->x;
-		mstream << mnode->data->y;
-		mstream << mnode->data->w;
+		mstream << points[i].x;
+		mstream << points[i].y;
+		mstream << points[i].w;
 	}
+
+	mstream << cubic;
 }
 
 void ChFunction_Recorder::StreamIN(ChStreamInBinary& mstream)
@@ -415,15 +400,18 @@ void ChFunction_Recorder::StreamIN(ChStreamInBinary& mstream)
 	int mcount;
 	mstream >> mcount;
 
-	for (int i = 0; i < mcount; i++)
+	points.resize(mcount);
+	for (int i = mcount - 1; i >= 0; i--)
 	{
-		ChRecPoint* mpt = new ChRecPoint;
-		mstream >> mpt->x;
-		mstream >> mpt->y;
-		mstream >> mpt->w;
-		points.AddHead(mpt);
+		mstream >> points[i].x;
+		mstream >> points[i].y;
+		mstream >> points[i].w;
 	}
+	lastindex = 0;
+	coeffs_valid = false;
 
+	if (version >= 2)
+		mstream >> cubic;
 }
 
 void ChFunction_Recorder::StreamOUT(ChStreamOutAscii& mstream)
@@ -28,6 +28,7 @@
 ///////////////////////////////////////////////////
 
 
+#include <vector>
 #include "ChFunction_Base.h"
 
 
@@ -53,26 +54,76 @@ public:
 /// RECORDER FUNCTION
 /// y = interpolation of array of (x,y) data, 
 ///     where (x,y) points can be inserted randomly.
+///
+/// The points are stored in an array sorted by x, so the
+/// interval that contains x is found by bisection, in O(log n)
+/// time, or in constant time if x is in the same interval of the
+/// last evaluation or in the next one (ex. when a recording is
+/// replayed as a function of time). Also adding points with
+/// increasing x, as when recording the time history of a variable,
+/// takes constant time, while inserting a point in the middle
+/// must shift the points that follow it.
+/// Large sets of points should be loaded all at once, with 
+/// SetPoints(), LoadAscii() or LoadBinary(), that sort them only once.
+///
+/// By default y is interpolated linearly between the points.
+/// If SetCubic(true), y is interpolated with a cubic Hermite spline,
+/// whose slope at each point is the average of the slopes of the
+/// two adjacent intervals: y, dy/dx are continuous and the derivatives
+/// are the exact derivatives of the spline. Its coefficients are computed 
+/// when the points are loaded, or at the first evaluation after the
+/// points have been changed.
 
 class ChApi ChFunction_Recorder : public ChFunction
 {
 	CH_RTTI(ChFunction_Recorder, ChFunction);
 private:
-	ChList<ChRecPoint> points;		// the list of points
-	ChNode<ChRecPoint>* lastnode;	// speed optimization: remember the last used pointer
+	std::vector<ChRecPoint> points;	// the points, sorted by x
+	int lastindex;					// speed optimization: remember the last used interval
+	bool cubic;
+	bool coeffs_valid;
+	std::vector<double> coeffs;		// a,b,c,d of a+b*t+c*t^2+d*t^3 for each interval
+
+	int InsertPoint (const ChRecPoint& mpt);
+	void LoadPoints (std::vector<ChRecPoint>& mpoints);
+	int FindInterval (double x);
+	void UpdateCoefficients ();
 
 public:
-	ChFunction_Recorder () {lastnode = NULL;};
-	~ChFunction_Recorder () {points.KillAll();};
+	ChFunction_Recorder () {lastindex = 0; cubic = false; coeffs_valid = false;};
+	~ChFunction_Recorder () {};
 	void Copy (ChFunction_Recorder* source);
 	ChFunction* new_Duplicate ();
 
 	int AddPoint (double mx, double my, double mw);
 	int AddPoint (double mx, double my) {return AddPoint(mx,my,1.0);};
 	int AddPointClean (double mx, double my, double dx_clean); // also clean nodes to the right, upt to dx interval
-	void Reset() {points.KillAll(); lastnode = NULL;};
-
-	ChList<ChRecPoint>*  GetPointList() {return &points;};
+	void Reset() {points.clear(); coeffs.clear(); lastindex = 0; coeffs_valid = false;};
+
+				/// Replace all the points with the n points (x[i],y[i]), with 
+				/// weight 1. The x values need not be sorted. If more points 
+				/// have the same x, only the last one is kept, as in AddPoint().
+	void SetPoints (int n, const double* x, const double* y);
+
+				/// Replace all the points with the x,y pairs of a text file,
+				/// one per line, separated by spaces, tabs, commas or semicolons
+				/// (ex. a CSV file). Lines that do not begin with two numbers, as
+				/// headers or comments, are skipped. Returns the number of points.
+				/// Throws a ChException if the file cannot be opened.
+	int LoadAscii (const char* filename);
+
+				/// Replace all the points with the x,y pairs of a binary file,
+				/// that contains only pairs of doubles, in the byte order of this
+				/// machine. Returns the number of points.
+				/// Throws a ChException if the file cannot be opened.
+	int LoadBinary (const char* filename);
+
+				/// The points, sorted by x.
+	const std::vector<ChRecPoint>&  GetPointList() {return points;};
+
+				/// Interpolate with a cubic spline instead of linearly.
+	void SetCubic (bool mcubic) {cubic = mcubic;};
+	bool GetCubic () {return cubic;};
 
 	double Get_y      (double x) ;
 	double Get_y_dx   (double x) ;
@@ -271,7 +271,7 @@ void ChFunction_Sequence::Setup()
 		lastIy = mnode->data->fx->Get_y(mnode->data->duration) +
 				 mnode->data->Iy +
 				 mnode->data->Iydt *  mnode->data->duration +
-				 mnode->data->Iydtdt *  mnode->data->duration *  mnode->data->duration;
+				 0.5 * mnode->data->Iydtdt *  mnode->data->duration *  mnode->data->duration;
 		lastIy_dt =
 				 mnode->data->fx->Get_y_dx(mnode->data->duration) +
 				 mnode->data->Iydt +
@@ -296,7 +296,7 @@ double ChFunction_Sequence::Get_y      (double x)
 			res = mnode->data->fx->Get_y(localtime) +
 				  mnode->data->Iy +
 				  mnode->data->Iydt *  localtime +
-				  mnode->data->Iydtdt *  localtime *  localtime;
+				  0.5 * mnode->data->Iydtdt *  localtime *  localtime;
 		}
 	}
 	return res;
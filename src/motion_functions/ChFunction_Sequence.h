@@ -112,7 +112,7 @@ public:
 				/// if you want that Get_weight() will give different results depending on the "x" parameter.
 				/// Set c0=true if you want to force C0 continuity with previous function (an offset
 				/// will be implicitly added to the function, as y=f(x)+Offset). Same for C1 and C2 continuity,
-				/// using c1 and c2 flags.
+				/// using c1 and c2 flags: the offset is then a polynomial of 2nd degree in the local x.
 	int InsertFunct (ChFunction* myfx, double duration, double weight=1, bool c0=false, bool c1=false, bool c2=false, int position=-1);
 
 				/// Remove and deletes function with defined "position", and returns TRUE. 
@@ -0,0 +1,191 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChTaskPool.cpp
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "parallel/ChTaskPool.h"
+
+
+namespace chrono
+{
+
+
+ChTaskPool::ChTaskPool(int nthreads)
+{
+	if (nthreads < 1)
+		nthreads = 1;
+	num_threads = nthreads;
+
+	workers = new Worker[num_threads];
+	for (int i = 0; i < num_threads; i++)
+	{
+		workers[i].next = 0;
+		workers[i].end = 0;
+		workers[i].id = i;
+		workers[i].pool = this;
+	}
+
+	threads = 0;
+	if (num_threads > 1)
+	{
+		ChThreadConstructionInfo create_args ( (char*)"ChTaskPool",
+							WorkerThreadFunc,
+							WorkerMemoryFunc,
+							num_threads - 1);
+		threads = new ChThreads(create_args);
+	}
+
+	loop = 0;
+	loop_nitems = 0;
+	loop_chunk_size = 1;
+}
+
+
+ChTaskPool::~ChTaskPool()
+{
+	if (threads)
+	{
+		threads->flush();
+		delete threads;
+		threads = 0;
+	}
+	delete [] workers;
+}
+
+
+void ChTaskPool::WorkerThreadFunc(void* userPtr, void* lsMemory)
+{
+	Worker* mworker = (Worker*)userPtr;
+	mworker->pool->RunWorker(mworker->id);
+}
+
+
+void* ChTaskPool::WorkerMemoryFunc()
+{
+	return 0;
+}
+
+
+void ChTaskPool::ParallelFor(int nitems, ChTaskPoolLoop& mloop, int chunk_size)
+{
+	if (nitems <= 0)
+		return;
+
+	if (chunk_size <= 0)
+		chunk_size = nitems / (8 * num_threads);
+	if (chunk_size < 1)
+		chunk_size = 1;
+
+	int nchunks = (nitems + chunk_size - 1) / chunk_size;
+
+	if (num_threads == 1 || nchunks == 1)
+	{
+		mloop.Run(0, nitems);
+		return;
+	}
+
+	loop = &mloop;
+	loop_nitems = nitems;
+	loop_chunk_size = chunk_size;
+
+	// Initial split of the chunks in contiguous ranges, one per worker
+	for (int i = 0; i < num_threads; i++)
+	{
+		workers[i].next = (int)(((long long)nchunks * i) / num_threads);
+		workers[i].end  = (int)(((long long)nchunks * (i+1)) / num_threads);
+	}
+
+	// Worker 0 is the calling thread
+	for (int i = 1; i < num_threads; i++)
+		threads->sendRequest(1, &workers[i], i-1);
+
+	RunWorker(0);
+
+	//... must wait that the all the threads finished!
+	threads->flush();
+
+	loop = 0;
+}
+
+
+void ChTaskPool::RunWorker(int mid)
+{
+	Worker& mworker = workers[mid];
+
+	while (true)
+	{
+		int mchunk = -1;
+
+		mworker.lock.Lock();
+		if (mworker.next < mworker.end)
+			mchunk = mworker.next++;
+		mworker.lock.Unlock();
+
+		if (mchunk < 0)
+			mchunk = StealChunk(mid);
+		if (mchunk < 0)
+			return; // nothing left
+
+		int mbegin = mchunk * loop_chunk_size;
+		int mend = mbegin + loop_chunk_size;
+		if (mend > loop_nitems)
+			mend = loop_nitems;
+		loop->Run(mbegin, mend);
+	}
+}
+
+
+int ChTaskPool::StealChunk(int mid)
+{
+	for (int k = 1; k < num_threads; k++)
+	{
+		Worker& mvictim = workers[(mid + k) % num_threads];
+
+		// take the second half of the chunks left to the victim
+		int mfrom = 0;
+		int mto = 0;
+		mvictim.lock.Lock();
+		int nleft = mvictim.end - mvictim.next;
+		if (nleft > 0)
+		{
+			mto = mvictim.end;
+			mfrom = mto - (nleft + 1) / 2;
+			mvictim.end = mfrom;
+		}
+		mvictim.lock.Unlock();
+
+		if (mto > mfrom)
+		{
+			// process the first stolen chunk now, keep the others as own range
+			Worker& mworker = workers[mid];
+			mworker.lock.Lock();
+			mworker.next = mfrom + 1;
+			mworker.end = mto;
+			mworker.lock.Unlock();
+			return mfrom;
+		}
+	}
+	return -1;
+}
+
+
+
+} // END_OF_NAMESPACE____
+
+
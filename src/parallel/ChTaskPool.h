@@ -0,0 +1,114 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHTASKPOOL_H
+#define CHTASKPOOL_H
+
+//////////////////////////////////////////////////
+//
+//   ChTaskPool.h
+//
+//   Pool of persistent threads that execute parallel
+//   loops, split in chunks that idle threads can steal
+//   from busy threads.
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "core/ChApiCE.h"
+#include "parallel/ChThreads.h"
+#include "parallel/ChThreadsSync.h"
+
+
+namespace chrono
+{
+
+
+/// Base class for the body of a parallel loop, see ChTaskPool::ParallelFor().
+/// Children classes implement Run(), and usually hold as data members
+/// the arrays and parameters needed by the loop.
+
+class ChApi ChTaskPoolLoop
+{
+public:
+	virtual ~ChTaskPoolLoop() {};
+
+			/// Process the items from 'begin' to 'end' (excluded). This is
+			/// called concurrently by multiple threads, on disjoint ranges.
+	virtual void Run(int begin, int end) = 0;
+};
+
+
+
+/// Pool of persistent threads (based on ChThreads) for executing
+/// parallel loops over arrays of items. The items are split in chunks,
+/// and each thread initially owns a contiguous range of chunks; a thread
+/// that finishes its range steals half of the remaining chunks of another
+/// thread, so loops whose items have very different costs are balanced.
+/// The calling thread takes part in the loop as one of the threads.
+/// ParallelFor() is not reentrant: it must not be called from a loop body.
+
+class ChApi ChTaskPool
+{
+public:
+			/// Create the pool with 'nthreads' threads, including the calling
+			/// thread (so nthreads-1 threads are created). If nthreads is 1, the
+			/// loops are executed serially.
+	ChTaskPool(int nthreads);
+
+	virtual ~ChTaskPool();
+
+			/// Get the number of threads, including the calling thread.
+	int GetNumThreads() {return num_threads;}
+
+			/// Execute mloop.Run() on all the items from 0 to nitems, split in
+			/// chunks of 'chunk_size' items, and wait for the end. If chunk_size
+			/// is 0, a size that gives some chunks per thread is used.
+	void ParallelFor(int nitems, ChTaskPoolLoop& mloop, int chunk_size = 0);
+
+private:
+	struct Worker
+	{
+		ChSpinlock lock;	// protects next and end
+		int next;			// next chunk to process
+		int end;			// end of the range of chunks of this worker
+		int id;
+		ChTaskPool* pool;
+		char padding[64];	// avoid false sharing between workers
+	};
+
+	static void WorkerThreadFunc(void* userPtr, void* lsMemory);
+	static void* WorkerMemoryFunc();
+
+	void RunWorker(int mid);
+	int  StealChunk(int mid);
+
+	int num_threads;
+	ChThreads* threads;
+	Worker* workers;
+
+	ChTaskPoolLoop* loop;
+	int loop_nitems;
+	int loop_chunk_size;
+};
+
+
+
+} // END_OF_NAMESPACE____
+
+
+#endif  // END of ChTaskPool.h
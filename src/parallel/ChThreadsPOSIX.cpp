@@ -205,12 +205,17 @@ void ChThreadsPOSIX::startSPU()
 ///tell the task scheduler we are done with the SPU tasks
 void ChThreadsPOSIX::stopSPU()
 {
-	for(size_t t=0; t < m_activeSpuStatus.size(); ++t) 
+	// STOP thread fx: a request with null user pointer makes the thread
+	// exit, then wait for it, before destroying the semaphore it waits on
+	for(int t=0; t < m_activeSpuStatus.size(); ++t) 
+		this->sendRequest(1, 0, t);
+
+	for(int t=0; t < m_activeSpuStatus.size(); ++t) 
 	{
             ChThreadStatePOSIX&	spuStatus = m_activeSpuStatus[t];
 
+            checkPThreadFunction(pthread_join(spuStatus.thread, 0));
             checkPThreadFunction(sem_destroy(&spuStatus.startSemaphore));
-            checkPThreadFunction(pthread_cancel(spuStatus.thread));
     }
     checkPThreadFunction(sem_destroy(&this->mainSemaphore));
 
@@ -72,8 +72,16 @@ private:
 
 #define EBUSY 16
 #pragma intrinsic(_InterlockedExchange)
+#pragma intrinsic(_InterlockedExchangeAdd)
 #pragma intrinsic(_ReadWriteBarrier)
 
+		/// Atomically add 'mval' to the integer at 'mvar', and return
+		/// the previous value.
+inline int ChAtomicFetchAdd(volatile int* mvar, int mval)
+{
+	return (int)_InterlockedExchangeAdd((volatile long*)mvar, (long)mval);
+}
+
 		/// Class that wraps a spinlock, a very fast locking mutex 
 		/// that should be used only for short wait periods.
 		/// This uses MSVC intrinsics to mimic a fast spinlock as 
@@ -178,6 +186,13 @@ static inline int pthread_spin_unlock(pthread_spinlock_t *lock) {
 #endif
 
 
+		/// Atomically add 'mval' to the integer at 'mvar', and return
+		/// the previous value.
+inline int ChAtomicFetchAdd(volatile int* mvar, int mval)
+{
+	return __sync_fetch_and_add(mvar, mval);
+}
+
 		/// Class that wraps a thread mutex, a locking mechanism to avoid,
 		/// for instance, multiple thread concurrent access to the same data.
 class ChMutexSpinlock
@@ -26,6 +26,7 @@
 #include "physics/ChAssembly.h"
 #include "physics/ChGlobal.h"
 #include "physics/ChSystem.h"
+#include "physics/ChStateSnapshot.h"
 
 #include "physics/ChExternalObject.h"
 #include "collision/ChCModelBulletDEM.h"
@@ -801,6 +802,38 @@ void ChAssembly::StreamINstate(ChStreamInBinary& mstream)
 	}
 }
 
+void ChAssembly::StateSave(ChStateSnapshot& msnapshot)
+{
+	HIER_BODY_INIT
+	while HIER_BODY_NOSTOP
+	{
+		Bpointer->StateSave(msnapshot);
+		HIER_BODY_NEXT
+	}
+	HIER_LINK_INIT
+	while HIER_LINK_NOSTOP
+	{
+		Lpointer->StateSave(msnapshot);
+		HIER_LINK_NEXT
+	}
+}
+
+void ChAssembly::StateRestore(ChStateSnapshot& msnapshot)
+{
+	HIER_BODY_INIT
+	while HIER_BODY_NOSTOP
+	{
+		Bpointer->StateRestore(msnapshot);
+		HIER_BODY_NEXT
+	}
+	HIER_LINK_INIT
+	while HIER_LINK_NOSTOP
+	{
+		Lpointer->StateRestore(msnapshot);
+		HIER_LINK_NEXT
+	}
+}
+
 
 #define CH_CHUNK_END_ASSEM 18881
 
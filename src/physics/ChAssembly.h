@@ -349,6 +349,10 @@ public:
 	virtual void StreamINstate(ChStreamInBinary& mstream);
 				/// Method to serialize only the state (position, speed)
 	virtual void StreamOUTstate(ChStreamOutBinary& mstream);	
+				/// Save/restore the state of the bodies and links, for
+				/// ChSystem::StateSave() and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
 
 				/// Method to allow deserializing a persistent binary archive (ex: a file)
 				/// into transient data.
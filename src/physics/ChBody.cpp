@@ -29,6 +29,7 @@
 #include "physics/ChMarker.h"
 #include "physics/ChForce.h"
 #include "physics/ChSystem.h"
+#include "physics/ChStateSnapshot.h"
 
 #include "physics/ChExternalObject.h"
 #include "collision/ChCModelBulletBody.h"
@@ -102,6 +103,8 @@ ChBody::ChBody ()
     sleep_starttime = 0;
     sleep_minspeed = 0.1f;
     sleep_minwvel = 0.04f;
+    sleeping_island = -1;
+    island_coord = coord;
     SetUseSleeping(true); 
 
     variables.SetUserData((void*)this);
@@ -144,6 +147,8 @@ ChBody::ChBody (ChCollisionModel* new_collision_model)
     sleep_starttime = 0;
     sleep_minspeed = 0.1f;
     sleep_minwvel = 0.04f;
+    sleeping_island = -1;
+    island_coord = coord;
     SetUseSleeping(true);
 
     variables.SetUserData((void*)this);
@@ -181,6 +186,7 @@ void ChBody::Copy(ChBody* source)
     ChTime = source->ChTime;
 
     collision_model->ClearModel(); // also copy-duplicate the collision model? Let the user handle this..
+    collision_model->SetSleeping(GetSleeping());
 
     this->matsurface = source->matsurface;  // also copy-duplicate the material? Let the user handle this..
 
@@ -200,6 +206,8 @@ void ChBody::Copy(ChBody* source)
     sleep_starttime = source->sleep_starttime;
     sleep_minspeed = source->sleep_minspeed;
     sleep_minwvel = source->sleep_minwvel;
+    sleeping_island = -1;
+    island_coord = coord;
 }
 
 
@@ -535,6 +543,16 @@ void ChBody::ComputeGyro ()
 }
 
 bool ChBody::TrySleeping()
+{
+    if (this->CanSleep())
+    {
+        SetSleeping(true);
+        return true;
+    }
+    return false;
+}
+
+bool ChBody::CanSleep()
 {
     if (this->GetUseSleeping())
     {   
@@ -545,10 +563,7 @@ bool ChBody::TrySleeping()
              ( 2.0*this->coord_dt.rot.LengthInf() < this->sleep_minwvel) )
         {
                 if ((this->GetChTime() - this->sleep_starttime) > this->sleep_time)
-                {
-                    SetSleeping(true);
                     return true;
-                }
         }
         else
         {
@@ -836,6 +851,10 @@ void ChBody::UpdateExternalGeometry ()
 
 void ChBody::SetBodyFixed (bool mev)
 {
+    if (mev && GetSleeping())
+        SetSleeping(false); // fixed bodies do not sleep
+    if (variables.IsActive() == mev && GetSystem())
+        GetSystem()->ResetIncrementalInjection(); // variables must be injected again
     variables.SetDisabled(mev);
     if (mev == BFlagGet(BF_FIXED)) 
             return;
@@ -843,6 +862,34 @@ void ChBody::SetBodyFixed (bool mev)
     //RecomputeCollisionModel(); // because one may use different model types for static or dynamic coll.shapes
 }
  
+void ChBody::SetSleeping (bool ms)
+{
+    if (ms == BFlagGet(BF_SLEEPING))
+        return;
+    if (GetSystem())
+    {
+        GetSystem()->ResetIncrementalInjection(); // variables must be injected again
+        GetSystem()->ResetAwakeBodyArray();
+    }
+    BFlagSet(BF_SLEEPING, ms);
+    sleeping_island = -1;
+    variables.SetDisabled(!IsActive());
+    if (collision_model)
+        collision_model->SetSleeping(ms);
+
+    if (ms)
+    {
+        // a sleeping body is at rest
+        this->coord_dt = CSYSNULL;
+        this->coord_dtdt = CSYSNULL;
+    }
+    else
+    {
+        // restart counting the time of quiet motion
+        this->sleep_starttime = float(this->GetChTime());
+    }
+}
+
 // collision stuff
 void ChBody::SetCollide (bool mcoll)
 {
@@ -1073,6 +1120,38 @@ void ChBody::StreamINstate(ChStreamInBinary& mstream)
     this->SyncCollisionModels();
 }
 
+void ChBody::StateSave(ChStateSnapshot& msnapshot)
+{
+    msnapshot.Add(this->ChTime);
+    msnapshot.Add(this->coord);
+    msnapshot.Add(this->coord_dt);
+    msnapshot.Add(this->coord_dtdt);
+    msnapshot.Add(this->GetSleeping() ? 1. : 0.);
+    msnapshot.Add(this->sleep_starttime);
+    msnapshot.Add(this->sleeping_island);
+}
+
+void ChBody::StateRestore(ChStateSnapshot& msnapshot)
+{
+    this->ChTime = msnapshot.Get();
+    ChCoordsys<> mcoord, mcoord_dt, mcoord_dtdt;
+    msnapshot.Get(mcoord);
+    msnapshot.Get(mcoord_dt);
+    msnapshot.Get(mcoord_dtdt);
+
+    // before setting the speeds, because falling asleep resets them
+    this->SetSleeping(msnapshot.Get() != 0);
+    this->sleep_starttime = (float)msnapshot.Get();
+    this->sleeping_island = (int)msnapshot.Get();
+
+    this->SetCoord(mcoord);
+    this->SetCoord_dt(mcoord_dt);
+    this->SetCoord_dtdt(mcoord_dtdt);
+
+    this->Update();
+    this->SyncCollisionModels();
+}
+
 
 #define CH_CHUNK_END 1234
 
@@ -149,6 +149,8 @@ protected:
     float  sleep_minspeed;
     float  sleep_minwvel;
     float  sleep_starttime;
+    int    sleeping_island;  // index of the island of sleeping bodies, or -1 [internal]
+    ChCoordsys<> island_coord; // position at the last ChSystem::ComputeIslands() [internal]
 
 public:
 
@@ -233,13 +235,30 @@ public:
 
                 /// Force the body in sleeping mode or not (usually this state change is not
                 /// handled by users, anyway, because it is mostly automatic).
-    void SetSleeping    (bool ms) { BFlagSet(BF_SLEEPING, ms);};
+    void SetSleeping    (bool ms);
                 /// Tell if the body is actually in sleeping state.
     bool GetSleeping()  {return BFlagGet(BF_SLEEPING);};
 
                 /// Put the body in sleeping state if requirements are satisfied.
     bool TrySleeping();
 
+                /// Tell if the requirements for sleeping are satisfied, i.e. the body
+                /// uses sleeping and it has been moving slower than the thresholds for
+                /// more than the sleep time, without putting it in sleeping state.
+                /// The ChSystem uses this to put to sleep whole islands of bodies.
+    bool CanSleep();
+
+                /// Index of the island of bodies that are sleeping together with this
+                /// one, or -1. Used internally by ChSystem to wake whole islands.
+    int  GetSleepingIsland() {return sleeping_island;}
+    void SetSleepingIsland(int mi) {sleeping_island = mi;}
+
+                /// Tell if the body moved since the last SynchronizeIslandPos(). Used
+                /// internally by ChSystem, to wake the bodies touched by a fixed body 
+                /// that the user moves.
+    bool HasMovedSinceIslands() {return !(coord == island_coord);}
+    void SynchronizeIslandPos() {island_coord = coord;}
+
                 /// Tell if the body is active, i.e. it is neither fixed to ground nor
                 /// it is in sleep mode.
     bool IsActive() {return !BFlagGet(BF_SLEEPING | BF_FIXED);}
@@ -359,6 +378,10 @@ public:
     virtual void StreamINstate(ChStreamInBinary& mstream);
                 /// Method to serialize only the state (position, speed)
     virtual void StreamOUTstate(ChStreamOutBinary& mstream);    
+                /// Save/restore the state (time, position, speed, acceleration,
+                /// sleeping) for ChSystem::StateSave() and ChSystem::StateRestore().
+    virtual void StateSave(ChStateSnapshot& msnapshot);
+    virtual void StateRestore(ChStateSnapshot& msnapshot);
 
                 /// Access the material surface properties, referenced by this 
                 /// rigid body. The material surface contains properties such as friction, etc. 
@@ -62,6 +62,7 @@ ChBodyDEM::ChBodyDEM ()
 	kn=2e5; //2e5		//2e8
 	gn=7.5e2;   //5		//15000
 	kt=kn;
+	load_index = -1;
 }
 
 
@@ -77,6 +77,8 @@ private:
 	float kn;	// normal spring constant for DEM contacts
 	float gn;   // normal damping constant for DEM contacts
 	float kt;   // tangential spring constant for DEM contacts
+
+	int load_index;	// index in the body list of the system, for the force reduction of ChContactContainerDEM, or -1 [internal]
 	 
 
 
@@ -114,6 +116,11 @@ public:
 	float  GetSpringCoefficientTangential() {return kt;}
 	void   SetSpringCoefficientTangential(float mval) {kt = mval;}
 
+				/// Index of the body in the lock-free reduction of the contact
+				/// forces done by ChContactContainerDEM, or -1 outside it [internal]
+	int    GetLoadIndex() {return load_index;}
+	void   SetLoadIndex(int mi) {load_index = mi;}
+
 				/// accumulate force on this body, or reset the force to zero
 	//void AccumulateForce(ChVector<> ff) {Xforce+=ff;}
 	//void ResetBodyForce() {Xforce = VNULL;}
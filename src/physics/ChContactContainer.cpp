@@ -49,41 +49,15 @@ ChClassRegister<ChContactContainer> a_registration_ChContactContainer;
 
 ChContactContainer::ChContactContainer ()
 { 
-	contactlist.clear();
 	n_added = 0;
 
-	contactlist_roll.clear();
 	n_added_roll = 0;
 }
 
 
 ChContactContainer::~ChContactContainer ()
 {
-	std::list<ChContact*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
-	{
-		delete (*itercontact);
-		(*itercontact) = 0;
-		++itercontact;
-		//contactlist.erase(itercontact); //no! do later with clear(), all together
-	}
-	contactlist.clear();
-
-	lastcontact = contactlist.begin();
-	n_added = 0;
-
-
-	std::list<ChContactRolling*>::iterator itercontact_roll = contactlist_roll.begin();
-	while(itercontact_roll != contactlist_roll.end())
-	{
-		delete (*itercontact_roll);
-		(*itercontact_roll) = 0;
-		++itercontact_roll;
-	}
-	contactlist_roll.clear();
-
-	lastcontact_roll = contactlist_roll.begin();
-	n_added_roll = 0;
+	// contact objects are deleted by the pools
 }
 
 
@@ -98,55 +72,29 @@ void ChContactContainer::Update (double mytime)
 
 void ChContactContainer::RemoveAllContacts()
 {
-	std::list<ChContact*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
-	{
-		delete (*itercontact);
-		(*itercontact) = 0;
-		++itercontact;
-		//contactlist.erase(itercontact); //no! do later with clear(), all together
-	}
-	contactlist.clear();
-
-	lastcontact = contactlist.begin();
+	contactlist.Clear();
 	n_added = 0;
 
-	std::list<ChContactRolling*>::iterator itercontact_roll = contactlist_roll.begin();
-	while(itercontact_roll != contactlist_roll.end())
-	{
-		delete (*itercontact_roll);
-		(*itercontact_roll) = 0;
-		++itercontact_roll;
-	}
-	contactlist_roll.clear();
-
-	lastcontact_roll = contactlist_roll.begin();
+	contactlist_roll.Clear();
 	n_added_roll = 0;
 }
 
 
 void ChContactContainer::BeginAddContact()
 {
-	lastcontact = contactlist.begin();
+	contactlist.Rewind();
 	n_added = 0;
 
-	lastcontact_roll = contactlist_roll.begin();
+	contactlist_roll.Rewind();
 	n_added_roll = 0;
 }
 
 void ChContactContainer::EndAddContact()
 {
-	// remove contacts that are beyond last contact
-	while (lastcontact != contactlist.end())
-	{
-		delete (*lastcontact);
-		lastcontact = contactlist.erase(lastcontact);
-	}
-	while (lastcontact_roll != contactlist_roll.end())
-	{
-		delete (*lastcontact_roll);
-		lastcontact_roll = contactlist_roll.erase(lastcontact_roll);
-	}
+	// release the memory of contacts only if much less contacts have been
+	// used for many steps, not to reallocate it when the number fluctuates
+	contactlist.EndFill();
+	contactlist_roll.EndFill();
 }
 
 
@@ -233,72 +181,32 @@ void ChContactContainer::AddContact(const collision::ChCollisionInfo& mcontact)
 
 	if ((mat.rolling_friction == 0) && (mat.spinning_friction == 0))
 	{
-		if (lastcontact != contactlist.end())
-		{
-			// reuse old contacts
-			(*lastcontact)->Reset(		  mcontact.modelA,
-										  mcontact.modelB,
-										  varA, varB,
-										  frameA, frameB,
-										  mcontact.vpA, 
-										  mcontact.vpB, 
-										  mcontact.vN,
-										  mcontact.distance, 
-										  mcontact.reaction_cache,
-										  mat);
-			lastcontact++;
-		}
-		else
-		{
-			// add new contact
-			ChContact* mc = new ChContact(mcontact.modelA,
-										  mcontact.modelB,
-										  varA, varB,
-										  frameA, frameB,
-										  mcontact.vpA, 
-										  mcontact.vpB, 
-										  mcontact.vN,
-										  mcontact.distance, 
-										  mcontact.reaction_cache,
-										  mat);
-			contactlist.push_back(mc);
-			lastcontact = contactlist.end();
-		}
+		// reuse old contacts if possible, otherwise a new chunk of contacts is allocated
+		contactlist.Next()->Reset(mcontact.modelA,
+								  mcontact.modelB,
+								  varA, varB,
+								  frameA, frameB,
+								  mcontact.vpA, 
+								  mcontact.vpB, 
+								  mcontact.vN,
+								  mcontact.distance, 
+								  mcontact.reaction_cache,
+								  mat);
 		n_added++;
 	}
 	else
 	{
-		if (lastcontact_roll != contactlist_roll.end())
-		{
-			// reuse old rolling contacts
-			(*lastcontact_roll)->Reset(	  mcontact.modelA,
-										  mcontact.modelB,
-										  varA, varB,
-										  frameA, frameB,
-										  mcontact.vpA, 
-										  mcontact.vpB, 
-										  mcontact.vN,
-										  mcontact.distance, 
-										  mcontact.reaction_cache,
-										  mat);
-			lastcontact_roll++;
-		}
-		else
-		{
-			// add new contact
-			ChContactRolling* mc = new ChContactRolling(mcontact.modelA,
-										  mcontact.modelB,
-										  varA, varB,
-										  frameA, frameB,
-										  mcontact.vpA, 
-										  mcontact.vpB, 
-										  mcontact.vN,
-										  mcontact.distance, 
-										  mcontact.reaction_cache,
-										  mat);
-			contactlist_roll.push_back(mc);
-			lastcontact_roll = contactlist_roll.end();
-		}
+		// reuse old rolling contacts if possible, otherwise a new chunk of contacts is allocated
+		contactlist_roll.Next()->Reset(mcontact.modelA,
+								  mcontact.modelB,
+								  varA, varB,
+								  frameA, frameB,
+								  mcontact.vpA, 
+								  mcontact.vpB, 
+								  mcontact.vN,
+								  mcontact.distance, 
+								  mcontact.reaction_cache,
+								  mat);
 		n_added_roll ++;
 	}
 
@@ -309,42 +217,40 @@ void ChContactContainer::AddContact(const collision::ChCollisionInfo& mcontact)
 
 void ChContactContainer::ReportAllContacts(ChReportContactCallback* mcallback)
 {
-	std::list<ChContact*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
+	for (int ic = 0; ic < n_added; ++ic)
 	{
+		ChContact& mc = contactlist[ic];
 		bool proceed = mcallback->ReportContactCallback(
-					(*itercontact)->GetContactP1(),
-					(*itercontact)->GetContactP2(),
-					*(*itercontact)->GetContactPlane(),
-					(*itercontact)->GetContactDistance(),
-					(*itercontact)->GetFriction(),
-					(*itercontact)->GetContactForce(),
+					mc.GetContactP1(),
+					mc.GetContactP2(),
+					*mc.GetContactPlane(),
+					mc.GetContactDistance(),
+					mc.GetFriction(),
+					mc.GetContactForce(),
 					VNULL, // no react torques
-					(*itercontact)->GetModelA(), 
-					(*itercontact)->GetModelB()  
+					mc.GetModelA(), 
+					mc.GetModelB()  
 					);
 		if (!proceed) 
 			break;
-		++itercontact;
 	}
 
-	std::list<ChContactRolling*>::iterator itercontact_roll = contactlist_roll.begin();
-	while(itercontact_roll != contactlist_roll.end())
+	for (int ic = 0; ic < n_added_roll; ++ic)
 	{
+		ChContactRolling& mc = contactlist_roll[ic];
 		bool proceed = mcallback->ReportContactCallback(
-					(*itercontact_roll)->GetContactP1(),
-					(*itercontact_roll)->GetContactP2(),
-					*(*itercontact_roll)->GetContactPlane(),
-					(*itercontact_roll)->GetContactDistance(),
-					(*itercontact_roll)->GetFriction(),
-					(*itercontact_roll)->GetContactForce(),
-					(*itercontact_roll)->GetContactTorque(),
-					(*itercontact_roll)->GetModelA(), 
-					(*itercontact_roll)->GetModelB()  
+					mc.GetContactP1(),
+					mc.GetContactP2(),
+					*mc.GetContactPlane(),
+					mc.GetContactDistance(),
+					mc.GetFriction(),
+					mc.GetContactForce(),
+					mc.GetContactTorque(),
+					mc.GetModelA(), 
+					mc.GetModelB()  
 					);
 		if (!proceed) 
 			break;
-		++itercontact_roll;
 	}
 }
 
@@ -354,50 +260,26 @@ void ChContactContainer::ReportAllContacts(ChReportContactCallback* mcallback)
 
 void ChContactContainer::InjectConstraints(ChLcpSystemDescriptor& mdescriptor)
 {
-	std::list<ChContact*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
-	{
-		(*itercontact)->InjectConstraints(mdescriptor);
-		++itercontact;
-	}
-	std::list<ChContactRolling*>::iterator itercontact_roll = contactlist_roll.begin();
-	while(itercontact_roll != contactlist_roll.end())
-	{
-		(*itercontact_roll)->InjectConstraints(mdescriptor);
-		++itercontact_roll;
-	}
+	for (int ic = 0; ic < n_added; ++ic)
+		contactlist[ic].InjectConstraints(mdescriptor);
+	for (int ic = 0; ic < n_added_roll; ++ic)
+		contactlist_roll[ic].InjectConstraints(mdescriptor);
 }
 
 void ChContactContainer::ConstraintsBiReset()
 {
-	std::list<ChContact*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
-	{
-		(*itercontact)->ConstraintsBiReset();
-		++itercontact;
-	}
-	std::list<ChContactRolling*>::iterator itercontact_roll = contactlist_roll.begin();
-	while(itercontact_roll != contactlist_roll.end())
-	{
-		(*itercontact_roll)->ConstraintsBiReset();
-		++itercontact_roll;
-	}
+	for (int ic = 0; ic < n_added; ++ic)
+		contactlist[ic].ConstraintsBiReset();
+	for (int ic = 0; ic < n_added_roll; ++ic)
+		contactlist_roll[ic].ConstraintsBiReset();
 }
  
 void ChContactContainer::ConstraintsBiLoad_C(double factor, double recovery_clamp, bool do_clamp)
 {
-	std::list<ChContact*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
-	{
-		(*itercontact)->ConstraintsBiLoad_C(factor, recovery_clamp, do_clamp);
-		++itercontact;
-	}
-	std::list<ChContactRolling*>::iterator itercontact_roll = contactlist_roll.begin();
-	while(itercontact_roll != contactlist_roll.end())
-	{
-		(*itercontact_roll)->ConstraintsBiLoad_C(factor, recovery_clamp, do_clamp);
-		++itercontact_roll;
-	}
+	for (int ic = 0; ic < n_added; ++ic)
+		contactlist[ic].ConstraintsBiLoad_C(factor, recovery_clamp, do_clamp);
+	for (int ic = 0; ic < n_added_roll; ++ic)
+		contactlist_roll[ic].ConstraintsBiLoad_C(factor, recovery_clamp, do_clamp);
 }
 
 
@@ -410,18 +292,10 @@ void ChContactContainer::ConstraintsLoadJacobians()
 void ChContactContainer::ConstraintsFetch_react(double factor)
 {
 	// From constraints to react vector:
-	std::list<ChContact*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
-	{
-		(*itercontact)->ConstraintsFetch_react(factor);
-		++itercontact;
-	}
-	std::list<ChContactRolling*>::iterator itercontact_roll = contactlist_roll.begin();
-	while(itercontact_roll != contactlist_roll.end())
-	{
-		(*itercontact_roll)->ConstraintsFetch_react(factor);
-		++itercontact_roll;
-	}
+	for (int ic = 0; ic < n_added; ++ic)
+		contactlist[ic].ConstraintsFetch_react(factor);
+	for (int ic = 0; ic < n_added_roll; ++ic)
+		contactlist_roll[ic].ConstraintsFetch_react(factor);
 }
 
 
@@ -432,72 +306,40 @@ void  ChContactContainer::ConstraintsLiLoadSuggestedSpeedSolution()
 {
 	// Fetch the last computed impulsive reactions from the persistent contact manifold (could
 	// be used for warm starting the CCP speed solver):
-	std::list<ChContact*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
-	{
-		(*itercontact)->ConstraintsLiLoadSuggestedSpeedSolution();
-		++itercontact;
-	}
-	std::list<ChContactRolling*>::iterator itercontact_roll = contactlist_roll.begin();
-	while(itercontact_roll != contactlist_roll.end())
-	{
-		(*itercontact_roll)->ConstraintsLiLoadSuggestedSpeedSolution();
-		++itercontact_roll;
-	}
+	for (int ic = 0; ic < n_added; ++ic)
+		contactlist[ic].ConstraintsLiLoadSuggestedSpeedSolution();
+	for (int ic = 0; ic < n_added_roll; ++ic)
+		contactlist_roll[ic].ConstraintsLiLoadSuggestedSpeedSolution();
 }
 
 void  ChContactContainer::ConstraintsLiLoadSuggestedPositionSolution()
 {
 	// Fetch the last computed 'positional' reactions from the persistent contact manifold (could
 	// be used for warm starting the CCP position stabilization solver):
-	std::list<ChContact*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
-	{
-		(*itercontact)->ConstraintsLiLoadSuggestedPositionSolution();
-		++itercontact;
-	}
-	std::list<ChContactRolling*>::iterator itercontact_roll = contactlist_roll.begin();
-	while(itercontact_roll != contactlist_roll.end())
-	{
-		(*itercontact_roll)->ConstraintsLiLoadSuggestedPositionSolution();
-		++itercontact_roll;
-	}
+	for (int ic = 0; ic < n_added; ++ic)
+		contactlist[ic].ConstraintsLiLoadSuggestedPositionSolution();
+	for (int ic = 0; ic < n_added_roll; ++ic)
+		contactlist_roll[ic].ConstraintsLiLoadSuggestedPositionSolution();
 }
 
 void  ChContactContainer::ConstraintsLiFetchSuggestedSpeedSolution()
 {
 	// Store the last computed reactions into the persistent contact manifold (might
 	// be used for warm starting CCP the speed solver):
-	std::list<ChContact*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
-	{
-		(*itercontact)->ConstraintsLiFetchSuggestedSpeedSolution();
-		++itercontact;
-	}
-	std::list<ChContactRolling*>::iterator itercontact_roll = contactlist_roll.begin();
-	while(itercontact_roll != contactlist_roll.end())
-	{
-		(*itercontact_roll)->ConstraintsLiFetchSuggestedSpeedSolution();
-		++itercontact_roll;
-	}
+	for (int ic = 0; ic < n_added; ++ic)
+		contactlist[ic].ConstraintsLiFetchSuggestedSpeedSolution();
+	for (int ic = 0; ic < n_added_roll; ++ic)
+		contactlist_roll[ic].ConstraintsLiFetchSuggestedSpeedSolution();
 }
 
 void  ChContactContainer::ConstraintsLiFetchSuggestedPositionSolution()
 {
 	// Store the last computed 'positional' reactions into the persistent contact manifold (might
 	// be used for warm starting the CCP position stabilization solver):
-	std::list<ChContact*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
-	{
-		(*itercontact)->ConstraintsLiFetchSuggestedPositionSolution();
-		++itercontact;
-	}
-	std::list<ChContactRolling*>::iterator itercontact_roll = contactlist_roll.begin();
-	while(itercontact_roll != contactlist_roll.end())
-	{
-		(*itercontact_roll)->ConstraintsLiFetchSuggestedPositionSolution();
-		++itercontact_roll;
-	}
+	for (int ic = 0; ic < n_added; ++ic)
+		contactlist[ic].ConstraintsLiFetchSuggestedPositionSolution();
+	for (int ic = 0; ic < n_added_roll; ++ic)
+		contactlist_roll[ic].ConstraintsLiFetchSuggestedPositionSolution();
 }
 
 
@@ -34,7 +34,7 @@
 #include "physics/ChContactContainerBase.h"
 #include "physics/ChContact.h"
 #include "physics/ChContactRolling.h"
-#include <list>
+#include "core/ChChunkedPool.h"
 
 namespace chrono
 {
@@ -42,8 +42,10 @@ namespace chrono
 
 ///
 /// Class representing a container of many contacts, 
-/// implemented as a typical linked list of ChContact 
-/// objects (that is, contacts between two 6DOF bodies).
+/// implemented as a pool of ChContact objects (that is, 
+/// contacts between two 6DOF bodies), allocated in chunks
+/// and reused from step to step, so that no memory is 
+/// allocated when the number of contacts is steady.
 /// It also contains rolling contact objects, if needed.
 /// This is the default contact container used in most
 /// cases.
@@ -58,19 +60,15 @@ protected:
 	  			// DATA
 				//
 
-	std::list<ChContact*>   contactlist; 
+	ChChunkedPool<ChContact>   contactlist; 
 
 	int n_added;
 
-	std::list<ChContact*>::iterator lastcontact;
 
-
-	std::list<ChContactRolling*>   contactlist_roll; 
+	ChChunkedPool<ChContactRolling>   contactlist_roll; 
 
 	int n_added_roll;
 
-	std::list<ChContactRolling*>::iterator lastcontact_roll;
-
 public:
 				//
 	  			// CONSTRUCTORS
@@ -87,17 +85,22 @@ public:
 					/// Tell the number of added contacts
 	virtual int GetNcontacts  () {return n_added + n_added_roll;}
 
-					/// Return the contact List
-	virtual std::list<ChContact*> & GetContactList() {return contactlist;}
+					/// Return the pool of (non-rolling) contacts. Use it only to
+					/// enumerate contacts, from 0 to GetContactList().Size()-1.
+	virtual ChChunkedPool<ChContact>& GetContactList() {return contactlist;}
+
+					/// Return the pool of rolling contacts. Use it only to
+					/// enumerate contacts, from 0 to GetContactListRolling().Size()-1.
+	virtual ChChunkedPool<ChContactRolling>& GetContactListRolling() {return contactlist_roll;}
 
 					/// Remove (delete) all contained contact data.
 	virtual void RemoveAllContacts();
 
 					/// The collision system will call BeginAddContact() before adding
 					/// all contacts (for example with AddContact() or similar). Instead of
-					/// simply deleting all list of the previous contacts, this optimized implementation
-					/// rewinds the link iterator to begin and tries to reuse previous contact objects
-					/// until possible, to avoid too much allocation/deallocation.
+					/// simply deleting all the previous contacts, this optimized implementation
+					/// rewinds the pools and reuses previous contact objects until possible, 
+					/// to avoid too much allocation/deallocation.
 	virtual void BeginAddContact();
 
 					/// Add a contact between two frames.
@@ -105,7 +108,8 @@ public:
 
 					/// The collision system will call BeginAddContact() after adding
 					/// all contacts (for example with AddContact() or similar). This optimized version
-					/// purges the end of the list of contacts that were not reused (if any).
+					/// frees the chunks of contacts that were not reused, but only after many steps
+					/// with much less contacts than the peak (see ChChunkedPool::EndFill()).
 	virtual void EndAddContact();
 
 					/// Scans all the contacts and for each contact exacutes the ReportContactCallback()
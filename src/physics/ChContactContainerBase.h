@@ -145,6 +145,13 @@ public:
 					/// it does nothing.
 	virtual void EndAddContact() {};
 
+					/// Tell that the contacts of this step are going to be added again,
+					/// because ChSystem repeated part of the collision detection after 
+					/// waking up some bodies. Containers that keep a history of the 
+					/// contacts must not advance it at the next BeginAddContact(). 
+					/// By default it does nothing.
+	virtual void RepeatAddContact() {};
+
 
 
 
@@ -161,6 +168,12 @@ public:
 					/// report all contacts).
 	virtual void ReportAllContacts(ChReportContactCallback* mcallback) =0;
 
+					/// Contacts are not saved in state snapshots (see ChSystem::StateSave()):
+					/// on restore, the current contacts are discarded, because they belong
+					/// to another time, and the collision detection finds them again.
+	virtual void StateSave(ChStateSnapshot& msnapshot) {};
+	virtual void StateRestore(ChStateSnapshot& msnapshot) { RemoveAllContacts(); }
+
 };
 
 
@@ -20,10 +20,15 @@
 ///////////////////////////////////////////////////
  
   
+#include <limits.h>
+#include <algorithm>
+#include <map>
+
 #include "physics/ChContactContainerDEM.h"
 #include "physics/ChSystem.h"
 #include "physics/ChIndexedNodes.h"
 #include "physics/ChBodyDEM.h"
+#include "parallel/ChThreadsSync.h"
 #include "collision/ChCModelBulletDEM.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
@@ -47,23 +52,17 @@ ChClassRegister<ChContactContainerDEM> a_registration_ChContactContainerDEM;
 
 ChContactContainerDEM::ChContactContainerDEM ()
 { 
-	contactlist.clear();
 	n_added = 0;
+	history_stamp = 0;
+	use_history = false;
+	history_kept = false;
 
 }
 
 
 ChContactContainerDEM::~ChContactContainerDEM ()
 {
-	std::list<ChContactDEM*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
-	{
-		delete (*itercontact);
-		(*itercontact) = 0;
-		++itercontact;
-		//contactlist.erase(itercontact); //no! do later with clear(), all together
-	}
-	contactlist.clear();
+	// contact objects are deleted by the pool
 }
 
 
@@ -123,53 +122,348 @@ void ChContactContainerDEM::Update (double mytime)
 
 }
 
-void ChContactContainerDEM::ConstraintsFbLoadForces(double factor)
+// Bodies of the parallel loops of ConstraintsFbLoadForces(). The ends of the 
+// contacts (2*contact for body A, 2*contact+1 for body B) are sorted by body 
+// with a counting sort, on a single histogram of the bodies: counts[i] is the 
+// number of ends of the i-th body, then the position of the next of them in the 
+// sorted ends. With many threads, the counts are incremented atomically.
+
+class ChContactContainerDEMIndexBodies : public ChTaskPoolLoop
 {
-	ChContactDEM* cntct;
+public:
+	std::vector<ChBody*>* bodies;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			if (ChBodyDEM* mbody = dynamic_cast<ChBodyDEM*>((*bodies)[i]))
+				mbody->SetLoadIndex(i);
+	}
+};
 
-	std::list<ChContactDEM*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
+class ChContactContainerDEMCountEnds : public ChTaskPoolLoop
+{
+public:
+	ChChunkedPool<ChContactDEM>* contacts;
+	int* counts;
+	int* ends;		// if null, only count the ends, otherwise scatter them
+	bool atomic;	// if the loop runs on many threads
+	virtual void Run(int begin, int end)
 	{
-		cntct = (ChContactDEM*)(*itercontact);
-		if ((cntct->GetContactDistance()<0) )
+		for (int ic = begin; ic < end; ++ic)
 		{
-			(*itercontact)->ConstraintsFbLoadForces(factor);
+			ChContactDEM& cntct = (*contacts)[ic];
+			if (cntct.GetContactDistance() < 0)
+			{
+				int iA = ((ChModelBulletDEM*)cntct.GetModelA())->GetBody()->GetLoadIndex();
+				int iB = ((ChModelBulletDEM*)cntct.GetModelB())->GetBody()->GetLoadIndex();
+				int posA = atomic ? ChAtomicFetchAdd(&counts[iA], 1) : counts[iA]++;
+				int posB = atomic ? ChAtomicFetchAdd(&counts[iB], 1) : counts[iB]++;
+				if (ends)
+				{
+					ends[posA] = 2 * ic;
+					ends[posB] = 2 * ic + 1;
+				}
+			}
+		}
+	}
+};
+
+class ChContactContainerDEMSumCounts : public ChTaskPoolLoop
+{
+public:
+	int nblocks;
+	int nbodies;
+	int* counts;	// turned in the offsets of the bodies at the second pass
+	int* cursors;	// set to the offsets too, at the second pass
+	int* totals;	// the sum of each block, then its offset at the second pass
+	bool second_pass;
+	virtual void Run(int begin, int end)
+	{
+		for (int k = begin; k < end; k++)
+		{
+			int ibegin = (int)(((long long)nbodies * k) / nblocks);
+			int iend   = (int)(((long long)nbodies * (k+1)) / nblocks);
+			if (second_pass)
+			{
+				int msum = totals[k];
+				for (int i = ibegin; i < iend; i++)
+				{
+					int mc = counts[i];
+					counts[i] = msum;
+					cursors[i] = msum;
+					msum += mc;
+				}
+			}
+			else
+			{
+				int msum = 0;
+				for (int i = ibegin; i < iend; i++)
+					msum += counts[i];
+				totals[k] = msum;
+			}
 		}
-		++itercontact;
 	}
+};
+
+class ChContactContainerDEMLoadBodies : public ChTaskPoolLoop
+{
+public:
+	ChChunkedPool<ChContactDEM>* contacts;
+	std::vector<ChBody*>* bodies;
+	const int* offsets;
+	int* ends;
+	bool sort_ends;	// if scattered by many threads, in any order
+	double factor;
+	virtual void Run(int begin, int end)
+	{
+		ChVector<> mforce, mtorque_loc;
+		for (int i = begin; i < end; i++)
+		{
+			if (offsets[i] == offsets[i+1])
+				continue;
+			// the same order whatever the number of threads, so the same sums
+			if (sort_ends)
+				std::sort(ends + offsets[i], ends + offsets[i+1]);
+			// only DEM bodies have contact ends
+			ChMatrix<>& mfb = (*bodies)[i]->Variables().Get_fb();
+			for (int ie = offsets[i]; ie < offsets[i+1]; ie++)
+			{
+				(*contacts)[ends[ie] >> 1].GetBodyLoad((ends[ie] & 1) == 0, factor, mforce, mtorque_loc);
+				mfb.PasteSumVector(mforce, 0, 0);
+				mfb.PasteSumVector(mtorque_loc, 3, 0);
+			}
+		}
+	}
+};
+
+
+void ChContactContainerDEM::ConstraintsFbLoadForces(double factor)
+{
+	ChSystem* msystem = GetSystem();
+	if (!msystem || n_added == 0)
+		return;
+
+	std::vector<ChBody*>* mbodies = msystem->Get_bodylist();
+	int nbodies = (int)mbodies->size();
+
+	// as many threads as pay off, each with a large enough range of contacts
+	int nchunks = 1;
+	if (msystem->GetUseParallelPasses())
+		nchunks = ChMax(1, ChMin(msystem->GetParallelThreadNumber(), n_added / 1024));
+
+	// 1) The DEM bodies are indexed by their position in the body list
+
+	ChContactContainerDEMIndexBodies mindexloop;
+	mindexloop.bodies = mbodies;
+	msystem->RunItemsLoop(nbodies, mindexloop);
+
+	// 2) Count the ends of the contacts per body
+
+	load_offsets.assign(nbodies + 1, 0);
+	load_counts.resize(nbodies);
+
+	ChContactContainerDEMCountEnds mcountloop;
+	mcountloop.contacts = &contactlist;
+	mcountloop.counts = &load_offsets[0];
+	mcountloop.ends = 0;
+	mcountloop.atomic = (nchunks > 1);
+	if (nchunks > 1)
+		msystem->RunItemsLoop(n_added, mcountloop, (n_added + nchunks - 1) / nchunks);
+	else
+		mcountloop.Run(0, n_added);
+
+	// 3) Prefix sum over the bodies, in blocks: the sums of the blocks, 
+	//    then the offsets of the bodies, starting from the offsets of the blocks
+
+	load_blocks.resize(nchunks);
+
+	ChContactContainerDEMSumCounts msumloop;
+	msumloop.nblocks = nchunks;
+	msumloop.nbodies = nbodies;
+	msumloop.counts = &load_offsets[0];
+	msumloop.cursors = &load_counts[0];
+	msumloop.totals = &load_blocks[0];
+	msumloop.second_pass = false;
+	msystem->RunItemsLoop(nchunks, msumloop, 1);
+
+	int nends = 0;
+	for (int k = 0; k < nchunks; k++)
+	{
+		int mtotal = load_blocks[k];
+		load_blocks[k] = nends;
+		nends += mtotal;
+	}
+	load_offsets[nbodies] = nends;
+	if (nends == 0)
+		return;
+
+	msumloop.second_pass = true;
+	msystem->RunItemsLoop(nchunks, msumloop, 1);
+
+	// 4) Scatter the ends of the contacts: in contact order with one thread,
+	//    otherwise in any order, sorted per body at the next pass
+
+	load_ends.resize(nends);
+	mcountloop.counts = &load_counts[0];
+	mcountloop.ends = &load_ends[0];
+	if (nchunks > 1)
+		msystem->RunItemsLoop(n_added, mcountloop, (n_added + nchunks - 1) / nchunks);
+	else
+		mcountloop.Run(0, n_added);
+
+	// 5) Each body gathers its forces: no two threads write the same body.
+
+	ChContactContainerDEMLoadBodies mloop;
+	mloop.contacts = &contactlist;
+	mloop.bodies = mbodies;
+	mloop.offsets = &load_offsets[0];
+	mloop.ends = &load_ends[0];
+	mloop.sort_ends = (nchunks > 1);
+	mloop.factor = factor;
+	msystem->RunItemsLoop(nbodies, mloop);
 }
 
 void ChContactContainerDEM::RemoveAllContacts()
 {
-	std::list<ChContactDEM*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
+	contactlist.Clear();
+	n_added = 0;
+	history.clear();
+	history_kept = false;
+}
+
+
+static inline size_t ChHashContactKey(collision::ChCollisionModel* modA, collision::ChCollisionModel* modB, int featureA, int featureB)
+{
+	size_t h = ((size_t)modA >> 3) * 2654435761u;
+	h ^= ((size_t)modB >> 3) + 0x9e3779b9 + (h << 6) + (h >> 2);
+	h ^= (size_t)featureA + 0x9e3779b9 + (h << 6) + (h >> 2);
+	h ^= (size_t)featureB + 0x9e3779b9 + (h << 6) + (h >> 2);
+	return h;
+}
+
+
+void ChContactContainerDEM::ResetHistory(int nentries)
+{
+	// a new stamp empties the table
+	history_stamp++;
+
+	// keep the load factor below 1/2, with a power of two size
+	size_t msize = history.size();
+	if (msize < 64 || msize < 2 * (size_t)nentries || history_stamp == INT_MAX)
 	{
-		delete (*itercontact);
-		(*itercontact) = 0;
-		++itercontact;
-		//contactlist.erase(itercontact); //no! do later with clear(), all together
+		if (msize < 64)
+			msize = 64;
+		while (msize < 2 * (size_t)nentries)
+			msize *= 2;
+		HistoryEntry empty;
+		empty.stamp = 0;
+		empty.claimed = 0;
+		history.assign(msize, empty);
+		history_stamp = 1;
 	}
-	contactlist.clear();
+}
 
-	lastcontact = contactlist.begin();
-	n_added = 0;
+
+void ChContactContainerDEM::InsertHistory(const HistoryEntry& mentry)
+{
+	size_t mmask = history.size() - 1;
+	size_t ih = ChHashContactKey(mentry.modA, mentry.modB, mentry.featureA, mentry.featureB) & mmask;
+	while (history[ih].stamp == history_stamp)
+		ih = (ih + 1) & mmask;
+	HistoryEntry& entry = history[ih];
+	entry.modA = mentry.modA;
+	entry.modB = mentry.modB;
+	entry.featureA = mentry.featureA;
+	entry.featureB = mentry.featureB;
+	entry.stamp = history_stamp;
+	entry.pointA = mentry.pointA;
+	entry.tangential_displacement = mentry.tangential_displacement;
+}
+
+
+void ChContactContainerDEM::StoreHistory()
+{
+	ResetHistory(n_added);
+
+	HistoryEntry mentry;
+	for (int ic = 0; ic < n_added; ++ic)
+	{
+		ChContactDEM& cntct = contactlist[ic];
+		mentry.modA = cntct.GetModelA();
+		mentry.modB = cntct.GetModelB();
+		mentry.featureA = cntct.GetFeatureA();
+		mentry.featureB = cntct.GetFeatureB();
+		mentry.pointA = cntct.GetContactP1local();
+		mentry.tangential_displacement = cntct.GetTangentialDisplacement();
+		InsertHistory(mentry);
+	}
+}
+
+
+const ChVector<>* ChContactContainerDEM::FindHistory(const collision::ChCollisionInfo& mcontact, const ChVector<>& mpointA)
+{
+	if (history.empty())
+		return 0;
+	size_t mmask = history.size() - 1;
+	size_t ih = ChHashContactKey(mcontact.modelA, mcontact.modelB, mcontact.featureA, mcontact.featureB) & mmask;
+
+	// Models can touch in more points with the same features (ex. two boxes),
+	// and the collision detection does not keep the order of these points:
+	// the nearest one, in the frame of A, is claimed.
+	HistoryEntry* best = 0;
+	double best_dist = 0;
+	while (history[ih].stamp == history_stamp)
+	{
+		HistoryEntry& entry = history[ih];
+		if (entry.claimed != history_stamp &&
+			entry.modA == mcontact.modelA &&
+			entry.modB == mcontact.modelB &&
+			entry.featureA == mcontact.featureA &&
+			entry.featureB == mcontact.featureB)
+		{
+			double dist = (entry.pointA - mpointA).Length2();
+			if (!best || dist < best_dist)
+			{
+				best = &entry;
+				best_dist = dist;
+			}
+		}
+		ih = (ih + 1) & mmask;
+	}
+	if (!best)
+		return 0;
+	best->claimed = history_stamp;
+	return &best->tangential_displacement;
 }
 
 
 void ChContactContainerDEM::BeginAddContact()
 {
-	lastcontact = contactlist.begin();
+	if (use_history && !history_kept)
+		StoreHistory();
+	history_kept = false;
+
+	contactlist.Rewind();
 	n_added = 0;
 }
 
+void ChContactContainerDEM::RepeatAddContact()
+{
+	if (!use_history)
+		return;
+
+	// the entries claimed by the contacts that are replaced are free again
+	for (size_t ih = 0; ih < history.size(); ih++)
+		if (history[ih].claimed == history_stamp)
+			history[ih].claimed = 0;
+	history_kept = true;
+}
+
 void ChContactContainerDEM::EndAddContact()
 {
-	// remove contacts that are beyond last contact
-	while (lastcontact != contactlist.end())
-	{
-		delete (*lastcontact);
-		lastcontact = contactlist.erase(lastcontact);
-	}
+	// release the memory of contacts only if much less contacts have been
+	// used for many steps, not to reallocate it when the number fluctuates
+	contactlist.EndFill();
 }
 
 
@@ -233,72 +527,147 @@ void ChContactContainerDEM::AddContact(const collision::ChCollisionInfo& mcontac
 
 		// %%%%%%% Create and add a ChContact object  %%%%%%%
 
-		if (lastcontact != contactlist.end())
+		const ChVector<>* mhistory = use_history ? FindHistory(mcontact, frameA->TrasformParentToLocal(mcontact.vpA)) : 0;
+
+		// reuse old contacts if possible, otherwise a new chunk of contacts is allocated
+		ChContactDEM* cntct = contactlist.Next();
+		cntct->SetFeatures(mcontact.featureA, mcontact.featureB);
+		cntct->Reset(mcontact.modelA,
+								  mcontact.modelB,
+								  varA, varB,
+								  frameA, frameB,
+								  mcontact.vpA, 
+								  mcontact.vpB, 
+								  mcontact.vN,
+								  mcontact.distance, 
+								  mcontact.reaction_cache,
+								  kn_eff,
+								  gn_eff,
+								  kt_eff,
+								  mu_eff,
+								  mhistory);
+		n_added++;
+	}
+	
+}
+
+
+
+// Append a history entry to a snapshot, with the bodies as indexes in
+// the system, unless a body is not in the body list of the system.
+
+static bool ChStateSaveHistory(ChStateSnapshot& msnapshot, std::map<ChBody*, int>& mbodyindex,
+							   collision::ChCollisionModel* modA, collision::ChCollisionModel* modB,
+							   int featureA, int featureB,
+							   const ChVector<>& pointA, const ChVector<>& tangential_displacement)
+{
+	std::map<ChBody*, int>::iterator iA = mbodyindex.find(((ChModelBulletDEM*)modA)->GetBody());
+	std::map<ChBody*, int>::iterator iB = mbodyindex.find(((ChModelBulletDEM*)modB)->GetBody());
+	if (iA == mbodyindex.end() || iB == mbodyindex.end())
+		return false;
+	msnapshot.Add(iA->second);
+	msnapshot.Add(iB->second);
+	msnapshot.Add(featureA);
+	msnapshot.Add(featureB);
+	msnapshot.Add(pointA);
+	msnapshot.Add(tangential_displacement);
+	return true;
+}
+
+void ChContactContainerDEM::StateSave(ChStateSnapshot& msnapshot)
+{
+	int mcount = msnapshot.Reserve();
+	int nsaved = 0;
+
+	if (use_history && GetSystem())
+	{
+		std::map<ChBody*, int> mbodyindex;
+		std::vector<ChBody*>* mbodies = GetSystem()->Get_bodylist();
+		for (unsigned int i = 0; i < mbodies->size(); i++)
+			mbodyindex[(*mbodies)[i]] = i;
+
+		// the history of the next step: the current contacts, or the
+		// table itself if it was just restored and not used yet
+		if (history_kept)
 		{
-			// reuse old contacts
-			(*lastcontact)->Reset(		  mcontact.modelA,
-										  mcontact.modelB,
-										  varA, varB,
-										  frameA, frameB,
-										  mcontact.vpA, 
-										  mcontact.vpB, 
-										  mcontact.vN,
-										  mcontact.distance, 
-										  mcontact.reaction_cache,
-										  kn_eff,
-										  gn_eff,
-										  kt_eff,
-										  mu_eff);
-			lastcontact++;
+			for (unsigned int ih = 0; ih < history.size(); ih++)
+			{
+				HistoryEntry& entry = history[ih];
+				if (entry.stamp == history_stamp &&
+					ChStateSaveHistory(msnapshot, mbodyindex, entry.modA, entry.modB, entry.featureA, entry.featureB,
+									   entry.pointA, entry.tangential_displacement))
+					nsaved++;
+			}
 		}
 		else
 		{
-			// add new contact
-			ChContactDEM* mc = new ChContactDEM(mcontact.modelA,
-											  mcontact.modelB,
-											  varA, varB,
-											  frameA, frameB,
-											  mcontact.vpA,
-											  mcontact.vpB,
-											  mcontact.vN,
-											  mcontact.distance,
-											  mcontact.reaction_cache,
-											  kn_eff,
-											  gn_eff,
-											  kt_eff,
-											  mu_eff);
-			contactlist.push_back(mc);
-			lastcontact = contactlist.end();
+			for (int ic = 0; ic < n_added; ++ic)
+			{
+				ChContactDEM& cntct = contactlist[ic];
+				if (ChStateSaveHistory(msnapshot, mbodyindex, cntct.GetModelA(), cntct.GetModelB(), cntct.GetFeatureA(), cntct.GetFeatureB(),
+									   cntct.GetContactP1local(), cntct.GetTangentialDisplacement()))
+					nsaved++;
+			}
 		}
-		ChModelBulletDEM* mmboA = dynamic_cast<ChModelBulletDEM*>(mcontact.modelA);
-		n_added++;
 	}
-	
+
+	msnapshot.SetAt(mcount, nsaved);
+}
+
+void ChContactContainerDEM::StateRestore(ChStateSnapshot& msnapshot)
+{
+	contactlist.Rewind();
+	n_added = 0;
+	history.clear();
+	history_kept = false;
+
+	int nsaved = (int)msnapshot.Get();
+	if (nsaved == 0)
+		return;
+	if (!GetSystem())
+		throw ChException("The state snapshot does not match the system");
+
+	std::vector<ChBody*>* mbodies = GetSystem()->Get_bodylist();
+	ResetHistory(nsaved);
+	HistoryEntry mentry;
+	for (int i = 0; i < nsaved; i++)
+	{
+		int iA = (int)msnapshot.Get();
+		int iB = (int)msnapshot.Get();
+		if (iA < 0 || iB < 0 || iA >= (int)mbodies->size() || iB >= (int)mbodies->size())
+			throw ChException("The state snapshot does not match the system");
+		mentry.modA = (*mbodies)[iA]->GetCollisionModel();
+		mentry.modB = (*mbodies)[iB]->GetCollisionModel();
+		mentry.featureA = (int)msnapshot.Get();
+		mentry.featureB = (int)msnapshot.Get();
+		msnapshot.Get(mentry.pointA);
+		msnapshot.Get(mentry.tangential_displacement);
+		InsertHistory(mentry);
+	}
+	history_kept = true;
 }
 
 
 
 void ChContactContainerDEM::ReportAllContacts(ChReportContactCallback* mcallback)
 {
-	std::list<ChContactDEM*>::iterator itercontact = contactlist.begin();
-	while(itercontact != contactlist.end())
+	for (int ic = 0; ic < n_added; ++ic)
 	{
+		ChContactDEM& mc = contactlist[ic];
 		bool proceed = mcallback->ReportContactCallback(
-					(*itercontact)->GetContactP1(),
-					(*itercontact)->GetContactP2(),
-					*(*itercontact)->GetContactPlane(),
-					(*itercontact)->GetContactDistance(),
+					mc.GetContactP1(),
+					mc.GetContactP2(),
+					*mc.GetContactPlane(),
+					mc.GetContactDistance(),
 					0.0,
-					(*itercontact)->GetContactForce(),
+					mc.GetContactForce(),
 					VNULL, // no react torques
-					(*itercontact)->GetModelA(), 
-					(*itercontact)->GetModelB()  
+					mc.GetModelA(), 
+					mc.GetModelB()  
 					);
 		if (!proceed) 
 			break;
-		++itercontact;
 	}
-
 }
 
 
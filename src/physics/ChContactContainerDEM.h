@@ -17,7 +17,7 @@
 //   ChContactContainerDEM.h
 //
 //   Class for container of many contacts, as CPU
-//   typical linked list of ChContactDEM objects
+//   pool of ChContactDEM objects
 //
 //   HEADER file for CHRONO,
 //	 Multibody dynamics engine
@@ -31,16 +31,27 @@
 
 #include "physics/ChContactContainerBase.h"
 #include "physics/ChContactDEM.h"
-#include <list>
+#include "core/ChChunkedPool.h"
 
 namespace chrono
 {
 
+class ChBodyDEM;
+
 
 ///
 /// Class representing a container of many contacts, 
-/// implemented as a typical linked list of ChContactNode
-/// objects (contacts between 3DOF nodes and 6DOF bodies)
+/// implemented as a pool of ChContactDEM objects (penalty
+/// contacts between two DEM bodies), allocated in chunks
+/// and reused from step to step, so that no memory is 
+/// allocated when the number of contacts is steady.
+/// If contact history is used, the tangential displacement of 
+/// each contact is carried to the next step, in a hash table 
+/// keyed by the two collision models and the features in contact,
+/// so the tangential springs keep their elongation while the 
+/// contact lasts (as needed by Hertz-Mindlin models). If two models
+/// touch in more points with the same features, each contact takes
+/// the history of the nearest point of the last step.
 ///
 
 class ChApi ChContactContainerDEM : public ChContactContainerBase {
@@ -52,11 +63,46 @@ protected:
 	  			// DATA
 				//
 
-	std::list<ChContactDEM*>   contactlist; 
+	ChChunkedPool<ChContactDEM>   contactlist; 
 
 	int n_added;
 
-	std::list<ChContactDEM*>::iterator lastcontact;
+						// Open addressing hash table with linear probing, with
+						// the tangential displacements of the contacts of the last
+						// step. A slot is used if its stamp is the current one, so
+						// the table is emptied by incrementing history_stamp.
+	struct HistoryEntry
+	{
+		collision::ChCollisionModel* modA;
+		collision::ChCollisionModel* modB;
+		int featureA;
+		int featureB;
+		int stamp;			// slot is used if == history_stamp
+		int claimed;		// already used by a contact if == history_stamp
+		ChVector<> pointA;	// contact point in the frame of A
+		ChVector<> tangential_displacement;
+	};
+	std::vector<HistoryEntry> history;
+	int history_stamp;
+	bool use_history;
+	bool history_kept;	// the table comes from StateRestore() or RepeatAddContact(), keep it at the next step
+
+	void ResetHistory(int nentries);
+	void InsertHistory(const HistoryEntry& mentry);
+	void StoreHistory();
+	const ChVector<>* FindHistory(const collision::ChCollisionInfo& mcontact, const ChVector<>& mpointA);
+
+						// The ends of the contacts (2*contact for body A, 2*contact+1 
+						// for body B) sorted by body, for the reduction of the forces:
+						// the ends of the i-th body of the system are from load_offsets[i] 
+						// to load_offsets[i+1]-1, load_counts are the positions of the next
+						// ends of the bodies while scattering, load_blocks the offsets of
+						// the blocks of bodies of the prefix sum.
+						// Rebuilt by ConstraintsFbLoadForces().
+	std::vector<int> load_counts;
+	std::vector<int> load_blocks;
+	std::vector<int> load_offsets;
+	std::vector<int> load_ends;
 
 
 public:
@@ -73,11 +119,19 @@ public:
 	  			// FUNCTIONS
 				//
 
-					/// Gets the list of contacts -low level function-.
-					/// NOTE! use this list only to enumerate etc., but NOT to
-					/// remove or add items (use the appropriate Remove.. and Add..
-					/// functions instead!)
-	std::list<ChContactDEM*>* Get_contactlist() {return &contactlist;}
+					/// Gets the pool of contacts -low level function-.
+					/// NOTE! use this only to enumerate contacts, from 0 to 
+					/// Size()-1, but NOT to add items (use the appropriate 
+					/// Remove.. and Add.. functions instead!)
+	ChChunkedPool<ChContactDEM>* Get_contactlist() {return &contactlist;}
+
+					/// Enable the contact history: the tangential displacement of
+					/// each contact is kept from step to step, as long as the contact
+					/// persists, so that the tangential springs can hold static friction.
+					/// If disabled (default), the tangential force only depends on the
+					/// slip of the current step.
+	void SetUseContactHistory(bool mh) {use_history = mh;}
+	bool GetUseContactHistory() {return use_history;}
 
 					/// Tell the number of added contacts
 	virtual int GetNcontacts  () {return n_added;};
@@ -87,9 +141,10 @@ public:
 
 					/// The collision system will call BeginAddContact() before adding
 					/// all contacts (for example with AddContact() or similar). Instead of
-					/// simply deleting all list of the previous contacts, this optimized implementation
-					/// rewinds the link iterator to begin and tries to reuse previous contact objects
-					/// until possible, to avoid too much allocation/deallocation.
+					/// simply deleting all the previous contacts, this optimized implementation
+					/// rewinds the pool and reuses previous contact objects until possible, 
+					/// to avoid too much allocation/deallocation. If contact history is
+					/// used, the previous contacts are stored in the history table first.
 	virtual void BeginAddContact();
 
 					/// Add a contact between two frames.
@@ -97,9 +152,14 @@ public:
 
 					/// The collision system will call BeginAddContact() after adding
 					/// all contacts (for example with AddContact() or similar). This optimized version
-					/// purges the end of the list of contacts that were not reused (if any).
+					/// frees the chunks of contacts that were not reused, but only after many steps
+					/// with much less contacts than the peak (see ChChunkedPool::EndFill()).
 	virtual void EndAddContact();
 
+					/// The history table, that holds the contacts of the previous step,
+					/// is kept for the contacts that are added again.
+	virtual void RepeatAddContact();
+
 					/// Scans all the contacts and for each contact exacutes the ReportContactCallback()
 					/// function of the user object inherited from ChReportContactCallback.
 					/// Child classes of ChContactContainerBase should try to implement this (although
@@ -113,7 +173,22 @@ public:
 					/// results in inner structures of contacts.
 	virtual void Update (double mtime);			
 
+					/// Adds the forces of the contacts to the 'fb' vectors of the bodies.
+					/// Instead of scattering each contact into its two bodies, the contacts 
+					/// are sorted by body and each body gathers the forces of its contacts, 
+					/// so that the bodies are processed in parallel without locks when 
+					/// ChSystem::SetUseParallelPasses() is on. The sums are done in the order 
+					/// of the contacts, so the results are the same as in serial mode.
 	virtual void ConstraintsFbLoadForces(double factor);
+
+					/// The contacts are not saved in state snapshots, as they are found
+					/// again by the collision detection, but if contact history is used
+					/// their tangential displacements are saved, with the bodies as indexes
+					/// in the body list of the system. On restore, the current contacts
+					/// are discarded and the history is rebuilt from the snapshot, so the
+					/// contacts found at the next step get it back.
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
 };
 
 
@@ -0,0 +1,459 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChContactContainerSoA.cpp
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include "physics/ChContactContainerSoA.h"
+#include "physics/ChSystem.h"
+#include "physics/ChBody.h"
+#include "physics/ChParticlesClones.h"
+#include "collision/ChCModelBulletBody.h"
+#include "collision/ChCModelBulletParticle.h"
+
+#include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
+
+
+namespace chrono
+{
+
+
+using namespace collision;
+using namespace geometry;
+
+
+
+
+
+// Register into the object factory, to enable run-time
+// dynamic creation and persistence
+ChClassRegister<ChContactContainerSoA> a_registration_ChContactContainerSoA;
+
+
+ChContactContainerSoA::ChContactContainerSoA ()
+{
+	n_added = 0;
+}
+
+
+ChContactContainerSoA::~ChContactContainerSoA ()
+{
+	RemoveAllContacts();
+}
+
+
+
+void ChContactContainerSoA::Update (double mytime)
+{
+    // Inherit time changes of parent class, basically doing nothing :)
+    ChContactContainerBase::Update(mytime);
+
+}
+
+
+void ChContactContainerSoA::RemoveAllContacts()
+{
+	n_added = 0;
+
+	modA.clear();
+	modB.clear();
+	varA.clear();
+	varB.clear();
+	frameA.clear();
+	frameB.clear();
+	p1.clear();
+	p2.clear();
+	normal.clear();
+	norm_dist.clear();
+	contact_plane.clear();
+	reactions_cache.clear();
+	friction.clear();
+	cohesion.clear();
+	restitution.clear();
+	dampingf.clear();
+	compliance.clear();
+	complianceT.clear();
+	react_force.clear();
+
+	lcp_contacts.Resize(0);
+}
+
+
+void ChContactContainerSoA::BeginAddContact()
+{
+	// Note: clear() keeps the capacity of the vectors, so that
+	// no reallocation happens in steady state.
+	n_added = 0;
+
+	modA.clear();
+	modB.clear();
+	varA.clear();
+	varB.clear();
+	frameA.clear();
+	frameB.clear();
+	p1.clear();
+	p2.clear();
+	normal.clear();
+	norm_dist.clear();
+	reactions_cache.clear();
+	friction.clear();
+	cohesion.clear();
+	restitution.clear();
+	dampingf.clear();
+	compliance.clear();
+	complianceT.clear();
+}
+
+
+void ChContactContainerSoA::AddContact(const collision::ChCollisionInfo& mcontact)
+{
+	// Fetch the frames of that contact and other infos
+
+	ChFrame<>* mframeA =0;
+	ChFrame<>* mframeB =0;
+	bool inactiveA = false;
+	bool inactiveB = false;
+	ChLcpVariablesBody* mvarA = 0;
+	ChLcpVariablesBody* mvarB = 0;
+	ChSharedPtr<ChMaterialSurface> mmatA;
+	ChSharedPtr<ChMaterialSurface> mmatB;
+
+	if (ChModelBulletBody* mmboA = dynamic_cast<ChModelBulletBody*>(mcontact.modelA))
+	{
+		mframeA = mmboA->GetBody();
+		mvarA    =&mmboA->GetBody()->Variables();
+		inactiveA = !mmboA->GetBody()->IsActive();
+		mmatA = mmboA->GetBody()->GetMaterialSurface();
+	}
+	if (ChModelBulletParticle* mmpaA = dynamic_cast<ChModelBulletParticle*>(mcontact.modelA))
+	{
+		mframeA = &(mmpaA->GetParticles()->GetParticle(mmpaA->GetParticleId()));
+		mvarA   = (ChLcpVariablesBody*) &(mmpaA->GetParticles()->GetParticle(mmpaA->GetParticleId())).Variables();
+		if (ChParticlesClones* mpclone = dynamic_cast<ChParticlesClones*>(mmpaA->GetParticles()))
+		{
+			mmatA = mpclone->GetMaterialSurface();
+		}
+	}
+
+	if (ChModelBulletBody* mmboB = dynamic_cast<ChModelBulletBody*>(mcontact.modelB))
+	{
+		mframeB = mmboB->GetBody();
+		mvarB    =&mmboB->GetBody()->Variables();
+		inactiveB = !mmboB->GetBody()->IsActive();
+		mmatB = mmboB->GetBody()->GetMaterialSurface();
+	}
+	if (ChModelBulletParticle* mmpaB = dynamic_cast<ChModelBulletParticle*>(mcontact.modelB))
+	{
+		mframeB = &(mmpaB->GetParticles()->GetParticle(mmpaB->GetParticleId()));
+		mvarB   = (ChLcpVariablesBody*) &(mmpaB->GetParticles()->GetParticle(mmpaB->GetParticleId())).Variables();
+		if (ChParticlesClones* mpclone = dynamic_cast<ChParticlesClones*>(mmpaB->GetParticles()))
+		{
+			mmatB = mpclone->GetMaterialSurface();
+		}
+	}
+
+	if (!(mframeA && mframeB))
+		return;
+
+	assert (mvarA);
+	assert (mvarB);
+
+	if ((inactiveA && inactiveB))
+		return;
+
+	// Compute default material-couple values.
+
+	ChMaterialCouple mat;
+
+	mat.static_friction		= (float)ChMin( mmatA->static_friction,		mmatB->static_friction);
+	mat.rolling_friction	= (float)ChMin( mmatA->rolling_friction,	mmatB->rolling_friction);
+	mat.spinning_friction	= (float)ChMin( mmatA->spinning_friction,	mmatB->spinning_friction);
+	mat.restitution			= (float)ChMin( mmatA->restitution,			mmatB->restitution);
+	mat.cohesion			= (float)ChMin( mmatA->cohesion,			mmatB->cohesion);
+	mat.dampingf			= (float)ChMin( mmatA->dampingf,			mmatB->dampingf);
+	mat.compliance			= (float)(mmatA->compliance+mmatB->compliance);
+	mat.complianceT			= (float)(mmatA->complianceT+mmatB->complianceT);
+	mat.complianceRoll		= (float)(mmatA->complianceRoll+mmatB->complianceRoll);
+	mat.complianceSpin      = (float)(mmatA->complianceSpin+mmatB->complianceSpin);
+
+	// Launch the contact callback, if any, to set custom friction & material
+	// properties, if implemented by the user:
+
+	if (this->add_contact_callback)
+	{
+		this->add_contact_callback->ContactCallback(mcontact, mat);
+	}
+
+	// Append the contact data to the arrays (jacobians are computed later,
+	// all together, in EndAddContact() ).
+
+	modA.push_back(mcontact.modelA);
+	modB.push_back(mcontact.modelB);
+	varA.push_back(mvarA);
+	varB.push_back(mvarB);
+	frameA.push_back(mframeA);
+	frameB.push_back(mframeB);
+	p1.push_back(mcontact.vpA);
+	p2.push_back(mcontact.vpB);
+	normal.push_back(mcontact.vN);
+	norm_dist.push_back(mcontact.distance);
+	reactions_cache.push_back(mcontact.reaction_cache);
+	friction.push_back(mat.static_friction);
+	cohesion.push_back(mat.cohesion);
+	restitution.push_back(mat.restitution);
+	dampingf.push_back(mat.dampingf);
+	compliance.push_back(mat.compliance);
+	complianceT.push_back(mat.complianceT);
+
+	n_added++;
+}
+
+
+void ChContactContainerSoA::EndAddContact()
+{
+	contact_plane.resize(n_added);
+	react_force.resize(n_added);
+
+	lcp_contacts.Resize(n_added);
+
+	// Compute contact planes and jacobians, as in ChContact::Reset(),
+	// but writing directly into the arrays of the LCP block.
+
+	int nthreads = GetSystem() ? GetSystem()->GetParallelThreadNumber() : 1;
+	#pragma omp parallel for num_threads(nthreads)
+	for (int k = 0; k < n_added; k++)
+	{
+		lcp_contacts.SetContact(k, varA[k], varB[k], friction[k], cohesion[k]);
+		for (int i = 0; i < 3; i++)
+			lcp_contacts.GetConstraint(3*k+i).Set_cfm_i(0);
+
+		ChVector<> VN = normal[k];
+		ChVector<double> Vx, Vy, Vz;
+		ChVector<double> singul(VECT_Y);
+		XdirToDxDyDz(&VN, &singul, &Vx,  &Vy, &Vz);
+		contact_plane[k].Set_A_axis(Vx,Vy,Vz);
+
+		ChVector<> Pl1 = frameA[k]->TrasformParentToLocal(p1[k]);
+		ChVector<> Pl2 = frameB[k]->TrasformParentToLocal(p2[k]);
+
+		ChMatrix33<> Jr1, Jr2;
+		ChMatrix33<> Ps1, Ps2, Jtemp;
+		Ps1.Set_X_matrix(Pl1);
+		Ps2.Set_X_matrix(Pl2);
+
+		Jtemp.MatrMultiply(*(frameA[k]->GetA()), Ps1);
+		Jr1.MatrTMultiply(contact_plane[k], Jtemp);
+
+		Jtemp.MatrMultiply(*(frameB[k]->GetA()), Ps2);
+		Jr2.MatrTMultiply(contact_plane[k], Jtemp);
+
+		// row i of Jx1 = -(column i of contact plane), Jx2 = -Jx1, Jr2 negated
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				lcp_contacts.Cq_a_ij(3*k+i, j)   = -contact_plane[k](j,i);
+				lcp_contacts.Cq_b_ij(3*k+i, j)   =  contact_plane[k](j,i);
+				lcp_contacts.Cq_a_ij(3*k+i, j+3) =  (float)Jr1(i,j);
+				lcp_contacts.Cq_b_ij(3*k+i, j+3) = -(float)Jr2(i,j);
+			}
+		}
+
+		react_force[k] = VNULL;
+	}
+}
+
+
+
+void ChContactContainerSoA::ReportAllContacts(ChReportContactCallback* mcallback)
+{
+	for (int k = 0; k < n_added; k++)
+	{
+		bool proceed = mcallback->ReportContactCallback(
+					p1[k],
+					p2[k],
+					contact_plane[k],
+					norm_dist[k],
+					friction[k],
+					react_force[k],
+					VNULL, // no react torques
+					modA[k],
+					modB[k]
+					);
+		if (!proceed)
+			break;
+	}
+}
+
+
+////////// LCP INTERFACES ////
+
+
+void ChContactContainerSoA::InjectConstraints(ChLcpSystemDescriptor& mdescriptor)
+{
+	if (n_added)
+		mdescriptor.InsertContactBlock(&lcp_contacts);
+}
+
+void ChContactContainerSoA::ConstraintsBiReset()
+{
+	for (int row = 0; row < 3*n_added; row++)
+		lcp_contacts.GetConstraint(row).Set_b_i(0.);
+}
+
+void ChContactContainerSoA::ConstraintsBiLoad_C(double factor, double recovery_clamp, bool do_clamp)
+{
+	for (int k = 0; k < n_added; k++)
+	{
+		ChLcpConstraintTwoContactSoA& Nx = lcp_contacts.GetConstraint(3*k);
+		ChLcpConstraintTwoContactSoA& Tu = lcp_contacts.GetConstraint(3*k+1);
+		ChLcpConstraintTwoContactSoA& Tv = lcp_contacts.GetConstraint(3*k+2);
+
+		bool bounced = false;
+
+		// Elastic Restitution model (use simple Newton model with coeffcient e=v(+)/v(-))
+		// Note that this works only if the two connected items are two ChBody.
+
+		if (restitution[k])
+		{
+			ChModelBulletBody* bm1 = dynamic_cast<ChModelBulletBody*>(modA[k]);
+			ChModelBulletBody* bm2 = dynamic_cast<ChModelBulletBody*>(modB[k]);
+			if (bm1&&bm2)
+			{
+				ChBody* bb1 = bm1->GetBody();
+				ChBody* bb2 = bm2->GetBody();
+				//compute normal rebounce speed
+				Vector Pl1 = bb1->Point_World2Body(&p1[k]);
+				Vector Pl2 = bb2->Point_World2Body(&p2[k]);
+				Vector V1_w = bb1->PointSpeedLocalToParent(Pl1);
+				Vector V2_w = bb2->PointSpeedLocalToParent(Pl2);
+				Vector Vrel_w = V2_w-V1_w;
+				Vector Vrel_cplane = contact_plane[k].MatrT_x_Vect(Vrel_w);
+
+				double neg_rebounce_speed = Vrel_cplane.x * restitution[k];
+				if (neg_rebounce_speed < -  bb1->GetSystem()->GetMinBounceSpeed() )
+				{
+					// CASE: BOUNCE
+					bounced = true;
+					Nx.Set_b_i( Nx.Get_b_i() + neg_rebounce_speed );
+				}
+			}
+		}
+
+		if (!bounced)
+		{
+			// CASE: SETTLE (most often, and also default if two colliding items are not two ChBody)
+
+			if (compliance[k])
+			{
+				//  inverse timestep is factor
+				double h = 1.0/factor;
+
+				double alpha=dampingf[k]; // [R]=alpha*[K]
+				double inv_hpa = 1.0/(h+alpha); // 1/(h+a)
+				double inv_hhpa = 1.0/(h*(h+alpha)); // 1/(h*(h+a))
+
+				Nx.Set_cfm_i( (inv_hhpa)*compliance[k]  );
+				Tu.Set_cfm_i( (inv_hhpa)*complianceT[k] );
+				Tv.Set_cfm_i( (inv_hhpa)*complianceT[k] );
+
+				// no clamping of residual
+				Nx.Set_b_i( Nx.Get_b_i() + inv_hpa * norm_dist[k]  );
+			}
+			else
+			{
+				if (do_clamp)
+					if (cohesion[k])
+						Nx.Set_b_i( Nx.Get_b_i() + ChMin( 0.0, ChMax (factor * norm_dist[k], -recovery_clamp) ) );
+					else
+						Nx.Set_b_i( Nx.Get_b_i() + ChMax (factor * norm_dist[k], -recovery_clamp)  );
+				else
+					Nx.Set_b_i( Nx.Get_b_i() + factor * norm_dist[k]  );
+			}
+		}
+	}
+}
+
+
+void ChContactContainerSoA::ConstraintsLoadJacobians()
+{
+	// already loaded in EndAddContact()
+}
+
+
+void ChContactContainerSoA::ConstraintsFetch_react(double factor)
+{
+	// From constraints to react vector:
+	for (int k = 0; k < n_added; k++)
+	{
+		react_force[k].x = lcp_contacts.GetConstraint(3*k).Get_l_i() * factor;
+		react_force[k].y = lcp_contacts.GetConstraint(3*k+1).Get_l_i() * factor;
+		react_force[k].z = lcp_contacts.GetConstraint(3*k+2).Get_l_i() * factor;
+	}
+}
+
+
+// Following functions are for exploiting the contact persistence
+
+
+void  ChContactContainerSoA::ConstraintsLiLoadSuggestedSpeedSolution()
+{
+	// Fetch the last computed impulsive reactions from the persistent contact manifold (could
+	// be used for warm starting the CCP speed solver):
+	for (int k = 0; k < n_added; k++)
+		if (reactions_cache[k])
+			for (int i = 0; i < 3; i++)
+				lcp_contacts.GetConstraint(3*k+i).Set_l_i(reactions_cache[k][i]);
+}
+
+void  ChContactContainerSoA::ConstraintsLiLoadSuggestedPositionSolution()
+{
+	// Fetch the last computed 'positional' reactions from the persistent contact manifold (could
+	// be used for warm starting the CCP position stabilization solver):
+	for (int k = 0; k < n_added; k++)
+		if (reactions_cache[k])
+			for (int i = 0; i < 3; i++)
+				lcp_contacts.GetConstraint(3*k+i).Set_l_i(reactions_cache[k][3+i]);
+}
+
+void  ChContactContainerSoA::ConstraintsLiFetchSuggestedSpeedSolution()
+{
+	// Store the last computed reactions into the persistent contact manifold (might
+	// be used for warm starting CCP the speed solver):
+	for (int k = 0; k < n_added; k++)
+		if (reactions_cache[k])
+			for (int i = 0; i < 3; i++)
+				reactions_cache[k][i] = (float)lcp_contacts.GetConstraint(3*k+i).Get_l_i();
+}
+
+void  ChContactContainerSoA::ConstraintsLiFetchSuggestedPositionSolution()
+{
+	// Store the last computed 'positional' reactions into the persistent contact manifold (might
+	// be used for warm starting the CCP position stabilization solver):
+	for (int k = 0; k < n_added; k++)
+		if (reactions_cache[k])
+			for (int i = 0; i < 3; i++)
+				reactions_cache[k][3+i] = (float)lcp_contacts.GetConstraint(3*k+i).Get_l_i();
+}
+
+
+
+
+} // END_OF_NAMESPACE____
+
+
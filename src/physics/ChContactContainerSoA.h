@@ -0,0 +1,165 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHCONTACTCONTAINERSOA_H
+#define CHCONTACTCONTAINERSOA_H
+
+///////////////////////////////////////////////////
+//
+//   ChContactContainerSoA.h
+//
+//   Class for container of many contacts between
+//   6DOF bodies, stored as structure of arrays and
+//   passed to the LCP solver as a ChLcpContactsSoA block.
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+
+#include "physics/ChContactContainerBase.h"
+#include "lcp/ChLcpContactsSoA.h"
+#include <vector>
+
+namespace chrono
+{
+
+
+///
+/// Class representing a container of many contacts between
+/// two 6DOF bodies (or particles), where the data of all contacts
+/// is stored in contiguous arrays instead of a linked list of
+/// ChContact objects. The jacobians are computed in EndAddContact()
+/// directly into a ChLcpContactsSoA block, that is passed to the
+/// ChLcpSystemDescriptor; the SOR, Jacobi and APGD solvers then
+/// work on the arrays of the block with non-virtual kernels.
+/// This is useful in scenarios with many thousands of contacts.
+/// Use it with ChSystem::ChangeContactContainer().
+/// NOTE: rolling and spinning friction are not supported by this
+/// container: contacts with rolling or spinning friction are
+/// handled as plain sliding contacts.
+///
+
+class ChApi ChContactContainerSoA : public ChContactContainerBase {
+
+	CH_RTTI(ChContactContainerSoA,ChContactContainerBase);
+
+protected:
+				//
+	  			// DATA
+				//
+
+	int n_added;
+
+				// per-contact data
+	std::vector<collision::ChCollisionModel*> modA;
+	std::vector<collision::ChCollisionModel*> modB;
+	std::vector<ChLcpVariablesBody*> varA;
+	std::vector<ChLcpVariablesBody*> varB;
+	std::vector<ChFrame<>*> frameA;
+	std::vector<ChFrame<>*> frameB;
+	std::vector< ChVector<> > p1;
+	std::vector< ChVector<> > p2;
+	std::vector< ChVector<float> > normal;
+	std::vector<double> norm_dist;
+	std::vector< ChMatrix33<float> > contact_plane;
+	std::vector<float*> reactions_cache;
+	std::vector<float> friction;
+	std::vector<float> cohesion;
+	std::vector<float> restitution;
+	std::vector<float> dampingf;
+	std::vector<float> compliance;
+	std::vector<float> complianceT;
+	std::vector< ChVector<> > react_force;
+
+				// the LCP data (jacobians, multipliers, etc.)
+	ChLcpContactsSoA lcp_contacts;
+
+public:
+				//
+	  			// CONSTRUCTORS
+				//
+
+	ChContactContainerSoA ();
+
+	virtual ~ChContactContainerSoA ();
+
+
+				//
+	  			// FUNCTIONS
+				//
+					/// Tell the number of added contacts
+	virtual int GetNcontacts  () {return n_added;}
+
+					/// Remove (delete) all contained contact data.
+	virtual void RemoveAllContacts();
+
+					/// The collision system will call BeginAddContact() before adding
+					/// all contacts (for example with AddContact() or similar). This
+					/// rewinds the arrays, but their memory is kept for reuse.
+	virtual void BeginAddContact();
+
+					/// Add a contact between two frames.
+	virtual void AddContact(const collision::ChCollisionInfo& mcontact);
+
+					/// The collision system will call EndAddContact() after adding
+					/// all contacts. This computes the jacobians of all contacts
+					/// in the ChLcpContactsSoA block.
+	virtual void EndAddContact();
+
+					/// Scans all the contacts and for each contact exacutes the ReportContactCallback()
+					/// function of the user object inherited from ChReportContactCallback.
+	virtual void ReportAllContacts(ChReportContactCallback* mcallback);
+
+					/// Access the block of LCP data of the contacts
+	ChLcpContactsSoA& GetLcpContacts() {return lcp_contacts;}
+
+
+					/// Tell the number of scalar bilateral constraints (actually, friction
+					/// constraints aren't exactly as unilaterals, but count them too)
+	virtual int GetDOC_d  () {return (n_added * 3);}
+
+					/// In detail, it computes jacobians, violations, etc. and stores
+					/// results in inner structures of contacts.
+	virtual void Update (double mtime);
+
+				//
+				// LCP INTERFACE
+				//
+
+	virtual void InjectConstraints(ChLcpSystemDescriptor& mdescriptor);
+	virtual void ConstraintsBiReset();
+	virtual void ConstraintsBiLoad_C(double factor=1., double recovery_clamp=0.1, bool do_clamp=false);
+	virtual void ConstraintsLoadJacobians();
+	virtual void ConstraintsLiLoadSuggestedSpeedSolution();
+	virtual void ConstraintsLiLoadSuggestedPositionSolution();
+	virtual void ConstraintsLiFetchSuggestedSpeedSolution();
+	virtual void ConstraintsLiFetchSuggestedPositionSolution();
+	virtual void ConstraintsFetch_react(double factor=1.);
+
+
+};
+
+
+
+
+//////////////////////////////////////////////////////
+//////////////////////////////////////////////////////
+
+
+} // END_OF_NAMESPACE____
+
+#endif
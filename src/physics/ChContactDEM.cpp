@@ -39,7 +39,7 @@ using namespace geometry;
 
 ChContactDEM::ChContactDEM ()
 { 
-	
+	featureA = featureB = -1;
 }
 
 ChContactDEM::ChContactDEM (		collision::ChCollisionModel* mmodA,	///< model A
@@ -56,9 +56,11 @@ ChContactDEM::ChContactDEM (		collision::ChCollisionModel* mmodA,	///< model A
 						double  mkn,				///< spring coeff.
 						double  mgn,				///< damping coeff.
 						double  mkt,				///< tangential spring coeff.
-						double mfriction			///< friction coeff.
+						double mfriction,			///< friction coeff.
+						const ChVector<>* mtangential_history
 				)
 { 
+	featureA = featureB = -1;
 	Reset(	mmodA, mmodB,
 			varA, ///< pass A vars
 			varB, ///< pass B vars
@@ -72,7 +74,8 @@ ChContactDEM::ChContactDEM (		collision::ChCollisionModel* mmodA,	///< model A
 			mkn,
 			mgn,
 			mkt,
-			mfriction
+			mfriction,
+			mtangential_history
 				);
 }
 
@@ -95,7 +98,8 @@ void ChContactDEM::Reset(	collision::ChCollisionModel* mmodA,	///< model A
 							double  mkn,				///< spring coeff.
 							double  mgn,				///< damping coeff.
 							double  mkt,				///< tangential spring coeff.
-							double mfriction			///< friction coeff.
+							double mfriction,			///< friction coeff.
+							const ChVector<>* mtangential_history
 				)
 {
 	assert (varA);
@@ -115,12 +119,14 @@ void ChContactDEM::Reset(	collision::ChCollisionModel* mmodA,	///< model A
 
 	this->p1 = vpA;
 	this->p2 = vpB;
+	this->p1_loc = frameA->TrasformParentToLocal(vpA);
 	this->normal = vN;
 	this->norm_dist = mdistance;
 	this->gnn=mgn;
 	this->knn=mkn;
 
 	react_force = VNULL;
+	tangential_displacement = VNULL;
 	if (mdistance<0)
 	{
 		ChModelBulletDEM* modelA = (ChModelBulletDEM*)mmodA;
@@ -142,19 +148,28 @@ void ChContactDEM::Reset(	collision::ChCollisionModel* mmodA,	///< model A
 		ChVector<> v_t = v_BA-v_n;
 
 		double dT = bodyA->GetSystem()->GetStep();
-		double slip = v_t.Length()*dT;
-		if (v_t.Length()>1e-4)
-		{
-			v_t.Normalize();
-		}
-		else
+
+		// the displacement of the previous step is rotated on the current 
+		// tangent plane, keeping its length, then the slip of this step is added
+		if (mtangential_history)
 		{
-			v_t.SetNull();
+			tangential_displacement = *mtangential_history;
+			double len_old = tangential_displacement.Length();
+			tangential_displacement -= vN * tangential_displacement.Dot(vN);
+			double len_new = tangential_displacement.Length();
+			if (len_new > 0)
+				tangential_displacement *= len_old / len_new;
 		}
+		tangential_displacement += v_t*dT;
+
+		// the spring force is capped by the Coulomb limit: if exceeded, the
+		// contact slides, and the displacement is limited accordingly
+		double maxforce = mfriction*react_force.Length();
+		double springforce = mkt*tangential_displacement.Length();
+		if (springforce > maxforce)
+			tangential_displacement *= maxforce / springforce;
 
-		double tmppp= (mkt*slip)<(mfriction*react_force.Length()) ? (mkt*slip) : (mfriction*react_force.Length());
-		//double tmppp = mfriction*react_force.Length();
-		react_force+=tmppp*v_t;
+		react_force+=mkt*tangential_displacement;
 
 		//bodyA->AccumulateForce(react_force);
 		//bodyB->AccumulateForce(-react_force);
@@ -162,30 +177,39 @@ void ChContactDEM::Reset(	collision::ChCollisionModel* mmodA,	///< model A
 }
 
 
+void ChContactDEM::GetBodyLoad(bool onA, double factor, ChVector<>& mforce, ChVector<>& mtorque_loc)
+{
+	if (onA)
+	{
+		ChBodyDEM* bodyA = ((ChModelBulletDEM*)modA)->GetBody();
+		ChVector<> pt1_loc = bodyA->Point_World2Body(&p1);
+		ChVector<> force1_loc = bodyA->Dir_World2Body(&react_force);
+		mforce = react_force*factor;
+		mtorque_loc = Vcross(pt1_loc, force1_loc)*factor;
+	}
+	else
+	{
+		ChBodyDEM* bodyB = ((ChModelBulletDEM*)modB)->GetBody();
+		ChVector<> pt2_loc = bodyB->Point_World2Body(&p2);
+		ChVector<> force2_loc = bodyB->Dir_World2Body(&react_force);
+		mforce = -react_force*factor;
+		mtorque_loc = Vcross(pt2_loc, -force2_loc)*factor;
+	}
+}
+
 void ChContactDEM::ConstraintsFbLoadForces(double factor)
 {
-	ChModelBulletDEM* modelA = (ChModelBulletDEM*)modA;
-	ChBodyDEM* bodyA = modelA->GetBody();
-	ChModelBulletDEM* modelB = (ChModelBulletDEM*)modB;
-	ChBodyDEM* bodyB = modelB->GetBody();
-
-	ChVector<> pt1_loc = bodyA->Point_World2Body(&p1);
-	ChVector<> pt2_loc = bodyB->Point_World2Body(&p2);
-	ChVector<> force1_loc = bodyA->Dir_World2Body(&react_force);
-	ChVector<> force2_loc = bodyB->Dir_World2Body(&react_force);
-	ChVector<> torque1_loc = Vcross(pt1_loc, force1_loc);
-	ChVector<> torque2_loc = Vcross(pt2_loc, -force2_loc);
-
-	//bodyA->To_abs_forcetorque (react_force, p1, 0, mabsforceA, mabstorqueA);
-	//bodyB->To_abs_forcetorque (-react_force, p2, 0, mabsforceB, mabstorqueB);
-
-	bodyA->Variables().Get_fb().PasteSumVector( react_force*factor ,0,0);
-	//bodyA->Variables().Get_fb().PasteSumVector( (bodyA->Dir_World2Body(&mabstorqueA))*factor,3,0);
-	bodyA->Variables().Get_fb().PasteSumVector( torque1_loc*factor,3,0);
-
-	bodyB->Variables().Get_fb().PasteSumVector( -react_force*factor ,0,0);
-	//bodyB->Variables().Get_fb().PasteSumVector( (bodyB->Dir_World2Body(&mabstorqueB))*factor,3,0);
-	bodyB->Variables().Get_fb().PasteSumVector( torque2_loc*factor,3,0);
+	ChBodyDEM* bodyA = ((ChModelBulletDEM*)modA)->GetBody();
+	ChBodyDEM* bodyB = ((ChModelBulletDEM*)modB)->GetBody();
+	ChVector<> mforce, mtorque_loc;
+
+	GetBodyLoad(true, factor, mforce, mtorque_loc);
+	bodyA->Variables().Get_fb().PasteSumVector( mforce ,0,0);
+	bodyA->Variables().Get_fb().PasteSumVector( mtorque_loc ,3,0);
+
+	GetBodyLoad(false, factor, mforce, mtorque_loc);
+	bodyB->Variables().Get_fb().PasteSumVector( mforce ,0,0);
+	bodyB->Variables().Get_fb().PasteSumVector( mtorque_loc ,3,0);
 }
 
 
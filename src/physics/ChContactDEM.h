@@ -51,6 +51,7 @@ protected:
 
 	ChVector<> p1;			///< max penetration point on geo1, after refining, in abs space
 	ChVector<> p2;			///< max penetration point on geo2, after refining, in abs space
+	ChVector<> p1_loc;		///< point p1 in the coordinates of the frame of A (to match the contact history)
 	ChVector<float> normal;	///< normal, on surface of master reference (geo1)
 
 							///< the plane of contact (X is normal direction)
@@ -62,6 +63,10 @@ protected:
 
 	ChVector<> react_force;
 
+	ChVector<> tangential_displacement;	///< elastic tangential displacement, in abs space (for the tangential spring)
+	int featureA;	///< id of the feature of model A in contact, or -1
+	int featureB;	///< id of the feature of model B in contact, or -1
+
 public:
 				//
 	  			// CONSTRUCTORS
@@ -83,7 +88,8 @@ public:
 						double  mkn,				///< spring coeff.
 						double  mgn,				///< damping coeff.
 						double  mkt,				///< tangential spring coeff.
-						double mfriction			///< friction coeff.
+						double mfriction,			///< friction coeff.
+						const ChVector<>* mtangential_history = 0	///< tangential displacement of the same contact at the previous step, if any
 				);
 
 	virtual ~ChContactDEM ();
@@ -93,7 +99,12 @@ public:
 	  			// FUNCTIONS
 				//
 
-					/// Initialize again this constraint.
+					/// Initialize again this constraint, and compute the contact force.
+					/// The tangential force is given by a spring, whose elongation is
+					/// the tangential displacement accumulated during the contact, capped
+					/// by the Coulomb limit. If the displacement of the previous step is not
+					/// given (ex. new contact), it starts from zero, so the tangential force
+					/// only depends on the slip during this step.
 	virtual void Reset(	collision::ChCollisionModel* mmodA,	///< model A
 						collision::ChCollisionModel* mmodB,	///< model B
 						const ChLcpVariablesBody* varA, ///< pass A vars
@@ -108,7 +119,8 @@ public:
 						double  mkn,				///< spring coeff.
 						double  mgn,				///< damping coeff.
 						double  mkt,				///< tangential spring coeff.
-						double mfriction			///< friction coeff.
+						double mfriction,			///< friction coeff.
+						const ChVector<>* mtangential_history = 0	///< tangential displacement of the same contact at the previous step, if any
 );
 
 
@@ -148,11 +160,30 @@ public:
 					/// Set the damping coefficient
 	virtual void SetDampingStiffness(float mg) { gnn=mg; };
 
+					/// Get the elastic tangential displacement of the contact, in absolute
+					/// coordinates, to be passed to Reset() at the next step.
+	const ChVector<>& GetTangentialDisplacement() {return tangential_displacement;};
+
+					/// Get the contact point P1 in the coordinates of the frame of A, as
+					/// it was when the contact was found.
+	const ChVector<>& GetContactP1local() {return p1_loc;};
+
+					/// Set the ids of the features in contact, see ChCollisionInfo.
+	void SetFeatures(int mfeatureA, int mfeatureB) {featureA = mfeatureA; featureB = mfeatureB;};
+	int GetFeatureA() {return featureA;};
+	int GetFeatureB() {return featureB;};
+
 					/// Get the collision model A, with point P1
 	virtual collision::ChCollisionModel* GetModelA() {return this->modA;};
 					/// Get the collision model B, with point P2
 	virtual collision::ChCollisionModel* GetModelB() {return this->modB;};
 
+					/// Get the force, in absolute coordinates, and the torque, in the
+					/// coordinates of the body, that this contact applies to the body of
+					/// model A (if onA is true) or of model B, multiplied by 'factor'.
+					/// It only reads the body, so it can be called in parallel.
+	void GetBodyLoad(bool onA, double factor, ChVector<>& mforce, ChVector<>& mtorque_loc);
+
 	virtual void ConstraintsFbLoadForces(double factor);
 
 };
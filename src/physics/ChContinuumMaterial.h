@@ -141,7 +141,7 @@ public:
 			/// Note: is performed every time you change a material parameter
 	void ComputeStressStrainMatrix();
 			/// Get the Elasticity matrix 
-	ChMatrixDynamic<> Get_StressStrainMatrix () {return StressStrainMatrix;}
+	ChMatrixDynamic<>& Get_StressStrainMatrix () {return StressStrainMatrix;}
 
 
 			/// Compute elastic stress from elastic strain
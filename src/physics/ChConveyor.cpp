@@ -327,6 +327,24 @@ void ChConveyor::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChConveyor::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChBody::StateSave(msnapshot);
+
+	this->conveyor_plate->StateSave(msnapshot);
+	this->internal_link->StateSave(msnapshot);
+}
+
+void ChConveyor::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChBody::StateRestore(msnapshot);
+
+	this->conveyor_plate->StateRestore(msnapshot);
+	this->internal_link->StateRestore(msnapshot);
+}
+
+
+
 
 
 } // END_OF_NAMESPACE____
@@ -153,6 +153,11 @@ public:
 				/// binary archive (ex: a file).
 	void StreamOUT(ChStreamOutBinary& mstream);
 
+				/// Save/restore also the state of the conveyor plate and of
+				/// its internal link, for ChSystem::StateSave() and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 	
 };
 
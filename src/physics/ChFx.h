@@ -50,6 +50,16 @@ public:
 	virtual void Eval  (      ChMatrix<>& A,	///< result output variables here
 						const ChMatrix<>& B		///< input variables here
 					   ) =0;
+
+		/// Create an independent copy of this function, that can be
+		/// evaluated concurrently with this one by another thread (for
+		/// example, a copy that owns its own ChSystem, if the function runs
+		/// a simulation). Used by the parallel evaluations of ChOptimizer.
+		/// By default returns NULL, meaning that the function cannot be
+		/// copied, and must be evaluated serially.
+	virtual ChFx* new_Duplicate () {return 0;}
+
+	virtual ~ChFx() {};
 };
 
 
@@ -71,6 +71,16 @@ ChNodeBase& ChNodeBase::operator= (const ChNodeBase& other)
 	return *this;
 }
 
+void ChNodeBase::StateSave(ChStateSnapshot& msnapshot)
+{
+	throw ChException("State snapshots are not supported by this type of node");
+}
+
+void ChNodeBase::StateRestore(ChStateSnapshot& msnapshot)
+{
+	throw ChException("State snapshots are not supported by this type of node");
+}
+
 
 //////////////////////////////////////
 
@@ -110,6 +120,20 @@ ChNodeXYZ& ChNodeXYZ::operator= (const ChNodeXYZ& other)
 	return *this;
 }
 
+void ChNodeXYZ::StateSave(ChStateSnapshot& msnapshot)
+{
+	msnapshot.Add(this->pos);
+	msnapshot.Add(this->pos_dt);
+	msnapshot.Add(this->pos_dtdt);
+}
+
+void ChNodeXYZ::StateRestore(ChStateSnapshot& msnapshot)
+{
+	msnapshot.Get(this->pos);
+	msnapshot.Get(this->pos_dt);
+	msnapshot.Get(this->pos_dtdt);
+}
+
 
 
 //////////////////////////////////////
@@ -131,6 +155,76 @@ ChIndexedNodes::~ChIndexedNodes ()
 
 
 
+// Spread the lowest 10 bits of x, putting two zeros before each bit.
+static unsigned int MortonSpreadBits(unsigned int x)
+{
+	x &= 0x000003ff;
+	x = (x | (x << 16)) & 0x030000ff;
+	x = (x | (x <<  8)) & 0x0300f00f;
+	x = (x | (x <<  4)) & 0x030c30c3;
+	x = (x | (x <<  2)) & 0x09249249;
+	return x;
+}
+
+void ChIndexedNodes::ComputeMortonOrder(std::vector<int>& order)
+{
+	int n = (int)this->GetNnodes();
+	order.resize(n);
+	if (n == 0)
+		return;
+
+	// Bounding box of the nodes
+
+	ChVector<> pmin = ((ChNodeXYZ*)this->GetNode(0))->GetPos();
+	ChVector<> pmax = pmin;
+	for (int j = 0; j < n; j++)
+	{
+		ChVector<> p = ((ChNodeXYZ*)this->GetNode(j))->GetPos();
+		pmin.x = ChMin(pmin.x, p.x);  pmax.x = ChMax(pmax.x, p.x);
+		pmin.y = ChMin(pmin.y, p.y);  pmax.y = ChMax(pmax.y, p.y);
+		pmin.z = ChMin(pmin.z, p.z);  pmax.z = ChMax(pmax.z, p.z);
+	}
+	double extent = ChMax(pmax.x - pmin.x, ChMax(pmax.y - pmin.y, pmax.z - pmin.z));
+	double scale = (extent > 0) ? 1023.0 / extent : 0;
+
+	// Morton code of each node, on a 1024x1024x1024 grid. Nodes with the 
+	// same code are kept in their current order.
+
+	std::vector< std::pair<unsigned int, int> > keys(n);
+	for (int j = 0; j < n; j++)
+	{
+		ChVector<> p = ((ChNodeXYZ*)this->GetNode(j))->GetPos();
+		unsigned int ix = (unsigned int)((p.x - pmin.x) * scale);
+		unsigned int iy = (unsigned int)((p.y - pmin.y) * scale);
+		unsigned int iz = (unsigned int)((p.z - pmin.z) * scale);
+		keys[j].first  = MortonSpreadBits(ix) | (MortonSpreadBits(iy) << 1) | (MortonSpreadBits(iz) << 2);
+		keys[j].second = j;
+	}
+	std::sort(keys.begin(), keys.end());
+
+	for (int i = 0; i < n; i++)
+		order[i] = keys[i].second;
+}
+
+
+
+void ChIndexedNodes::StateSave(ChStateSnapshot& msnapshot)
+{
+	msnapshot.Add(this->GetNnodes());
+	for (unsigned int j = 0; j < this->GetNnodes(); j++)
+		this->GetNode(j)->StateSave(msnapshot);
+}
+
+void ChIndexedNodes::StateRestore(ChStateSnapshot& msnapshot)
+{
+	if ((unsigned int)msnapshot.Get() != this->GetNnodes())
+		throw ChException("The state snapshot does not match the nodes of the cluster");
+	for (unsigned int j = 0; j < this->GetNnodes(); j++)
+		this->GetNode(j)->StateRestore(msnapshot);
+}
+
+
+
 //////// FILE I/O
 
 void ChIndexedNodes::StreamOUT(ChStreamOutBinary& mstream)
@@ -31,6 +31,7 @@
 
 
 #include <math.h>
+#include <vector>
 
 #include "physics/ChPhysicsItem.h"
 #include "lcp/ChLcpVariablesBodyOwnMass.h"
@@ -107,6 +108,17 @@ public:
 	virtual void VariablesQbIncrementPosition(double step) {};
 
 
+			//
+			// STATE
+			//
+
+				/// Append the state of the node (positions, speeds, etc.) to a
+				/// snapshot, see ChIndexedNodes::StateSave(). The default throws
+				/// a ChException; children classes with a state implement it.
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+				/// Read back the state written by StateSave(), in the same order.
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 };
 
 
@@ -146,6 +158,10 @@ public:
 			// Set mass of the node. To be implemented in children classes
 	virtual void SetMass(double mm) = 0;
 
+			// Save/restore position, speed and acceleration of the node.
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 					//
 					// DATA
 					// 
@@ -192,6 +208,13 @@ public:
 				/// Access the N-th node 
 	virtual ChNodeBase* GetNode(unsigned int n) =0;
 
+				/// Compute the order of the nodes along a Morton (Z-order)
+				/// curve through their positions: order[i] is the index of
+				/// the i-th node along the curve. Nodes that are near along
+				/// the curve are also near in space, so this order can be used
+				/// to arrange the nodes in memory. Nodes must be ChNodeXYZ.
+	void ComputeMortonOrder(std::vector<int>& order);
+
 				/// Add a new node to the particle cluster, passing a 
 				/// vector as initial position.
 //	virtual void AddNode(ChVector<double> initial_state) =0;
@@ -204,6 +227,17 @@ public:
 //	virtual int GetDOF  ()   {return 3*GetNnodes();} 
 
 
+			//
+			// STATE
+			//
+
+				/// Save/restore the state of all the nodes, for ChSystem::StateSave()
+				/// and ChSystem::StateRestore(). The number of nodes must not
+				/// change in between.
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
+
 
 			//
 			// STREAMING
@@ -96,6 +96,36 @@ ChIndexedParticles::~ChIndexedParticles ()
 }
 
 
+void ChIndexedParticles::StateSave(ChStateSnapshot& msnapshot)
+{
+	msnapshot.Add(this->GetNparticles());
+	for (unsigned int j = 0; j < this->GetNparticles(); j++)
+	{
+		ChParticleBase& mparticle = this->GetParticle(j);
+		msnapshot.Add(mparticle.GetCoord());
+		msnapshot.Add(mparticle.GetCoord_dt());
+		msnapshot.Add(mparticle.GetCoord_dtdt());
+	}
+}
+
+void ChIndexedParticles::StateRestore(ChStateSnapshot& msnapshot)
+{
+	if ((unsigned int)msnapshot.Get() != this->GetNparticles())
+		throw ChException("The state snapshot does not match the particles of the cluster");
+	for (unsigned int j = 0; j < this->GetNparticles(); j++)
+	{
+		ChCoordsys<> mcoord, mcoord_dt, mcoord_dtdt;
+		msnapshot.Get(mcoord);
+		msnapshot.Get(mcoord_dt);
+		msnapshot.Get(mcoord_dtdt);
+		ChParticleBase& mparticle = this->GetParticle(j);
+		mparticle.SetCoord(mcoord);
+		mparticle.SetCoord_dt(mcoord_dt);
+		mparticle.SetCoord_dtdt(mcoord_dtdt);
+	}
+}
+
+
 
 //////// FILE I/O
 
@@ -121,6 +121,17 @@ public:
 	virtual unsigned int GetAssetsFrameNclones() {return GetNparticles();}
 
 
+			//
+			// STATE
+			//
+
+				/// Save/restore position, speed and acceleration of all the particles,
+				/// for ChSystem::StateSave() and ChSystem::StateRestore(). The number
+				/// of particles must not change in between.
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
+
 			//
 			// STREAMING
 			//
@@ -23,6 +23,7 @@
 #include "physics/ChLink.h"
 #include "physics/ChGlobal.h"
 #include "physics/ChSystem.h"
+#include "physics/ChStateSnapshot.h"
 #include "physics/ChExternalObject.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
@@ -99,6 +100,34 @@ ChLink* ChLink::new_Duplicate ()   // inherited classes:  Link* MyInheritedLink:
  
 
 
+void ChLink::SetValid(bool mon)
+{
+	if (mon != valid && GetSystem())
+		GetSystem()->ResetIncrementalInjection(); // constraints must be injected again
+	valid = mon;
+}
+
+void ChLink::SetDisabled(bool mdis)
+{
+	if (mdis != disabled && GetSystem())
+		GetSystem()->ResetIncrementalInjection(); // constraints must be injected again
+	disabled = mdis;
+}
+
+void ChLink::SetBroken(bool mon)
+{
+	if (mon != broken && GetSystem())
+		GetSystem()->ResetIncrementalInjection(); // constraints must be injected again
+	broken = mon;
+}
+
+
+bool ChLink::InjectInactiveConstraints()
+{
+	return GetSystem() && GetSystem()->GetUseIncrementalInjection();
+}
+
+
 void ChLink::Set2Dmode(int mode)
 {
     // Nothing specific to do on mask, 'cause base link.
@@ -223,11 +252,17 @@ void ChLink::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChLink::StateSave(ChStateSnapshot& msnapshot)
+{
+	msnapshot.Add(react_force);
+	msnapshot.Add(react_torque);
+}
 
-
-
-
-
+void ChLink::StateRestore(ChStateSnapshot& msnapshot)
+{
+	msnapshot.Get(react_force);
+	msnapshot.Get(react_torque);
+}
 
 
 
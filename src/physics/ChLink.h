@@ -112,6 +112,13 @@ protected:
 	bool valid;			// link data is valid
 	bool broken;		// link is broken because of excessive pulling/pushing.
 
+				// Tells if InjectConstraints() must insert also the inactive constraints.
+				// This is true if the system uses incremental injection, where the
+				// constraints are not injected again when a single constraint changes 
+				// its active state (ex. redundant or 2D mode constraints of masks):
+				// all of them are kept in the descriptor, and the solvers skip the inactive ones.
+	bool InjectInactiveConstraints();
+
 public:
 				//
 	  			// CONSTRUCTORS
@@ -132,20 +139,20 @@ public:
 				/// (i.e. pointers to other items are correct)
 	virtual bool IsValid() {return valid;}
 				/// Set the status of link validity
-	virtual void SetValid(bool mon) {valid = mon;}
+	virtual void SetValid(bool mon);
 
 				/// Tells if all constraints of this link are currently turned
 				/// on or off by the user.
 	virtual bool IsDisabled() {return disabled;}
 				/// User can use this to enable/disable all the constraint of
 				/// the link as desired.
-	virtual void SetDisabled(bool mdis) {disabled = mdis;}
+	virtual void SetDisabled(bool mdis);
 
 
 				/// Tells if the link is broken, for excess of pulling/pushing.
 	virtual bool IsBroken() {return broken;}
 				/// Ex:3rd party software can set the 'broken' status via this method
-	virtual void SetBroken(bool mon) {broken = mon;}
+	virtual void SetBroken(bool mon);
 
 
 				/// An important function!
@@ -266,6 +273,11 @@ public:
 					/// as a readable item, for example   "chrono::GetLog() << myobject;"
 	virtual void StreamOUT(ChStreamOutAscii& mstream) {};
 
+					/// Save/restore the reactions, for ChSystem::StateSave()
+					/// and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 };
 
 
@@ -21,6 +21,7 @@
  
   
 #include "physics/ChLinkDistance.h"
+#include "physics/ChStateSnapshot.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
@@ -242,6 +243,22 @@ void  ChLinkDistance::ConstraintsLiFetchSuggestedPositionSolution()
 
 
 
+void ChLinkDistance::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChLinkGeometric::StateSave(msnapshot);
+
+	msnapshot.Add(cache_li_speed);
+	msnapshot.Add(cache_li_pos);
+}
+
+void ChLinkDistance::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChLinkGeometric::StateRestore(msnapshot);
+
+	cache_li_speed = (float)msnapshot.Get();
+	cache_li_pos = (float)msnapshot.Get();
+}
+
 
 
 } // END_OF_NAMESPACE____
@@ -160,6 +160,13 @@ public:
 	virtual void ConstraintsLiFetchSuggestedSpeedSolution();
 	virtual void ConstraintsLiFetchSuggestedPositionSolution();
 
+				//
+				// STATE SNAPSHOTS
+				//
+
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 };
 
 
@@ -22,6 +22,7 @@
  
 
 #include "physics/ChLinkEngine.h"
+#include "physics/ChStateSnapshot.h"
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
 
@@ -832,6 +833,46 @@ void ChLinkEngine::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChLinkEngine::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChLinkLock::StateSave(msnapshot);
+
+	msnapshot.Add(last_r3time);
+	msnapshot.Add(last_r3mot_rot);
+	msnapshot.Add(last_r3mot_rot_dt);
+	msnapshot.Add(last_r3relm_rot);
+	msnapshot.Add(last_r3relm_rot_dt);
+	innershaft1.StateSave(msnapshot);
+	innershaft2.StateSave(msnapshot);
+	msnapshot.Add(cache_li_speed1);
+	msnapshot.Add(cache_li_pos1);
+	msnapshot.Add(torque_react1);
+	msnapshot.Add(cache_li_speed2);
+	msnapshot.Add(cache_li_pos2);
+	msnapshot.Add(torque_react2);
+}
+
+void ChLinkEngine::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChLinkLock::StateRestore(msnapshot);
+
+	last_r3time = msnapshot.Get();
+	last_r3mot_rot = msnapshot.Get();
+	last_r3mot_rot_dt = msnapshot.Get();
+	msnapshot.Get(last_r3relm_rot);
+	msnapshot.Get(last_r3relm_rot_dt);
+	innershaft1.StateRestore(msnapshot);
+	innershaft2.StateRestore(msnapshot);
+	cache_li_speed1 = msnapshot.Get();
+	cache_li_pos1 = msnapshot.Get();
+	torque_react1 = msnapshot.Get();
+	cache_li_speed2 = msnapshot.Get();
+	cache_li_pos2 = msnapshot.Get();
+	torque_react2 = msnapshot.Get();
+}
+
+
+
 ///////////////////////////////////////////////////////////////
 
 
@@ -218,6 +218,12 @@ public:
 	virtual void StreamIN(ChStreamInBinary& mstream);
 	virtual void StreamOUT(ChStreamOutBinary& mstream);
 
+						/// Save/restore also the inner shafts and the values kept for backward
+						/// differentiation and warm starting, for
+						/// ChSystem::StateSave() and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 };
 
 
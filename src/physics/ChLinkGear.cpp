@@ -21,6 +21,7 @@
  
  
 #include "physics/ChLinkGear.h"
+#include "physics/ChStateSnapshot.h"
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
  
@@ -397,6 +398,24 @@ void ChLinkGear::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChLinkGear::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChLinkLock::StateSave(msnapshot);
+
+	msnapshot.Add(a1);
+	msnapshot.Add(a2);
+}
+
+void ChLinkGear::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChLinkLock::StateRestore(msnapshot);
+
+	a1 = msnapshot.Get();
+	a2 = msnapshot.Get();
+}
+
+
+
 ///////////////////////////////////////////////////////////////
 
 
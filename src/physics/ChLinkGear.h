@@ -177,6 +177,11 @@ public:
 	virtual void StreamIN(ChStreamInBinary& mstream);
 	virtual void StreamOUT(ChStreamOutBinary& mstream);
 
+						/// Save/restore also the total rotations of the two gears, for
+						/// ChSystem::StateSave() and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 };
 
 
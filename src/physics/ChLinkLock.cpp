@@ -23,6 +23,7 @@
 
 
 #include "physics/ChLinkLock.h"
+#include "physics/ChStateSnapshot.h"
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
 
@@ -1205,58 +1206,60 @@ void ChLinkLock::InjectConstraints(ChLcpSystemDescriptor& mdescriptor)
 	// parent 
 	ChLinkMasked::InjectConstraints(mdescriptor);
 
+	bool inject_all = InjectInactiveConstraints();
+
 	if (limit_X) if (limit_X->Get_active())
 	{
 		limit_X->constr_lower.SetVariables(&Body1->Variables(),&Body2->Variables());
 		limit_X->constr_upper.SetVariables(&Body1->Variables(),&Body2->Variables());
-		if (limit_X->constr_lower.IsActive())
+		if (inject_all || limit_X->constr_lower.IsActive())
 			mdescriptor.InsertConstraint(&limit_X->constr_lower);
-		if (limit_X->constr_upper.IsActive())
+		if (inject_all || limit_X->constr_upper.IsActive())
 			mdescriptor.InsertConstraint(&limit_X->constr_upper);
 	}
 	if (limit_Y) if (limit_Y->Get_active())
 	{
 		limit_Y->constr_lower.SetVariables(&Body1->Variables(),&Body2->Variables());
 		limit_Y->constr_upper.SetVariables(&Body1->Variables(),&Body2->Variables());
-		if (limit_Y->constr_lower.IsActive())
+		if (inject_all || limit_Y->constr_lower.IsActive())
 			mdescriptor.InsertConstraint(&limit_Y->constr_lower);
-		if (limit_Y->constr_upper.IsActive())
+		if (inject_all || limit_Y->constr_upper.IsActive())
 			mdescriptor.InsertConstraint(&limit_Y->constr_upper);
 	}
 	if (limit_Z) if (limit_Z->Get_active())
 	{
 		limit_Z->constr_lower.SetVariables(&Body1->Variables(),&Body2->Variables());
 		limit_Z->constr_upper.SetVariables(&Body1->Variables(),&Body2->Variables());
-		if (limit_Z->constr_lower.IsActive())
+		if (inject_all || limit_Z->constr_lower.IsActive())
 			mdescriptor.InsertConstraint(&limit_Z->constr_lower);
-		if (limit_Z->constr_upper.IsActive())
+		if (inject_all || limit_Z->constr_upper.IsActive())
 			mdescriptor.InsertConstraint(&limit_Z->constr_upper);
 	}
 	if (limit_Rx) if (limit_Rx->Get_active())
 	{
 		limit_Rx->constr_lower.SetVariables(&Body1->Variables(),&Body2->Variables());
 		limit_Rx->constr_upper.SetVariables(&Body1->Variables(),&Body2->Variables());
-		if (limit_Rx->constr_lower.IsActive())
+		if (inject_all || limit_Rx->constr_lower.IsActive())
 			mdescriptor.InsertConstraint(&limit_Rx->constr_lower);
-		if (limit_Rx->constr_upper.IsActive())
+		if (inject_all || limit_Rx->constr_upper.IsActive())
 			mdescriptor.InsertConstraint(&limit_Rx->constr_upper);
 	}
 	if (limit_Ry) if (limit_Ry->Get_active())
 	{
 		limit_Ry->constr_lower.SetVariables(&Body1->Variables(),&Body2->Variables());
 		limit_Ry->constr_upper.SetVariables(&Body1->Variables(),&Body2->Variables());
-		if (limit_Ry->constr_lower.IsActive())
+		if (inject_all || limit_Ry->constr_lower.IsActive())
 			mdescriptor.InsertConstraint(&limit_Ry->constr_lower);
-		if (limit_Ry->constr_upper.IsActive())
+		if (inject_all || limit_Ry->constr_upper.IsActive())
 			mdescriptor.InsertConstraint(&limit_Ry->constr_upper);
 	}
 	if (limit_Rz) if (limit_Rz->Get_active())
 	{
 		limit_Rz->constr_lower.SetVariables(&Body1->Variables(),&Body2->Variables());
 		limit_Rz->constr_upper.SetVariables(&Body1->Variables(),&Body2->Variables());
-		if (limit_Rz->constr_lower.IsActive())
+		if (inject_all || limit_Rz->constr_lower.IsActive())
 			mdescriptor.InsertConstraint(&limit_Rz->constr_lower);
-		if (limit_Rz->constr_upper.IsActive())
+		if (inject_all || limit_Rz->constr_upper.IsActive())
 			mdescriptor.InsertConstraint(&limit_Rz->constr_upper);
 	}
 }
@@ -1632,6 +1635,37 @@ void ChLinkLock::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChLinkLock::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChLinkMasked::StateSave(msnapshot);
+
+	ChLinkLimit* mlimits[6] = {limit_X, limit_Y, limit_Z, limit_Rx, limit_Ry, limit_Rz};
+	for (int i = 0; i < 6; i++)
+	{
+		msnapshot.Add(mlimits[i] ? mlimits[i]->constr_lower.Get_l_i() : 0.);
+		msnapshot.Add(mlimits[i] ? mlimits[i]->constr_upper.Get_l_i() : 0.);
+	}
+}
+
+void ChLinkLock::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChLinkMasked::StateRestore(msnapshot);
+
+	ChLinkLimit* mlimits[6] = {limit_X, limit_Y, limit_Z, limit_Rx, limit_Ry, limit_Rz};
+	for (int i = 0; i < 6; i++)
+	{
+		double ml_lower = msnapshot.Get();
+		double ml_upper = msnapshot.Get();
+		if (mlimits[i])
+		{
+			mlimits[i]->constr_lower.Set_l_i(ml_lower);
+			mlimits[i]->constr_upper.Set_l_i(ml_upper);
+		}
+	}
+}
+
+
+
 
 
 
@@ -248,6 +248,16 @@ public:
 	virtual void StreamIN(ChStreamInBinary& mstream);
 	virtual void StreamOUT(ChStreamOutBinary& mstream);
 
+			//
+			// STATE
+			//
+
+				/// Save/restore also the multipliers of the unilateral constraints
+				/// of the limits, that are kept for warm starting, for
+				/// ChSystem::StateSave() and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 };
 
 
@@ -23,6 +23,7 @@
 
 #include "physics/ChLinkMasked.h"
 #include "physics/ChSystem.h"
+#include "physics/ChStateSnapshot.h"
 #include "physics/ChGlobal.h"
 //#include "physics/ChCollide.h"
 
@@ -135,6 +136,8 @@ void ChLinkMasked::BuildLink ()
 	ndoc_c = mask->GetMaskDoc_c();
 	ndoc_d = mask->GetMaskDoc_d();
 
+	if (GetSystem())
+		GetSystem()->ResetIncrementalInjection(); // constraints must be injected again
 
                 // create matrices
     if (ndoc > 0)
@@ -283,9 +286,11 @@ void ChLinkMasked::InjectConstraints(ChLcpSystemDescriptor& mdescriptor)
 	if (!this->IsActive())
 		return;
 
+	bool inject_all = InjectInactiveConstraints();
+
 	for (int i=0; i< mask->nconstr; i++)
 	{
-		if (mask->Constr_N(i).IsActive())
+		if (inject_all || mask->Constr_N(i).IsActive())
 			mdescriptor.InsertConstraint(&mask->Constr_N(i));
 	}
 }
@@ -677,6 +682,37 @@ void ChLinkMasked::StreamIN(ChStreamInBinary& mstream)
 
 
  
+
+
+
+void ChLinkMasked::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChLink::StateSave(msnapshot);
+
+	msnapshot.Add(cache_li_speed ? cache_li_speed->GetRows() : 0);
+	if (cache_li_speed)
+	{
+		msnapshot.Add(*cache_li_speed);
+		msnapshot.Add(*cache_li_pos);
+	}
+}
+
+void ChLinkMasked::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChLink::StateRestore(msnapshot);
+
+	int ncache = (int)msnapshot.Get();
+	if (ncache != (cache_li_speed ? cache_li_speed->GetRows() : 0))
+		throw ChException("The state snapshot does not match the constraints of the link");
+	if (cache_li_speed)
+	{
+		msnapshot.Get(*cache_li_speed);
+		msnapshot.Get(*cache_li_pos);
+	}
+}
+
+
+
 } // END_OF_NAMESPACE____
 
 
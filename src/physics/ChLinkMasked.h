@@ -137,7 +137,7 @@ public:
 
 
 					/// Set the status of link validity
-	virtual void SetValid(bool mon) {valid = mon;}
+	virtual void SetValid(bool mon) {ChLinkMarkers::SetValid(mon);}
 
 					/// User can use this to enable/disable all the constraint of
 					/// the link as desired.
@@ -303,6 +303,11 @@ public:
 					/// as a readable item, for example   "chrono::GetLog() << myobject;"
 	virtual void StreamOUT(ChStreamOutAscii& mstream) {};
 
+					/// Save/restore the reactions and the cached multipliers, for ChSystem::StateSave()
+					/// and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 
 protected:
 					// Internal use only - transforms a Nx7 jacobian matrix for a 
@@ -21,6 +21,7 @@
   
 #include "physics/ChLinkMate.h"
 #include "physics/ChSystem.h"
+#include "physics/ChStateSnapshot.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
@@ -191,6 +192,9 @@ void ChLinkMateGeneric::ChangedLinkMask()
 	ndoc   = mask->GetMaskDoc();
 	ndoc_c = mask->GetMaskDoc_c();
 	ndoc_d = mask->GetMaskDoc_d();
+
+	if (GetSystem())
+		GetSystem()->ResetIncrementalInjection(); // constraints must be injected again
 }
 
 
@@ -389,9 +393,11 @@ void ChLinkMateGeneric::InjectConstraints(ChLcpSystemDescriptor& mdescriptor)
 	if (!this->IsActive())
 		return;
 
+	bool inject_all = InjectInactiveConstraints();
+
 	for (int i=0; i< mask->nconstr; i++)
 	{
-		if (mask->Constr_N(i).IsActive())
+		if (inject_all || mask->Constr_N(i).IsActive())
 			mdescriptor.InsertConstraint(&mask->Constr_N(i));
 	}
 }
@@ -1072,6 +1078,32 @@ void ChLinkMateOrthogonal::Update (double mtime)
 
 
 
+void ChLinkMateGeneric::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChLinkMate::StateSave(msnapshot);
+
+	msnapshot.Add(cache_li_speed ? cache_li_speed->GetRows() : 0);
+	if (cache_li_speed)
+	{
+		msnapshot.Add(*cache_li_speed);
+		msnapshot.Add(*cache_li_pos);
+	}
+}
+
+void ChLinkMateGeneric::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChLinkMate::StateRestore(msnapshot);
+
+	int ncache = (int)msnapshot.Get();
+	if (ncache != (cache_li_speed ? cache_li_speed->GetRows() : 0))
+		throw ChException("The state snapshot does not match the constraints of the link");
+	if (cache_li_speed)
+	{
+		msnapshot.Get(*cache_li_speed);
+		msnapshot.Get(*cache_li_pos);
+	}
+}
+
 
 
 } // END_OF_NAMESPACE____
@@ -218,7 +218,7 @@ public:
 	virtual int  RestoreRedundant();		   ///< \return number of changed states
 
 					/// Set the status of link validity
-	virtual void SetValid(bool mon) {valid = mon;}
+	virtual void SetValid(bool mon) {ChLinkMate::SetValid(mon);}
 
 					/// User can use this to enable/disable all the constraint of
 					/// the link as desired.
@@ -246,6 +246,13 @@ public:
 	virtual void ConstraintsLiFetchSuggestedPositionSolution();
 	virtual void ConstraintsFetch_react(double factor=1.);
 
+				//
+				// STATE SNAPSHOTS
+				//
+
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 protected:
 	void SetupLinkMask();
 	void ChangedLinkMask();
@@ -21,6 +21,7 @@
  
  
 #include "physics/ChLinkPneumaticActuator.h"
+#include "physics/ChStateSnapshot.h"
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
 
@@ -288,6 +289,32 @@ void ChLinkPneumaticActuator::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChLinkPneumaticActuator::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChLinkLock::StateSave(msnapshot);
+
+	msnapshot.Add(pA);
+	msnapshot.Add(pB);
+	msnapshot.Add(pA_dt);
+	msnapshot.Add(pB_dt);
+	msnapshot.Add(pneu_F);
+	msnapshot.Add(last_force_time);
+}
+
+void ChLinkPneumaticActuator::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChLinkLock::StateRestore(msnapshot);
+
+	pA = msnapshot.Get();
+	pB = msnapshot.Get();
+	pA_dt = msnapshot.Get();
+	pB_dt = msnapshot.Get();
+	pneu_F = msnapshot.Get();
+	last_force_time = msnapshot.Get();
+}
+
+
+
 ///////////////////////////////////////////////////////////////
 
 
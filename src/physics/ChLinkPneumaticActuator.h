@@ -122,6 +122,11 @@ public:
 	virtual void StreamIN(ChStreamInBinary& mstream);
 	virtual void StreamOUT(ChStreamOutBinary& mstream);
 
+						/// Save/restore also the pressures in the chambers, for
+						/// ChSystem::StateSave() and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 };
 
 
@@ -21,6 +21,7 @@
  
  
 #include "physics/ChLinkPulley.h"
+#include "physics/ChStateSnapshot.h"
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
  
@@ -311,6 +312,24 @@ void ChLinkPulley::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChLinkPulley::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChLinkLock::StateSave(msnapshot);
+
+	msnapshot.Add(a1);
+	msnapshot.Add(a2);
+}
+
+void ChLinkPulley::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChLinkLock::StateRestore(msnapshot);
+
+	a1 = msnapshot.Get();
+	a2 = msnapshot.Get();
+}
+
+
+
 ///////////////////////////////////////////////////////////////
 
 
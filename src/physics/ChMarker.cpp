@@ -239,8 +239,8 @@ Vector ChMarker::Dir_Ref2World (Vector* mpoint)
 
 void ChMarker::UpdateTime (double mytime)
 {
-	static Coordsys csys, csys_dt, csys_dtdt;
-	static Quaternion qtemp;
+	Coordsys csys, csys_dt, csys_dtdt;
+	Quaternion qtemp;
 	double ang, ang_dt, ang_dtdt;
 
 	ChTime = mytime;
@@ -28,6 +28,7 @@
 
 #include "physics/ChExternalObject.h"
 #include "physics/ChProximityContainerSPH.h"
+#include "parallel/ChTaskPool.h"
 #include "collision/ChCModelBulletNode.h"
 #include "core/ChLinearAlgebra.h"
 
@@ -118,15 +119,52 @@ ChNodeSPH& ChNodeSPH::operator= (const ChNodeSPH& other)
 void ChNodeSPH::SetKernelRadius(double mr)
 {
 	h_rad = mr;
-	double aabb_rad = h_rad/2; // to avoid too many pairs: bounding boxes hemisizes will sum..  __.__--*--
-	((ChModelBulletNode*)this->collision_model)->SetSphereRadius(coll_rad, ChMax(0.0, aabb_rad-coll_rad) );
+	UpdateCollisionEnvelope();
 }
 	
 void ChNodeSPH::SetCollisionRadius(double mr)
 {
 	coll_rad = mr;
+	UpdateCollisionEnvelope();
+}
+
+void ChNodeSPH::UpdateCollisionEnvelope()
+{
+	ChModelBulletNode* mmodel = (ChModelBulletNode*)this->collision_model;
+
+	// If the cluster finds the neighbors by itself, the collision model
+	// is needed only for contacts, so it is not inflated.
+	ChMatterSPH* mmatter = dynamic_cast<ChMatterSPH*>(mmodel->GetNodes());
+	if (mmatter && mmatter->GetUseNeighborGrid())
+	{
+		mmodel->SetSphereRadius(coll_rad, coll_rad);
+		return;
+	}
+
 	double aabb_rad = h_rad/2; // to avoid too many pairs: bounding boxes hemisizes will sum..  __.__--*--
-	((ChModelBulletNode*)this->collision_model)->SetSphereRadius(coll_rad, ChMax(0.0, aabb_rad-coll_rad) );
+	mmodel->SetSphereRadius(coll_rad, ChMax(0.0, aabb_rad-coll_rad) );
+}
+
+void ChNodeSPH::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChNodeXYZ::StateSave(msnapshot);
+
+	msnapshot.Add(this->h_rad);
+	msnapshot.Add(this->coll_rad);
+}
+
+void ChNodeSPH::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChNodeXYZ::StateRestore(msnapshot);
+
+	double mh_rad = msnapshot.Get();
+	double mcoll_rad = msnapshot.Get();
+	if (mh_rad != this->h_rad || mcoll_rad != this->coll_rad)
+	{
+		this->h_rad = mh_rad;
+		this->coll_rad = mcoll_rad;
+		UpdateCollisionEnvelope();
+	}
 }
 
 
@@ -173,11 +211,147 @@ void ChContinuumSPH::StreamIN(ChStreamInBinary& mstream)
 /// CLASS FOR SPH NODE CLUSTER
 
 
+// Bodies of the per-particle loops on the neighbor grid. Each
+// particle sums the contributions of its neighbors, and writes
+// only its own results, so there are no conflicts between threads.
+
+class ChMatterSPHdensitySum
+{
+public:
+	const ChNeighborGridSPH* grid;
+	double x, y, z, h;
+	double sum;
+	void operator()(int i, int j)
+	{
+		double dx = grid->pos_x[j] - x;
+		double dy = grid->pos_y[j] - y;
+		double dz = grid->pos_z[j] - z;
+		double r2 = dx*dx + dy*dy + dz*dz;
+		double h_ij = 0.5*(h + grid->h_rad[j]);
+		if (r2 < h_ij*h_ij)
+			sum += grid->mass[j] * ChContinuumSPH::W_poly6( sqrt(r2), h_ij );
+	}
+};
+
+class ChMatterSPHforceSum
+{
+public:
+	const ChNeighborGridSPH* grid;
+	double x, y, z, h;
+	ChVector<> vel;
+	double volume, pressure, viscosity;
+	ChVector<> force;
+	void operator()(int i, int j)
+	{
+		ChVector<> r_BA(grid->pos_x[j] - x, grid->pos_y[j] - y, grid->pos_z[j] - z);
+		double r2 = r_BA.Length2();
+		double h_ij = 0.5*(h + grid->h_rad[j]);
+		if (r2 >= h_ij*h_ij)
+			return;
+		double dist_BA = sqrt(r2);
+
+		// pressure forces
+		ChVector<> W_k_press;
+		ChContinuumSPH::W_gr_press( W_k_press, r_BA, dist_BA, h_ij );
+		double avg_press = 0.5*(pressure + grid->pressure[j]);
+		force += W_k_press * (volume * avg_press * grid->volume[j]);
+
+		// viscous forces
+		double W_k_visc = ChContinuumSPH::W_sq_visco( dist_BA, h_ij );
+		ChVector<> velBA(grid->vel_x[j] - vel.x, grid->vel_y[j] - vel.y, grid->vel_z[j] - vel.z);
+		force += velBA * (volume * viscosity * grid->volume[j] * W_k_visc);
+	}
+};
+
+class ChMatterSPHdensities : public ChTaskPoolLoop
+{
+public:
+	ChNeighborGridSPH* grid;
+	double pressure_stiffness;
+	double ref_density;
+	virtual void Run(int begin, int end)
+	{
+		ChMatterSPHdensitySum msum;
+		msum.grid = grid;
+		for (int i = begin; i < end; i++)
+		{
+			msum.x = grid->pos_x[i];
+			msum.y = grid->pos_y[i];
+			msum.z = grid->pos_z[i];
+			msum.h = grid->h_rad[i];
+			msum.sum = 0;
+			grid->VisitNeighbors(i, msum);
+
+			// node volume is v=mass/density, node pressure = k(dens - dens_0);
+			double dens = msum.sum;
+			grid->density[i]  = dens;
+			grid->volume[i]   = dens ? grid->mass[i]/dens : 0;
+			grid->pressure[i] = pressure_stiffness * (dens - ref_density);
+		}
+	}
+};
+
+class ChMatterSPHforces : public ChTaskPoolLoop
+{
+public:
+	ChNeighborGridSPH* grid;
+	double viscosity;
+	virtual void Run(int begin, int end)
+	{
+		ChMatterSPHforceSum msum;
+		msum.grid = grid;
+		msum.viscosity = viscosity;
+		for (int i = begin; i < end; i++)
+		{
+			msum.x = grid->pos_x[i];
+			msum.y = grid->pos_y[i];
+			msum.z = grid->pos_z[i];
+			msum.h = grid->h_rad[i];
+			msum.vel.Set(grid->vel_x[i], grid->vel_y[i], grid->vel_z[i]);
+			msum.volume   = grid->volume[i];
+			msum.pressure = grid->pressure[i];
+			msum.force = VNULL;
+			grid->VisitNeighbors(i, msum);
+
+			grid->force_x[i] = msum.force.x;
+			grid->force_y[i] = msum.force.y;
+			grid->force_z[i] = msum.force.z;
+		}
+	}
+};
+
+class ChMatterSPHstoreResults : public ChTaskPoolLoop
+{
+public:
+	ChNeighborGridSPH* grid;
+	ChNodeSPH** nodes;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			ChNodeSPH* mnode = nodes[grid->GetNodeIndex(i)];
+			mnode->density  = grid->density[i];
+			mnode->volume   = grid->volume[i];
+			mnode->pressure = grid->pressure[i];
+			mnode->UserForce.Set(grid->force_x[i], grid->force_y[i], grid->force_z[i]);
+		}
+	}
+};
+
+
+
 ChMatterSPH::ChMatterSPH ()
 {
 	this->do_collide = false;
 
+	this->use_neighbor_grid = false;
+
 	this->nodes.clear();
+	this->node_block = 0;
+	this->node_block_size = 0;
+
+	this->sort_interval = 0;
+	this->sort_counter = 0;
 
 	SetIdentifier(CHGLOBALS().GetUniqueIntID()); // mark with unique ID
 
@@ -198,6 +372,8 @@ void ChMatterSPH::Copy(ChMatterSPH* source)
 	ChIndexedNodes::Copy(source);
 
 	do_collide = source->do_collide;
+	use_neighbor_grid = source->use_neighbor_grid;
+	sort_interval = source->sort_interval;
 
 	this->material = source->material;
 	
@@ -212,17 +388,21 @@ void ChMatterSPH::ResizeNnodes(int newsize)
 	bool oldcoll = this->GetCollide();
 	this->SetCollide(false); // this will remove old particle coll.models from coll.engine, if previously added
 
-	for (unsigned int j = 0; j < nodes.size(); j++)
+	for (unsigned int j = node_block_size; j < nodes.size(); j++)
 	{
 		delete (this->nodes[j]);
 		this->nodes[j] = 0;
 	}
+	delete [] node_block;
 
+		// the new nodes are allocated in a single block
 	this->nodes.resize(newsize);
+	this->node_block_size = newsize;
+	this->node_block = newsize ? new ChNodeSPH[newsize] : 0;
 
 	for (unsigned int j = 0; j < nodes.size(); j++)
 	{
-		this->nodes[j] = new ChNodeSPH;
+		this->nodes[j] = &node_block[j];
 
 		this->nodes[j]->variables.SetUserData((void*)this); // UserData unuseful in future cuda solver?
 		((ChModelBulletNode*)this->nodes[j]->collision_model)->SetNode(this,j);
@@ -251,6 +431,86 @@ void ChMatterSPH::AddNode(ChVector<double> initial_state)
 
 
 
+// Exchange the data of two nodes, with their collision models (so the
+// models that are in the collision engine follow the data of their nodes).
+static void SwapNodeData(ChNodeSPH& ma, ChNodeSPH& mb)
+{
+	std::swap(ma.pos,      mb.pos);
+	std::swap(ma.pos_dt,   mb.pos_dt);
+	std::swap(ma.pos_dtdt, mb.pos_dtdt);
+
+	double mass = ma.GetMass();
+	ma.SetMass(mb.GetMass());
+	mb.SetMass(mass);
+	bool disabled = ma.variables.IsDisabled();
+	ma.variables.SetDisabled(mb.variables.IsDisabled());
+	mb.variables.SetDisabled(disabled);
+	for (int i = 0; i < 3; i++)
+	{
+		std::swap(ma.variables.Get_qb()(i), mb.variables.Get_qb()(i));
+		std::swap(ma.variables.Get_fb()(i), mb.variables.Get_fb()(i));
+	}
+
+	std::swap(ma.collision_model, mb.collision_model);
+	std::swap(ma.UserForce, mb.UserForce);
+	std::swap(ma.volume,    mb.volume);
+	std::swap(ma.density,   mb.density);
+	std::swap(ma.h_rad,     mb.h_rad);
+	std::swap(ma.coll_rad,  mb.coll_rad);
+	std::swap(ma.pressure,  mb.pressure);
+}
+
+
+void ChMatterSPH::SortNodes()
+{
+	unsigned int nnodes = nodes.size();
+
+	// Move the nodes that were added one by one in a new block
+
+	if (nnodes != node_block_size)
+	{
+		ChNodeSPH* new_block = new ChNodeSPH[nnodes];
+		for (unsigned int j = 0; j < nnodes; j++)
+		{
+			new_block[j].variables.SetUserData((void*)this);
+			SwapNodeData(new_block[j], *nodes[j]);
+			if (j >= node_block_size)
+				delete (this->nodes[j]);
+			this->nodes[j] = &new_block[j];
+		}
+		delete [] node_block;
+		node_block = new_block;
+		node_block_size = nnodes;
+	}
+
+	// Permute the data of the nodes in place, following the cycles of 
+	// the permutation, so that the j-th node gets the data of order[j].
+
+	std::vector<int> order;
+	this->ComputeMortonOrder(order);
+
+	std::vector<char> done(nnodes, 0);
+	for (unsigned int start = 0; start < nnodes; start++)
+	{
+		if (done[start])
+			continue;
+		int j = start;
+		done[j] = 1;
+		while (order[j] != (int)start)
+		{
+			SwapNodeData(*nodes[j], *nodes[order[j]]);
+			j = order[j];
+			done[j] = 1;
+		}
+	}
+
+	for (unsigned int j = 0; j < nnodes; j++)
+	{
+		((ChModelBulletNode*)this->nodes[j]->collision_model)->SetNode(this,j);
+	}
+}
+
+
 void ChMatterSPH::FillBox (const ChVector<> size,	
 				  const double spacing,		
 				  const double initial_density, 
@@ -331,52 +591,83 @@ void ChMatterSPH::VariablesFbLoadForces(double factor)
 
 	// COMPUTE THE SPH FORCES HERE
 
-	// First, find if any ChProximityContainerSPH object is present
-	// in the system,
-
-	ChProximityContainerSPH* edges =0;
-	std::list<ChPhysicsItem*>::iterator iterotherphysics = this->GetSystem()->Get_otherphysicslist()->begin();
-	while (iterotherphysics != this->GetSystem()->Get_otherphysicslist()->end())
+	if (this->use_neighbor_grid)
 	{
-		if (edges=dynamic_cast<ChProximityContainerSPH*>(*iterotherphysics))
-			break;
-		iterotherphysics++;
-	}
-	assert(edges); // If using a ChMatterSPH, you must add also a ChProximityContainerSPH.
-	
+		// 1- Sort the particles in the cells of the neighbor grid
 
-	// 1- Per-node initialization
+		neighbor_grid.Build(this->nodes, this->GetSystem());
+		int nparticles = neighbor_grid.GetNparticles();
 
-	for (unsigned int j = 0; j < nodes.size(); j++)
-	{
-		this->nodes[j]->UserForce = VNULL;
-		this->nodes[j]->density = 0;
-	}
+		// 2- Per-particle density, volume and pressure, summing on neighbors
 
-	// 2- Per-edge initialization and accumulation of particles's density
+		ChMatterSPHdensities mdensities;
+		mdensities.grid = &neighbor_grid;
+		mdensities.pressure_stiffness = this->material.Get_pressure_stiffness();
+		mdensities.ref_density = this->material.Get_density();
+		this->GetSystem()->RunItemsLoop(nparticles, mdensities);
 
-	edges->AccumulateStep1();
+		// 3- Per-particle pressure and viscous forces, summing on neighbors
 
-	// 3- Per-node volume and pressure computation
+		ChMatterSPHforces mforces;
+		mforces.grid = &neighbor_grid;
+		mforces.viscosity = this->material.Get_viscosity();
+		this->GetSystem()->RunItemsLoop(nparticles, mforces);
 
-	for (unsigned int j = 0; j < nodes.size(); j++)
+		// 4- Store results in nodes
+
+		ChMatterSPHstoreResults mstore;
+		mstore.grid = &neighbor_grid;
+		mstore.nodes = nparticles ? &this->nodes[0] : 0;
+		this->GetSystem()->RunItemsLoop(nparticles, mstore);
+	}
+	else
 	{
-		ChNodeSPH* mnode = this->nodes[j];
+		// First, find if any ChProximityContainerSPH object is present
+		// in the system,
 
-		// node volume is v=mass/density
-		if (mnode->density)
-			mnode->volume = mnode->GetMass()/mnode->density;
-		else 
-			mnode->volume = 0; 
+		ChProximityContainerSPH* edges =0;
+		std::list<ChPhysicsItem*>::iterator iterotherphysics = this->GetSystem()->Get_otherphysicslist()->begin();
+		while (iterotherphysics != this->GetSystem()->Get_otherphysicslist()->end())
+		{
+			if ((edges=dynamic_cast<ChProximityContainerSPH*>(*iterotherphysics)))
+				break;
+			iterotherphysics++;
+		}
+		assert(edges); // If using a ChMatterSPH, you must add also a ChProximityContainerSPH.
+	
 
-		// node pressure = k(dens - dens_0);
-		mnode->pressure = this->material.Get_pressure_stiffness() * ( mnode->density - this->material.Get_density() );
-	}
+		// 1- Per-node initialization
+
+		for (unsigned int j = 0; j < nodes.size(); j++)
+		{
+			this->nodes[j]->UserForce = VNULL;
+			this->nodes[j]->density = 0;
+		}
+
+		// 2- Per-edge initialization and accumulation of particles's density
 
-	// 4- Per-edge forces computation and accumulation
+		edges->AccumulateStep1();
 
-	edges->AccumulateStep2();
+		// 3- Per-node volume and pressure computation
 
+		for (unsigned int j = 0; j < nodes.size(); j++)
+		{
+			ChNodeSPH* mnode = this->nodes[j];
+
+			// node volume is v=mass/density
+			if (mnode->density)
+				mnode->volume = mnode->GetMass()/mnode->density;
+			else 
+				mnode->volume = 0; 
+
+			// node pressure = k(dens - dens_0);
+			mnode->pressure = this->material.Get_pressure_stiffness() * ( mnode->density - this->material.Get_density() );
+		}
+
+		// 4- Per-edge forces computation and accumulation
+
+		edges->AccumulateStep2();
+	}
 
 	// 5- Per-node load forces in LCP
 
@@ -530,8 +821,26 @@ void ChMatterSPH::SetCollide (bool mcoll)
 	}
 }
 
+void ChMatterSPH::SetUseNeighborGrid (bool mg)
+{
+	this->use_neighbor_grid = mg;
+
+	// update the size of the collision models
+	for (unsigned int j = 0; j < nodes.size(); j++)
+	{
+		this->nodes[j]->UpdateCollisionEnvelope();
+	}
+}
+
 void ChMatterSPH::SyncCollisionModels()
 {
+	// Sort the nodes now, if needed, before the contacts refer to them
+	if (sort_interval > 0 && ++sort_counter >= sort_interval)
+	{
+		sort_counter = 0;
+		this->SortNodes();
+	}
+
 	for (unsigned int j = 0; j < nodes.size(); j++)
 	{
 		this->nodes[j]->collision_model->SyncPosition();
@@ -573,6 +882,27 @@ void ChMatterSPH::UpdateParticleCollisionModels()
 
 
 
+void ChMatterSPH::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChIndexedNodes::StateSave(msnapshot);
+
+	msnapshot.Add(this->sort_counter);
+}
+
+void ChMatterSPH::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChIndexedNodes::StateRestore(msnapshot);
+
+	this->sort_counter = (int)msnapshot.Get();
+
+	for (unsigned int j = 0; j < nodes.size(); j++)
+	{
+		this->nodes[j]->collision_model->SyncPosition();
+	}
+}
+
+
+
 //////// FILE I/O
 
 void ChMatterSPH::StreamOUT(ChStreamOutBinary& mstream)
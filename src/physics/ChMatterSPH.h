@@ -35,6 +35,7 @@
 
 #include "physics/ChIndexedNodes.h"
 #include "physics/ChContinuumMaterial.h"
+#include "physics/ChNeighborGridSPH.h"
 #include "collision/ChCCollisionModel.h"
 #include "lcp/ChLcpVariablesNode.h"
 
@@ -85,6 +86,15 @@ public:
 			// Access the 'LCP variables' of the node
 	ChLcpVariables& Variables() {return variables;}
 
+			// Resize the collision model after changes of the radii, or
+			// of the neighbor search mode of the cluster
+	void UpdateCollisionEnvelope();
+
+			// Save/restore the state of the node, also the radii because
+			// the nodes are reordered in memory, see ChMatterSPH::SortNodes()
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 					//
 					// DATA
 					// 
@@ -144,6 +154,45 @@ public:
 	double Get_pressure_stiffness() {return pressure_stiffness;}
 
 
+			/// Smoothing kernel for the density (poly6), at distance r,
+			/// for kernel radius h.
+	static double W_poly6(double r, double h)
+	{
+		if (r < h)
+		{
+			double h3 = h*h*h;
+			double d = h*h - r*r;
+			return (315.0 / (64.0 * CH_C_PI * h3*h3*h3) ) * d*d*d;
+		}
+		else return 0;
+	}
+
+			/// Laplacian of the smoothing kernel for the viscosity,
+			/// at distance r, for kernel radius h.
+	static double W_sq_visco(double r, double h)
+	{
+		if (r < h)
+		{
+			double h3 = h*h*h;
+			return (45.0 / (CH_C_PI * h3*h3) ) * (h - r);
+		}
+		else return 0;
+	}
+
+			/// Gradient of the smoothing kernel for the pressure (spiky),
+			/// for the vector r of length r_length, for kernel radius h.
+	static void W_gr_press(ChVector<>& Wresult, const ChVector<>& r, const double r_length, const double h)
+	{
+		if (r_length < h)
+		{
+			double h3 = h*h*h;
+			Wresult = r;
+			Wresult *= -(45.0 / (CH_C_PI * h3*h3) ) * (h - r_length)*(h - r_length);
+		}
+		else Wresult = VNULL;
+	}
+
+
 				/// Method to allow deserializing 
 	void StreamIN(ChStreamInBinary& mstream);
 
@@ -173,10 +222,21 @@ private:
 						// The nodes: 
 	std::vector<ChNodeSPH*> nodes;				
 
+						// Contiguous storage of the first node_block_size nodes 
+						// (nodes added later with AddNode() are allocated one by one)
+	ChNodeSPH* node_block;
+	unsigned int node_block_size;
+
+	int sort_interval;
+	int sort_counter;
+
 	ChContinuumSPH material;
 
 	bool do_collide;
 
+	bool use_neighbor_grid;
+	ChNeighborGridSPH neighbor_grid;
+
 public:
 
 			//
@@ -206,6 +266,22 @@ public:
 	void  SetCollide (bool mcoll);
 	bool  GetCollide() {return do_collide;}
 
+				/// Enable/disable the search of the neighbors of the particles
+				/// with the cell-linked list of this cluster (see ChNeighborGridSPH).
+				/// In this case the SPH forces between the particles of this cluster
+				/// are computed without a ChProximityContainerSPH, and the collision 
+				/// models of the particles, if collision is on, are used only for the
+				/// contacts with other objects: there is no SPH interaction with the
+				/// particles of other clusters. Default: off, i.e. the SPH forces come 
+				/// from the proximity pairs found by the collision engine and stored 
+				/// in a ChProximityContainerSPH, that must be added to the system.
+	void  SetUseNeighborGrid (bool mg);
+	bool  GetUseNeighborGrid() {return use_neighbor_grid;}
+
+				/// Access the cell-linked list used for the neighbor search, 
+				/// with the data of the particles sorted by cell at last step.
+	ChNeighborGridSPH& GetNeighborGrid() {return neighbor_grid;}
+
 
 			//
 	  		// FUNCTIONS
@@ -225,6 +301,20 @@ public:
 				/// vector as initial position.
 	void AddNode(ChVector<double> initial_state);
 
+				/// Sort the nodes along a Morton curve through their positions,
+				/// and store them in a single contiguous block of memory, so that
+				/// the loops on nodes (and on the neighbors of nodes) access memory 
+				/// almost sequentially. The data of the nodes is moved, so after
+				/// this the index of a node, and the node returned by GetNode()
+				/// for an index, are different.
+	void SortNodes();
+
+				/// Sort the nodes with SortNodes() every 'nsteps' time steps, to
+				/// keep their order as they move. The sorting is done just before
+				/// the collision detection. Default 0: never.
+	void SetNodeSortingInterval(int nsteps) {sort_interval = nsteps; sort_counter = 0;}
+	int  GetNodeSortingInterval() {return sort_interval;}
+
 
 
 		//
@@ -324,6 +414,16 @@ public:
 	void UpdateExternalGeometry ();
 
 
+			//
+			// STATE
+			//
+
+				/// Save/restore the state of all the nodes, for ChSystem::StateSave()
+				/// and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
+
 			//
 			// STREAMING
 			//
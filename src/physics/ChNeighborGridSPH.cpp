@@ -0,0 +1,205 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChNeighborGridSPH.cpp
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <math.h>
+
+#include "physics/ChNeighborGridSPH.h"
+#include "physics/ChMatterSPH.h"
+#include "physics/ChSystem.h"
+#include "parallel/ChTaskPool.h"
+
+#include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
+
+
+namespace chrono
+{
+
+
+// Bodies of the per-particle loops of Build().
+
+class ChNeighborGridCells : public ChTaskPoolLoop
+{
+public:
+	ChNodeSPH** nodes;
+	int* node_cell;
+	double ox, oy, oz, inv_size;
+	int nx, ny, nz;
+	virtual void Run(int begin, int end)
+	{
+		for (int j = begin; j < end; j++)
+		{
+			const ChVector<>& p = nodes[j]->GetPos();
+			int ix = ChMin(nx-1, ChMax(0, (int)((p.x - ox) * inv_size)));
+			int iy = ChMin(ny-1, ChMax(0, (int)((p.y - oy) * inv_size)));
+			int iz = ChMin(nz-1, ChMax(0, (int)((p.z - oz) * inv_size)));
+			node_cell[j] = (iz * ny + iy) * nx + ix;
+		}
+	}
+};
+
+class ChNeighborGridCopy : public ChTaskPoolLoop
+{
+public:
+	ChNodeSPH** nodes;
+	ChNeighborGridSPH* grid;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			ChNodeSPH* mnode = nodes[grid->GetNodeIndex(i)];
+			const ChVector<>& p = mnode->GetPos();
+			const ChVector<>& v = mnode->GetPos_dt();
+			grid->pos_x[i] = p.x;
+			grid->pos_y[i] = p.y;
+			grid->pos_z[i] = p.z;
+			grid->vel_x[i] = v.x;
+			grid->vel_y[i] = v.y;
+			grid->vel_z[i] = v.z;
+			grid->mass[i]  = mnode->GetMass();
+			grid->h_rad[i] = mnode->GetKernelRadius();
+		}
+	}
+};
+
+
+
+ChNeighborGridSPH::ChNeighborGridSPH()
+{
+	origin_x = origin_y = origin_z = 0;
+	cell_size = 1;
+	nx = ny = nz = 1;
+	cell_start.assign(2, 0);
+}
+
+
+void ChNeighborGridSPH::Build(std::vector<ChNodeSPH*>& nodes, ChSystem* msystem)
+{
+	int n = (int)nodes.size();
+
+	ids.resize(n);
+	cell.resize(n);
+	node_cell.resize(n);
+	pos_x.resize(n); pos_y.resize(n); pos_z.resize(n);
+	vel_x.resize(n); vel_y.resize(n); vel_z.resize(n);
+	mass.resize(n);
+	h_rad.resize(n);
+	density.resize(n);
+	volume.resize(n);
+	pressure.resize(n);
+	force_x.resize(n); force_y.resize(n); force_z.resize(n);
+
+	if (n == 0)
+	{
+		nx = ny = nz = 1;
+		cell_start.assign(2, 0);
+		return;
+	}
+
+	// Bounding box of the particles, and largest kernel radius
+
+	ChVector<> pmin = nodes[0]->GetPos();
+	ChVector<> pmax = pmin;
+	double hmax = 0;
+	for (int j = 0; j < n; j++)
+	{
+		const ChVector<>& p = nodes[j]->GetPos();
+		pmin.x = ChMin(pmin.x, p.x);  pmax.x = ChMax(pmax.x, p.x);
+		pmin.y = ChMin(pmin.y, p.y);  pmax.y = ChMax(pmax.y, p.y);
+		pmin.z = ChMin(pmin.z, p.z);  pmax.z = ChMax(pmax.z, p.z);
+		hmax = ChMax(hmax, nodes[j]->GetKernelRadius());
+	}
+	ChVector<> extent = pmax - pmin;
+	if (hmax <= 0)
+		hmax = ChMax(1e-9, ChMax(extent.x, ChMax(extent.y, extent.z)));
+
+	// Cells as large as the kernel radius, but enlarged if there would
+	// be many more cells than particles (ex. for splashes in a large space)
+
+	double max_cells = 4.0 * n + 64;
+	cell_size = hmax;
+	while (true)
+	{
+		double ncells = (floor(extent.x / cell_size) + 1) *
+						(floor(extent.y / cell_size) + 1) *
+						(floor(extent.z / cell_size) + 1);
+		if (ncells <= max_cells)
+			break;
+		cell_size *= ChMax(1.1, pow(ncells / max_cells, 1.0/3.0));
+	}
+	nx = (int)floor(extent.x / cell_size) + 1;
+	ny = (int)floor(extent.y / cell_size) + 1;
+	nz = (int)floor(extent.z / cell_size) + 1;
+	origin_x = pmin.x;
+	origin_y = pmin.y;
+	origin_z = pmin.z;
+	int ncells = nx * ny * nz;
+
+	// Cell of each particle
+
+	ChNeighborGridCells mcells;
+	mcells.nodes = &nodes[0];
+	mcells.node_cell = &node_cell[0];
+	mcells.ox = origin_x;
+	mcells.oy = origin_y;
+	mcells.oz = origin_z;
+	mcells.inv_size = 1.0 / cell_size;
+	mcells.nx = nx;
+	mcells.ny = ny;
+	mcells.nz = nz;
+	if (msystem)
+		msystem->RunItemsLoop(n, mcells);
+	else
+		mcells.Run(0, n);
+
+	// Counting sort by cell. It is stable, so the order of the
+	// particles in each cell is always the order of the nodes.
+
+	cell_start.assign(ncells + 1, 0);
+	for (int j = 0; j < n; j++)
+		cell_start[node_cell[j] + 1]++;
+	for (int c = 0; c < ncells; c++)
+		cell_start[c + 1] += cell_start[c];
+
+	cell_fill.assign(cell_start.begin(), cell_start.end() - 1);
+	for (int j = 0; j < n; j++)
+	{
+		int i = cell_fill[node_cell[j]]++;
+		ids[i] = j;
+		cell[i] = node_cell[j];
+	}
+
+	// Copy the data of the particles in the order of the cells
+
+	ChNeighborGridCopy mcopy;
+	mcopy.nodes = &nodes[0];
+	mcopy.grid = this;
+	if (msystem)
+		msystem->RunItemsLoop(n, mcopy);
+	else
+		mcopy.Run(0, n);
+}
+
+
+
+} // END_OF_NAMESPACE____
+
+
+/////////////////////
@@ -0,0 +1,146 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHNEIGHBORGRIDSPH_H
+#define CHNEIGHBORGRIDSPH_H
+
+//////////////////////////////////////////////////
+//
+//   ChNeighborGridSPH.h
+//
+//   Cell-linked list for the neighbor search in
+//   clusters of SPH particles.
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <vector>
+#include "core/ChApiCE.h"
+
+
+namespace chrono
+{
+
+// Forward references
+class ChNodeSPH;
+class ChSystem;
+
+
+/// Neighbor search for the particles of a ChMatterSPH, with a
+/// cell-linked list: the space is divided in a regular grid of cubic
+/// cells, as large as the largest kernel radius, and the particles are
+/// sorted by cell, so that the neighbors of a particle are found in the
+/// 3x3x3 cells around its cell.
+///
+/// The positions, speeds, masses and kernel radii of the particles are
+/// copied in separate arrays (structure of arrays) in the order of the
+/// cells, so particles that are near in space are also near in memory.
+/// The arrays for the per-particle results of the SPH summations are
+/// in the same order. Loops on particles that write only the data of
+/// their own particle, and read the data of the neighbors, can run in
+/// parallel without locks.
+///
+/// Build() sorts the particles with a counting sort, whose cost is linear
+/// in the number of particles, so it can be repeated at each time step.
+
+class ChApi ChNeighborGridSPH
+{
+public:
+	ChNeighborGridSPH();
+	virtual ~ChNeighborGridSPH() {};
+
+				/// Sort the nodes in the cells, and copy their data in the arrays.
+				/// If a system is given, the per-particle loops are executed with
+				/// its ChSystem::RunItemsLoop(), hence in parallel if enabled.
+	void Build(std::vector<ChNodeSPH*>& nodes, ChSystem* msystem = 0);
+
+				/// Number of particles sorted by last Build().
+	int GetNparticles() const {return (int)ids.size();}
+
+				/// Number of cells of the grid.
+	int GetNcells() const {return nx*ny*nz;}
+
+				/// Size of the cells. It is the largest kernel radius, or more
+				/// if the particles are so sparse that most cells would be empty.
+	double GetCellSize() const {return cell_size;}
+
+				/// Index, in the vector of nodes passed to Build(), of the
+				/// i-th particle in the order of the cells.
+	int GetNodeIndex(int i) const {return ids[i];}
+
+				/// Call visitor(i,j) for all the particles j (other than i) in the
+				/// 3x3x3 cells around the cell of the particle i. These are all the
+				/// particles closer than the largest kernel radius, and some more:
+				/// the visitor must test the distance.
+	template <class Visitor>
+	void VisitNeighbors(int i, Visitor& visitor) const
+	{
+		int c  = cell[i];
+		int ix = c % nx;
+		int iy = (c / nx) % ny;
+		int iz = c / (nx * ny);
+		int x0 = (ix > 0)    ? ix - 1 : ix;
+		int x1 = (ix < nx-1) ? ix + 1 : ix;
+		int y0 = (iy > 0)    ? iy - 1 : iy;
+		int y1 = (iy < ny-1) ? iy + 1 : iy;
+		int z0 = (iz > 0)    ? iz - 1 : iz;
+		int z1 = (iz < nz-1) ? iz + 1 : iz;
+		for (int z = z0; z <= z1; z++)
+			for (int y = y0; y <= y1; y++)
+			{
+				// the three cells along x are contiguous, as their particles
+				int row  = (z * ny + y) * nx;
+				int jend = cell_start[row + x1 + 1];
+				for (int j = cell_start[row + x0]; j < jend; j++)
+					if (j != i)
+						visitor(i, j);
+			}
+	}
+
+			//
+			// DATA OF THE PARTICLES, IN THE ORDER OF THE CELLS
+			//
+
+	std::vector<double> pos_x, pos_y, pos_z;
+	std::vector<double> vel_x, vel_y, vel_z;
+	std::vector<double> mass;
+	std::vector<double> h_rad;
+
+			// results of the SPH summations
+	std::vector<double> density;
+	std::vector<double> volume;
+	std::vector<double> pressure;
+	std::vector<double> force_x, force_y, force_z;
+
+private:
+	std::vector<int> ids;			// node index of each sorted particle
+	std::vector<int> cell;			// cell of each sorted particle
+	std::vector<int> cell_start;	// ncells+1 offsets of the particles of each cell
+	std::vector<int> node_cell;		// cell of each node, in the order of nodes (workspace)
+	std::vector<int> cell_fill;		// workspace for the counting sort
+
+	double origin_x, origin_y, origin_z;
+	double cell_size;
+	int nx, ny, nz;
+};
+
+
+
+} // END_OF_NAMESPACE____
+
+
+#endif  // END of ChNeighborGridSPH.h
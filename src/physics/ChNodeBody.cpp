@@ -23,6 +23,7 @@
 #include "physics/ChNodeBody.h"
 #include "physics/ChSystem.h"
 #include "physics/ChIndexedNodes.h"
+#include "physics/ChStateSnapshot.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
@@ -269,6 +270,22 @@ void ChNodeBody::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChNodeBody::StateSave(ChStateSnapshot& msnapshot)
+{
+	msnapshot.Add(react);
+	msnapshot.Add(cache_li_speed);
+	msnapshot.Add(cache_li_pos);
+}
+
+void ChNodeBody::StateRestore(ChStateSnapshot& msnapshot)
+{
+	msnapshot.Get(react);
+	msnapshot.Get(cache_li_speed);
+	msnapshot.Get(cache_li_pos);
+}
+
+
+
 } // END_OF_NAMESPACE____
 
 
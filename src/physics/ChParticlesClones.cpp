@@ -488,6 +488,13 @@ void ChParticlesClones::SyncCollisionModels()
 	}
 }
 
+void ChParticlesClones::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChIndexedParticles::StateRestore(msnapshot);
+
+	SyncCollisionModels();
+}
+
 void ChParticlesClones::AddCollisionModelsToSystem() 
 {
 	assert(this->GetSystem());
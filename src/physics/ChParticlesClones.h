@@ -355,6 +355,15 @@ public:
 	void UpdateExternalGeometry ();
 
 
+			//
+			// STATE
+			//
+
+				/// Restore the particles as ChIndexedParticles::StateRestore(),
+				/// then move their collision models too.
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
+
 			//
 			// STREAMING
 			//
@@ -21,6 +21,8 @@
 
 
 #include "physics/ChPhysicsItem.h"
+#include "physics/ChStateSnapshot.h"
+#include "core/ChException.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
@@ -45,6 +47,7 @@ void ChPhysicsItem::Copy(ChPhysicsItem* source)
 
 	// copy other class data
 	system=0; // do not copy - must be initialized with insertion in system.
+	island_index = -1;
 
 	this->assets = source->assets;  // copy the list of shared pointers to assets
 }
@@ -66,6 +69,18 @@ void ChPhysicsItem::GetCenter(ChVector<>& mcenter)
 }
 
 
+void ChPhysicsItem::StateSave(ChStateSnapshot& msnapshot)
+{
+	throw ChException("State snapshots are not supported by physics items of class " + std::string(this->GetRTTI()->GetName()));
+}
+
+void ChPhysicsItem::StateRestore(ChStateSnapshot& msnapshot)
+{
+	throw ChException("State snapshots are not supported by physics items of class " + std::string(this->GetRTTI()->GetName()));
+}
+
+
+
 /////////
 ///////// FILE I/O
 /////////
@@ -44,6 +44,7 @@ namespace chrono
 
 // Forward references
 class ChSystem;
+class ChStateSnapshot;
 
 
 /// Base class for items that can contain objects
@@ -63,13 +64,15 @@ protected:
 
 	ChSystem *system;	  // parent system
 
+	int island_index;	  // index of the item in the islands computed by the system [internal]
+
 	std::vector< ChSharedPtr<ChAsset> > assets;
 
 public:
 				//
 	  			// CONSTRUCTORS
 				//
-	ChPhysicsItem () { system = 0;};
+	ChPhysicsItem () { system = 0; island_index = -1;};
 	virtual ~ChPhysicsItem () {}; 
 	virtual void Copy(ChPhysicsItem* source);
 
@@ -86,6 +89,12 @@ public:
 				/// Set the pointer to the parent ChSystem()
 	virtual void SetSystem (ChSystem* m_system) {system= m_system;}
 
+				/// Index of this item in the union-find partitioning of the parent 
+				/// system into islands of connected items, or -1 if the item does not 
+				/// belong to any island (ex. fixed bodies). Used internally by ChSystem.
+	int  GetIslandIndex () { return island_index;}
+	void SetIslandIndex (int mindex) { island_index = mindex;}
+
 
 				/// Add an optional asset (it can be used to define visualization shapes, es ChSphereShape,
 				/// or textures, or custom attached properties that the user can define by
@@ -161,6 +170,18 @@ public:
 				/// Must be implemented by child classes. 
 	virtual void StreamOUTstate(ChStreamOutBinary& mstream) {};				
 
+				/// Append the state of the item (positions, speeds, cached
+				/// multipliers for warm starting, etc.) to a flat snapshot,
+				/// see ChSystem::StateSave(). Child classes implement this,
+				/// calling the parent class first; items without any state
+				/// implement it as an empty function. The default throws a
+				/// ChException, so that an item whose state is not supported
+				/// is not silently left out of the snapshot.
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+				/// Read back the state written by StateSave(), in the same order.
+				/// The default throws a ChException, as StateSave().
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 
 			// UPDATING  - child classes may implement these functions
 			//
@@ -154,6 +154,12 @@ public:
 					/// report all contacts).
 	virtual void ReportAllProximities(ChReportProximityCallback* mcallback) =0;
 
+					/// Proximities are not saved in state snapshots (see ChSystem::StateSave()):
+					/// on restore, the current pairs are discarded and the collision
+					/// detection finds them again.
+	virtual void StateSave(ChStateSnapshot& msnapshot) {};
+	virtual void StateRestore(ChStateSnapshot& msnapshot) { RemoveAllProximities(); }
+
 };
 
 
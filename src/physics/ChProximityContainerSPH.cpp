@@ -124,6 +124,13 @@ void ChProximityContainerSPH::AddProximity(
 	if ((fixedA && fixedB))
 		return;
 
+	// Pairs of nodes of a cluster that uses its neighbor grid are already
+	// processed by the cluster itself, so do not count them twice.
+
+	ChMatterSPH* mmatA = dynamic_cast<ChMatterSPH*>(mmpaA->GetNodes());
+	if (mmatA && mmatA == mmpaB->GetNodes() && mmatA->GetUseNeighborGrid())
+		return;
+
 	// Launch the proximity callback, if implemented by the user
 
 	if (this->add_proximity_callback)
@@ -173,36 +180,6 @@ void ChProximityContainerSPH::ReportAllProximities(ChReportProximityCallback* mc
 
 ////////// LCP INTERFACES ////
 
-static double W_poly6(double r, double h)
-{
-	if (r < h)
-	{
-		return (315.0 / (64.0 * CH_C_PI * pow(h,9)) ) * pow((h*h - r*r) ,3);
-	}
-	else return 0;
-}
-
-
-static double W_sq_visco(double r, double h)
-{
-	if (r < h)
-	{
-		return (45.0 / (CH_C_PI * pow(h,6)) ) * (h - r);
-	}
-	else return 0;
-}
-
-static void W_gr_press(ChVector<>& Wresult, const ChVector<>& r, const double r_length, const double h)
-{
-	if (r_length < h)
-	{
-		Wresult = r;
-		Wresult *= -(45.0 / (CH_C_PI * pow(h,6)) ) * pow((h - r_length),2.0) ;
-	}
-	else Wresult = VNULL;
-}
-
-
 void ChProximityContainerSPH::AccumulateStep1()
 {
 	// Per-edge data computation
@@ -220,7 +197,12 @@ void ChProximityContainerSPH::AccumulateStep1()
 		ChVector<> r_BA = x_B  - x_A ;
 		double dist_BA = r_BA.Length();
 
-		double W_k_poly6 =  W_poly6( dist_BA, mnodeA->GetKernelRadius() );
+		// The pair uses the mean kernel radius of the two nodes: with the radius 
+		// of node A, the result would depend on the order of the pair, that is 
+		// arbitrary (it comes from the broadphase), if the radii differ.
+		double h_AB = 0.5*(mnodeA->GetKernelRadius() + mnodeB->GetKernelRadius());
+
+		double W_k_poly6 =  ChContinuumSPH::W_poly6( dist_BA, h_AB );
 
 		// increment data of connected nodes
 
@@ -249,10 +231,12 @@ void ChProximityContainerSPH::AccumulateStep2()
 		ChVector<> r_BA = x_B - x_A;
 		double dist_BA = r_BA.Length();
 
+		double h_AB = 0.5*(mnodeA->GetKernelRadius() + mnodeB->GetKernelRadius());
+
 		// increment pressure forces
 
 		ChVector<> W_k_press;
-		W_gr_press( W_k_press, r_BA, dist_BA, mnodeA->GetKernelRadius() );
+		ChContinuumSPH::W_gr_press( W_k_press, r_BA, dist_BA, h_AB );
 
 		double avg_press = 0.5*(mnodeA->pressure + mnodeB->pressure);
 	
@@ -265,7 +249,7 @@ void ChProximityContainerSPH::AccumulateStep2()
 
 		// increment viscous forces..
 
-		double W_k_visc =  W_sq_visco( dist_BA, mnodeA->GetKernelRadius() );
+		double W_k_visc =  ChContinuumSPH::W_sq_visco( dist_BA, h_AB );
 		ChVector<> velBA =  mnodeB->GetPos_dt() - mnodeA->GetPos_dt();
 
 		double avg_viscosity =  0.5*(mmatA->GetMaterial().Get_viscosity() + mmatB->GetMaterial().Get_viscosity());
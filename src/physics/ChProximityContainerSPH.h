@@ -90,6 +90,8 @@ private:
 /// Class for container of many proximity pairs for SPH (Smooth 
 /// Particle Hydrodinamics and similar meshless force computations), 
 /// as CPU typical linked list of ChProximitySPH objects.
+/// Pairs of nodes of the same ChMatterSPH cluster are not stored here
+/// if the cluster uses its own neighbor grid (see ChMatterSPH::SetUseNeighborGrid()).
 ///
 
 class ChApi ChProximityContainerSPH : public ChProximityContainerBase {
@@ -21,6 +21,7 @@
 
 #include "physics/ChShaft.h"
 #include "physics/ChSystem.h"
+#include "physics/ChStateSnapshot.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
@@ -299,6 +300,26 @@ void ChShaft::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChShaft::StateSave(ChStateSnapshot& msnapshot)
+{
+	msnapshot.Add(this->ChTime);
+	msnapshot.Add(this->pos);
+	msnapshot.Add(this->pos_dt);
+	msnapshot.Add(this->pos_dtdt);
+	msnapshot.Add(this->sleeping ? 1. : 0.);
+	msnapshot.Add(this->sleep_starttime);
+}
+
+void ChShaft::StateRestore(ChStateSnapshot& msnapshot)
+{
+	this->ChTime = msnapshot.Get();
+	this->pos = msnapshot.Get();
+	this->pos_dt = msnapshot.Get();
+	this->pos_dtdt = msnapshot.Get();
+	this->sleeping = msnapshot.Get() != 0;
+	this->sleep_starttime = (float)msnapshot.Get();
+}
+
 
 
 } // END_OF_NAMESPACE____
@@ -265,6 +265,11 @@ public:
 				/// binary archive (ex: a file).
 	void StreamOUT(ChStreamOutBinary& mstream);
 
+				/// Save/restore the state (time, rotation, speed, acceleration,
+				/// sleeping) for ChSystem::StateSave() and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 };
 
 
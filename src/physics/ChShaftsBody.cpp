@@ -22,6 +22,7 @@
 
 #include "physics/ChShaftsBody.h"
 #include "physics/ChGlobal.h"
+#include "physics/ChStateSnapshot.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
@@ -220,6 +221,22 @@ void ChShaftsBody::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChShaftsBody::StateSave(ChStateSnapshot& msnapshot)
+{
+	msnapshot.Add(torque_react);
+	msnapshot.Add(cache_li_speed);
+	msnapshot.Add(cache_li_pos);
+}
+
+void ChShaftsBody::StateRestore(ChStateSnapshot& msnapshot)
+{
+	torque_react = msnapshot.Get();
+	cache_li_speed = (float)msnapshot.Get();
+	cache_li_pos = (float)msnapshot.Get();
+}
+
+
+
 } // END_OF_NAMESPACE____
 
 
@@ -177,6 +177,11 @@ public:
 				/// binary archive (ex: a file).
 	void StreamOUT(ChStreamOutBinary& mstream);
 
+				/// Save/restore the reaction and the cached multipliers, for
+				/// ChSystem::StateSave() and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 };
 
 
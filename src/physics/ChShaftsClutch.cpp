@@ -22,6 +22,7 @@
 #include "physics/ChShaftsClutch.h"
 #include "physics/ChSystem.h"
 #include "physics/ChShaft.h"
+#include "physics/ChStateSnapshot.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
@@ -229,6 +230,23 @@ void ChShaftsClutch::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChShaftsClutch::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChShaftsCouple::StateSave(msnapshot);
+
+	msnapshot.Add(torque_react);
+	msnapshot.Add(cache_li_speed);
+	msnapshot.Add(cache_li_pos);
+}
+
+void ChShaftsClutch::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChShaftsCouple::StateRestore(msnapshot);
+
+	torque_react = msnapshot.Get();
+	cache_li_speed = (float)msnapshot.Get();
+	cache_li_pos = (float)msnapshot.Get();
+}
 
 
 
@@ -156,6 +156,11 @@ public:
 							// stream out all member data
 						// nothing - pointers must be rebound
 					}
+
+				/// The couple has no state by itself: children classes
+				/// save/restore their reactions, multipliers, etc.
+	virtual void StateSave(ChStateSnapshot& msnapshot) {};
+	virtual void StateRestore(ChStateSnapshot& msnapshot) {};
 					
 };
 
@@ -23,6 +23,7 @@
 #include "physics/ChShaftsGear.h"
 #include "physics/ChSystem.h"
 #include "physics/ChShaft.h"
+#include "physics/ChStateSnapshot.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
@@ -209,6 +210,23 @@ void ChShaftsGear::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChShaftsGear::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChShaftsCouple::StateSave(msnapshot);
+
+	msnapshot.Add(torque_react);
+	msnapshot.Add(cache_li_speed);
+	msnapshot.Add(cache_li_pos);
+}
+
+void ChShaftsGear::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChShaftsCouple::StateRestore(msnapshot);
+
+	torque_react = msnapshot.Get();
+	cache_li_speed = (float)msnapshot.Get();
+	cache_li_pos = (float)msnapshot.Get();
+}
 
 
 
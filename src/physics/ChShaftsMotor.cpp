@@ -22,6 +22,7 @@
 #include "physics/ChShaftsMotor.h"
 #include "physics/ChSystem.h"
 #include "physics/ChShaft.h"
+#include "physics/ChStateSnapshot.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
@@ -243,6 +244,34 @@ void ChShaftsMotor::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChShaftsMotor::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChShaftsCouple::StateSave(msnapshot);
+
+	msnapshot.Add(motor_torque);
+	msnapshot.Add(motor_set_rot);
+	msnapshot.Add(motor_set_rot_dt);
+	msnapshot.Add(torque_react1);
+	msnapshot.Add(torque_react2);
+	msnapshot.Add(cache_li_speed);
+	msnapshot.Add(cache_li_pos);
+}
+
+void ChShaftsMotor::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChShaftsCouple::StateRestore(msnapshot);
+
+	motor_torque = msnapshot.Get();
+	motor_set_rot = msnapshot.Get();
+	motor_set_rot_dt = msnapshot.Get();
+	torque_react1 = msnapshot.Get();
+	torque_react2 = msnapshot.Get();
+	cache_li_speed = (float)msnapshot.Get();
+	cache_li_pos = (float)msnapshot.Get();
+}
+
+
+
 } // END_OF_NAMESPACE____
 
 
@@ -23,6 +23,7 @@
 #include "physics/ChShaftsPlanetary.h"
 #include "physics/ChSystem.h"
 #include "physics/ChShaft.h"
+#include "physics/ChStateSnapshot.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
@@ -237,6 +238,22 @@ void ChShaftsPlanetary::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChShaftsPlanetary::StateSave(ChStateSnapshot& msnapshot)
+{
+	msnapshot.Add(torque_react);
+	msnapshot.Add(cache_li_speed);
+	msnapshot.Add(cache_li_pos);
+}
+
+void ChShaftsPlanetary::StateRestore(ChStateSnapshot& msnapshot)
+{
+	torque_react = msnapshot.Get();
+	cache_li_speed = (float)msnapshot.Get();
+	cache_li_pos = (float)msnapshot.Get();
+}
+
+
+
 } // END_OF_NAMESPACE____
 
 
@@ -22,6 +22,7 @@
 #include "physics/ChShaftsTorsionSpring.h"
 #include "physics/ChSystem.h"
 #include "physics/ChShaft.h"
+#include "physics/ChStateSnapshot.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
 
@@ -125,6 +126,22 @@ void ChShaftsTorsionSpring::StreamIN(ChStreamInBinary& mstream)
 
 
 
+void ChShaftsTorsionSpring::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChShaftsCouple::StateSave(msnapshot);
+
+	msnapshot.Add(torque_kr);
+}
+
+void ChShaftsTorsionSpring::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChShaftsCouple::StateRestore(msnapshot);
+
+	torque_kr = msnapshot.Get();
+}
+
+
+
 } // END_OF_NAMESPACE____
 
 
@@ -29,6 +29,7 @@
 #endif
 #include "core/ChLog.h"
 #include "physics/ChSolvmin.h"
+#include "parallel/ChTaskPool.h"
 
 
 
@@ -70,13 +71,20 @@ ChOptimizer::ChOptimizer()
 	break_cycles = 10;
 	break_cyclecounter = 0;
 	user_break = 0;
+
+	num_threads = 1;
+	use_cache = false;
+	fx_clones_source = 0;
+	task_pool = 0;
 }
 
 
 // destroy
 ChOptimizer::~ChOptimizer()
 {
-
+	ResetEvaluations();
+	if (task_pool)
+		delete task_pool;
 }
 
 
@@ -105,6 +113,8 @@ void ChOptimizer::Copy(ChOptimizer* source)
 	break_cyclecounter = source->break_cyclecounter;
 	user_break = source->user_break;
 
+	num_threads = source->num_threads;
+	use_cache = source->use_cache;
 }
 
 
@@ -113,6 +123,10 @@ void ChOptimizer::Copy(ChOptimizer* source)
 
 double ChOptimizer::Eval_fx(double x[])
 {
+	double fx;
+	if (use_cache && GetCached(x, fx))
+		return fx;
+
 	ChMatrixDynamic<> Vin	(this->C_vars,1);
 	ChMatrixDynamic<> Vout	(1,1);
 
@@ -121,6 +135,9 @@ double ChOptimizer::Eval_fx(double x[])
 
 	this->fx_evaluations++;
 
+	if (use_cache)
+		SetCached(x, Vout(0,0));
+
 	return Vout(0,0);
 }
 
@@ -145,22 +162,27 @@ void ChOptimizer::Eval_grad(double x[], double gr[])
 	{
 		// ------ otherwise use BDF  ---------------------
 		int mtotvars = GetNumOfVars();
-		double oldval;
-		double mf, mfd;
 
-		// %%%%%%%%%%%%%  Evaluate central value of function
-		mf = Eval_fx(x);
+		// %%%%%%%%%%%%%  Evaluate central value of function, and
+		// the function with one variable incremented at a time, all
+		// together, so that they can be computed in parallel.
+		ChMatrixDynamic<> mpoints(mtotvars + 1, mtotvars);
+		std::vector<double*> mx(mtotvars + 1);
+		std::vector<double> mf(mtotvars + 1);
+		for (int i = 0; i <= mtotvars; i++)
+		{
+			mx[i] = mpoints.GetAddress() + i * mtotvars;
+			for (int mvar = 0; mvar < mtotvars; mvar++)
+				mx[i][mvar] = x[mvar];
+			if (i > 0)
+				mx[i][i-1] += this->grad_step;
+		}
+		Eval_fx_batch(mtotvars + 1, &mx[0], &mf[0]);
 
 		for (int mvar = 0; mvar < mtotvars; mvar++)
 		{
-			oldval = x[mvar];
-			// increment one variable
-			x[mvar]=oldval + this->grad_step;
-			mfd = Eval_fx(x);
 			// %%%%%%%%%%%%% compute gradient by BDF
-			gr[mvar]= ((mfd-mf)/(this->grad_step));
-			// back to original value
-			x[mvar]=oldval;
+			gr[mvar]= ((mf[mvar+1]-mf[0])/(this->grad_step));
 		}
 	}
 	this->grad_evaluations++;		// increment the counter of total number of gradient evaluations
@@ -169,9 +191,17 @@ void ChOptimizer::Eval_grad(double x[], double gr[])
 
 double ChOptimizer::Eval_fx(const ChMatrix<>* x)
 {
+	double fx;
+	if (use_cache && GetCached(x->GetAddress(), fx))
+		return fx;
+
 	ChMatrixDynamic<> out(1,1);
 	this->afunction->Eval(out, *x);
 	this->fx_evaluations++;
+
+	if (use_cache)
+		SetCached(x->GetAddress(), out(0,0));
+
 	return out(0,0);
 }
 
@@ -181,30 +211,136 @@ void   ChOptimizer::Eval_grad(const ChMatrix<>* x, ChMatrix<>* gr)
 	if (this->afunctionGrad)
 	{
 		this->afunctionGrad->Eval(*gr, *x);
+		this->grad_evaluations++;
 	}
 	else
 	{
 		// ------ otherwise use BDF  ---------------------
-		int mtotvars = GetNumOfVars();
-		double oldval;
-		double mf, mfd;
+		ChMatrixDynamic<> mx(*x);
+		Eval_grad(mx.GetAddress(), gr->GetAddress());
+	}
+}
 
-		// Evaluate central value of function
-		mf = Eval_fx(x);
-		ChMatrixDynamic<> mdx(*x);
 
-		for (int mvar = 0; mvar < mtotvars; mvar++)
+// Values of the function stored if use_cache is true.
+
+bool ChOptimizer::GetCached(const double* x, double& fx)
+{
+	std::map<std::vector<double>, double>::iterator iter = fx_cache.find(std::vector<double>(x, x + C_vars));
+	if (iter == fx_cache.end())
+		return false;
+	fx = iter->second;
+	return true;
+}
+
+void ChOptimizer::SetCached(const double* x, double fx)
+{
+	fx_cache[std::vector<double>(x, x + C_vars)] = fx;
+}
+
+void ChOptimizer::ResetEvaluations()
+{
+	fx_cache.clear();
+	for (unsigned int i = 0; i < fx_clones.size(); i++)
+		delete fx_clones[i];
+	fx_clones.clear();
+	fx_clones_source = 0;
+}
+
+int ChOptimizer::UpdateClones(int nclones)
+{
+	if (fx_clones_source != afunction)
+	{
+		for (unsigned int i = 0; i < fx_clones.size(); i++)
+			delete fx_clones[i];
+		fx_clones.clear();
+		fx_clones_source = afunction;
+	}
+	while ((int)fx_clones.size() < nclones)
+	{
+		ChFx* mclone = afunction->new_Duplicate();
+		if (!mclone)
+			return FALSE;	// the function cannot be copied
+		fx_clones.push_back(mclone);
+	}
+	return TRUE;
+}
+
+
+// Body of the parallel loop of Eval_fx_batch(). Each thread takes one 
+// of the copies of the function that are not in use, and gives it back
+// at the end. 
+
+class ChOptimizerEvalLoop : public ChTaskPoolLoop
+{
+public:
+	double** x;
+	double* fx;
+	int* points;
+	int nvars;
+	ChFx** free_clones;
+	int nfree;
+	ChSpinlock lock;
+	virtual void Run(int begin, int end)
+	{
+		lock.Lock();
+		ChFx* mfunction = free_clones[--nfree];
+		lock.Unlock();
+
+		ChMatrixDynamic<> Vin	(nvars,1);
+		ChMatrixDynamic<> Vout	(1,1);
+		for (int k = begin; k < end; k++)
 		{
-			oldval = (*x)(mvar);
-			// increment one variable
-			mdx(mvar)=oldval + this->grad_step;
-			mfd = Eval_fx(x);
-			// compute gradient by BDF
-			(*gr)(mvar)= ((mfd-mf)/(this->grad_step));
-			// back to original value
-			mdx(mvar)=oldval;
+			int i = points[k];
+			for (int j = 0; j < nvars; j++) Vin(j,0) = x[i][j];
+			mfunction->Eval(Vout, Vin);
+			fx[i] = Vout(0,0);
 		}
+
+		lock.Lock();
+		free_clones[nfree++] = mfunction;
+		lock.Unlock();
 	}
+};
+
+
+void ChOptimizer::Eval_fx_batch(int npoints, double* x[], double fx[])
+{
+	// the points whose value is not known yet
+	std::vector<int> mpoints;
+	for (int i = 0; i < npoints; i++)
+		if (!(use_cache && GetCached(x[i], fx[i])))
+			mpoints.push_back(i);
+	int ncompute = (int)mpoints.size();
+
+	if (num_threads < 2 || ncompute < 2 || !UpdateClones(num_threads))
+	{
+		for (int k = 0; k < ncompute; k++)
+			fx[mpoints[k]] = Eval_fx(x[mpoints[k]]);
+		return;
+	}
+
+	if (!task_pool || task_pool->GetNumThreads() != num_threads)
+	{
+		if (task_pool)
+			delete task_pool;
+		task_pool = new ChTaskPool(num_threads);
+	}
+
+	std::vector<ChFx*> mfree(fx_clones.begin(), fx_clones.begin() + num_threads);
+	ChOptimizerEvalLoop mloop;
+	mloop.x = x;
+	mloop.fx = fx;
+	mloop.points = &mpoints[0];
+	mloop.nvars = C_vars;
+	mloop.free_clones = &mfree[0];
+	mloop.nfree = num_threads;
+	task_pool->ParallelFor(ncompute, mloop, 1);	// one point per chunk: each one can be a long simulation
+
+	this->fx_evaluations += ncompute;
+	if (use_cache)
+		for (int k = 0; k < ncompute; k++)
+			SetCached(x[mpoints[k]], fx[mpoints[k]]);
 }
 
 
@@ -236,6 +372,9 @@ int ChOptimizer::PreOptimize()
 	user_break = 0;
 	break_cyclecounter = 0;
 
+	// the function could have been changed since last optimization
+	ResetEvaluations();
+
 	// reset error message
 	strcpy (err_message, "");
 
@@ -681,29 +820,31 @@ double ChOptimizerGenetic::ComputeFitness(ChGenotype* mygen)
 
 int ChOptimizerGenetic::ComputeAllFitness()
 {
-	int nv= GetNumOfVars();
-	int mvar, mind;
-	// create temporary array of variables for function-parameter-passing purposes.
-	double* myvars = (double*) calloc (nv, sizeof(double));
-
+	int mind;
+	// the individuals to evaluate, and their genes as double* arrays
+	std::vector<ChGenotype*> mindividuals;
+	std::vector<double*> myvars;
 	for (mind = 0; mind < popsize; mind++)
 	{
 		if (population[mind]->need_eval)
 		{
-			// fill the vector of variables as double* array
-			for (mvar = 0; mvar <nv; mvar++)
-				{ myvars[mvar] = population[mind]->genes->GetElement(mvar,0); }
-				 // impose these variables to the system,
-				 // Vars_to_System(myvars);
-			// evaluate functional,
-			population[mind]->fitness = this->Eval_fx(myvars);	// ++++++ HERE THE FITNESS IS EVALUATED
-			// set flag for speed reasons..
-			population[mind]->need_eval = FALSE;
-			// user break?
-			if (this->user_break) break;
+			mindividuals.push_back(population[mind]);
+			myvars.push_back(population[mind]->genes->GetAddress());
 		}
 	}
-	free (myvars); // delete the array of variables
+	if (mindividuals.empty())
+		return TRUE;
+
+	// evaluate functional, all together (in parallel, if num_threads > 1)
+	std::vector<double> mfitness(mindividuals.size());
+	this->Eval_fx_batch((int)mindividuals.size(), &myvars[0], &mfitness[0]);	// ++++++ HERE THE FITNESS IS EVALUATED
+
+	for (mind = 0; mind < (int)mindividuals.size(); mind++)
+	{
+		mindividuals[mind]->fitness = mfitness[mind];
+		// set flag for speed reasons..
+		mindividuals[mind]->need_eval = FALSE;
+	}
 
 	return TRUE;
 }
@@ -1435,13 +1576,16 @@ int ChOptimizerGradient::DoOptimize()
 			mDx.MatrScale(nstep*0.25);
 			mX1.MatrAdd(mX, mDx);
 
-			fx1 = Eval_fx(&mX1);
-
 			mDx.CopyFromMatrix(mG);// initialize right
 			mDx.MatrScale(nstep*0.75);
 			mX2.MatrAdd(mX, mDx);
 
-			fx2 = Eval_fx(&mX2);
+			// evaluate left and right together (in parallel, if num_threads > 1)
+			double* mx12[2] = {mX1.GetAddress(), mX2.GetAddress()};
+			double  fx12[2];
+			Eval_fx_batch(2, mx12, fx12);
+			fx1 = fx12[0];
+			fx2 = fx12[1];
 
 			gone = FALSE;
 			if ((fx1 <= fxmid)&&(fxmid <= fx2)&&(gone==FALSE))
@@ -1596,6 +1740,10 @@ int ChOptimizerHybrid::DoOptimize()
 	local_opt->break_funct = this->break_funct;
 	genetic_opt->break_cycles = this->break_cycles;
 	local_opt->break_cycles = this->break_cycles;
+	genetic_opt->num_threads = this->num_threads;
+	local_opt->num_threads = this->num_threads;
+	genetic_opt->use_cache = this->use_cache;
+	local_opt->use_cache = this->use_cache;
 
 
 	// 1)  optimization with genetic method
@@ -33,6 +33,8 @@
 //****          test is the heavy changes have broken some functionality!!!
 //****
 
+#include <vector>
+#include <map>
 #include "physics/ChFx.h"
 #include "physics/ChObject.h"
 
@@ -43,6 +45,9 @@ struct JSScript;
 namespace chrono
 {
 
+// forward reference
+class ChTaskPool;
+
 
 
 
@@ -77,6 +82,15 @@ protected:
 	double* xv_sup;		// These are the hi/lo limits for the variables,
 	double* xv_inf;		// these are not used by all optimizer, and can be NULL for gradient, for example, but needed for genetic.
 
+	std::map<std::vector<double>, double> fx_cache;	// already computed values of the function
+	std::vector<ChFx*> fx_clones;	// copies of afunction, for parallel evaluations
+	ChFx* fx_clones_source;			// the function that has been copied in fx_clones
+	ChTaskPool* task_pool;
+
+	bool GetCached(const double* x, double& fx);
+	void SetCached(const double* x, double fx);
+	int  UpdateClones(int nclones);
+
 public:
 
 	// ------ DATA
@@ -97,6 +111,9 @@ public:
 	int user_break;			///< if break_funct() reported TRUE, this flag is ON, and optimizers should exit all cycles
 	int break_cyclecounter; ///< internal
 
+	int num_threads;		///< default = 1; if >1, sets of points (ex. populations or gradient stencils) are evaluated in parallel, see Eval_fx_batch()
+	bool use_cache;			///< default = false; if true, values of the function are remembered and not computed again for the same variables
+
 
 	// ------ FUCTIONS
 
@@ -134,6 +151,19 @@ public:
 	double Eval_fx(double x[]);
 	double Eval_fx(const ChMatrix<>* x);
 
+				/// Evaluates the function at 'npoints' points, where x[i] is the 
+				/// array of variables of the i-th point, and stores the values 
+				/// in fx[i]. If num_threads > 1 and the objective function can be 
+				/// duplicated (see ChFx::new_Duplicate()) the points are evaluated
+				/// in parallel, each thread using its own copy of the function.
+	void Eval_fx_batch(int npoints, double* x[], double fx[]);
+
+				/// Forgets the values of the function remembered if use_cache is
+				/// true, and the copies of the function used for parallel evaluations.
+				/// This is done at the beginning of each optimization; call it also
+				/// if the objective function is changed during an optimization.
+	void ResetEvaluations();
+
 				/// Computes the gradient of objective function, for given state of variables.
 				/// The gradient is stored into gr vector.
 	void   Eval_grad(double x[], double gr[]);
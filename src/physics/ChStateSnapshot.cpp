@@ -0,0 +1,172 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChStateSnapshot.cpp
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "physics/ChStateSnapshot.h"
+
+#if !(defined(_WIN32) || defined(__WIN32__) || defined(__CYGWIN__))
+	#define CH_SNAPSHOT_MMAP
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
+
+
+namespace chrono
+{
+
+
+// Header of the files: the values follow, aligned to 8 bytes.
+
+struct ChStateSnapshotHeader
+{
+	char magic[8];
+	double nvalues;
+};
+
+static const char CH_SNAPSHOT_MAGIC[8] = {'C','H','S','N','A','P','0','1'};
+
+
+
+ChStateSnapshot::ChStateSnapshot()
+{
+	data = 0;
+	data_size = 0;
+	cursor = 0;
+	mapping = 0;
+	mapping_size = 0;
+}
+
+ChStateSnapshot::~ChStateSnapshot()
+{
+	Clear();
+}
+
+void ChStateSnapshot::Clear()
+{
+	buffer.clear();
+	data = 0;
+	data_size = 0;
+	cursor = 0;
+#ifdef CH_SNAPSHOT_MMAP
+	if (mapping)
+		munmap(mapping, mapping_size);
+#endif
+	mapping = 0;
+	mapping_size = 0;
+}
+
+void ChStateSnapshot::SetExternalData(const double* mdata, int msize)
+{
+	Clear();
+	data = mdata;
+	data_size = msize;
+}
+
+
+void ChStateSnapshot::Save(const char* filename)
+{
+	ChStateSnapshotHeader mheader;
+	memcpy(mheader.magic, CH_SNAPSHOT_MAGIC, sizeof(mheader.magic));
+	mheader.nvalues = (double)GetSize();
+
+	FILE* mfile = fopen(filename, "wb");
+	if (!mfile)
+		throw ChException("Cannot open the state snapshot file for writing");
+	bool ok = fwrite(&mheader, sizeof(mheader), 1, mfile) == 1;
+	if (ok && GetSize() > 0)
+		ok = fwrite(GetData(), sizeof(double), GetSize(), mfile) == (size_t)GetSize();
+	if (fclose(mfile) != 0)
+		ok = false;
+	if (!ok)
+		throw ChException("Cannot write the state snapshot file");
+}
+
+
+void ChStateSnapshot::Load(const char* filename)
+{
+	Clear();
+
+#ifdef CH_SNAPSHOT_MMAP
+
+	int mfd = open(filename, O_RDONLY);
+	if (mfd < 0)
+		throw ChException("Cannot open the state snapshot file");
+	struct stat mstat;
+	if (fstat(mfd, &mstat) != 0 || (size_t)mstat.st_size < sizeof(ChStateSnapshotHeader))
+	{
+		close(mfd);
+		throw ChException("Invalid state snapshot file");
+	}
+	void* maddress = mmap(0, (size_t)mstat.st_size, PROT_READ, MAP_PRIVATE, mfd, 0);
+	close(mfd);
+	if (maddress == MAP_FAILED)
+		throw ChException("Cannot map the state snapshot file");
+	mapping = maddress;
+	mapping_size = (size_t)mstat.st_size;
+
+	const ChStateSnapshotHeader* mheader = (const ChStateSnapshotHeader*)mapping;
+	size_t nvalues = (size_t)mheader->nvalues;
+	if (memcmp(mheader->magic, CH_SNAPSHOT_MAGIC, sizeof(mheader->magic)) != 0 ||
+		mapping_size != sizeof(ChStateSnapshotHeader) + nvalues * sizeof(double))
+	{
+		Clear();
+		throw ChException("Invalid state snapshot file");
+	}
+	data = (const double*)(mheader + 1);
+	data_size = (int)nvalues;
+
+#else
+
+	FILE* mfile = fopen(filename, "rb");
+	if (!mfile)
+		throw ChException("Cannot open the state snapshot file");
+	ChStateSnapshotHeader mheader;
+	bool ok = fread(&mheader, sizeof(mheader), 1, mfile) == 1 &&
+			  memcmp(mheader.magic, CH_SNAPSHOT_MAGIC, sizeof(mheader.magic)) == 0;
+	if (ok)
+	{
+		buffer.resize((size_t)mheader.nvalues);
+		if (!buffer.empty())
+			ok = fread(&buffer[0], sizeof(double), buffer.size(), mfile) == buffer.size();
+	}
+	fclose(mfile);
+	if (!ok)
+	{
+		Clear();
+		throw ChException("Invalid state snapshot file");
+	}
+
+#endif
+}
+
+
+
+} // END_OF_NAMESPACE____
+
+
+/////////////////////
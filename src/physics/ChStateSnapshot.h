@@ -0,0 +1,138 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHSTATESNAPSHOT_H
+#define CHSTATESNAPSHOT_H
+
+//////////////////////////////////////////////////
+//
+//   ChStateSnapshot.h
+//
+//   Flat binary snapshot of the state of a system,
+//   for checkpoints and rollbacks.
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <vector>
+#include "core/ChApiCE.h"
+#include "core/ChCoordsys.h"
+#include "core/ChMatrix.h"
+#include "core/ChException.h"
+
+
+namespace chrono
+{
+
+
+/// Snapshot of the state of a ChSystem (time, positions, speeds,
+/// cached multipliers for the warm starting of the solver, etc.)
+/// stored as a flat array of doubles.
+/// It is filled by ChSystem::StateSave() and used by
+/// ChSystem::StateRestore(), that do not create or delete objects:
+/// the topology of the system must be the same. This is much faster
+/// than StreamOUTall() and StreamINall(), so it can be used for
+/// frequent checkpoints, or to roll back and retry a simulation.
+/// The file written by Save() is a raw image of the array, in the
+/// native format of the machine; Load() maps it in memory where
+/// supported (POSIX systems), so restoring does not copy it.
+
+class ChApi ChStateSnapshot
+{
+public:
+	ChStateSnapshot();
+	~ChStateSnapshot();
+
+					/// Remove all values (and release the loaded file, if any).
+	void Clear();
+
+				//
+				// WRITING (used by the StateSave() functions of the items)
+				//
+
+	void Add(double mval) {if (data) Clear(); buffer.push_back(mval);}
+	void Add(const ChVector<>& mv) {Add(mv.x); Add(mv.y); Add(mv.z);}
+	void Add(const ChQuaternion<>& mq) {Add(mq.e0); Add(mq.e1); Add(mq.e2); Add(mq.e3);}
+	void Add(const ChCoordsys<>& mc) {Add(mc.pos); Add(mc.rot);}
+	void Add(const ChMatrix<>& mm) {for (int i = 0; i < mm.GetRows() * mm.GetColumns(); i++) Add(mm.GetElementN(i));}
+
+					/// Add a placeholder, to be set later with SetAt(), and
+					/// return its position.
+	int Reserve() {Add(0.); return (int)buffer.size() - 1;}
+	void SetAt(int mpos, double mval) {buffer[mpos] = mval;}
+
+				//
+				// READING (used by the StateRestore() functions of the items)
+				//
+
+					/// Restart reading from the first value.
+	void Rewind() {cursor = 0;}
+
+					/// Position of the next value to be read.
+	int GetCursor() {return cursor;}
+
+	double Get()
+	{
+		if (cursor >= GetSize())
+			throw ChException("The state snapshot is shorter than expected");
+		return GetData()[cursor++];
+	}
+	void Get(ChVector<>& mv) {mv.x = Get(); mv.y = Get(); mv.z = Get();}
+	void Get(ChQuaternion<>& mq) {mq.e0 = Get(); mq.e1 = Get(); mq.e2 = Get(); mq.e3 = Get();}
+	void Get(ChCoordsys<>& mc) {Get(mc.pos); Get(mc.rot);}
+	void Get(ChMatrix<>& mm) {for (int i = 0; i < mm.GetRows() * mm.GetColumns(); i++) mm.SetElementN(i, Get());}
+
+				//
+				// DATA
+				//
+
+					/// Number of values.
+	int GetSize() {return data ? data_size : (int)buffer.size();}
+
+					/// The values, as a contiguous array.
+	const double* GetData() {return data ? data : (buffer.empty() ? 0 : &buffer[0]);}
+
+					/// Use the 'msize' values at 'mdata', that are not copied:
+					/// the memory must stay valid while this snapshot is used.
+					/// For example, this can be a file mapped in memory by the user.
+	void SetExternalData(const double* mdata, int msize);
+
+				//
+				// FILES
+				//
+
+					/// Write the snapshot in a binary file. Throws ChException on error.
+	void Save(const char* filename);
+
+					/// Read a snapshot written by Save(). Throws ChException on error.
+	void Load(const char* filename);
+
+private:
+	std::vector<double> buffer;	// values, if written or read by copy
+	const double* data;			// values, if external or mapped
+	int data_size;
+	int cursor;
+	void* mapping;				// the mapped file, if any
+	size_t mapping_size;
+};
+
+
+
+} // END_OF_NAMESPACE____
+
+
+#endif  // END of ChStateSnapshot.h
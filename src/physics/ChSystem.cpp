@@ -37,9 +37,11 @@
 
 #include "lcp/ChLcpSystemDescriptor.h"
 #include "lcp/ChLcpSimplexSolver.h"
+#include "lcp/ChLcpSparseDirectSolver.h"
 #include "lcp/ChLcpIterativeSOR.h"
 #include "lcp/ChLcpIterativeSymmSOR.h"
 #include "lcp/ChLcpIterativeSORmultithread.h"
+#include "lcp/ChLcpIterativeSORcolored.h"
 #include "lcp/ChLcpIterativeJacobi.h"
 //#include "lcp/ChLcpIterativeMINRES.h"
 #include "lcp/ChLcpIterativePMINRES.h"
@@ -51,6 +53,7 @@
 
 #include "core/ChTimer.h"
 #include "collision/ChCCollisionSystemBullet.h"
+#include "collision/ChCCollisionSystemSpheres.h"
 #include "collision/ChCModelBulletBody.h"
 
 #include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
@@ -343,11 +346,17 @@ ChSystem::ChSystem(unsigned int max_objects, double scene_size, bool init_sys)
 	max_penetration_recovery_speed = 0.6;
 
 	parallel_thread_number = CHOMPfunctions::GetNumProcs(); // default n.threads as n.cores
+	use_parallel_passes = false;
+	task_pool = 0;
+	linkarray_valid = false;
+	awakebodyarray_valid = false;
+	nislands_sleeping = 0;
 
 	this->contact_container=0;
 	// default contact container
 	if(init_sys){
 		this->contact_container = new ChContactContainer();
+		this->contact_container->SetSystem(this);
 	}
 	collision_system=0;
 	// default GPU collision engine
@@ -369,6 +378,8 @@ ChSystem::ChSystem(unsigned int max_objects, double scene_size, bool init_sys)
 	
 	use_GPU = false;
 	use_sleeping = false;
+	use_incremental_injection = false;
+	use_lcp_islands = false;
 
 	collision_callback = 0;
 	collisionpoint_callback = 0;
@@ -400,6 +411,8 @@ ChSystem::ChSystem(unsigned int max_objects, double scene_size, bool init_sys)
 	timer_collision_broad = 0;
 	timer_collision_narrow = 0;
 	timer_update = 0;
+
+	profiler = 0;
 }
 
 
@@ -415,9 +428,14 @@ ChSystem::~ChSystem()
 	if (LCP_solver_speed) delete LCP_solver_speed; LCP_solver_speed=0;
 	if (LCP_solver_stab)  delete LCP_solver_stab;  LCP_solver_stab=0;
 	if (LCP_descriptor) delete LCP_descriptor; LCP_descriptor=0;
+	for (unsigned int i = 0; i < island_solvers.size(); i++)
+		delete island_solvers[i];
+	island_solvers.clear();
 	
 	if (collision_system) delete collision_system; collision_system = 0;
 	if (contact_container) delete contact_container; contact_container = 0;
+	if (task_pool) delete task_pool;
+	task_pool = 0;
 
 	if (events) delete events; events = 0;
 
@@ -479,8 +497,11 @@ void ChSystem::Copy(ChSystem* source)
 	simplexLCPmaxSteps = source->simplexLCPmaxSteps;
 	SetLcpSolverType(GetLcpSolverType());
 	parallel_thread_number = source->parallel_thread_number;
+	use_parallel_passes = source->use_parallel_passes;
 	use_GPU = source->use_GPU;
 	use_sleeping = source->use_sleeping;
+	use_incremental_injection = source->use_incremental_injection;
+	use_lcp_islands = source->use_lcp_islands;
 	timer_step = source->timer_step;
 	timer_lcp = source->timer_lcp;
 	timer_collision_broad = source->timer_collision_broad;
@@ -556,11 +577,15 @@ void ChSystem::SetLcpSolverType(eCh_lcpSolver mval)
 	if (LCP_solver_stab)  delete LCP_solver_stab;  LCP_solver_stab=0;
 	if (LCP_descriptor) delete LCP_descriptor; LCP_descriptor=0;
 	if (contact_container) delete contact_container; contact_container=0;
+	for (unsigned int i = 0; i < island_solvers.size(); i++)
+		delete island_solvers[i];
+	island_solvers.clear();
 
 	LCP_descriptor = new ChLcpSystemDescriptor;
 	LCP_descriptor->SetNumThreads(parallel_thread_number);
 
 	contact_container = new ChContactContainer;
+	contact_container->SetSystem(this);
 	
 
 	switch (mval)
@@ -605,6 +630,14 @@ void ChSystem::SetLcpSolverType(eCh_lcpSolver mval)
 		LCP_solver_speed = new ChLcpSolverDEM();
 		LCP_solver_stab = new ChLcpSolverDEM();
 		break;
+	case LCP_ITERATIVE_SOR_COLORED:
+		LCP_solver_speed = new ChLcpIterativeSORcolored();
+		LCP_solver_stab  = new ChLcpIterativeSORcolored();
+		break;
+	case LCP_SPARSE_DIRECT:
+		LCP_solver_speed = new ChLcpSparseDirectSolver();
+		LCP_solver_stab  = new ChLcpSparseDirectSolver();
+		break;
 	default:
 		LCP_solver_speed = new ChLcpIterativeSymmSOR();
 		LCP_solver_stab  = new ChLcpIterativeSymmSOR();
@@ -619,6 +652,7 @@ ChLcpSolver* ChSystem::GetLcpSolverSpeed()
 	switch(lcp_solver_type)
 	{
 	case LCP_DEM:
+	case LCP_SPARSE_DIRECT:
 		break;
 	case LCP_SIMPLEX:
 		((ChLcpSimplexSolver*)LCP_solver_speed)->SetTruncationStep(GetSimplexLCPmaxSteps());
@@ -648,16 +682,19 @@ ChLcpSolver* ChSystem::GetLcpSolverSpeed()
 ChLcpSolver* ChSystem::GetLcpSolverStab()
 {
 	// in case the solver is iterative, pre-configure it with max.iter.number
-	if (lcp_solver_type != LCP_SIMPLEX)
+	switch(lcp_solver_type)
 	{
+	case LCP_DEM:
+	case LCP_SPARSE_DIRECT:
+		break;
+	case LCP_SIMPLEX:
+		((ChLcpSimplexSolver*)LCP_solver_stab)->SetTruncationStep(GetSimplexLCPmaxSteps());
+		break;
+	default:
 		ChLcpIterativeSolver* iter_solver = (ChLcpIterativeSolver*)LCP_solver_stab;
 		iter_solver->SetMaxIterations(GetIterLCPmaxItersStab());
 		iter_solver->SetTolerance(this->tol);
-	}
-	else
-	{
-		ChLcpSimplexSolver* simplex_solver = (ChLcpSimplexSolver*)LCP_solver_stab;
-		simplex_solver->SetTruncationStep(GetSimplexLCPmaxSteps());
+		break;
 	}
 	return LCP_solver_stab;
 }
@@ -735,6 +772,11 @@ void ChSystem::SetParallelThreadNumber(int mthreads)
 	
 	LCP_descriptor->SetNumThreads(mthreads);
 
+	if (ChCollisionSystemBullet* mcollsys = dynamic_cast<ChCollisionSystemBullet*>(collision_system))
+		mcollsys->SetNumThreads(mthreads);
+	if (ChCollisionSystemSpheres* mcollsys = dynamic_cast<ChCollisionSystemSpheres*>(collision_system))
+		mcollsys->SetNumThreads(mthreads);
+
 	if (lcp_solver_type == LCP_ITERATIVE_SOR_MULTITHREAD)
 	{
 		((ChLcpIterativeSORmultithread*)LCP_solver_speed)->ChangeNumberOfThreads(mthreads);
@@ -777,6 +819,7 @@ void ChSystem::ChangeContactContainer(ChContactContainerBase* newcontainer)
 	if (this->contact_container) 
 		delete (this->contact_container);
 	this->contact_container = newcontainer;
+	this->contact_container->SetSystem(this);
 }
 
 void ChSystem::ChangeCollisionSystem(ChCollisionSystem* newcollsystem)
@@ -786,6 +829,14 @@ void ChSystem::ChangeCollisionSystem(ChCollisionSystem* newcollsystem)
 	if (this->collision_system) 
 		delete (this->collision_system);
 	this->collision_system = newcollsystem;
+	this->collision_system->SetProfiler(this->profiler);
+}
+
+void ChSystem::SetProfiler(ChProfiler* mprofiler)
+{
+	this->profiler = mprofiler;
+	if (this->collision_system)
+		this->collision_system->SetProfiler(mprofiler);
 }
 
 // JS commands
@@ -932,12 +983,14 @@ int ChSystem::ExecuteControlsFor3DStep()
 
 void ChSystem::AddBody (ChSharedPtr<ChBody> newbody)
 {
+	ResetIncrementalInjection();
 	assert(std::find<std::vector<ChBody*>::iterator>(bodylist.begin(), bodylist.end(), newbody.get_ptr())==bodylist.end());
 	assert(newbody->GetSystem()==0); // should remove from other system before adding here
 
 	newbody->AddRef();
 	newbody->SetSystem (this);
 	bodylist.push_back((newbody).get_ptr());
+	awakebodyarray_valid = false;
 
 	// add to collision system too
 	if (newbody->GetCollide())
@@ -946,6 +999,7 @@ void ChSystem::AddBody (ChSharedPtr<ChBody> newbody)
 
 void ChSystem::RemoveBody (ChSharedPtr<ChBody> mbody)
 {
+	ResetIncrementalInjection();
 	assert(std::find<std::vector<ChBody*>::iterator>(bodylist.begin(), bodylist.end(), mbody.get_ptr() )!=bodylist.end());
 
 	// remove from collision system
@@ -954,6 +1008,7 @@ void ChSystem::RemoveBody (ChSharedPtr<ChBody> mbody)
  
 	// warning! linear time search, to erase pointer from container.
 	bodylist.erase(std::find<std::vector<ChBody*>::iterator>(bodylist.begin(), bodylist.end(), mbody.get_ptr() ) );
+	awakebodyarray_valid = false;
 	
 	// nullify backward link to system
 	mbody->SetSystem(0);
@@ -963,11 +1018,13 @@ void ChSystem::RemoveBody (ChSharedPtr<ChBody> mbody)
    
 void ChSystem::AddLink (ChLink* newlink)
 { 
+	ResetIncrementalInjection();
 	assert(std::find<std::list<ChLink*>::iterator>(linklist.begin(), linklist.end(), newlink)==linklist.end());
 
 	newlink->AddRef();
 	newlink->SetSystem (this);
 	linklist.push_back(newlink);
+	linkarray_valid = false;
 }
 
 void ChSystem::AddLink (ChSharedPtr<ChLink> newlink)
@@ -978,19 +1035,23 @@ void ChSystem::AddLink (ChSharedPtr<ChLink> newlink)
 // Faster than RemoveLink because it does not require the linear time search
 std::list<ChLink*>::iterator ChSystem::RemoveLinkIter(std::list<ChLink*>::iterator& mlinkiter)
 {
+	ResetIncrementalInjection();
 	// nullify backward link to system
 	(*mlinkiter)->SetSystem(0);
 	// this may delete the link, if none else's still referencing it..
 	(*mlinkiter)->RemoveRef();
 
+	linkarray_valid = false;
 	return linklist.erase(mlinkiter);
 }
 
 void ChSystem::RemoveLink (ChSharedPtr<ChLink> mlink)
 {
+	ResetIncrementalInjection();
 	assert(std::find<std::list<ChLink*>::iterator>(linklist.begin(), linklist.end(), mlink.get_ptr() )!=linklist.end());
 
 	// warning! linear time search, to erase pointer from container.
+	linkarray_valid = false;
 	linklist.remove(mlink.get_ptr());//erase(std::find<std::vector<ChBody*>::iterator>(bodylist.begin(), bodylist.end(), mbody.get_ptr() ) );
 	
 	// nullify backward link to system
@@ -1002,6 +1063,7 @@ void ChSystem::RemoveLink (ChSharedPtr<ChLink> mlink)
 
 void ChSystem::AddOtherPhysicsItem (ChSharedPtr<ChPhysicsItem> newitem)
 {
+	ResetIncrementalInjection();
 	assert(std::find<std::list<ChPhysicsItem*>::iterator>(otherphysicslist.begin(), otherphysicslist.end(), newitem.get_ptr())==otherphysicslist.end());
 	//assert(newitem->GetSystem()==0); // should remove from other system before adding here
 
@@ -1016,6 +1078,7 @@ void ChSystem::AddOtherPhysicsItem (ChSharedPtr<ChPhysicsItem> newitem)
 
 void ChSystem::RemoveOtherPhysicsItem (ChSharedPtr<ChPhysicsItem> mitem)
 {
+	ResetIncrementalInjection();
 	assert(std::find<std::list<ChPhysicsItem*>::iterator>(otherphysicslist.begin(), otherphysicslist.end(), mitem.get_ptr())!=otherphysicslist.end());
 
 	// remove from collision system
@@ -1081,6 +1144,7 @@ void ChSystem::AddControls (ChSharedPtr<ChControls>& newcontrols)
    
 void ChSystem::RemoveAllBodies() 
 { 
+	ResetIncrementalInjection();
 	HIER_BODY_INIT
 	while (HIER_BODY_NOSTOP)
 	{
@@ -1094,11 +1158,13 @@ void ChSystem::RemoveAllBodies()
 		HIER_BODY_NEXT
 	}	
 	bodylist.clear(); 
+	awakebodyarray_valid = false;
 }; 
 
 
 void ChSystem::RemoveAllLinks() 
 { 
+	ResetIncrementalInjection();
 
 	HIER_LINK_INIT
 	while (HIER_LINK_NOSTOP)
@@ -1110,10 +1176,12 @@ void ChSystem::RemoveAllLinks()
 		HIER_LINK_NEXT
 	}	
 	linklist.clear(); 
+	linkarray_valid = false;
 };
 
 void ChSystem::RemoveAllOtherPhysicsItems() 
 { 
+	ResetIncrementalInjection();
 	HIER_OTHERPHYSICS_INIT
 	while (HIER_OTHERPHYSICS_NOSTOP)
 	{
@@ -1345,88 +1413,434 @@ void ChSystem::SetIntegrationType (eCh_integrationType m_integration)
 
 
 
-void ChSystem::WakeUpSleepingBodies()
+// Union-find on the island indexes of the items, with path halving.
+
+static int ChIslandFind(std::vector<int>& parent, int i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+static void ChIslandUnion(std::vector<int>& parent, int a, int b)
+{
+	a = ChIslandFind(parent, a);
+	b = ChIslandFind(parent, b);
+	if (a < b)
+		parent[b] = a;
+	else if (b < a)
+		parent[a] = b;
+}
+
+// Callback that joins the islands of the two items of each contact.
+
+class ChSystemIslandContacts : public ChReportContactCallback 
+{
+public:
+	std::vector<int>* parent;
+
+	virtual bool ReportContactCallback (
+					const ChVector<>& pA,
+					const ChVector<>& pB,
+					const ChMatrix33<>& plane_coord,
+					const double& distance,
+					const float& mfriction,
+					const ChVector<>& react_forces,
+					const ChVector<>& react_torques,
+					collision::ChCollisionModel* modA,
+					collision::ChCollisionModel* modB
+										) 
+	{
+		if (!(modA && modB)) 
+			return true;
+		ChPhysicsItem* itemA = modA->GetPhysicsItem();
+		ChPhysicsItem* itemB = modB->GetPhysicsItem();
+		if (!(itemA && itemB))
+			return true;
+		int ia = itemA->GetIslandIndex();
+		int ib = itemB->GetIslandIndex();
+		int n = (int)parent->size();
+		if (ia >= 0 && ib >= 0 && ia < n && ib < n)
+			ChIslandUnion(*parent, ia, ib);
+		return true; // to continue scanning contacts
+	}
+};
+
+
+// Pairs found by the collision system, used to join to the islands the
+// fixed bodies moved by the user: their contacts with sleeping bodies are 
+// not kept by the contact containers, as both bodies are inactive.
+
+class ChSystemIslandProximities : public ChProximityContainerBase
+{
+public:
+	std::vector<int>* parent;
+	std::vector<ChBody*>* bodies;
+
+	virtual int  GetNproximities() {return 0;}
+	virtual void RemoveAllProximities() {}
+	virtual void ReportAllProximities(ChReportProximityCallback* mcallback) {}
+	virtual void AddProximity(collision::ChCollisionModel* modA, collision::ChCollisionModel* modB)
+	{
+		ChPhysicsItem* itemA = modA->GetPhysicsItem();
+		ChPhysicsItem* itemB = modB->GetPhysicsItem();
+		if (!(itemA && itemB))
+			return;
+		int ia = itemA->GetIslandIndex();
+		int ib = itemB->GetIslandIndex();
+		int nb = (int)bodies->size();
+		if (ia < 0 || ib < 0 || ia >= (int)parent->size() || ib >= (int)parent->size())
+			return;
+		if ((ia < nb && (*bodies)[ia]->GetBodyFixed()) ||
+			(ib < nb && (*bodies)[ib]->GetBodyFixed()))
+			ChIslandUnion(*parent, ia, ib);
+	}
+};
+
+
+void ChSystem::ComputeIslands()
 {
-	// Make this class for iterating through contacts (if supported by
-	// contact container)
+	ChProfileScope mscope(profiler, "ComputeIslands");
+
+	if (!this->GetUseSleeping())
+		return;
 
-	class _wakeup_reporter_class : public ChReportContactCallback 
+	int nb = (int)bodylist.size();
+	int nitems = nb + (int)otherphysicslist.size();
+
+	island_parent.resize(nitems);
+	island_awake.assign(nitems, 0);
+
+	// The bodies are the items 0..nb-1 of the forest. Fixed bodies do not
+	// belong to islands, otherwise all bodies on the ground would be joined,
+	// unless the user moved them since the last step: then they keep awake
+	// the bodies they touch.
+	// Bodies that were put to sleep in the same island are joined again
+	// (there are no contacts between sleeping bodies), using island_number 
+	// for the first body found in each island of sleeping bodies.
+
+	island_number.assign(nislands_sleeping, -1);
+	bool fixed_moved = false;
+
+	for (int i = 0; i < nb; i++)
 	{
-	public:
-				/// Callback, used to report contact points already added to the container.
-				/// This must be implemented by a child class of ChReportContactCallback.
-				/// If returns false, the contact scanning will be stopped.
-		virtual bool ReportContactCallback (
-						const ChVector<>& pA,				///< get contact pA
-						const ChVector<>& pB,				///< get contact pB
-						const ChMatrix33<>& plane_coord,	///< get contact plane coordsystem (A column 'X' is contact normal)
-						const double& distance,				///< get contact distance
-						const float& mfriction,			  	///< get friction info
-						const ChVector<>& react_forces,		///< get react.forces (if already computed). In coordsystem 'plane_coord'
-						const ChVector<>& react_torques,	///< get react.torques, if rolling friction (if already computed)
-						collision::ChCollisionModel* modA,	///< get model A (note: some containers may not support it and could be zero!)
-						collision::ChCollisionModel* modB	///< get model B (note: some containers may not support it and could be zero!)
-											) 
+		ChBody* mbody = bodylist[i];
+		island_parent[i] = i;
+		if (mbody->GetBodyFixed())
 		{
-			if (!(modA && modB)) 
-				return true;
-			ChBody* b1=0;
-			ChBody* b2=0;
-			if (ChModelBulletBody* mmboA = dynamic_cast<ChModelBulletBody*>(modA))
-				b1 = mmboA->GetBody();
-			if (ChModelBulletBody* mmboB = dynamic_cast<ChModelBulletBody*>(modB))
-				b2 = mmboB->GetBody();
-			if (!(b1 && b2)) 
-				return true;
-			bool sleep1 = b1->GetSleeping();
-			bool sleep2 = b2->GetSleeping();
-			bool ground1 = b1->GetBodyFixed();
-			bool ground2 = b2->GetBodyFixed();
-			if (sleep1 && !sleep2 && !ground2)
+			bool mmoved = mbody->HasMovedSinceIslands();
+			mbody->SynchronizeIslandPos();
+			mbody->SetIslandIndex(mmoved ? i : -1);
+			if (mmoved)
 			{
-				b1->SetSleeping(false);
+				island_awake[i] = 1;
+				fixed_moved = true;
 			}
-			if (sleep2 && !sleep1 && !ground1)
+			continue;
+		}
+		mbody->SetIslandIndex(i);
+
+		if (mbody->GetSleeping())
+		{
+			int msleeping = mbody->GetSleepingIsland();
+			if (msleeping >= 0 && msleeping < nislands_sleeping)
 			{
-				b2->SetSleeping(false);
+				if (island_number[msleeping] < 0)
+					island_number[msleeping] = i;
+				else
+					ChIslandUnion(island_parent, island_number[msleeping], i);
 			}
-			this->someone_sleeps = sleep1 | sleep2 | this->someone_sleeps;
+			if (!mbody->GetUseSleeping())
+				island_awake[i] = 1;
+		}
+		else if (!mbody->CanSleep())
+			island_awake[i] = 1;
+	}
+
+	// Other physics items (particles, FEM meshes, etc.) do not sleep,
+	// so they keep awake the bodies that touch them.
 
-			return true; // to continue scanning contacts
+	int nother = nb;
+	HIER_OTHERPHYSICS_INIT
+	while HIER_OTHERPHYSICS_NOSTOP
+	{
+		PHpointer->SetIslandIndex(nother);
+		island_parent[nother] = nother;
+		island_awake[nother] = 1;
+		nother++;
+		HIER_OTHERPHYSICS_NEXT
+	}
+
+	// Join the islands connected by links
+
+	HIER_LINK_INIT
+	while HIER_LINK_NOSTOP
+	{
+		ChBody* mbody1 = Lpointer->GetBody1();
+		ChBody* mbody2 = Lpointer->GetBody2();
+		int i1 = mbody1 ? mbody1->GetIslandIndex() : -1;
+		int i2 = mbody2 ? mbody2->GetIslandIndex() : -1;
+		if (i1 >= nitems) i1 = -1;
+		if (i2 >= nitems) i2 = -1;
+		if (Lpointer->IsActive() && i1 >= 0 && i2 >= 0)
+			ChIslandUnion(island_parent, i1, i2);
+		if (Lpointer->IsRequiringWaking())
+		{
+			if (i1 >= 0) island_awake[i1] = 1;
+			if (i2 >= 0) island_awake[i2] = 1;
 		}
+		HIER_LINK_NEXT
+	}
 
-		// Data 
-		bool someone_sleeps;
-	};
+	// Join the islands connected by contacts. Note that contacts between
+	// bodies that are both sleeping are not in the containers.
 
-	_wakeup_reporter_class my_waker;
+	ChSystemIslandContacts mcontacts;
+	mcontacts.parent = &island_parent;
 
-	if (this->GetUseSleeping())
+	this->contact_container->ReportAllContacts(&mcontacts);
+
+	for (std::list<ChPhysicsItem*>::iterator iph = otherphysicslist.begin(); iph != otherphysicslist.end(); ++iph)
 	{
-		for (int i=0; i<1; i++)  //***TO DO*** reconfigurable number of wakeup cycles
+		if (ChContactContainerBase* mcontactcontainer = dynamic_cast<ChContactContainerBase*>(*iph))
+			mcontactcontainer->ReportAllContacts(&mcontacts);
+	}
+
+	if (fixed_moved)
+	{
+		ChSystemIslandProximities mproximities;
+		mproximities.parent = &island_parent;
+		mproximities.bodies = &bodylist;
+		collision_system->ReportProximities(&mproximities);
+	}
+
+	// An island stays awake if any of its items must stay awake
+
+	for (int i = 0; i < nitems; i++)
+		if (island_awake[i])
+			island_awake[ChIslandFind(island_parent, i)] = 1;
+
+	// Wake up or put to sleep all the bodies of each island, and
+	// number the islands of sleeping bodies for the next step.
+
+	island_number.assign(nitems, -1);
+	nislands_sleeping = 0;
+	island_woken.clear();
+
+	for (int i = 0; i < nb; i++)
+	{
+		ChBody* mbody = bodylist[i];
+		if (mbody->GetIslandIndex() < 0)
+			continue;
+		int mroot = ChIslandFind(island_parent, i);
+		if (island_awake[mroot])
+		{
+			if (mbody->GetSleeping())
+			{
+				mbody->SetSleeping(false);	// updated by Update(), as the other awake bodies
+				if (mbody->GetCollide())
+					island_woken.push_back(mbody->GetCollisionModel());
+			}
+		}
+		else
 		{
-			my_waker.someone_sleeps = false;
+			if (island_number[mroot] < 0)
+				island_number[mroot] = nislands_sleeping++;
+			if (!mbody->GetSleeping())
+			{
+				mbody->SetSleeping(true);
+				mbody->Update(ChTime);	// will not be updated while sleeping
+			}
+			mbody->SetSleepingIsland(island_number[mroot]);
+		}
+	}
+
+	// The narrow phase skipped the pairs of the bodies just woken up with each
+	// other and with sleeping bodies: it is done for these pairs only, then
+	// the contacts are reported again.
+
+	if (!island_woken.empty())
+	{
+		this->contact_container->RepeatAddContact();
+		for (std::list<ChPhysicsItem*>::iterator iph = otherphysicslist.begin(); iph != otherphysicslist.end(); ++iph)
+		{
+			if (ChContactContainerBase* mcontactcontainer = dynamic_cast<ChContactContainerBase*>(*iph))
+				mcontactcontainer->RepeatAddContact();
+		}
+		collision_system->RunWoken(island_woken);
+		ReportCollisions();
+	}
+}
+
+
+
+
+////////////////////////////////
+//////
+////// PARALLEL PASSES ON BODIES AND LINKS
+//////
+//////
+
+// Bodies of the loops on bodies and links, executed by RunItemsLoop().
+// Each one modifies only the data of its own items, so these can be
+// executed in parallel, with the same results as a serial execution.
+
+class ChSystemUpdateBodies : public ChTaskPoolLoop
+{
+public:
+	ChBody** bodies;
+	double mytime;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			bodies[i]->Update(mytime);
+	}
+};
+
+class ChSystemUpdateLinks : public ChTaskPoolLoop
+{
+public:
+	ChLink** links;
+	double mytime;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			links[i]->Update(mytime);
+	}
+};
 
-			// scan all links and wake connected bodies
-			HIER_LINK_INIT
-			while HIER_LINK_NOSTOP
+class ChSystemLoadBodies : public ChTaskPoolLoop
+{
+public:
+	ChBody** bodies;
+	double F_factor;
+	bool load_Mv;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (F_factor)
+				bodies[i]->VariablesFbLoadForces(F_factor);		// f*dt
+			if (load_Mv)
 			{
-				if (Lpointer->IsRequiringWaking())
-				{
-					Lpointer->GetBody1()->SetSleeping(false);
-					Lpointer->GetBody2()->SetSleeping(false);
-				}
-				HIER_LINK_NEXT
+				bodies[i]->VariablesQbLoadSpeed();				//   v_old 
+				bodies[i]->VariablesFbIncrementMq();			// M*v_old
 			}
-			
-			// scan all contacts and wake neighbouring bodies
-			this->contact_container->ReportAllContacts(&my_waker);
-			
-			// bailout wakeup cycle prematurely, if all bodies are not sleeping
-			if (!my_waker.someone_sleeps) 
-				break; 
 		}
 	}
+};
+
+	// Only the terms of the constraints: forces and masses of links 
+	// are added to the 'fb' of the bodies, so that must be serial.
+class ChSystemLoadLinkConstraints : public ChTaskPoolLoop
+{
+public:
+	ChLink** links;
+	double C_factor;
+	double recovery_clamp;
+	bool do_clamp;
+	double Ct_factor;
+	bool load_jacobians;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (C_factor)
+				links[i]->ConstraintsBiLoad_C(C_factor, recovery_clamp, do_clamp);
+			if (Ct_factor)
+				links[i]->ConstraintsBiLoad_Ct(Ct_factor);		// Ct
+			if (load_jacobians)
+				links[i]->ConstraintsLoadJacobians();
+		}
+	}
+};
+
+class ChSystemFetchLinkReactions : public ChTaskPoolLoop
+{
+public:
+	ChLink** links;
+	double mfactor;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			links[i]->ConstraintsFetch_react(mfactor);
+	}
+};
+
+class ChSystemIntegrateBodies : public ChTaskPoolLoop
+{
+public:
+	ChBody** bodies;
+	double dt_position;		// pos+=v_new*dt_position
+	bool increment_position;
+	bool set_speed;			// set body speed from v_new, using 'step'
+	double step;
+	bool update;			// update markers and forces at 'mytime'
+	double mytime;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			if (increment_position)
+				bodies[i]->VariablesQbIncrementPosition(dt_position);
+			if (set_speed)
+				bodies[i]->VariablesQbSetSpeed(step);
+			if (update)
+				bodies[i]->Update(mytime);
+		}
+	}
+};
+
+
+void ChSystem::RunItemsLoop(int nitems, ChTaskPoolLoop& mloop, int chunk_size)
+{
+	if (nitems <= 0)
+		return;
+
+	if (!use_parallel_passes || parallel_thread_number < 2)
+	{
+		mloop.Run(0, nitems);
+		return;
+	}
+
+	if (!task_pool || task_pool->GetNumThreads() != parallel_thread_number)
+	{
+		if (task_pool) 
+			delete task_pool;
+		task_pool = new ChTaskPool(parallel_thread_number);
+	}
+
+	// chunks must be large enough to amortize the scheduling
+	if (chunk_size <= 0)
+		chunk_size = ChMax(64, nitems / (8 * parallel_thread_number));
+	task_pool->ParallelFor(nitems, mloop, chunk_size);
+}
+
+
+std::vector<ChLink*>& ChSystem::GetLinkArray()
+{
+	if (!linkarray_valid)
+	{
+		linkarray.assign(linklist.begin(), linklist.end());
+		linkarray_valid = true;
+	}
+	return linkarray;
+}
+
+std::vector<ChBody*>& ChSystem::GetAwakeBodyArray()
+{
+	if (!awakebodyarray_valid)
+	{
+		awakebodyarray.clear();
+		for (unsigned int i = 0; i < bodylist.size(); i++)
+			if (!bodylist[i]->GetSleeping())
+				awakebodyarray.push_back(bodylist[i]);
+		awakebodyarray_valid = true;
+	}
+	return awakebodyarray;
 }
 
 
@@ -1444,6 +1858,7 @@ void ChSystem::WakeUpSleepingBodies()
 
 int ChSystem::Setup()
 {
+	ChProfileScope mscope(profiler, "Setup");
 	events->Record(CHEVENT_SETUP);
 
 	int need_update = FALSE;
@@ -1525,6 +1940,13 @@ int ChSystem::Setup()
 
 	ndof= ncoords - ndoc;			// sets number of left degrees of freedom (approximate - does not consider constr. redundancy, etc)
 
+	if (profiler)
+	{
+		profiler->SetCounter("bodies", nbodies);
+		profiler->SetCounter("links", nlinks);
+		profiler->SetCounter("dof", ndof);
+	}
+
 	return need_update;
 }
 
@@ -1537,6 +1959,7 @@ int ChSystem::Setup()
 
 void ChSystem::Update() 
 {
+	ChProfileScope mscope(profiler, "Update");
 
 	ChTimer<double>mtimer; mtimer.start(); // Timer for profiling
 
@@ -1552,16 +1975,15 @@ void ChSystem::Update()
 									// --------------------------------------
 									// Spread state vector Y to bodies
 									//    Y --> Bodies
-	HIER_BODY_INIT					//    Y_accel --> Bodies
-	while HIER_BODY_NOSTOP			// Updates recursively all other aux.vars
-	{								// --------------------------------------
-		Bpointer->Update(ChTime);  
-
-		if (this->GetUseSleeping())
-			Bpointer->TrySleeping();
-
-		HIER_BODY_NEXT
-	}
+									//    Y_accel --> Bodies
+									// Updates recursively all other aux.vars
+									// --------------------------------------
+									// (sleeping bodies are not updated)
+	std::vector<ChBody*>& mbodies = GetAwakeBodyArray();
+	ChSystemUpdateBodies mupdatebodies;
+	mupdatebodies.bodies = mbodies.empty() ? 0 : &mbodies[0];
+	mupdatebodies.mytime = ChTime;
+	RunItemsLoop((int)mbodies.size(), mupdatebodies);
 									// -----------------------------
 									// Updates other physical items
 									// -----------------------------
@@ -1575,13 +1997,11 @@ void ChSystem::Update()
 									// -----------------------------
 									// Updates all links
 									// -----------------------------
-	HIER_LINK_INIT					
-	while HIER_LINK_NOSTOP
-	{
-		Lpointer->Update(ChTime);
-
-		HIER_LINK_NEXT
-	}
+	std::vector<ChLink*>& mlinks = GetLinkArray();
+	ChSystemUpdateLinks mupdatelinks;
+	mupdatelinks.links = mlinks.empty() ? 0 : &mlinks[0];
+	mupdatelinks.mytime = ChTime;
+	RunItemsLoop((int)mlinks.size(), mupdatelinks);
 
 	this->contact_container->Update(); // Update all contacts, if any
 
@@ -1621,18 +2041,16 @@ void ChSystem::UpdateExternalGeometry ()
 
 void ChSystem::LCPprepare_reset()
 {
+	ChProfileScope mscope(profiler, "LCPprepare_reset");
 	HIER_LINK_INIT
 	while HIER_LINK_NOSTOP
 	{
 		Lpointer->ConstraintsBiReset();
 		HIER_LINK_NEXT
 	}
-	HIER_BODY_INIT
-	while HIER_BODY_NOSTOP
-	{
-		Bpointer->VariablesFbReset();
-		HIER_BODY_NEXT
-	}	
+	std::vector<ChBody*>& mbodies = GetAwakeBodyArray();
+	for (unsigned int i = 0; i < mbodies.size(); i++)
+		mbodies[i]->VariablesFbReset();
 	HIER_OTHERPHYSICS_INIT
 	while HIER_OTHERPHYSICS_NOSTOP
 	{
@@ -1656,37 +2074,40 @@ void ChSystem::LCPprepare_load(bool load_jacobians,
 							   bool do_clamp
 							    )
 {
-	HIER_LINK_INIT
-	while HIER_LINK_NOSTOP
+	ChProfileScope mscope(profiler, "LCPprepare_load");
+
+	std::vector<ChLink*>& mlinks = GetLinkArray();
+	ChSystemLoadLinkConstraints mloadlinks;
+	mloadlinks.links = mlinks.empty() ? 0 : &mlinks[0];
+	mloadlinks.C_factor = C_factor;
+	mloadlinks.recovery_clamp = recovery_clamp;
+	mloadlinks.do_clamp = do_clamp;
+	mloadlinks.Ct_factor = Ct_factor;
+	mloadlinks.load_jacobians = load_jacobians;
+	RunItemsLoop((int)mlinks.size(), mloadlinks);
+
+	if (F_factor || load_Mv)
 	{
-		if (C_factor)
-			Lpointer->ConstraintsBiLoad_C(C_factor, recovery_clamp, do_clamp);
-		if (Ct_factor)
-			Lpointer->ConstraintsBiLoad_Ct(Ct_factor);			// Ct
-		if (F_factor)
-			Lpointer->ConstraintsFbLoadForces(F_factor);		// f*dt
-		if (load_Mv)
+		HIER_LINK_INIT
+		while HIER_LINK_NOSTOP
 		{
-			Lpointer->VariablesQbLoadSpeed();					//   v_old 
-			Lpointer->VariablesFbIncrementMq();					// M*v_old
+			if (F_factor)
+				Lpointer->ConstraintsFbLoadForces(F_factor);		// f*dt
+			if (load_Mv)
+			{
+				Lpointer->VariablesQbLoadSpeed();					//   v_old 
+				Lpointer->VariablesFbIncrementMq();					// M*v_old
+			}
+			HIER_LINK_NEXT
 		}
-		if (load_jacobians)
-			Lpointer->ConstraintsLoadJacobians();
-		HIER_LINK_NEXT
 	}
 
-	HIER_BODY_INIT
-	while HIER_BODY_NOSTOP
-	{
-		if (F_factor)
-			Bpointer->VariablesFbLoadForces(F_factor);			// f*dt
-		if (load_Mv)
-		{
-			Bpointer->VariablesQbLoadSpeed();					//   v_old 
-			Bpointer->VariablesFbIncrementMq();					// M*v_old
-		} 
-		HIER_BODY_NEXT
-	}
+	std::vector<ChBody*>& mbodies = GetAwakeBodyArray();
+	ChSystemLoadBodies mloadbodies;
+	mloadbodies.bodies = mbodies.empty() ? 0 : &mbodies[0];
+	mloadbodies.F_factor = F_factor;
+	mloadbodies.load_Mv = load_Mv;
+	RunItemsLoop((int)mbodies.size(), mloadbodies);
 
 	HIER_OTHERPHYSICS_INIT
 	while HIER_OTHERPHYSICS_NOSTOP
@@ -1720,19 +2141,29 @@ void ChSystem::LCPprepare_load(bool load_jacobians,
 
 void ChSystem::LCPprepare_inject(ChLcpSystemDescriptor& mdescriptor)
 {
-	mdescriptor.BeginInsertion(); // This resets the vectors of constr. and var. pointers.
+	ChProfileScope mscope(profiler, "LCPprepare_inject");
+	// In incremental mode, links and bodies are kept in the descriptor from 
+	// the previous injection, if they did not change since then: only the
+	// other items and the contacts, that follow them, are injected again.
+	bool keep_static = false;
+	if (this->use_incremental_injection)
+		keep_static = mdescriptor.BeginIncrementalInsertion(); 
+	else
+		mdescriptor.BeginInsertion(); // This resets the vectors of constr. and var. pointers.
 
-	HIER_LINK_INIT
-	while HIER_LINK_NOSTOP
+	if (!keep_static)
 	{
-		Lpointer->InjectConstraints(mdescriptor);
-		HIER_LINK_NEXT
-	}
-	HIER_BODY_INIT
-	while HIER_BODY_NOSTOP
-	{
-		Bpointer->InjectVariables(mdescriptor);
-		HIER_BODY_NEXT
+		HIER_LINK_INIT
+		while HIER_LINK_NOSTOP
+		{
+			Lpointer->InjectConstraints(mdescriptor);
+			HIER_LINK_NEXT
+		}
+		std::vector<ChBody*>& mbodies = GetAwakeBodyArray(); // sleeping bodies are not injected
+		for (unsigned int i = 0; i < mbodies.size(); i++)
+			mbodies[i]->InjectVariables(mdescriptor);
+		if (this->use_incremental_injection)
+			mdescriptor.SetStaticMark();
 	}
 	HIER_OTHERPHYSICS_INIT
 	while HIER_OTHERPHYSICS_NOSTOP
@@ -1745,11 +2176,18 @@ void ChSystem::LCPprepare_inject(ChLcpSystemDescriptor& mdescriptor)
 	this->contact_container->InjectConstraints(mdescriptor);
 
 	mdescriptor.EndInsertion(); 
+
+	if (profiler)
+	{
+		profiler->SetCounter("variables", mdescriptor.CountActiveVariables());
+		profiler->SetCounter("constraints", mdescriptor.CountActiveConstraints());
+	}
 }
 
 
 void ChSystem::LCPprepare_Li_from_speed_cache()
 {
+	ChProfileScope mscope(profiler, "LCPprepare_Li_from_speed_cache");
 	HIER_LINK_INIT
 	while HIER_LINK_NOSTOP
 	{
@@ -1767,6 +2205,7 @@ void ChSystem::LCPprepare_Li_from_speed_cache()
 
 void ChSystem::LCPprepare_Li_from_position_cache()
 {
+	ChProfileScope mscope(profiler, "LCPprepare_Li_from_position_cache");
 	HIER_LINK_INIT
 	while HIER_LINK_NOSTOP
 	{
@@ -1784,6 +2223,7 @@ void ChSystem::LCPprepare_Li_from_position_cache()
 
 void ChSystem::LCPresult_Li_into_speed_cache()
 {
+	ChProfileScope mscope(profiler, "LCPresult_Li_into_speed_cache");
 	HIER_LINK_INIT
 	while HIER_LINK_NOSTOP
 	{
@@ -1801,6 +2241,7 @@ void ChSystem::LCPresult_Li_into_speed_cache()
 
 void ChSystem::LCPresult_Li_into_position_cache()
 {
+	ChProfileScope mscope(profiler, "LCPresult_Li_into_position_cache");
 	HIER_LINK_INIT
 	while HIER_LINK_NOSTOP
 	{
@@ -1818,12 +2259,14 @@ void ChSystem::LCPresult_Li_into_position_cache()
 
 void ChSystem::LCPresult_Li_into_reactions(double mfactor)
 {
-	HIER_LINK_INIT
-	while HIER_LINK_NOSTOP
-	{
-		Lpointer->ConstraintsFetch_react(mfactor);
-		HIER_LINK_NEXT
-	}
+	ChProfileScope mscope(profiler, "LCPresult_Li_into_reactions");
+
+	std::vector<ChLink*>& mlinks = GetLinkArray();
+	ChSystemFetchLinkReactions mfetchlinks;
+	mfetchlinks.links = mlinks.empty() ? 0 : &mlinks[0];
+	mfetchlinks.mfactor = mfactor;
+	RunItemsLoop((int)mlinks.size(), mfetchlinks);
+
 	HIER_OTHERPHYSICS_INIT
 	while HIER_OTHERPHYSICS_NOSTOP
 	{
@@ -1893,25 +2336,40 @@ public:
 
 double ChSystem::ComputeCollisions()
 {
+	ChProfileScope mscope(profiler, "ComputeCollisions");
 	double mretC= 0.0; 
 
 	ChTimer<double> mtimer;  
 	mtimer.start();
 
 	// Update all positions of collision models	
-	HIER_BODY_INIT
-	while HIER_BODY_NOSTOP
 	{
-		Bpointer->SyncCollisionModels();
-		HIER_BODY_NEXT
-	}
+	ChProfileScope mscope_sync(profiler, "SyncCollisionModels");
+	std::vector<ChBody*>& mbodies = GetAwakeBodyArray(); // sleeping bodies did not move
+	for (unsigned int i = 0; i < mbodies.size(); i++)
+		mbodies[i]->SyncCollisionModels();
 	HIER_OTHERPHYSICS_INIT
 	while HIER_OTHERPHYSICS_NOSTOP
 	{
 		PHpointer->SyncCollisionModels();
 		HIER_OTHERPHYSICS_NEXT
 	}
+	}
  
+	// !!! Perform the collision detection ( broadphase and narrowphase ) !!!
+	
+	collision_system->Run();
+
+	ReportCollisions();
+
+	mtimer.stop();
+	this->timer_collision_broad = mtimer();
+
+	return mretC;
+}
+
+void ChSystem::ReportCollisions()
+{
 	// Prepare the callback
 
 	// In case there is some user callback for each added point..
@@ -1923,17 +2381,15 @@ double ChSystem::ComputeCollisions()
 	} else 
 		this->contact_container->SetAddContactCallback(0);
 
-	// !!! Perform the collision detection ( broadphase and narrowphase ) !!!
-	
-	collision_system->Run();
-
 	// Report and store contacts and/or proximities, if there are some 
 	// containers in the physic system. The default contact container
 	// for ChBody and ChParticles is used always.
 
+	{
+	ChProfileScope mscope_report(profiler, "ReportContacts");
+
 	collision_system->ReportContacts(this->contact_container);
 
-	{
 	HIER_OTHERPHYSICS_INIT
 	while HIER_OTHERPHYSICS_NOSTOP
 	{
@@ -1955,11 +2411,8 @@ double ChSystem::ComputeCollisions()
 
 	// Count the contacts of body-body type.
 	this->ncontacts = this->contact_container->GetNcontacts();
-
-	mtimer.stop();
-	this->timer_collision_broad = mtimer();
-
-	return mretC;
+	if (profiler)
+		profiler->SetCounter("contacts", this->ncontacts);
 }
 
 
@@ -1985,6 +2438,156 @@ double ChSystem::ComputeCollisions()
 
 
 
+	// Attach the n. of iterations and the history of the constraint violation
+	// of an iterative solver to the current scope of the profiler, if any.
+	// The history is available only if the solver has SetRecordViolation(true).
+static void ChSystemProfileSolver(ChProfiler* profiler, ChLcpSolver* msolver)
+{
+	if (!profiler)
+		return;
+	if (ChLcpIterativeSolver* miterative = dynamic_cast<ChLcpIterativeSolver*>(msolver))
+	{
+		profiler->SetCounter("iterations", miterative->GetTotalIterations());
+		if (!miterative->GetViolationHistory().empty())
+		{
+			profiler->SetCounter("violation", miterative->GetViolationHistory().back());
+			profiler->SetSeries("violation history", miterative->GetViolationHistory());
+		}
+	}
+}
+
+
+// Solver for the islands of the LCP, of the same type of the solvers 
+// created by SetLcpSolverType(), or 0 if the type can't solve islands.
+
+static ChLcpIterativeSolver* ChSystemNewIslandSolver(ChSystem::eCh_lcpSolver mtype)
+{
+	switch (mtype)
+	{
+	case ChSystem::LCP_ITERATIVE_SOR:				return new ChLcpIterativeSOR();
+	case ChSystem::LCP_ITERATIVE_SYMMSOR:			return new ChLcpIterativeSymmSOR();
+	case ChSystem::LCP_ITERATIVE_JACOBI:			return new ChLcpIterativeJacobi();
+	case ChSystem::LCP_ITERATIVE_PMINRES:			return new ChLcpIterativePMINRES();
+	case ChSystem::LCP_ITERATIVE_BARZILAIBORWEIN:	return new ChLcpIterativeBB();
+	case ChSystem::LCP_ITERATIVE_PCG:				return new ChLcpIterativePCG();
+	case ChSystem::LCP_ITERATIVE_APGD:				return new ChLcpIterativeAPGD();
+	case ChSystem::LCP_ITERATIVE_SOR_COLORED:		return new ChLcpIterativeSORcolored();
+	default:
+		return 0;
+	}
+}
+
+// Body of the loop on the islands of the LCP, executed by RunItemsLoop().
+// Islands do not share variables, so they can be solved in parallel.
+
+class ChSystemSolveIslands : public ChTaskPoolLoop
+{
+public:
+	ChLcpSystemDescriptor* descriptor;
+	ChLcpSolver** solvers;
+	int* order;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			solvers[order[i]]->Solve(*descriptor->GetIsland(order[i]));
+	}
+};
+
+class ChSystemIslandSizeCompare
+{
+public:
+	ChLcpSystemDescriptor* descriptor;
+	bool operator()(int a, int b) const
+	{
+		return descriptor->GetIsland(a)->GetConstraintsList().size() > 
+			   descriptor->GetIsland(b)->GetConstraintsList().size();
+	}
+};
+
+void ChSystem::LCPsolve(ChLcpSolver* msolver)
+{
+	ChLcpIterativeSolver* miterative = dynamic_cast<ChLcpIterativeSolver*>(msolver);
+
+	if (use_lcp_islands && miterative && !use_GPU && island_solvers.empty())
+	{
+		ChLcpIterativeSolver* mfirst = ChSystemNewIslandSolver(lcp_solver_type);
+		if (mfirst)
+			island_solvers.push_back(mfirst);
+	}
+
+	// Solvers plugged with ChangeLcpSolverSpeed() etc. are not of the type of
+	// island solvers: in that case, and for non-iterative solvers, solve as a whole.
+	bool use_islands = use_lcp_islands && miterative && !use_GPU &&
+					   !island_solvers.empty() && 
+					   typeid(*island_solvers[0]) == typeid(*msolver);
+
+	int nislands = use_islands ? LCP_descriptor->SplitIntoIslands() : 0;
+
+	if (nislands < 2)
+	{
+		msolver->Solve(*LCP_descriptor);
+		ChSystemProfileSolver(profiler, msolver);
+		return;
+	}
+
+	while ((int)island_solvers.size() < nislands)
+		island_solvers.push_back(ChSystemNewIslandSolver(lcp_solver_type));
+
+	for (int i = 0; i < nislands; i++)
+		((ChLcpIterativeSolver*)island_solvers[i])->CopySettings(miterative);
+
+	// Largest islands first, for load balancing
+	island_order.resize(nislands);
+	for (int i = 0; i < nislands; i++)
+		island_order[i] = i;
+	ChSystemIslandSizeCompare mcompare;
+	mcompare.descriptor = LCP_descriptor;
+	std::stable_sort(island_order.begin(), island_order.end(), mcompare);
+
+	ChSystemSolveIslands msolve;
+	msolve.descriptor = LCP_descriptor;
+	msolve.solvers = &island_solvers[0];
+	msolve.order = &island_order[0];
+	RunItemsLoop(nislands, msolve, 1);
+
+	// islands changed the offsets of variables and constraints
+	LCP_descriptor->UpdateCountsAndOffsets();
+
+	// the violation history of the whole system has, at each iteration,
+	// the largest values of the islands
+	if (miterative->GetRecordViolation())
+	{
+		std::vector<double>& mviolation = miterative->GetViolationHistory();
+		std::vector<double>& mdlambda = miterative->GetDeltalambdaHistory();
+		mviolation.clear();
+		mdlambda.clear();
+		for (int i = 0; i < nislands; i++)
+		{
+			ChLcpIterativeSolver* misland = (ChLcpIterativeSolver*)island_solvers[i];
+			std::vector<double>& iviolation = misland->GetViolationHistory();
+			std::vector<double>& idlambda = misland->GetDeltalambdaHistory();
+			if (mviolation.size() < iviolation.size())
+				mviolation.resize(iviolation.size(), 0.);
+			if (mdlambda.size() < idlambda.size())
+				mdlambda.resize(idlambda.size(), 0.);
+			for (unsigned int j = 0; j < iviolation.size(); j++)
+				mviolation[j] = ChMax(mviolation[j], iviolation[j]);
+			for (unsigned int j = 0; j < idlambda.size(); j++)
+				mdlambda[j] = ChMax(mdlambda[j], idlambda[j]);
+		}
+	}
+
+	if (profiler)
+	{
+		double max_iterations = 0;
+		for (int i = 0; i < nislands; i++)
+			max_iterations = ChMax(max_iterations, ((ChLcpIterativeSolver*)island_solvers[i])->GetTotalIterations());
+		profiler->SetCounter("islands", nislands);
+		profiler->SetCounter("iterations", max_iterations);
+	}
+}
+
+
 // internal codes for m_repeat: if FALSE (null or 0) the step won't repeat
 //#define TRUE_REFINE 1
 //#define TRUE_FORCED 2
@@ -1992,6 +2595,8 @@ double ChSystem::ComputeCollisions()
 
 int ChSystem::Integrate_Y()
 {
+	ChProfileScope mscope(profiler, "Step");
+
 	switch (integration_type)
 	{
 		case INT_ANITESCU:
@@ -2037,15 +2642,15 @@ int ChSystem::Integrate_Y_impulse_Anitescu()
 
 	ComputeCollisions();
 
+				// Put to sleep the islands of bodies that came to a rest, and wake
+				// up the islands where some body is moving.
+	ComputeIslands();
 
-	Setup();	// Counts dofs, statistics, etc.
 
+	Setup();	// Counts dofs, statistics, etc.
 
-	Update();	// Update everything - and put to sleep bodies that need it
 
-				// Re-wake the bodies that cannot sleep because they are in contact with
-				// some body that is not in sleep state.
-	WakeUpSleepingBodies();
+	Update();	// Update everything (except sleeping bodies)
 
 
 	ChTimer<double> mtimer_lcp;
@@ -2085,9 +2690,10 @@ int ChSystem::Integrate_Y_impulse_Anitescu()
 
 	// Solve the LCP problem.
 	// Solution variables are new speeds 'v_new'
-	GetLcpSolverSpeed()->Solve(
-							*this->LCP_descriptor
-							);
+	{
+	ChProfileScope mscope_solve(profiler, "LCP solve speed");
+	LCPsolve(GetLcpSolverSpeed());
+	}
 	mtimer_lcp.stop();
 	timer_lcp = mtimer_lcp();
 
@@ -2099,21 +2705,23 @@ int ChSystem::Integrate_Y_impulse_Anitescu()
  
 	// perform an Eulero integration step (1st order stepping as pos+=v_new*dt)
 
-
-	HIER_BODY_INIT
-	while HIER_BODY_NOSTOP
 	{
-		// EULERO INTEGRATION: pos+=v_new*dt  (do not do this, if GPU already computed it)
-		if (!use_GPU)
-		{
-			Bpointer->VariablesQbIncrementPosition(this->GetStep());
-			// Set body speed, and approximates the acceleration by differentiation.
-			Bpointer->VariablesQbSetSpeed(this->GetStep());
-		}
-		// Now also updates all markers & forces
-		Bpointer->Update(this->ChTime);
-		HIER_BODY_NEXT
-	}
+	ChProfileScope mscope_integration(profiler, "Integration");
+
+	// EULERO INTEGRATION: pos+=v_new*dt  (do not do this, if GPU already computed it)
+	// Set body speed, and approximates the acceleration by differentiation.
+	// Now also updates all markers & forces
+	ChSystemIntegrateBodies mintegrate;
+	std::vector<ChBody*>& mbodies = GetAwakeBodyArray();
+	mintegrate.bodies = mbodies.empty() ? 0 : &mbodies[0];
+	mintegrate.dt_position = this->GetStep();
+	mintegrate.increment_position = !use_GPU;
+	mintegrate.set_speed = !use_GPU;
+	mintegrate.step = this->GetStep();
+	mintegrate.update = true;
+	mintegrate.mytime = this->ChTime;
+	RunItemsLoop((int)mbodies.size(), mintegrate);
+
  	HIER_OTHERPHYSICS_INIT
 	while HIER_OTHERPHYSICS_NOSTOP
 	{
@@ -2128,6 +2736,7 @@ int ChSystem::Integrate_Y_impulse_Anitescu()
 		PHpointer->Update(this->ChTime);
 		HIER_OTHERPHYSICS_NEXT
 	}
+	}
  
 	this->ChTime = ChTime + GetStep();
 
@@ -2180,14 +2789,14 @@ int ChSystem::Integrate_Y_impulse_Tasora()
 
 	ComputeCollisions();
 
+				// Put to sleep the islands of bodies that came to a rest, and wake
+				// up the islands where some body is moving.
+	ComputeIslands();
 
-	Setup();	// Counts dofs, statistics, etc.
 
-	Update();	// Update everything - and put to sleep bodies that need it
+	Setup();	// Counts dofs, statistics, etc.
 
-				// Re-wake the bodies that cannot sleep because they are in contact with
-				// some body that is not in sleep state.
-	WakeUpSleepingBodies();
+	Update();	// Update everything (except sleeping bodies)
 
 
 	ChTimer<double> mtimer_lcp;
@@ -2227,10 +2836,10 @@ int ChSystem::Integrate_Y_impulse_Tasora()
 
 	// Solve the LCP problem. 
 	// Solution variables are new speeds 'v_new'
-	
-	GetLcpSolverSpeed()->Solve(
-							*this->LCP_descriptor
-							);  
+	{
+	ChProfileScope mscope_solve(profiler, "LCP solve speed");
+	LCPsolve(GetLcpSolverSpeed());
+	}
 		
 	// stores computed multipliers in constraint caches, maybe useful for warm starting next step 
 	LCPresult_Li_into_speed_cache();
@@ -2241,19 +2850,23 @@ int ChSystem::Integrate_Y_impulse_Tasora()
 
 	// perform an Eulero integration step (1st order stepping as pos+=v_new*dt)
 
-
-	HIER_BODY_INIT
-	while HIER_BODY_NOSTOP
 	{
-		// EULERO INTEGRATION: pos+=v_new*dt
-		Bpointer->VariablesQbIncrementPosition(this->GetStep());
-		// Set body speed, and approximates the acceleration by differentiation.
-		Bpointer->VariablesQbSetSpeed(this->GetStep());
+	ChProfileScope mscope_integration(profiler, "Integration");
+
+	// EULERO INTEGRATION: pos+=v_new*dt
+	// Set body speed, and approximates the acceleration by differentiation.
+	// (updating markers & forces is not needed - will be done later anyway)
+	ChSystemIntegrateBodies mintegrate;
+	std::vector<ChBody*>& mbodies = GetAwakeBodyArray();
+	mintegrate.bodies = mbodies.empty() ? 0 : &mbodies[0];
+	mintegrate.dt_position = this->GetStep();
+	mintegrate.increment_position = true;
+	mintegrate.set_speed = true;
+	mintegrate.step = this->GetStep();
+	mintegrate.update = false;
+	mintegrate.mytime = this->ChTime;
+	RunItemsLoop((int)mbodies.size(), mintegrate);
 
-		// Now also updates all markers & forces
-		//Bpointer->UpdateALL(this->ChTime); // not needed - will be done later anyway
-		HIER_BODY_NEXT
-	}
 	HIER_OTHERPHYSICS_INIT
 	while HIER_OTHERPHYSICS_NOSTOP
 	{
@@ -2266,6 +2879,7 @@ int ChSystem::Integrate_Y_impulse_Tasora()
 		//PHpointer->UpdateALL(this->ChTime); // not needed - will be done later anyway
 		HIER_OTHERPHYSICS_NEXT
 	}
+	}
 
 	this->ChTime = ChTime + GetStep();
  
@@ -2300,22 +2914,29 @@ int ChSystem::Integrate_Y_impulse_Tasora()
 	// Solve the LCP problem.
 	// Solution variables are 'Dpos', delta positions.
 
-	GetLcpSolverStab()->Solve(
-							*this->LCP_descriptor
-							);
+	{
+	ChProfileScope mscope_solve(profiler, "LCP solve position");
+	LCPsolve(GetLcpSolverStab());
+	}
 
 	// stores computed multipliers in constraint caches, maybe useful for warm starting next step 
 	LCPresult_Li_into_position_cache();
 
 	{
-		HIER_BODY_INIT
-		while HIER_BODY_NOSTOP
-		{
-			Bpointer->VariablesQbIncrementPosition(1.0); // pos+=Dpos
-			// Now also updates all markers & forces
-			Bpointer->Update(this->ChTime);
-			HIER_BODY_NEXT
-		}
+		ChProfileScope mscope_integration(profiler, "Integration position");
+
+		// pos+=Dpos, then updates all markers & forces
+		ChSystemIntegrateBodies mintegrate;
+		std::vector<ChBody*>& mbodies = GetAwakeBodyArray();
+		mintegrate.bodies = mbodies.empty() ? 0 : &mbodies[0];
+		mintegrate.dt_position = 1.0;
+		mintegrate.increment_position = true;
+		mintegrate.set_speed = false;
+		mintegrate.step = this->GetStep();
+		mintegrate.update = true;
+		mintegrate.mytime = this->ChTime;
+		RunItemsLoop((int)mbodies.size(), mintegrate);
+
 		HIER_OTHERPHYSICS_INIT
 		while HIER_OTHERPHYSICS_NOSTOP
 		{
@@ -2535,9 +3156,9 @@ int ChSystem::DoStaticLinear()
 /*
 try
 {
-	chrono::ChSparseMatrix mdMK;
-	chrono::ChSparseMatrix mdCq;
-	chrono::ChSparseMatrix mdE;
+	chrono::ChCSRMatrix mdMK;
+	chrono::ChCSRMatrix mdCq;
+	chrono::ChCSRMatrix mdE;
 	chrono::ChMatrixDynamic<double> mdf;
 	chrono::ChMatrixDynamic<double> mdb;
 	chrono::ChMatrixDynamic<double> mdfric;
@@ -3183,6 +3804,121 @@ int ChSystem::StreamOUTall  (ChStreamOutBinary& m_file)
 	return 1;
 }
 
+// Each item is saved as the number of its values, then the values,
+// so that a snapshot that does not match the system is detected.
+
+static void ChStateSaveItem(ChPhysicsItem* mitem, ChStateSnapshot& msnapshot)
+{
+	int mpos = msnapshot.Reserve();
+	mitem->StateSave(msnapshot);
+	msnapshot.SetAt(mpos, msnapshot.GetSize() - mpos - 1);
+}
+
+static void ChStateRestoreItem(ChPhysicsItem* mitem, ChStateSnapshot& msnapshot)
+{
+	int nvalues = (int)msnapshot.Get();
+	int mstart = msnapshot.GetCursor();
+	mitem->StateRestore(msnapshot);
+	if (msnapshot.GetCursor() - mstart != nvalues)
+		throw ChException("The state snapshot does not match the system");
+}
+
+#define CH_STATE_SNAPSHOT_VERSION 2
+
+void ChSystem::StateSave (ChStateSnapshot& msnapshot)
+{
+	msnapshot.Clear();
+
+	msnapshot.Add(CH_STATE_SNAPSHOT_VERSION);
+	msnapshot.Add((int)bodylist.size());
+	msnapshot.Add((int)linklist.size());
+	msnapshot.Add((int)otherphysicslist.size());
+
+	msnapshot.Add(ChTime);
+	msnapshot.Add(step);
+	msnapshot.Add(stepcount);
+	msnapshot.Add(nislands_sleeping);
+
+	HIER_BODY_INIT
+	while HIER_BODY_NOSTOP
+	{
+		ChStateSaveItem(Bpointer, msnapshot);
+		HIER_BODY_NEXT
+	}
+	HIER_LINK_INIT
+	while HIER_LINK_NOSTOP
+	{
+		ChStateSaveItem(Lpointer, msnapshot);
+		HIER_LINK_NEXT
+	}
+	HIER_OTHERPHYSICS_INIT
+	while HIER_OTHERPHYSICS_NOSTOP
+	{
+		ChStateSaveItem(PHpointer, msnapshot);
+		HIER_OTHERPHYSICS_NEXT
+	}
+	ChStateSaveItem(contact_container, msnapshot);
+
+	// the multipliers cached in the persistent contact points, for warm starting
+	int mpos = msnapshot.Reserve();
+	if (collision_system)
+		collision_system->StateSave(msnapshot);
+	msnapshot.SetAt(mpos, msnapshot.GetSize() - mpos - 1);
+}
+
+void ChSystem::StateRestore (ChStateSnapshot& msnapshot)
+{
+	msnapshot.Rewind();
+
+	if ((int)msnapshot.Get() != CH_STATE_SNAPSHOT_VERSION)
+		throw ChException("Unsupported version of the state snapshot");
+	int mnbodies = (int)msnapshot.Get();
+	int mnlinks  = (int)msnapshot.Get();
+	int mnitems  = (int)msnapshot.Get();
+	if (mnbodies != (int)bodylist.size() ||
+		mnlinks  != (int)linklist.size() ||
+		mnitems  != (int)otherphysicslist.size())
+		throw ChException("The state snapshot does not match the system");
+
+	ChTime = msnapshot.Get();
+	step = msnapshot.Get();
+	stepcount = (int)msnapshot.Get();
+	nislands_sleeping = (int)msnapshot.Get();
+
+	HIER_BODY_INIT
+	while HIER_BODY_NOSTOP
+	{
+		ChStateRestoreItem(Bpointer, msnapshot);
+		HIER_BODY_NEXT
+	}
+	HIER_LINK_INIT
+	while HIER_LINK_NOSTOP
+	{
+		ChStateRestoreItem(Lpointer, msnapshot);
+		HIER_LINK_NEXT
+	}
+	HIER_OTHERPHYSICS_INIT
+	while HIER_OTHERPHYSICS_NOSTOP
+	{
+		ChStateRestoreItem(PHpointer, msnapshot);
+		HIER_OTHERPHYSICS_NEXT
+	}
+	ChStateRestoreItem(contact_container, msnapshot);
+
+	int nvalues = (int)msnapshot.Get();
+	int mstart = msnapshot.GetCursor();
+	if (collision_system)
+		collision_system->StateRestore(msnapshot);
+	if (msnapshot.GetCursor() - mstart != nvalues)
+		throw ChException("The state snapshot does not match the system");
+
+	if (msnapshot.GetCursor() != msnapshot.GetSize())
+		throw ChException("The state snapshot does not match the system");
+
+	this->ResetAwakeBodyArray();
+	this->ResetIncrementalInjection();
+}
+
 void ChSystem::ShowHierarchy(ChStreamOutAscii& m_file)
 {
 	m_file << "\n   List of the " << (int)Get_bodylist()->size() << " added rigid bodies: \n";
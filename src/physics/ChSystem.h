@@ -44,11 +44,14 @@
 #include "core/ChLog.h"
 #include "core/ChMath.h"
 #include "core/ChSpmatrix.h"
+#include "core/ChProfiler.h"
+#include "parallel/ChTaskPool.h"
 #include "physics/ChBody.h"
 #include "physics/ChMarker.h"
 #include "physics/ChForce.h"
 #include "physics/ChLinksAll.h"
 #include "physics/ChHistory.h"
+#include "physics/ChStateSnapshot.h"
 #include "physics/ChEvents.h"
 #include "physics/ChProbe.h"
 #include "physics/ChControls.h"
@@ -309,7 +312,9 @@ public:
 						 LCP_ITERATIVE_BARZILAIBORWEIN,
 						 LCP_ITERATIVE_PCG,
 						 LCP_ITERATIVE_APGD,
-						 LCP_DEM};
+						 LCP_DEM,
+						 LCP_ITERATIVE_SOR_COLORED,
+						 LCP_SPARSE_DIRECT};	// only bilateral constraints, ex. for FEM
 
 				/// Choose the LCP solver type, to be used for the simultaneous
 				/// solution of the constraints in dynamical simulations (as well as 
@@ -410,6 +415,42 @@ public:
 				/// Note that not all solvers use parallel computation.
 	int GetParallelThreadNumber() {return parallel_thread_number;}
 
+				/// Turn on this feature to process bodies and links (and the elements of FEM
+				/// meshes) in parallel, with a pool
+				/// of GetParallelThreadNumber() threads, in the passes of the time step that
+				/// loop on them: Update(), loading of the LCP known terms and jacobians, 
+				/// fetching of the reactions, integration of positions. The results are the 
+				/// same as in serial mode, but in these passes each body or link must modify
+				/// only its own data: for instance links must not share markers, and links 
+				/// that move bodies, as ChLinkNumdiff, cannot be used. Default: off.
+	void SetUseParallelPasses(bool mp) {use_parallel_passes = mp;}
+				/// Tell if bodies and links are processed in parallel in the time step.
+	bool GetUseParallelPasses() {return use_parallel_passes;}
+
+				/// Execute the loop on 'nitems' items, in parallel if SetUseParallelPasses()
+				/// is on, otherwise serially. Used internally, and by physics items that
+				/// contain many sub-items (ex. the elements of FEM meshes).
+				/// The items are scheduled in chunks of 'chunk_size' items; if 0, a size
+				/// that amortizes the scheduling of many cheap items is used.
+	void RunItemsLoop(int nitems, ChTaskPoolLoop& mloop, int chunk_size = 0);
+
+				/// Turn on this feature to split the LCP problem, at each step, in 'islands'
+				/// of variables and constraints that are not coupled (ex. separate piles of 
+				/// objects, or separate mechanisms), and solve each island independently, with
+				/// its own stopping criterion: small islands stop after few iterations, instead
+				/// of running as many iterations as the hardest island. If SetUseParallelPasses()
+				/// is on, the islands are solved in parallel. This works with the iterative 
+				/// solvers set by SetLcpSolverType(), except LCP_ITERATIVE_SOR_MULTITHREAD; with 
+				/// other solvers, or with FEM stiffness matrices, the LCP is solved as a whole.
+				/// The islands use all the settings of the solver (see CopySettings() of 
+				/// ChLcpIterativeSolver), and its violation history, if recorded, gets the 
+				/// largest values of the islands at each iteration.
+				/// Note: if the tolerance is 0 (as by default) all islands run the max.number of 
+				/// iterations, and the results of SOR-like solvers are the same as without islands.
+	void SetUseLcpIslands(bool mi) {use_lcp_islands = mi;}
+				/// Tell if the LCP problem is split in independent islands.
+	bool GetUseLcpIslands() {return use_lcp_islands;}
+
 
 				/// Returns true if the GPU is used for the LCP problem (ex. because
 				/// the LCP_ITERATIVE_GPU solver is used)
@@ -587,6 +628,7 @@ public:
 				/// custom contact container (suffice it is inherited from ChContactContainerBase) and plug
 				/// it into the system using this function. The replaced container is automatically deleted. 
 				/// When the system is deleted, the custom container that you plugged will be automatically deleted.
+				/// The container is bound to this system (see ChPhysicsItem::GetSystem()), as the default one.
 	void ChangeContactContainer(ChContactContainerBase* newcontainer);
 
 				/// Get the contact container
@@ -670,6 +712,15 @@ public:
 				/// Resets the timers.
 	void ResetTimers() {timer_step = timer_lcp = timer_collision_broad = timer_collision_narrow = timer_update = 0.;}
 
+				/// Sets a profiler, where the phases of each time step (collision detection,
+				/// update, preparation of the LCP, solver, integration, etc.) are recorded 
+				/// as nested scopes, with counters of contacts, constraints, solver iterations.
+				/// The profiler is also passed to the collision system. Use 0 to turn off 
+				/// profiling (default). The profiler is not deleted by the system.
+	void SetProfiler(ChProfiler* mprofiler);
+				/// Gets the profiler, if any.
+	ChProfiler* GetProfiler() {return profiler;}
+
 				/// Current warning/error (soon this function will be deprecated and obsolete)
 	char* GetErrMessage () {return err_message;}
 				/// Current warning/error code (soon this function will be deprecated and obsolete)
@@ -734,6 +785,11 @@ protected:
 				/// into the LCP descriptor. 
 	virtual void LCPprepare_inject(ChLcpSystemDescriptor& mdescriptor);
 
+				/// Solves the LCP problem of the LCP descriptor with the given solver (usually 
+				/// GetLcpSolverSpeed() or GetLcpSolverStab()), split in islands if SetUseLcpIslands()
+				/// is on and the solver supports it.
+	virtual void LCPsolve(ChLcpSolver* msolver);
+
 				/// The following constraints<->system functions are used before and after the solution of a LCP, because
 				/// iterative LCP solvers may converge faster to the Li lagrangian multiplier solutions if 'guessed' 
 				/// values provided (exploit the fact that ChLink classes implement caches with 'last computed multipliers').
@@ -858,11 +914,57 @@ public:
 				/// Tell if the system will put to sleep the bodies whose motion has almost come to a rest. 
 	bool GetUseSleeping() {return use_sleeping;}
 
+				/// Turn on this feature to inject the links and the bodies into the LCP 
+				/// system descriptor only when they change, instead of at each step: only 
+				/// the other physics items and the contacts are injected again. This speeds
+				/// up systems with many links and bodies, like machine assemblies with few 
+				/// contacts. A full injection
+				/// is done automatically when items are added or removed, bodies are fixed 
+				/// or put to sleep, links are disabled, broken or change their mask; for
+				/// other changes (ex. activating link limits) call ResetIncrementalInjection().
+				/// In this mode links inject also their inactive constraints, that the solvers
+				/// skip, so that single constraints can be turned on and off without a new
+				/// injection (ex. ChLinkMask::RestoreRedundant(), or the 2D mode of masks).
+	void SetUseIncrementalInjection(bool mi) {use_incremental_injection = mi; ResetIncrementalInjection();}
+
+				/// Tell if links and bodies are injected in the LCP descriptor only when they change.
+	bool GetUseIncrementalInjection() {return use_incremental_injection;}
+
+				/// Force a full injection of links and bodies into the LCP system descriptor
+				/// at the next step, when SetUseIncrementalInjection() is on.
+	void ResetIncrementalInjection() {if (LCP_descriptor) LCP_descriptor->InvalidateStaticMark();}
+
+				/// Rebuild the array of the bodies that are not sleeping before it is
+				/// used again. Called automatically when bodies fall asleep or wake up.
+	void ResetAwakeBodyArray() {awakebodyarray_valid = false;}
+
   private:
-	  			/// If some body has been tentatively and automatically put into sleeping mode,
-				/// but it is touching some objects that are still moving, this function
-				/// will wake up those sleeping bodies. Used internally.
-	void WakeUpSleepingBodies();
+				/// Partition the bodies in islands, i.e. groups of bodies connected by
+				/// links or contacts, with an union-find pass. An island is put to sleep 
+				/// only if all its bodies can sleep, otherwise all its bodies are woken up,
+				/// so that a sleeping body touched by a moving one wakes up with all the 
+				/// bodies resting on it. Links that require waking and other physics items
+				/// keep their islands awake, as fixed bodies moved by the user keep awake
+				/// the islands they touch. If some island is woken up, the narrow phase
+				/// is done again for the pairs of the woken bodies with each other and
+				/// with sleeping bodies, that were skipped, and the contacts are reported 
+				/// again. Used internally, if sleeping is enabled, after ComputeCollisions()
+				/// and before Setup().
+	void ComputeIslands();
+
+				/// Fill the contact and proximity containers with the contacts found 
+				/// by the last run of the collision system. Used by ComputeCollisions().
+	void ReportCollisions();
+
+				/// Get the links in an array, as the linklist cannot be indexed. 
+				/// The array is rebuilt only after links are added or removed.
+	std::vector<ChLink*>& GetLinkArray();
+
+				/// Get the bodies that are not sleeping (fixed bodies included) in an
+				/// array. Sleeping bodies are skipped by the update, the collision sync, 
+				/// the LCP descriptor and the integration. The array is rebuilt only 
+				/// after bodies are added or removed, or fall asleep or wake up.
+	std::vector<ChBody*>& GetAwakeBodyArray();
 
 
 
@@ -965,6 +1067,9 @@ public:
 				/// reactions). This is a one-step only approach that solves
 				/// the _linear_ equilibrium. To be used mostly for FEM 
 				/// problems with small deformations.
+				/// The system is solved by the 'speed' LCP solver: for large
+				/// FEM problems use LCP_SPARSE_DIRECT, that assembles and
+				/// factorizes it in compressed row storage (ChCSRMatrix).
 	int DoStaticLinear();
 
 				/// Finds the position of static equilibrium (and the
@@ -1001,6 +1106,24 @@ public:
 					/// also rebuilding hierarchy.
 	int StreamINall (ChStreamInBinary& m_file);
 
+					/// Save the state of the system in a flat snapshot: the time, and
+					/// the state of each body, link and other physics item (positions,
+					/// speeds, sleeping, reactions and cached multipliers for warm starting).
+					/// No objects are saved, so this is much faster than StreamOUTall():
+					/// it can be used for frequent checkpoints, or to roll back the
+					/// simulation. Previous contents of the snapshot are discarded.
+					/// The system is not modified. The contact points of the collision
+					/// system are not saved, only their multipliers for warm starting:
+					/// after a restore, the new points take the multipliers of the saved
+					/// points nearby. So a replay after StateRestore() is close to the
+					/// original run, but not identical to it.
+	void StateSave (ChStateSnapshot& msnapshot);
+
+					/// Restore a state saved by StateSave(). The system must have the
+					/// same items, in the same order (the same topology) as when saved.
+					/// Throws ChException if the snapshot does not match the system.
+	void StateRestore (ChStateSnapshot& msnapshot);
+
 					/// Writes the hierarchy of contained bodies, markers, etc. in ASCII
 					/// readable form, mostly for debugging purposes.
 	void ShowHierarchy(ChStreamOutAscii& m_file);
@@ -1081,6 +1204,7 @@ protected:
 	int msteps_collide; // maximum number of steps for bisection rule which rewinds the intgration at the collision event //***DISABLED
 	bool use_GPU;		// if true, the GPU parallel code is used for the LCP problem
 	bool use_sleeping;  // if true, can put to sleep objects that come to rest, to speed up simulation (but decreasing the precision)
+	bool use_incremental_injection; // if true, links and bodies are injected in the LCP descriptor only when they change
 
 	eCh_integrationType integration_type;// integration scheme
 
@@ -1096,7 +1220,25 @@ protected:
 	double min_bounce_speed; // maximum speed for rebounce after impacts. If lower speed at rebounce, it is clamped to zero.
 	double max_penetration_recovery_speed; // For Anitescu stepper, this value limits the speed of penetration recovery (>0, speed of exiting)
 
+	bool use_lcp_islands;	// if true, the LCP is split in independent islands, see SetUseLcpIslands()
+	std::vector<ChLcpSolver*> island_solvers; // one solver for each island of the LCP, created when needed
+	std::vector<int> island_order;	// islands of the LCP, sorted by decreasing n. of constraints
+
 	int parallel_thread_number; // used for multithreaded solver etc.
+	bool use_parallel_passes;	// if true, bodies and links are processed in parallel in the passes of the step
+	ChTaskPool* task_pool;		// threads for the parallel passes, created when needed
+
+	std::vector<ChLink*> linkarray; // same as linklist, but indexable (used by parallel passes)
+	bool linkarray_valid;
+
+	std::vector<ChBody*> awakebodyarray; // bodies of bodylist that are not sleeping
+	bool awakebodyarray_valid;
+
+	std::vector<int>  island_parent;	// union-find forest of bodies and other items, by island index
+	std::vector<char> island_awake;		// for each root of the forest, if the island must stay awake
+	std::vector<int>  island_number;	// for each root, index of its island of sleeping bodies
+	std::vector<collision::ChCollisionModel*> island_woken; // collision models of the bodies woken up
+	int nislands_sleeping;				// number of islands of sleeping bodies
 
 	int stepcount;		// internal counter for steps
 
@@ -1147,6 +1289,8 @@ protected:
 	double timer_collision_narrow;
 	double timer_update;
 
+	ChProfiler* profiler;	// hierarchical profiler, if any
+
 };
 
 
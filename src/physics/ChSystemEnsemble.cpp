@@ -0,0 +1,245 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   ChSystemEnsemble.cpp
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <math.h>
+#include <limits>
+
+#include "physics/ChSystemEnsemble.h"
+#include "physics/ChSystem.h"
+#include "motion_functions/ChFunction_Recorder.h"
+#include "parallel/ChTaskPool.h"
+#include "parallel/ChOpenMP.h"
+
+#include "core/ChMemory.h" // must be last include (memory leak debugger). In .cpp only.
+
+
+namespace chrono
+{
+
+
+ChEnsembleChannelBody::ChEnsembleChannelBody(const char* mbody_name, eChEnsembleBodyQuantity mquantity)
+	: body_name(mbody_name), quantity(mquantity)
+{
+	static const char* suffixes[] = {"_pos_x", "_pos_y", "_pos_z", "_speed_x", "_speed_y", "_speed_z"};
+	SetName((body_name + suffixes[quantity]).c_str());
+}
+
+void ChEnsembleChannelBody::SetupRun(ChSystem* msystem, int run)
+{
+	if ((int)bodies.size() <= run)
+		bodies.resize(run + 1, 0);
+	ChSharedPtr<ChBody> mbody = msystem->SearchBody((char*)body_name.c_str());
+	bodies[run] = mbody.get_ptr();	// still referenced by the system
+}
+
+double ChEnsembleChannelBody::GetValue(ChSystem* msystem, int run)
+{
+	ChBody* mbody = bodies[run];
+	if (!mbody)
+		return 0;
+	switch (quantity)
+	{
+	case ENSEMBLE_POS_X:	return mbody->GetPos().x;
+	case ENSEMBLE_POS_Y:	return mbody->GetPos().y;
+	case ENSEMBLE_POS_Z:	return mbody->GetPos().z;
+	case ENSEMBLE_SPEED_X:	return mbody->GetPos_dt().x;
+	case ENSEMBLE_SPEED_Y:	return mbody->GetPos_dt().y;
+	case ENSEMBLE_SPEED_Z:	return mbody->GetPos_dt().z;
+	}
+	return 0;
+}
+
+
+
+ChSystemEnsemble::ChSystemEnsemble()
+{
+	num_threads = CHOMPfunctions::GetNumProcs();
+	if (num_threads < 1)
+		num_threads = 1;
+	task_pool = 0;
+}
+
+ChSystemEnsemble::~ChSystemEnsemble()
+{
+	for (unsigned int i = 0; i < systems.size(); i++)
+		delete systems[i];
+	for (unsigned int i = 0; i < channels.size(); i++)
+		delete channels[i];
+	if (task_pool)
+		delete task_pool;
+}
+
+void ChSystemEnsemble::AddSystem(ChSystem* msystem)
+{
+	systems.push_back(msystem);
+}
+
+int ChSystemEnsemble::AddSystems(ChEnsembleBuilder& mbuilder, int nsystems)
+{
+	// serially: the constructors of the objects use global data (ex. unique IDs)
+	int first = (int)systems.size();
+	for (int i = 0; i < nsystems; i++)
+		AddSystem(mbuilder.CreateSystem(first + i));
+	return first;
+}
+
+void ChSystemEnsemble::AddChannel(ChEnsembleChannel* mchannel)
+{
+	channels.push_back(mchannel);
+}
+
+
+// Body of the parallel loop of Run(): each item is a whole run.
+
+class ChSystemEnsembleLoop : public ChTaskPoolLoop
+{
+public:
+	ChSystemEnsemble* ensemble;
+	virtual void Run(int begin, int end)
+	{
+		int nframes = ensemble->GetNframes();
+		int nchannels = ensemble->GetNchannels();
+		for (int run = begin; run < end; run++)
+		{
+			ChSystem* msystem = ensemble->systems[run];
+			int ok = TRUE;
+			for (int frame = 0; frame < nframes; frame++)
+			{
+				if (frame > 0 && ok)
+					ok = msystem->DoFrameDynamics(ensemble->frame_times[frame]);
+				for (int ch = 0; ch < nchannels; ch++)
+					ensemble->data[ensemble->Column(run, ch) + frame] = ok ?
+						ensemble->channels[ch]->GetValue(msystem, run) : std::numeric_limits<double>::quiet_NaN();
+			}
+			ensemble->run_ok[run] = ok;
+		}
+	}
+};
+
+
+int ChSystemEnsemble::Run(double end_time, double frame_step)
+{
+	int nsystems = GetNsystems();
+
+	frame_times.clear();
+	data.clear();
+	run_ok.assign(nsystems, FALSE);
+	if (nsystems == 0)
+		return 0;
+
+	// Times of the frames
+
+	double start_time = systems[0]->GetChTime();
+	int nsteps = 0;
+	if (frame_step > 0 && end_time > start_time)
+		nsteps = (int)ceil((end_time - start_time) / frame_step - 1e-9);
+	frame_times.resize(nsteps + 1);
+	for (int i = 0; i <= nsteps; i++)
+		frame_times[i] = ChMin(start_time + i * frame_step, end_time);
+	frame_times[0] = start_time;
+
+	data.resize(nsystems * channels.size() * frame_times.size());
+
+	for (int run = 0; run < nsystems; run++)
+		for (unsigned int ch = 0; ch < channels.size(); ch++)
+			channels[ch]->SetupRun(systems[run], run);
+
+	// Simulate the systems; if in parallel, each one with a single thread
+
+	ChSystemEnsembleLoop mloop;
+	mloop.ensemble = this;
+
+	int nthreads = ChMin(num_threads, nsystems);
+	if (nthreads < 2)
+	{
+		mloop.Run(0, nsystems);
+	}
+	else
+	{
+		std::vector<int> old_threads(nsystems);
+		for (int run = 0; run < nsystems; run++)
+		{
+			old_threads[run] = systems[run]->GetParallelThreadNumber();
+			if (old_threads[run] != 1)
+				systems[run]->SetParallelThreadNumber(1);
+		}
+
+		if (!task_pool || task_pool->GetNumThreads() != nthreads)
+		{
+			if (task_pool)
+				delete task_pool;
+			task_pool = new ChTaskPool(nthreads);
+		}
+		task_pool->ParallelFor(nsystems, mloop, 1);
+
+		for (int run = 0; run < nsystems; run++)
+			if (old_threads[run] != 1)
+				systems[run]->SetParallelThreadNumber(old_threads[run]);
+	}
+
+	int nok = 0;
+	for (int run = 0; run < nsystems; run++)
+		if (run_ok[run])
+			nok++;
+	return nok;
+}
+
+
+void ChSystemEnsemble::GetRecorder(int run, int channel, ChFunction_Recorder& mrecorder)
+{
+	const double* mvalues = GetColumn(run, channel);
+	int n = 0;
+	while (n < GetNframes() && mvalues[n] == mvalues[n])	// stop at NaN
+		n++;
+	if (n > 0)
+		mrecorder.SetPoints(n, &frame_times[0], mvalues);
+	else
+		mrecorder.Reset();
+}
+
+
+void ChSystemEnsemble::StreamOUTresults(ChStreamOutAscii& mstream)
+{
+	int nsystems = GetNsystems();
+	int nchannels = GetNchannels();
+
+	mstream << "time";
+	for (int run = 0; run < nsystems; run++)
+		for (int ch = 0; ch < nchannels; ch++)
+			mstream << ", run" << run << "_" << channels[ch]->GetName();
+	mstream << "\n";
+
+	for (int frame = 0; frame < GetNframes(); frame++)
+	{
+		mstream << frame_times[frame];
+		for (int run = 0; run < nsystems; run++)
+			for (int ch = 0; ch < nchannels; ch++)
+				mstream << ", " << GetValue(run, ch, frame);
+		mstream << "\n";
+	}
+}
+
+
+
+} // END_OF_NAMESPACE____
+
+
+/////////////////////
@@ -0,0 +1,225 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+#ifndef CHSYSTEMENSEMBLE_H
+#define CHSYSTEMENSEMBLE_H
+
+//////////////////////////////////////////////////
+//
+//   ChSystemEnsemble.h
+//
+//   Batch simulation of many independent systems,
+//   as the variants of a Monte Carlo sweep.
+//
+//   HEADER file for CHRONO,
+//	 Multibody dynamics engine
+//
+// ------------------------------------------------
+//             www.deltaknowledge.com
+// ------------------------------------------------
+///////////////////////////////////////////////////
+
+
+#include <vector>
+#include <string>
+#include "core/ChApiCE.h"
+#include "core/ChStream.h"
+
+
+namespace chrono
+{
+
+// Forward references
+class ChSystem;
+class ChBody;
+class ChTaskPool;
+class ChFunction_Recorder;
+
+
+/// Base class for the quantities that a ChSystemEnsemble records
+/// from each system at each frame (ex. the position of a body).
+/// Children classes implement GetValue().
+/// The same channel is used for all the systems, concurrently by
+/// multiple threads: data that depends on the system must be
+/// prepared in SetupRun(), that is called serially.
+
+class ChApi ChEnsembleChannel
+{
+public:
+	ChEnsembleChannel(const char* mname = "") : name(mname) {};
+	virtual ~ChEnsembleChannel() {};
+
+				/// Called before the simulation, for each system.
+	virtual void SetupRun(ChSystem* msystem, int run) {};
+
+				/// Return the value of the quantity for the system 'msystem',
+				/// that is the n-th system 'run' of the ensemble.
+	virtual double GetValue(ChSystem* msystem, int run) = 0;
+
+				/// Name of the channel, used in the header of the results.
+	const char* GetName() {return name.c_str();}
+	void SetName(const char* mname) {name = mname;}
+
+private:
+	std::string name;
+};
+
+
+enum eChEnsembleBodyQuantity{
+	ENSEMBLE_POS_X = 0,
+	ENSEMBLE_POS_Y,
+	ENSEMBLE_POS_Z,
+	ENSEMBLE_SPEED_X,
+	ENSEMBLE_SPEED_Y,
+	ENSEMBLE_SPEED_Z
+};
+
+/// Channel that records a coordinate of the position or of the speed
+/// of a body. The body is searched by name in each system, so the
+/// same channel can be used for all the systems of the ensemble.
+
+class ChApi ChEnsembleChannelBody : public ChEnsembleChannel
+{
+public:
+	ChEnsembleChannelBody(const char* mbody_name, eChEnsembleBodyQuantity mquantity);
+
+	virtual void SetupRun(ChSystem* msystem, int run);
+	virtual double GetValue(ChSystem* msystem, int run);
+
+private:
+	std::string body_name;
+	eChEnsembleBodyQuantity quantity;
+	std::vector<ChBody*> bodies;	// the body of each run, or null if not found
+};
+
+
+
+/// Interface for creating the systems of a ChSystemEnsemble, 
+/// see ChSystemEnsemble::AddSystems(). Children classes implement
+/// CreateSystem(), that usually builds the same model with the 
+/// parameters or initial conditions of the n-th run.
+
+class ChApi ChEnsembleBuilder
+{
+public:
+	virtual ~ChEnsembleBuilder() {};
+
+				/// Create the system of the n-th run.
+	virtual ChSystem* CreateSystem(int run) = 0;
+};
+
+
+
+/// Simulation of many independent systems, for example the variants
+/// of a model with different parameters or initial conditions, as in
+/// Monte Carlo analyses or parameter sweeps.
+/// The systems are simulated concurrently by a pool of threads, each
+/// system as a whole by one thread (each ChSystem has its own LCP
+/// descriptor, solver and collision system, so there is no shared data).
+/// Threads that finish their systems steal the systems left to other
+/// threads, so runs of different length are balanced.
+/// At each frame the values of the channels are recorded for each
+/// system, in a table with a column for each run and channel.
+/// The systems must not share objects, as bodies, markers or functions
+/// (also the evaluation of some ChFunction objects modifies them, as
+/// ChFunction_Recorder, that remembers the last used interval).
+
+class ChApi ChSystemEnsemble
+{
+public:
+	ChSystemEnsemble();
+
+				/// Deletes the systems and the channels.
+	virtual ~ChSystemEnsemble();
+
+				/// Add a system, that will be deleted by the ensemble.
+	void AddSystem(ChSystem* msystem);
+
+				/// Add 'nsystems' systems, created by mbuilder.CreateSystem(run),
+				/// where run is the index that each system will have in the 
+				/// ensemble. Returns the index of the first added system.
+	int AddSystems(ChEnsembleBuilder& mbuilder, int nsystems);
+
+				/// Number of systems, i.e. of runs.
+	int GetNsystems() {return (int)systems.size();}
+	ChSystem* GetSystem(int run) {return systems[run];}
+
+				/// Add a channel, that will be deleted by the ensemble.
+	void AddChannel(ChEnsembleChannel* mchannel);
+
+	int GetNchannels() {return (int)channels.size();}
+	ChEnsembleChannel* GetChannel(int channel) {return channels[channel];}
+
+				/// Number of threads that simulate the systems (default: the
+				/// number of cores). During Run(), if more than one, each system
+				/// is simulated with one thread, see ChSystem::SetParallelThreadNumber().
+	void SetNumThreads(int mthreads) {num_threads = mthreads < 1 ? 1 : mthreads;}
+	int GetNumThreads() {return num_threads;}
+
+				/// Simulate all the systems, from the time of the first system
+				/// up to 'end_time', with ChSystem::DoFrameDynamics(), recording
+				/// the channels every 'frame_step' (also at the beginning).
+				/// Previous results are discarded. Returns the number of runs
+				/// that have been completed without integration errors.
+	int Run(double end_time, double frame_step);
+
+			//
+			// RESULTS OF LAST Run()
+			//
+
+				/// Number of recorded frames.
+	int GetNframes() {return (int)frame_times.size();}
+
+				/// Time of a frame.
+	double GetFrameTime(int frame) {return frame_times[frame];}
+
+				/// Recorded value of a channel, for a run, at a frame. After an
+				/// integration error, the values of the run are NaN.
+	double GetValue(int run, int channel, int frame) {return data[Column(run, channel) + frame];}
+
+				/// The values of a channel for a run, at all frames, as a
+				/// contiguous array of GetNframes() values.
+	const double* GetColumn(int run, int channel) {return &data[Column(run, channel)];}
+
+				/// Tell if the run has been completed without integration errors.
+	bool GetRunOk(int run) {return run_ok[run] != 0;}
+
+				/// Load the values of a channel for a run, as a function of time,
+				/// in a ChFunction_Recorder. The frames after an error are skipped.
+	void GetRecorder(int run, int channel, ChFunction_Recorder& mrecorder);
+
+				/// Write the results as a table of comma-separated values, with a
+				/// row per frame: the time, then the channels of the first run,
+				/// the channels of the second run, etc. The first row has the names
+				/// of the columns, as "run3_name".
+	void StreamOUTresults(ChStreamOutAscii& mstream);
+
+private:
+	int Column(int run, int channel) {return (run * (int)channels.size() + channel) * (int)frame_times.size();}
+
+	std::vector<ChSystem*> systems;
+	std::vector<ChEnsembleChannel*> channels;
+	int num_threads;
+	ChTaskPool* task_pool;
+
+	std::vector<double> frame_times;
+	std::vector<double> data;		// columns of frames, for each run and channel
+	std::vector<int> run_ok;
+
+	friend class ChSystemEnsembleLoop;
+};
+
+
+
+} // END_OF_NAMESPACE____
+
+
+#endif  // END of ChSystemEnsemble.h
@@ -119,7 +119,7 @@ public:
 				/// Computes the internal forces (ex. the actual position of
 				/// nodes is not in relaxed reference position) and set values
 				/// in the Fi vector.
-	virtual void ComputeInternalForces	(ChMatrixDynamic<>& Fi)
+	virtual void ComputeInternalForces	(ChMatrix<>& Fi)
 				{
 					assert((Fi.GetRows() == 6) && (Fi.GetColumns()==1));
 
@@ -60,8 +60,9 @@ public:
 				/// Computes the internal forces (ex. the actual position of
 				/// nodes is not in relaxed reference position) and set values
 				/// in the Fi vector, whith n.rows = n.of dof of element.
+				/// Fi can be a fixed-size ChMatrixNM, to avoid heap allocations.
 				/// CHLDREN CLASSES MUST IMPLEMENT THIS!!!
-	virtual void ComputeInternalForces	(ChMatrixDynamic<>& Fi) = 0;
+	virtual void ComputeInternalForces	(ChMatrix<>& Fi) = 0;
 
 				/// Initial setup: This is used mostly to precompute matrices 
 				/// that do not change during the simulation, i.e. the local 
@@ -71,6 +72,10 @@ public:
 				/// Update: this is called at least at each time step. If the
 				/// element has to keep updated some auxiliary data, such as the rotation
 				/// matrices for corotational approach, this is the proper place.
+				/// Note: ChMesh may call SetupInitial(), Update(), KRMmatricesLoad() and
+				/// VariablesFb...() of different elements in parallel, so these must
+				/// modify only data of the element itself (VariablesFb...() can also
+				/// modify the nodes of the element).
 	virtual void Update() {};
 
 
@@ -88,6 +93,17 @@ public:
 				/// values Kfactor, Rfactor, Mfactor.  
 	virtual void KRMmatricesLoad(double Kfactor, double Rfactor, double Mfactor) =0;
 
+				/// Tell if the element can compute the product of its K, R, M matrices by
+				/// a vector on the fly, without storing them, see KRMmatricesMultiplyAndAdd().
+	virtual bool HasMatrixFreeKRM() {return false;}
+
+				/// Adds to 'result' the product of the current K, R, M matrices, scaled by 
+				/// Kfactor, Rfactor, Mfactor, by 'vect', as in KRMmatricesLoad() followed by 
+				/// a ChLcpKstiffness::MultiplyAndAdd(), but without storing the matrices. 
+				/// The vectors are indexed with the offsets of the variables of the nodes.
+				/// Used by ChMesh::SetMatrixFree(); only for elements with HasMatrixFreeKRM().
+	virtual void KRMmatricesMultiplyAndAdd(ChMatrix<>& result, const ChMatrix<>& vect, double Kfactor, double Rfactor, double Mfactor) {};
+
 				/// Adds the internal forces, expressed as nodal forces, into the
 				/// encapsulated ChLcpVariables, in the 'fb' part: qf+=forces*factor
 	virtual void VariablesFbLoadInternalForces(double factor=1.) {};
@@ -697,8 +697,8 @@ public:
 
 					// warp the local stiffness matrix K in order to obtain global 
 					// tangent stiffness CKCt:
-					ChMatrixDynamic<> CK(3*20, 3*20);
-					ChMatrixDynamic<> CKCt(3*20, 3*20); // the global, corotated, K matrix, for 20 nodes
+					ChMatrixNM<double,3*20,3*20> CK;
+					ChMatrixNM<double,3*20,3*20> CKCt; // the global, corotated, K matrix, for 20 nodes
 					ChMatrixCorotation::ComputeCK(StiffnessMatrix, this->A, 20, CK);
 					ChMatrixCorotation::ComputeKCt(CK, this->A, 20, CKCt);
 
@@ -729,26 +729,26 @@ public:
 				/// Computes the internal forces (ex. the actual position of
 				/// nodes is not in relaxed reference position) and set values
 				/// in the Fi vector.
-	virtual void ComputeInternalForces	(ChMatrixDynamic<>& Fi)
+	virtual void ComputeInternalForces	(ChMatrix<>& Fi)
 				{
 					assert((Fi.GetRows() == 3*20) && (Fi.GetColumns()==1));
 
 						// set up vector of nodal displacements (in local element system) u_l = R*p - p0
-					ChMatrixDynamic<> displ(3*20,1);
+					ChMatrixNM<double,3*20,1> displ;
 					for (int in=0; in < 20; ++in)
 					{
 						displ.PasteVector(A.MatrT_x_Vect(nodes[in]->pos) - nodes[in]->GetX0(), in*3, 0); // nodal displacements, local
 					}
 
 						// [local Internal Forces] = [Klocal] * displ + [Rlocal] * displ_dt
-					ChMatrixDynamic<> FiK_local(3*20,1);
+					ChMatrixNM<double,3*20,1> FiK_local;
 					FiK_local.MatrMultiply(StiffnessMatrix, displ);
 
 					for (int in=0; in < 20; ++in)
 					{
 						displ.PasteVector(A.MatrT_x_Vect(nodes[in]->pos_dt), in*3, 0); // nodal speeds, local
 					}
-					ChMatrixDynamic<> FiR_local(3*20,1);
+					ChMatrixNM<double,3*20,1> FiR_local;
 					FiR_local.MatrMultiply(StiffnessMatrix, displ);
 					FiR_local.MatrScale(this->Material->Get_RayleighDampingK());
 
@@ -360,8 +360,8 @@ public:
 
 					// warp the local stiffness matrix K in order to obtain global 
 					// tangent stiffness CKCt:
-					ChMatrixDynamic<> CK(30,30);
-					ChMatrixDynamic<> CKCt(30,30); // the global, corotated, K matrix
+					ChMatrixNM<double,30,30> CK;
+					ChMatrixNM<double,30,30> CKCt; // the global, corotated, K matrix
 					ChMatrixCorotation::ComputeCK(StiffnessMatrix, this->A, 10, CK);
 					ChMatrixCorotation::ComputeKCt(CK, this->A, 10, CKCt);
 					
@@ -390,12 +390,12 @@ public:
 				/// Computes the internal forces (ex. the actual position of
 				/// nodes is not in relaxed reference position) and set values
 				/// in the Fi vector.
-	virtual void ComputeInternalForces	(ChMatrixDynamic<>& Fi)
+	virtual void ComputeInternalForces	(ChMatrix<>& Fi)
 				{
 					assert((Fi.GetRows() == 30) && (Fi.GetColumns()==1));
 
 						// set up vector of nodal displacements (in local element system) u_l = R*p - p0
-					ChMatrixDynamic<> displ(30,1);
+					ChMatrixNM<double,30,1> displ;
 					displ.PasteVector(A.MatrT_x_Vect(nodes[0]->pos) - nodes[0]->GetX0(), 0, 0); // nodal displacements, local
 					displ.PasteVector(A.MatrT_x_Vect(nodes[1]->pos) - nodes[1]->GetX0(), 3, 0);
 					displ.PasteVector(A.MatrT_x_Vect(nodes[2]->pos) - nodes[2]->GetX0(), 6, 0);
@@ -408,7 +408,7 @@ public:
 					displ.PasteVector(A.MatrT_x_Vect(nodes[9]->pos) - nodes[9]->GetX0(),27, 0);
 
 						// [local Internal Forces] = [Klocal] * displ + [Rlocal] * displ_dt
-					ChMatrixDynamic<> FiK_local(30,1);
+					ChMatrixNM<double,30,1> FiK_local;
 					FiK_local.MatrMultiply(StiffnessMatrix, displ);
 
 					displ.PasteVector(A.MatrT_x_Vect(nodes[0]->pos_dt), 0, 0); // nodal speeds, local
@@ -421,7 +421,7 @@ public:
 					displ.PasteVector(A.MatrT_x_Vect(nodes[7]->pos_dt),21, 0);
 					displ.PasteVector(A.MatrT_x_Vect(nodes[8]->pos_dt),24, 0);
 					displ.PasteVector(A.MatrT_x_Vect(nodes[9]->pos_dt),27, 0);
-					ChMatrixDynamic<> FiR_local(30,1);
+					ChMatrixNM<double,30,1> FiR_local;
 					FiR_local.MatrMultiply(StiffnessMatrix, displ);
 					FiR_local.MatrScale(this->Material->Get_RayleighDampingK());
 
@@ -74,7 +74,7 @@ public:
 					B1.Sub(nodes[1]->pos,nodes[0]->pos);
 					C1.Sub(nodes[2]->pos,nodes[0]->pos);
 					D1.Sub(nodes[3]->pos,nodes[0]->pos);
-					ChMatrixDynamic<> M(3,3);
+					ChMatrix33<> M;
 					M.PasteVector(B1,0,0);
 					M.PasteVector(C1,0,1);
 					M.PasteVector(D1,0,2);
@@ -213,8 +213,6 @@ public:
 					double det = ChPolarDecomposition::Compute(F, this->A, S, 1E-6);
 					if (det <0)
 						this->A.MatrScale(-1.0);
-
-					GetLog() << "FEM rotation: \n" << A << "\n" ;
 				}
 
 
@@ -225,33 +223,16 @@ public:
 					assert((H.GetRows() == 12) && (H.GetColumns()==12));
 
 					// warp the local stiffness matrix K in order to obtain global 
-					// tangent stiffness CKCt:
-					ChMatrixDynamic<> CK(12,12);
-					ChMatrixDynamic<> CKCt(12,12); // the global, corotated, K matrix
+					// tangent stiffness CKCt, directly in H:
+					ChMatrixNM<double,12,12> CK;
 					ChMatrixCorotation::ComputeCK(StiffnessMatrix, this->A, 4, CK);
-					ChMatrixCorotation::ComputeKCt(CK, this->A, 4, CKCt);
-
-					// DEBUG
-					/*
-					ChMatrixDynamic<> Ctest(12,12);
-					Ctest.PasteMatrix(&A,0,0);
-					Ctest.PasteMatrix(&A,3,3);
-					Ctest.PasteMatrix(&A,6,6);
-					Ctest.PasteMatrix(&A,9,9);
-					ChMatrixDynamic<> CKtest(12,12);
-					CKtest.MatrMultiply(Ctest,StiffnessMatrix);
-					ChMatrixDynamic<> CKCttest(12,12);
-					CKCttest.MatrMultiplyT(CKtest,Ctest);
-					GetLog() << "CKCt difference \n" << CKCt-CKCttest << "\n";
-					*/
+					ChMatrixCorotation::ComputeKCt(CK, this->A, 4, H);
 
 					// For K stiffness matrix and R damping matrix:
 
 					double mkfactor = Kfactor + Rfactor * this->GetMaterial()->Get_RayleighDampingK();
 
-					CKCt.MatrScale( mkfactor );
-
-					H.PasteMatrix(&CKCt,0,0);
+					H.MatrScale( mkfactor );
 
 
 					// For M mass matrix:
@@ -271,26 +252,26 @@ public:
 				/// Computes the internal forces (ex. the actual position of
 				/// nodes is not in relaxed reference position) and set values
 				/// in the Fi vector.
-	virtual void ComputeInternalForces	(ChMatrixDynamic<>& Fi)
+	virtual void ComputeInternalForces	(ChMatrix<>& Fi)
 				{
 					assert((Fi.GetRows() == 12) && (Fi.GetColumns()==1));
 
 						// set up vector of nodal displacements (in local element system) u_l = R*p - p0
-					ChMatrixDynamic<> displ(12,1);
+					ChMatrixNM<double,12,1> displ;
 					displ.PasteVector(A.MatrT_x_Vect(nodes[0]->pos) - nodes[0]->GetX0(), 0, 0); // nodal displacements, local
 					displ.PasteVector(A.MatrT_x_Vect(nodes[1]->pos) - nodes[1]->GetX0(), 3, 0);
 					displ.PasteVector(A.MatrT_x_Vect(nodes[2]->pos) - nodes[2]->GetX0(), 6, 0);
 					displ.PasteVector(A.MatrT_x_Vect(nodes[3]->pos) - nodes[3]->GetX0(), 9, 0);
 
 						// [local Internal Forces] = [Klocal] * displ + [Rlocal] * displ_dt
-					ChMatrixDynamic<> FiK_local(12,1);
+					ChMatrixNM<double,12,1> FiK_local;
 					FiK_local.MatrMultiply(StiffnessMatrix, displ);
 
 					displ.PasteVector(A.MatrT_x_Vect(nodes[0]->pos_dt), 0, 0); // nodal speeds, local
 					displ.PasteVector(A.MatrT_x_Vect(nodes[1]->pos_dt), 3, 0);
 					displ.PasteVector(A.MatrT_x_Vect(nodes[2]->pos_dt), 6, 0);
 					displ.PasteVector(A.MatrT_x_Vect(nodes[3]->pos_dt), 9, 0);
-					ChMatrixDynamic<> FiR_local(12,1);
+					ChMatrixNM<double,12,1> FiR_local;
 					FiR_local.MatrMultiply(StiffnessMatrix, displ);
 					FiR_local.MatrScale(this->Material->Get_RayleighDampingK());
 
@@ -308,6 +289,68 @@ public:
 
 				}
 
+				/// The K*v product can be computed on the fly, see KRMmatricesMultiplyAndAdd().
+	virtual bool HasMatrixFreeKRM() {return true;}
+
+				/// Adds to 'result' the product of the K, R, M matrices by 'vect', without
+				/// building the 12x12 matrix: since K = C*(Volume*B'*E*B)*C', the product 
+				/// is computed through strains and stresses, using only the rotation A, 
+				/// the 12 shape function derivatives (in mM) and the elasticity matrix E.
+	virtual void KRMmatricesMultiplyAndAdd(ChMatrix<>& result, const ChMatrix<>& vect, double Kfactor, double Rfactor, double Mfactor)
+				{
+					double mkfactor = (Kfactor + Rfactor * this->Material->Get_RayleighDampingK()) * this->Volume;
+					double amfactor = 0;
+					if (Mfactor)
+						amfactor = (Mfactor + Rfactor * this->Material->Get_RayleighDampingM()) * (this->Volume * this->Material->Get_density() ) / 4.0;
+					ChMatrix<>& E = this->Material->Get_StressStrainMatrix();
+
+					int off[4];
+					ChVector<> vi[4];
+					
+						// strains e = B*u, where u_i = A'*v_i are local nodal displacements
+					double e[6] = {0,0,0,0,0,0};
+					for (int in=0; in < 4; in++)
+					{
+						off[in] = nodes[in]->Variables().GetOffset();
+						vi[in].Set(vect(off[in]), vect(off[in]+1), vect(off[in]+2));
+						ChVector<> u = A.MatrT_x_Vect(vi[in]);
+						double dx = mM(in,0);
+						double dy = mM(in,1);
+						double dz = mM(in,2);
+						e[0] += dx * u.x;
+						e[1] += dy * u.y;
+						e[2] += dz * u.z;
+						e[3] += dy * u.x + dx * u.y;
+						e[4] += dz * u.y + dy * u.z;
+						e[5] += dz * u.x + dx * u.z;
+					}
+
+						// stresses s = E*e, scaled
+					double st[6];
+					for (int r=0; r < 6; r++)
+					{
+						double sum = 0;
+						for (int c=0; c < 6; c++)
+							sum += E(r,c) * e[c];
+						st[r] = sum * mkfactor;
+					}
+
+						// nodal forces f_i = A*B_i'*s, plus lumped mass
+					for (int in=0; in < 4; in++)
+					{
+						double dx = mM(in,0);
+						double dy = mM(in,1);
+						double dz = mM(in,2);
+						ChVector<> fl(dx * st[0] + dy * st[3] + dz * st[5],
+									  dy * st[1] + dx * st[3] + dz * st[4],
+									  dz * st[2] + dy * st[4] + dx * st[5]);
+						ChVector<> f = A.Matr_x_Vect(fl);
+						result(off[in])   += f.x + amfactor * vi[in].x;
+						result(off[in]+1) += f.y + amfactor * vi[in].y;
+						result(off[in]+2) += f.z + amfactor * vi[in].z;
+					}
+				}
+
 			//
 			// Custom properties functions
 			//
@@ -323,7 +366,38 @@ public:
 
 			//
 			// Functions for interfacing to the LCP solver 
-			//            (***not needed, thank to bookkeeping in parent class ChElementGeneric)
+			//            (faster versions of the bookkeeping in parent class ChElementGeneric,
+			//             without temporary matrices in the heap)
+
+				/// Adds the internal forces, expressed as nodal forces, into the
+				/// encapsulated ChLcpVariables, in the 'fb' part: qf+=forces*factor
+	virtual void VariablesFbLoadInternalForces(double factor=1.) 
+				{
+					ChMatrixNM<double,12,1> mFi;
+					this->ComputeInternalForces(mFi);
+					for (int in=0; in < 4; in++)
+					{
+						ChMatrix<>& mfb = nodes[in]->Variables().Get_fb();
+						mfb(0) += factor * mFi(in*3);
+						mfb(1) += factor * mFi(in*3+1);
+						mfb(2) += factor * mFi(in*3+2);
+					}
+				}
+
+				/// Adds M*q (internal masses multiplied current 'qb') to Fb. 
+				/// The mass is lumped, so M is diagonal.
+	virtual void VariablesFbIncrementMq() 
+				{
+					double lumped_node_mass = (this->GetVolume() * this->Material->Get_density() ) / 4.0;
+					for (int in=0; in < 4; in++)
+					{
+						ChMatrix<>& mfb = nodes[in]->Variables().Get_fb();
+						ChMatrix<>& mqb = nodes[in]->Variables().Get_qb();
+						mfb(0) += lumped_node_mass * mqb(0);
+						mfb(1) += lumped_node_mass * mqb(1);
+						mfb(2) += lumped_node_mass * mqb(2);
+					}
+				}
 
 
 
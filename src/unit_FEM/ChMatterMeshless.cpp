@@ -134,6 +134,33 @@ void ChNodeMeshless::SetCollisionRadius(double mr)
 	((ChModelBulletNode*)this->collision_model)->SetSphereRadius(coll_rad, ChMax(0.0, aabb_rad-coll_rad) );
 }
 
+void ChNodeMeshless::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChNodeXYZ::StateSave(msnapshot);
+
+	msnapshot.Add(this->pos_ref);
+	msnapshot.Add(this->p_strain);
+	msnapshot.Add(this->hardening);
+	msnapshot.Add(this->h_rad);
+	msnapshot.Add(this->coll_rad);
+}
+
+void ChNodeMeshless::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChNodeXYZ::StateRestore(msnapshot);
+
+	msnapshot.Get(this->pos_ref);
+	msnapshot.Get(this->p_strain);
+	this->hardening = msnapshot.Get();
+	double mh_rad = msnapshot.Get();
+	double mcoll_rad = msnapshot.Get();
+	if (mh_rad != this->h_rad || mcoll_rad != this->coll_rad)
+	{
+		this->h_rad = mh_rad;
+		this->SetCollisionRadius(mcoll_rad);
+	}
+}
+
 
 
 
@@ -156,6 +183,11 @@ ChMatterMeshless::ChMatterMeshless ()
 	this->viscosity = 0.0;
 
 	this->nodes.clear();
+	this->node_block = 0;
+	this->node_block_size = 0;
+
+	this->sort_interval = 0;
+	this->sort_counter = 0;
 
 	SetIdentifier(CHGLOBALS().GetUniqueIntID()); // mark with unique ID
 
@@ -176,6 +208,7 @@ void ChMatterMeshless::Copy(ChMatterMeshless* source)
 	ChIndexedNodes::Copy(source);
 
 	do_collide = source->do_collide;
+	sort_interval = source->sort_interval;
 	
 	ResizeNnodes(source->GetNnodes());
 }
@@ -191,17 +224,21 @@ void ChMatterMeshless::ResizeNnodes(int newsize)
 	bool oldcoll = this->GetCollide();
 	this->SetCollide(false); // this will remove old particle coll.models from coll.engine, if previously added
 
-	for (unsigned int j = 0; j < nodes.size(); j++)
+	for (unsigned int j = node_block_size; j < nodes.size(); j++)
 	{
 		delete (this->nodes[j]);
 		this->nodes[j] = 0;
 	}
+	delete [] node_block;
 
+		// the new nodes are allocated in a single block
 	this->nodes.resize(newsize);
+	this->node_block_size = newsize;
+	this->node_block = newsize ? new ChNodeMeshless[newsize] : 0;
 
 	for (unsigned int j = 0; j < nodes.size(); j++)
 	{
-		this->nodes[j] = new ChNodeMeshless;
+		this->nodes[j] = &node_block[j];
 
 		this->nodes[j]->variables.SetUserData((void*)this); // UserData unuseful in future cuda solver?
 		((ChModelBulletNode*)this->nodes[j]->collision_model)->SetNode(this,j);
@@ -232,6 +269,95 @@ void ChMatterMeshless::AddNode(ChVector<double> initial_state)
 
 
 
+// Exchange the data of two nodes, with their collision models (so the
+// models that are in the collision engine follow the data of their nodes).
+static void SwapNodeData(ChNodeMeshless& ma, ChNodeMeshless& mb)
+{
+	std::swap(ma.pos,      mb.pos);
+	std::swap(ma.pos_dt,   mb.pos_dt);
+	std::swap(ma.pos_dtdt, mb.pos_dtdt);
+	std::swap(ma.pos_ref,  mb.pos_ref);
+
+	std::swap(ma.Amoment,  mb.Amoment);
+	std::swap(ma.J,        mb.J);
+	std::swap(ma.FA,       mb.FA);
+	std::swap(ma.t_strain, mb.t_strain);
+	std::swap(ma.p_strain, mb.p_strain);
+	std::swap(ma.e_strain, mb.e_strain);
+	std::swap(ma.e_stress, mb.e_stress);
+
+	double mass = ma.GetMass();
+	ma.SetMass(mb.GetMass());
+	mb.SetMass(mass);
+	bool disabled = ma.variables.IsDisabled();
+	ma.variables.SetDisabled(mb.variables.IsDisabled());
+	mb.variables.SetDisabled(disabled);
+	for (int i = 0; i < 3; i++)
+	{
+		std::swap(ma.variables.Get_qb()(i), mb.variables.Get_qb()(i));
+		std::swap(ma.variables.Get_fb()(i), mb.variables.Get_fb()(i));
+	}
+
+	std::swap(ma.collision_model, mb.collision_model);
+	std::swap(ma.UserForce, mb.UserForce);
+	std::swap(ma.volume,    mb.volume);
+	std::swap(ma.density,   mb.density);
+	std::swap(ma.h_rad,     mb.h_rad);
+	std::swap(ma.coll_rad,  mb.coll_rad);
+	std::swap(ma.hardening, mb.hardening);
+}
+
+
+void ChMatterMeshless::SortNodes()
+{
+	unsigned int nnodes = nodes.size();
+
+	// Move the nodes that were added one by one in a new block
+
+	if (nnodes != node_block_size)
+	{
+		ChNodeMeshless* new_block = new ChNodeMeshless[nnodes];
+		for (unsigned int j = 0; j < nnodes; j++)
+		{
+			new_block[j].variables.SetUserData((void*)this);
+			SwapNodeData(new_block[j], *nodes[j]);
+			if (j >= node_block_size)
+				delete (this->nodes[j]);
+			this->nodes[j] = &new_block[j];
+		}
+		delete [] node_block;
+		node_block = new_block;
+		node_block_size = nnodes;
+	}
+
+	// Permute the data of the nodes in place, following the cycles of 
+	// the permutation, so that the j-th node gets the data of order[j].
+
+	std::vector<int> order;
+	this->ComputeMortonOrder(order);
+
+	std::vector<char> done(nnodes, 0);
+	for (unsigned int start = 0; start < nnodes; start++)
+	{
+		if (done[start])
+			continue;
+		int j = start;
+		done[j] = 1;
+		while (order[j] != (int)start)
+		{
+			SwapNodeData(*nodes[j], *nodes[order[j]]);
+			j = order[j];
+			done[j] = 1;
+		}
+	}
+
+	for (unsigned int j = 0; j < nnodes; j++)
+	{
+		((ChModelBulletNode*)this->nodes[j]->collision_model)->SetNode(this,j);
+	}
+}
+
+
 void ChMatterMeshless::FillBox (const ChVector<> size,	
 				  const double spacing,		
 				  const double initial_density, 
@@ -595,6 +721,13 @@ void ChMatterMeshless::SetCollide (bool mcoll)
 
 void ChMatterMeshless::SyncCollisionModels()
 {
+	// Sort the nodes now, if needed, before the contacts refer to them
+	if (sort_interval > 0 && ++sort_counter >= sort_interval)
+	{
+		sort_counter = 0;
+		this->SortNodes();
+	}
+
 	for (unsigned int j = 0; j < nodes.size(); j++)
 	{
 		this->nodes[j]->collision_model->SyncPosition();
@@ -636,6 +769,27 @@ void ChMatterMeshless::UpdateParticleCollisionModels()
 
 
 
+void ChMatterMeshless::StateSave(ChStateSnapshot& msnapshot)
+{
+	ChIndexedNodes::StateSave(msnapshot);
+
+	msnapshot.Add(this->sort_counter);
+}
+
+void ChMatterMeshless::StateRestore(ChStateSnapshot& msnapshot)
+{
+	ChIndexedNodes::StateRestore(msnapshot);
+
+	this->sort_counter = (int)msnapshot.Get();
+
+	for (unsigned int j = 0; j < nodes.size(); j++)
+	{
+		this->nodes[j]->collision_model->SyncPosition();
+	}
+}
+
+
+
 //////// FILE I/O
 
 void ChMatterMeshless::StreamOUT(ChStreamOutBinary& mstream)
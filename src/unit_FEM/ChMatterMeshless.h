@@ -92,6 +92,11 @@ public:
 			// Access the 'LCP variables' of the node
 	ChLcpVariables& Variables() {return variables;}
 
+			// Save/restore the state of the node, including the reference
+			// position and the plastic strain
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
 					//
 					// DATA
 					// 
@@ -138,6 +143,14 @@ private:
 						// The nodes: 
 	std::vector<ChNodeMeshless*> nodes;				
 
+						// Contiguous storage of the first node_block_size nodes 
+						// (nodes added later with AddNode() are allocated one by one)
+	ChNodeMeshless* node_block;
+	unsigned int node_block_size;
+
+	int sort_interval;
+	int sort_counter;
+
 	//ChContinuumPlasticVonMises material;
 	ChSharedPtr<ChContinuumElastoplastic> material; //* ChContinuumDruckerPrager material; //***TEST***
 
@@ -193,6 +206,19 @@ public:
 				/// vector as initial position.
 	void AddNode(ChVector<double> initial_state);
 
+				/// Sort the nodes along a Morton curve through their positions,
+				/// and store them in a single contiguous block of memory, so that
+				/// the loops on nodes access memory almost sequentially. The data
+				/// of the nodes is moved, so after this the index of a node, and 
+				/// the node returned by GetNode() for an index, are different.
+	void SortNodes();
+
+				/// Sort the nodes with SortNodes() every 'nsteps' time steps, to
+				/// keep their order as they move. The sorting is done just before
+				/// the collision detection. Default 0: never.
+	void SetNodeSortingInterval(int nsteps) {sort_interval = nsteps; sort_counter = 0;}
+	int  GetNodeSortingInterval() {return sort_interval;}
+
 
 
 		//
@@ -272,6 +298,16 @@ public:
 	void UpdateExternalGeometry ();
 
 
+			//
+			// STATE
+			//
+
+				/// Save/restore the state of all the nodes, for ChSystem::StateSave()
+				/// and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot);
+	virtual void StateRestore(ChStateSnapshot& msnapshot);
+
+
 			//
 			// STREAMING
 			//
@@ -13,7 +13,9 @@
 
 #include "core/ChMath.h"
 #include "physics/ChObject.h"
+#include "physics/ChSystem.h"
 #include "ChMesh.h"
+#include <map>
 
 namespace chrono 
 {
@@ -22,6 +24,103 @@ namespace fem
 
 
 
+// Bodies of the loops on elements, executed by RunElementsLoop().
+// Each one modifies only the data of its own elements, or (for the
+// loops on the elements of one color) the data of nodes that are not
+// shared with other elements of the loop.
+
+class ChMeshSetupElements : public ChTaskPoolLoop
+{
+public:
+	ChElementBase** elements;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			elements[i]->SetupInitial();
+	}
+};
+
+class ChMeshUpdateElements : public ChTaskPoolLoop
+{
+public:
+	ChElementBase** elements;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			elements[i]->Update();
+	}
+};
+
+class ChMeshLoadKRMmatrices : public ChTaskPoolLoop
+{
+public:
+	ChElementBase** elements;
+	double Kfactor, Rfactor, Mfactor;
+	bool skip_matrix_free;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			if (!(skip_matrix_free && elements[i]->HasMatrixFreeKRM()))
+				elements[i]->KRMmatricesLoad(Kfactor, Rfactor, Mfactor);
+	}
+};
+
+class ChMeshLoadInternalForces : public ChTaskPoolLoop
+{
+public:
+	ChElementBase** elements;
+	int* indexes;		// elements of one color
+	double factor;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			elements[indexes[i]]->VariablesFbLoadInternalForces(factor);
+	}
+};
+
+class ChMeshKRMmultiply : public ChTaskPoolLoop
+{
+public:
+	ChElementBase** elements;
+	int* indexes;		// elements of one color
+	ChMatrix<>* result;
+	const ChMatrix<>* vect;
+	double Kfactor, Rfactor, Mfactor;
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			ChElementBase* melement = elements[indexes[i]];
+			if (melement->HasMatrixFreeKRM())
+				melement->KRMmatricesMultiplyAndAdd(*result, *vect, Kfactor, Rfactor, Mfactor);
+		}
+	}
+};
+
+class ChMeshIncrementMq : public ChTaskPoolLoop
+{
+public:
+	ChElementBase** elements;
+	int* indexes;		// elements of one color
+	virtual void Run(int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+			elements[indexes[i]]->VariablesFbIncrementMq();
+	}
+};
+
+
+void ChMesh::RunElementsLoop(int nitems, ChTaskPoolLoop& mloop)
+{
+	if (nitems <= 0)
+		return;
+	if (this->GetSystem())
+		this->GetSystem()->RunItemsLoop(nitems, mloop);
+	else
+		mloop.Run(0, nitems);
+}
+
+
 void ChMesh::SetupInitial()
 {
 	n_dofs = 0;
@@ -32,12 +131,61 @@ void ChMesh::SetupInitial()
 		n_dofs += vnodes[i]->Get_ndof();
 	}
 
-	for (unsigned int i=0; i< velements.size(); i++)
+	if (velements.empty())
+		return;
+
+		//    - precompute matrices, such as the [Kl] local stiffness of each element, if needed, etc.
+	ChMeshSetupElements mloop;
+	mloop.elements = &velements[0];
+	RunElementsLoop((int)velements.size(), mloop);
+
+	ComputeElementColoring();
+}
+
+
+void ChMesh::ComputeElementColoring()
+{
+	element_colors.clear();
+
+	std::map<ChNodeFEMbase*, int> node_slot;	// compact index of each node
+	std::vector< std::vector<int> > node_colors;	// colors already used around each node
+	std::vector<int> color_stamp;	// color_stamp[c]==ie means that color c is forbidden for element ie
+
+	for (int ie = 0; ie < (int)velements.size(); ie++)
 	{
-			//    - precompute matrices, such as the [Kl] local stiffness of each element, if needed, etc.
-		velements[i]->SetupInitial();
+		int nnodes = velements[ie]->GetNnodes();
+
+		for (int in = 0; in < nnodes; in++)
+		{
+			ChNodeFEMbase* mnode = velements[ie]->GetNodeN(in);
+			std::map<ChNodeFEMbase*, int>::iterator it = node_slot.find(mnode);
+			if (it == node_slot.end())
+			{
+				node_slot[mnode] = (int)node_colors.size();
+				node_colors.push_back(std::vector<int>());
+				continue;
+			}
+			std::vector<int>& mcolors = node_colors[it->second];
+			for (unsigned int j = 0; j < mcolors.size(); j++)
+				color_stamp[mcolors[j]] = ie;
+		}
+
+		// first color not used by elements sharing nodes with this one
+		int icolor = 0;
+		while (icolor < (int)color_stamp.size() && color_stamp[icolor] == ie)
+			icolor++;
+		if (icolor == (int)color_stamp.size())
+		{
+			color_stamp.push_back(-1);
+			element_colors.push_back(std::vector<int>());
+		}
+
+		element_colors[icolor].push_back(ie);
+		for (int in = 0; in < nnodes; in++)
+			node_colors[node_slot[velements[ie]->GetNodeN(in)]].push_back(icolor);
 	}
 
+	coloring_valid = true;
 }
 
 
@@ -59,17 +207,20 @@ void ChMesh::AddNode (ChNodeFEMbase& m_node)
 void ChMesh::AddElement (ChElementBase& m_elem)
 {
 	this->velements.push_back(&m_elem);
+	coloring_valid = false;
 }
 
 void ChMesh::ClearElements ()
 {
 	velements.clear();
+	coloring_valid = false;
 }
 
 void ChMesh::ClearNodes ()
 {
 	velements.clear();
 	vnodes.clear();
+	coloring_valid = false;
 }
 
 
@@ -84,25 +235,47 @@ void ChMesh::Update (double m_time)
 	// Parent class update
 	ChIndexedNodes::Update(m_time);
 	
-	for (unsigned int i=0; i< velements.size(); i++)
-	{
-			//    - update auxiliary stuff, ex. update element's rotation matrices if corotational..
-		velements[i]->Update();
-	}
+	if (velements.empty())
+		return;
+
+		//    - update auxiliary stuff, ex. update element's rotation matrices if corotational..
+	ChMeshUpdateElements mloop;
+	mloop.elements = &velements[0];
+	RunElementsLoop((int)velements.size(), mloop);
 
 }
 
 
 void ChMesh::InjectKRMmatrices(ChLcpSystemDescriptor& mdescriptor) 
 {
+	bool has_matrix_free = false;
 	for (unsigned int ie = 0; ie < this->velements.size(); ie++)
-		this->velements[ie]->InjectKRMmatrices(mdescriptor);
+	{
+		if (matrix_free && this->velements[ie]->HasMatrixFreeKRM())
+			has_matrix_free = true;
+		else
+			this->velements[ie]->InjectKRMmatrices(mdescriptor);
+	}
+
+	// a single proxy for all the elements in matrix-free mode
+	if (has_matrix_free)
+		mdescriptor.InsertKstiffness(&matrixfree_K);
 }
 
 void ChMesh::KRMmatricesLoad(double Kfactor, double Rfactor, double Mfactor)
 {
-	for (unsigned int ie = 0; ie < this->velements.size(); ie++)
-		this->velements[ie]->KRMmatricesLoad(Kfactor, Rfactor, Mfactor);
+	if (velements.empty())
+		return;
+
+	ChMeshLoadKRMmatrices mloop;
+	mloop.elements = &velements[0];
+	mloop.Kfactor = Kfactor;
+	mloop.Rfactor = Rfactor;
+	mloop.Mfactor = Mfactor;
+	mloop.skip_matrix_free = matrix_free;
+	RunElementsLoop((int)velements.size(), mloop);
+
+	matrixfree_K.SetFactors(Kfactor, Rfactor, Mfactor);
 }
 
 void ChMesh::VariablesFbReset()
@@ -117,9 +290,20 @@ void ChMesh::VariablesFbLoadForces(double factor)
 	for (unsigned int in = 0; in < this->vnodes.size(); in++)
 		this->vnodes[in]->VariablesFbLoadForces(factor);
 
-	// internal forces
-	for (unsigned int ie = 0; ie < this->velements.size(); ie++)
-		this->velements[ie]->VariablesFbLoadInternalForces(factor);
+	// internal forces, color by color (the elements of one color do not share nodes)
+	if (velements.empty())
+		return;
+	if (!coloring_valid)
+		ComputeElementColoring();
+
+	ChMeshLoadInternalForces mloop;
+	mloop.elements = &velements[0];
+	mloop.factor = factor;
+	for (unsigned int ic = 0; ic < element_colors.size(); ic++)
+	{
+		mloop.indexes = &element_colors[ic][0];
+		RunElementsLoop((int)element_colors[ic].size(), mloop);
+	}
 }
 
 void ChMesh::VariablesQbLoadSpeed() 
@@ -134,9 +318,19 @@ void ChMesh::VariablesFbIncrementMq()
 	for (unsigned int ie = 0; ie < this->vnodes.size(); ie++)
 		this->vnodes[ie]->VariablesFbIncrementMq();
 
-	// internal masses
-	for (unsigned int ie = 0; ie < this->velements.size(); ie++)
-		this->velements[ie]->VariablesFbIncrementMq();
+	// internal masses, color by color (the elements of one color do not share nodes)
+	if (velements.empty())
+		return;
+	if (!coloring_valid)
+		ComputeElementColoring();
+
+	ChMeshIncrementMq mloop;
+	mloop.elements = &velements[0];
+	for (unsigned int ic = 0; ic < element_colors.size(); ic++)
+	{
+		mloop.indexes = &element_colors[ic][0];
+		RunElementsLoop((int)element_colors[ic].size(), mloop);
+	}
 }
 
 void ChMesh::VariablesQbSetSpeed(double step) 
@@ -160,6 +354,90 @@ void ChMesh::InjectVariables(ChLcpSystemDescriptor& mdescriptor)
 
 
 
+unsigned int ChLcpKstiffnessMesh::GetNvars() const
+{
+	return mesh->GetNnodes();
+}
+
+void ChLcpKstiffnessMesh::MultiplyAndAdd(ChMatrix<double>& result, const ChMatrix<double>& vect)
+{
+	if (mesh->velements.empty())
+		return;
+	if (!mesh->coloring_valid)
+		mesh->ComputeElementColoring();
+
+	// color by color, because elements that share nodes add to the same rows of result
+	ChMeshKRMmultiply mloop;
+	mloop.elements = &mesh->velements[0];
+	mloop.result = &result;
+	mloop.vect = &vect;
+	mloop.Kfactor = Kfactor;
+	mloop.Rfactor = Rfactor;
+	mloop.Mfactor = Mfactor;
+	for (unsigned int ic = 0; ic < mesh->element_colors.size(); ic++)
+	{
+		mloop.indexes = &mesh->element_colors[ic][0];
+		mesh->RunElementsLoop((int)mesh->element_colors[ic].size(), mloop);
+	}
+}
+
+void ChLcpKstiffnessMesh::DiagonalAdd(ChMatrix<double>& result)
+{
+	for (unsigned int ie = 0; ie < mesh->velements.size(); ie++)
+	{
+		ChElementBase* melement = mesh->velements[ie];
+		if (!melement->HasMatrixFreeKRM())
+			continue;
+
+		int ncoords = melement->GetNcoords();
+		H.Reset(ncoords, ncoords);
+		melement->ComputeKRMmatricesGlobal(H, Kfactor, Rfactor, Mfactor);
+
+		int kio = 0;
+		for (int in = 0; in < melement->GetNnodes(); in++)
+		{
+			int io = melement->GetNodeN(in)->Variables().GetOffset();
+			int ndof = melement->GetNodeN(in)->Get_ndof();
+			for (int r = 0; r < ndof; r++)
+				result(io+r) += H(kio+r, kio+r);
+			kio += ndof;
+		}
+	}
+}
+
+void ChLcpKstiffnessMesh::Build_K(ChSparseMatrixBase& storage, bool add)
+{
+	for (unsigned int ie = 0; ie < mesh->velements.size(); ie++)
+	{
+		ChElementBase* melement = mesh->velements[ie];
+		if (!melement->HasMatrixFreeKRM())
+			continue;
+
+		int ncoords = melement->GetNcoords();
+		H.Reset(ncoords, ncoords);
+		melement->ComputeKRMmatricesGlobal(H, Kfactor, Rfactor, Mfactor);
+
+		int kio = 0;
+		for (int in = 0; in < melement->GetNnodes(); in++)
+		{
+			int io = melement->GetNodeN(in)->Variables().GetOffset();
+			int indof = melement->GetNodeN(in)->Get_ndof();
+			int kjo = 0;
+			for (int jn = 0; jn < melement->GetNnodes(); jn++)
+			{
+				int jo = melement->GetNodeN(jn)->Variables().GetOffset();
+				int jndof = melement->GetNodeN(jn)->Get_ndof();
+				storage.PasteSumClippedMatrix(&H, kio, kjo, indof, jndof,  io,jo);
+				kjo += jndof;
+			}
+			kio += indof;
+		}
+	}
+}
+
+
+
+
 
 
 } // END_OF_NAMESPACE____
@@ -19,6 +19,8 @@
 
 #include "physics/ChPhysicsItem.h"
 #include "physics/ChContinuumMaterial.h"
+#include "parallel/ChTaskPool.h"
+#include "lcp/ChLcpKstiffness.h"
 #include "ChNodeFEMbase.h"
 #include "ChElementBase.h"
 
@@ -29,8 +31,63 @@ namespace fem
 
 
 
+class ChMesh;
+
+
+/// Proxy to the stiffness of the elements of a ChMesh that support the
+/// matrix-free mode (see ChMesh::SetMatrixFree()): the products by vectors
+/// needed by iterative solvers are computed on the fly by the elements, 
+/// without storing their K, R, M matrices.
+
+class ChApiFem ChLcpKstiffnessMesh : public ChLcpKstiffness
+{
+	CH_RTTI(ChLcpKstiffnessMesh, ChLcpKstiffness)
+
+public:
+	ChLcpKstiffnessMesh(ChMesh* mmesh) : mesh(mmesh), Kfactor(0), Rfactor(0), Mfactor(0) {};
+	virtual ~ChLcpKstiffnessMesh() {};
+
+				/// Set the scaling of the K, R, M matrices, as in ChMesh::KRMmatricesLoad().
+	void SetFactors(double mKfactor, double mRfactor, double mMfactor) 
+				{ Kfactor = mKfactor; Rfactor = mRfactor; Mfactor = mMfactor; }
+
+				/// Returns the number of nodes of the mesh.
+	virtual unsigned int GetNvars() const;
+
+				/// There is no single K block: returns null.
+	virtual ChMatrix<double>* Get_K() {return 0;}
+
+				/// Computes the product of K by 'vect' on the fly, element by element,
+				/// (in parallel, if the ChSystem of the mesh uses parallel passes) and 
+				/// adds to 'result'.
+	virtual void MultiplyAndAdd(ChMatrix<double>& result, const ChMatrix<double>& vect);
+
+				/// Add the diagonal of the stiffness matrix to 'result'. The matrices
+				/// of the elements are computed one at a time in a temporary.
+	virtual void DiagonalAdd(ChMatrix<double>& result);
+
+				/// Add the K matrix to 'storage'. The matrices of the elements are
+				/// computed one at a time in a temporary, and always summed, also
+				/// if 'add' is false, because elements share nodes.
+	virtual void Build_K(ChSparseMatrixBase& storage, bool add= true);
+
+private:
+	ChMesh* mesh;
+	double Kfactor;
+	double Rfactor;
+	double Mfactor;
+	ChMatrixDynamic<> H;	// temporary for DiagonalAdd() and Build_K()
+};
+
+
+
 /// Class which defines a mesh of finite elements of class ChFelem,
 /// between nodes of class  ChFnode. 
+/// If ChSystem::SetUseParallelPasses() is on, the elements are processed
+/// in parallel. The elements are split in 'colors', i.e. groups of elements
+/// that do not share nodes, so that the internal forces of the elements of
+/// one color can be added to the nodes in parallel without locks; the result
+/// does not depend on the number of threads.
 
 class ChApiFem ChMesh : public ChIndexedNodes
 {
@@ -41,10 +98,20 @@ private:
 
 	unsigned int n_dofs; // total degrees of freedom
 
+	std::vector< std::vector<int> > element_colors; // indexes of elements, for each color
+	bool coloring_valid;
+
+	bool matrix_free;
+	ChLcpKstiffnessMesh matrixfree_K;	// stiffness of elements in matrix-free mode
+
+	friend class ChLcpKstiffnessMesh;
+
+	void RunElementsLoop(int nitems, ChTaskPoolLoop& mloop);
+
 
 public:
 
-	ChMesh() { n_dofs = 0;};
+	ChMesh() : matrixfree_K(this) { n_dofs = 0; coloring_valid = false; matrix_free = false;};
 	~ChMesh() {};
 
 	void AddNode (ChNodeFEMbase& m_node);
@@ -65,6 +132,22 @@ public:
 				/// - Precompute auxiliary data, such as (local) stiffness matrices Kl, if any, for each element.
 	void SetupInitial ();				
 
+				/// Split the elements in groups that do not share nodes (greedy coloring).
+				/// This is done automatically in SetupInitial() or when elements
+				/// have been added or removed.
+	void ComputeElementColoring ();
+
+				/// Access the groups of elements computed by ComputeElementColoring(): for 
+				/// each color, the indexes of elements (see GetElement()) that do not share nodes.
+	std::vector< std::vector<int> >& GetElementColors() {return element_colors;}
+
+				/// If true, the elements that support it (see ChElementBase::HasMatrixFreeKRM(),
+				/// ex. ChElementTetra_4) do not store their K, R, M matrices at each step: the 
+				/// products by vectors needed by iterative solvers (ex. LCP_ITERATIVE_PMINRES)
+				/// are computed on the fly, saving memory traffic in large meshes. Default false.
+	void SetMatrixFree(bool mf) {matrix_free = mf;}
+	bool GetMatrixFree() {return matrix_free;}
+
 				/// Set reference position of nodes as current position, for all nodes.
 	void Relax ();
 
@@ -16,6 +16,7 @@
 
 #include "ChNodeFEMbase.h"
 #include "lcp/ChLcpVariablesNode.h"
+#include "physics/ChStateSnapshot.h"
 
 
 namespace chrono
@@ -111,6 +112,23 @@ public:
 				/// Acceleration of the node - in absolute csys.
 	void SetPos_dtdt(const ChVector<>& mposdtdt) {pos_dtdt = mposdtdt;}
 
+				/// Save/restore the state of the node, for ChSystem::StateSave()
+				/// and ChSystem::StateRestore().
+	virtual void StateSave(ChStateSnapshot& msnapshot)
+					{
+						msnapshot.Add(this->X0);
+						msnapshot.Add(this->pos);
+						msnapshot.Add(this->pos_dt);
+						msnapshot.Add(this->pos_dtdt);
+					}
+	virtual void StateRestore(ChStateSnapshot& msnapshot)
+					{
+						msnapshot.Get(this->X0);
+						msnapshot.Get(this->pos);
+						msnapshot.Get(this->pos_dt);
+						msnapshot.Get(this->pos_dtdt);
+					}
+
 
 
 			//
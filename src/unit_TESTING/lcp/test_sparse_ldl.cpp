@@ -0,0 +1,216 @@
+//
+// PROJECT CHRONO - http://projectchrono.org
+//
+// Copyright (c) 2013 Project Chrono
+// All rights reserved.
+//
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file at the top level of the distribution
+// and at http://projectchrono.org/license-chrono.txt.
+//
+
+///////////////////////////////////////////////////
+//
+//   test_sparse_ldl.cpp
+//
+//   Regression test of the sparse LDL' factorization
+//   (ChSparseLDL) of saddle point (KKT) matrices, as
+//   assembled by ChLcpSparseDirectSolver.
+//
+///////////////////////////////////////////////////
+
+
+#include <vector>
+#include "core/ChSparseLDL.h"
+#include "core/ChCSRMatrix.h"
+#include "core/ChMatrix.h"
+#include "core/ChMathematics.h"
+#include "core/ChLog.h"
+
+using namespace chrono;
+
+
+// Random KKT matrix | H Cq'; Cq E |, with 'nb' blocks of 6 rows in H
+// (symmetric positive definite if 'hsign' is 1, negative definite if -1)
+// and 'nc' constraints, each coupling two random blocks, with E = -cfm.
+// If 'redundant', the last constraint is a copy of the first one.
+
+static void BuildKKT(ChCSRMatrix& A, std::vector<int>& blocks, std::vector<int>& signs,
+					 int nb, int nc, double hsign, bool redundant, double cfm)
+{
+	int nq = 6 * nb;
+	int n = nq + nc;
+	A.Reset(n, n);
+	blocks.clear();
+	signs.assign(n, 1);
+
+	for (int ib = 0; ib < nb; ib++)
+	{
+		int off = 6 * ib;
+		for (int i = 0; i < 6; i++)
+		{
+			A.AddElement(off + i, off + i, hsign * (10.0 + ChRandom()));
+			for (int j = 0; j < i; j++)
+			{
+				double v = hsign * (ChRandom() - 0.5);
+				A.AddElement(off + i, off + j, v);
+				A.AddElement(off + j, off + i, v);
+			}
+		}
+		blocks.push_back(off);
+	}
+
+	std::vector<double> first_row(12);
+	int first_a = 0, first_b = 0;
+	for (int ic = 0; ic < nc; ic++)
+	{
+		int row = nq + ic;
+		int ia = (int)(ChRandom() * nb) % nb;
+		int ibb = (ia + 1 + (int)(ChRandom() * (nb - 1))) % nb;
+		if (redundant && ic == nc - 1)
+		{
+			ia = first_a;
+			ibb = first_b;
+		}
+		for (int j = 0; j < 12; j++)
+		{
+			double v = (redundant && ic == nc - 1) ? first_row[j] : ChRandom() - 0.5;
+			if (ic == 0)
+				first_row[j] = v;
+			int col = (j < 6) ? 6 * ia + j : 6 * ibb + j - 6;
+			A.AddElement(row, col, v);
+			A.AddElement(col, row, v);
+		}
+		if (ic == 0)
+		{
+			first_a = ia;
+			first_b = ibb;
+		}
+		A.SetElement(row, row, -cfm);	// always stored, as in ChLcpSparseDirectSolver
+		blocks.push_back(row);
+		signs[row] = -1;
+	}
+	blocks.push_back(n);
+	A.Compress();
+}
+
+// Solve A*x=b with a few steps of iterative refinement, as done by
+// ChLcpSparseDirectSolver, and return the residual relative to b.
+
+static double SolveAndCheck(ChSparseLDL& LDL, ChCSRMatrix& A, ChMatrixDynamic<>& b)
+{
+	ChMatrixDynamic<> x, res, dx;
+	LDL.Solve(b, x);
+	double maxres = 0;
+	for (int iter = 0; ; iter++)
+	{
+		A.MatrMultiply(x, res);
+		res.MatrSub(b, res);
+		maxres = res.NormInf();
+		if (iter >= 10 || maxres <= 1e-12 * b.NormInf())
+			break;
+		LDL.Solve(res, dx);
+		x.MatrInc(dx);
+	}
+	return maxres / b.NormInf();
+}
+
+static int nfailures = 0;
+
+static void Check(bool mcond, const char* mtest)
+{
+	GetLog() << (mcond ? "  ok     " : "  FAILED ") << mtest << "\n";
+	if (!mcond)
+		nfailures++;
+}
+
+
+int main(int argc, char* argv[])
+{
+	ChSetRandomSeed(123);
+
+	ChCSRMatrix A;
+	std::vector<int> blocks, signs;
+
+	// 1) random block KKT matrix, with the expected signs of the pivots
+
+	{
+		GetLog() << "Random block KKT matrix\n";
+		BuildKKT(A, blocks, signs, 40, 60, 1.0, false, 0.0);
+		ChSparseLDL LDL;
+		LDL.Analyze(A, &blocks, &signs);
+		bool factorized = LDL.Factorize(A);
+		Check(factorized, "factorized");
+		Check(LDL.GetNregularized() == 0, "no regularized pivots");
+
+		ChMatrixDynamic<> b(A.GetRows(), 1);
+		for (int i = 0; i < b.GetRows(); i++)
+			b(i) = ChRandom() - 0.5;
+		Check(SolveAndCheck(LDL, A, b) < 1e-10, "residual");
+
+		// a new factorization with the same pattern, without a new analysis
+		A.MatrScale(2.0);
+		Check(LDL.HasSamePattern(A), "same pattern");
+		Check(LDL.Factorize(A), "factorized again");
+		Check(SolveAndCheck(LDL, A, b) < 1e-10, "residual after a new factorization");
+	}
+
+	// 2) a redundant constraint: its pivot is regularized, and a consistent
+	//    right hand side is still solved
+
+	{
+		GetLog() << "Redundant constraint\n";
+		BuildKKT(A, blocks, signs, 20, 30, 1.0, true, 0.0);
+		ChSparseLDL LDL;
+		LDL.Analyze(A, &blocks, &signs);
+		bool factorized = LDL.Factorize(A);
+		Check(factorized, "factorized");
+		Check(LDL.GetNregularized() == 1, "one regularized pivot");
+
+		int nq = 6 * 20;
+		ChMatrixDynamic<> b(A.GetRows(), 1);
+		for (int i = 0; i < b.GetRows(); i++)
+			b(i) = ChRandom() - 0.5;
+		b(A.GetRows() - 1) = b(nq);	// the same as the copied constraint
+		Check(SolveAndCheck(LDL, A, b) < 1e-8, "residual");
+	}
+
+	// 3) no sign hints: a quasi definite matrix (E = -cfm is negative
+	//    definite), ordered and factorized without the expected signs
+
+	{
+		GetLog() << "No sign hints\n";
+		BuildKKT(A, blocks, signs, 30, 40, 1.0, false, 1e-3);
+		ChSparseLDL LDL;
+		LDL.Analyze(A);
+		bool factorized = LDL.Factorize(A);
+		Check(factorized, "factorized");
+		Check(LDL.GetNwrongSign() == 0, "no wrong sign pivots");
+
+		ChMatrixDynamic<> b(A.GetRows(), 1);
+		for (int i = 0; i < b.GetRows(); i++)
+			b(i) = ChRandom() - 0.5;
+		Check(SolveAndCheck(LDL, A, b) < 1e-10, "residual");
+	}
+
+	// 4) large pivots with the wrong sign (H negative definite): the
+	//    factorization fails, but it is not regularized, so it is still exact
+
+	{
+		GetLog() << "Large pivots with the wrong sign\n";
+		BuildKKT(A, blocks, signs, 10, 12, -1.0, false, 0.0);
+		ChSparseLDL LDL;
+		LDL.Analyze(A, &blocks, &signs);
+		bool factorized = LDL.Factorize(A);
+		Check(!factorized, "failure reported");
+		Check(LDL.GetNwrongSign() > 0, "wrong sign pivots counted");
+
+		ChMatrixDynamic<> b(A.GetRows(), 1);
+		for (int i = 0; i < b.GetRows(); i++)
+			b(i) = ChRandom() - 0.5;
+		Check(SolveAndCheck(LDL, A, b) < 1e-8, "residual");
+	}
+
+	GetLog() << (nfailures ? "FAILED\n" : "PASSED\n");
+	return nfailures ? 1 : 0;
+}
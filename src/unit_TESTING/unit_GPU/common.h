@@ -306,7 +306,7 @@ void printContactsBullet(btCollisionWorld* bt_collision_world, vector<contact_da
 }
 bool printContactsCPU(ChSystem* system_cpu, vector<contact_dat> & contact_cpu) {
 
-	std::list<ChContact*> list_cpu = ((ChContactContainer*) (system_cpu->GetContactContainer()))->GetContactList();
+	ChChunkedPool<ChContact>& list_cpu = ((ChContactContainer*) (system_cpu->GetContactContainer()))->GetContactList();
 	contact_dat icontact;
 	std::vector<ChLcpConstraint*>& mconstraints = system_cpu->GetLcpSystemDescriptor()->GetConstraintsList();
 	int i = 0;
@@ -318,17 +318,18 @@ bool printContactsCPU(ChSystem* system_cpu, vector<contact_dat> & contact_cpu) {
 	((ChLcpIterativeAPGD *) (system_cpu->GetLcpSolverSpeed()))->Dump_Rhs(rhs_cpu);
 	//((ChLcpSolverGPU *) (system_gpu->GetLcpSolverSpeed()))->Dump_Rhs(rhs_gpu);
 
-	for (std::list<ChContact*>::iterator it = list_cpu.begin(); it != list_cpu.end(); ++it) {
-		Vector Pa = (*it)->GetContactP1();
-		Vector Pb = (*it)->GetContactP2();
-		Vector N = (*it)->GetContactNormal();
+	for (int ic = 0; ic < list_cpu.Size(); ++ic) {
+		ChContact* it = list_cpu.Get(ic);
+		Vector Pa = it->GetContactP1();
+		Vector Pb = it->GetContactP2();
+		Vector N = it->GetContactNormal();
 
 		icontact.posA = R3(Pa.x, Pa.y, Pa.z);
 		icontact.posB = R3(Pb.x, Pb.y, Pb.z);
 		icontact.N = R3(N.x, N.y, N.z);
-		icontact.dist = (*it)->GetContactDistance();
-		icontact.idA = (*it)->GetModelA()->GetPhysicsItem()->GetIdentifier();
-		icontact.idB = (*it)->GetModelB()->GetPhysicsItem()->GetIdentifier();
+		icontact.dist = it->GetContactDistance();
+		icontact.idA = it->GetModelA()->GetPhysicsItem()->GetIdentifier();
+		icontact.idB = it->GetModelB()->GetPhysicsItem()->GetIdentifier();
 
 		JA = ((ChLcpConstraintTwoBodies*) (mconstraints[0 + i]))->Get_Cq_a();
 		JB = ((ChLcpConstraintTwoBodies*) (mconstraints[0 + i]))->Get_Cq_b();